@@ -6,4 +6,7 @@ pushd fuzzing
 cmake -DBOLOS_SDK=../BOLOS_SDK -Bbuild -H.
 make -C build
 mv ./build/fuzz_tx_parser "${OUT}"
-popd
\ No newline at end of file
+mv ./build/fuzz_tx_parser_structured "${OUT}"
+mv ./build/fuzz_apdu_dispatcher "${OUT}"
+mv ./build/*.dict "${OUT}"
+popd
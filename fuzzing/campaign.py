@@ -0,0 +1,501 @@
+#!/usr/bin/env python3
+'''
+Local fuzzing campaign: runs the fuzzers of this directory in parallel on the
+available cores, merges their corpora periodically, and reports throughput and
+coverage over time in a static HTML and JSON report.
+
+    cmake -DBOLOS_SDK=... -DCMAKE_C_COMPILER=clang -Bbuild -H. && make -C build
+    cmake -DBOLOS_SDK=... -DCMAKE_C_COMPILER=clang -DFUZZ_COVERAGE=ON -Bbuild-cov -H. \\
+        && make -C build-cov
+    ./campaign.py --build build --coverage-build build-cov --duration 3600
+
+Every fuzzer runs with -fork (or -jobs with --mode jobs) on its share of the
+cores. Fuzzers of the same seed corpus share their campaign corpus. Every merge
+interval, each campaign corpus is merged into a minimized corpus, and the
+coverage of the minimized corpus is measured with the fuzzers of the coverage
+build, llvm-profdata and llvm-cov. Inputs of the minimized corpora are merged
+into the seed corpora with the minimize_corpus target:
+
+    cmake -DFUZZ_MERGE_DIRS="campaign/merged/corpus;campaign/merged/corpus_apdu_dispatcher" build
+    make -C build minimize_corpus
+
+The report, <work>/report.html and <work>/report.json, is rewritten at every
+sample, and needs no network access to view. Crashes are written to
+<work>/<fuzzer>/artifacts, and fuzzing goes on after them.
+'''
+
+import argparse
+import dataclasses
+import html
+import json
+import os
+import re
+import shutil
+import signal
+import subprocess
+import sys
+import time
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+FUZZING_DIR = Path(__file__).resolve().parent
+
+# Fuzzers, with their seed corpus
+FUZZERS = {
+    'fuzz_tx_parser': 'corpus',
+    'fuzz_tx_parser_structured': 'corpus',
+    'fuzz_apdu_dispatcher': 'corpus_apdu_dispatcher',
+}
+
+# Status lines of libFuzzer, in fork mode and otherwise:
+#   #1048576: cov: 512 ft: 1024 corp: 128 exec/s 20000 oom/timeout/crash: 0/0/0 time: 60s ...
+#   #1048576  pulse  cov: 512 ft: 1024 corp: 128/4Kb lim: 4096 exec/s: 20000 rss: 40Mb
+STATUS_LINE = re.compile(r'^#(\d+)\b.*?\bcov: (\d+) ft: (\d+) corp: (\d+)')
+EXECS_PER_SECOND = re.compile(r'\bexec/s:? (\d+)')
+
+ARTIFACT_PREFIXES = ('crash-', 'timeout-', 'oom-', 'leak-')
+
+# Sources of the SDK and of the fuzzing harness are left out of the coverage
+DEFAULT_IGNORE_FILENAME_REGEX = r'(lib_standard_app|/fuzzing/)'
+
+
+@dataclasses.dataclass
+class Status:
+    execs: int = 0
+    execs_per_second: int = 0
+    cov: int = 0
+    ft: int = 0
+    corpus: int = 0
+
+
+@dataclasses.dataclass
+class Sample:
+    time_s: float
+    execs: int
+    execs_per_second: float
+    cov: int
+    ft: int
+    corpus: int
+    artifacts: int
+
+
+class StatusLog:
+    '''
+    Log of a libFuzzer process, read as it grows.
+    '''
+
+    def __init__(self, path: Path) -> None:
+        self.path = path
+        self.offset = 0
+        self.pending = b''
+        self.status: Optional[Status] = None
+
+    def update(self) -> Optional[Status]:
+        try:
+            with open(self.path, 'rb') as log:
+                log.seek(self.offset)
+                data = log.read()
+        except FileNotFoundError:
+            return self.status
+        self.offset += len(data)
+        lines = (self.pending + data).split(b'\n')
+        self.pending = lines.pop()
+        for line in lines:
+            match = STATUS_LINE.match(line.decode(errors='replace'))
+            if not match:
+                continue
+            execs_per_second = EXECS_PER_SECOND.search(match.string)
+            self.status = Status(int(match[1]),
+                                 int(execs_per_second[1]) if execs_per_second else 0,
+                                 int(match[2]), int(match[3]), int(match[4]))
+        return self.status
+
+
+class Fuzzer:
+    '''
+    Fuzzer of the campaign, with the time series of its status.
+    '''
+
+    def __init__(self, name: str, args: argparse.Namespace, jobs: int) -> None:
+        self.name = name
+        self.binary = args.build / name
+        self.coverage_binary = args.coverage_build / name if args.coverage_build else None
+        self.dictionary = args.build / f'{name}.dict'
+        self.seeds = FUZZING_DIR / FUZZERS[name]
+        self.corpus = args.work / 'corpus' / FUZZERS[name]
+        self.merged = args.work / 'merged' / FUZZERS[name]
+        self.work = args.work / name
+        self.artifacts = self.work / 'artifacts'
+        self.jobs = jobs
+        self.mode = args.mode
+        self.fuzzer_args = args.fuzzer_arg
+        self.process: Optional[subprocess.Popen] = None
+        self.logs: Dict[Path, StatusLog] = {}
+        self.samples: List[Sample] = []
+        self.coverage: List[Dict[str, Any]] = []
+        self.new_edges_s: List[float] = []
+        self.coverage_html: Optional[str] = None
+
+    def start(self) -> None:
+        for directory in [self.corpus, self.merged, self.artifacts]:
+            directory.mkdir(parents=True, exist_ok=True)
+        command = [str(self.binary), f'-artifact_prefix={self.artifacts}/']
+        if self.dictionary.exists():
+            command.append(f'-dict={self.dictionary}')
+        if self.mode == 'fork':
+            command += [
+                f'-fork={self.jobs}', '-ignore_crashes=1', '-ignore_timeouts=1',
+                '-ignore_ooms=1'
+            ]
+        else:
+            # Jobs stopped by a crash are replaced by new jobs, each logging
+            # to fuzz-<job>.log
+            command += [f'-jobs={2**31 - 1}', f'-workers={self.jobs}']
+        command += self.fuzzer_args
+        # New inputs are written to the first directory
+        command += [str(self.corpus), str(self.seeds)]
+
+        log = open(self.work / 'fuzzer.log', 'wb')  # pylint: disable=consider-using-with
+        self.process = subprocess.Popen(command,
+                                        cwd=self.work,
+                                        stdout=log,
+                                        stderr=subprocess.STDOUT,
+                                        start_new_session=True)
+        log.close()
+
+    def stop(self) -> None:
+        if self.process is None or self.process.poll() is not None:
+            return
+        # The process group includes the jobs of the fuzzer
+        os.killpg(self.process.pid, signal.SIGINT)
+        try:
+            self.process.wait(timeout=30)
+        except subprocess.TimeoutExpired:
+            os.killpg(self.process.pid, signal.SIGKILL)
+            self.process.wait()
+
+    def running(self) -> bool:
+        return self.process is not None and self.process.poll() is None
+
+    def artifact_files(self) -> List[str]:
+        return sorted(path.name for path in self.artifacts.iterdir()
+                      if path.name.startswith(ARTIFACT_PREFIXES))
+
+    def status(self) -> Optional[Status]:
+        if self.mode == 'fork':
+            paths = [self.work / 'fuzzer.log']
+        else:
+            paths = sorted(self.work.glob('fuzz-*.log'))
+        for path in paths:
+            self.logs.setdefault(path, StatusLog(path))
+        statuses = [status for status in (log.update() for log in self.logs.values()) if status]
+        if not statuses:
+            return None
+        # Workers of the jobs mode run side by side, each with its own count
+        return Status(sum(status.execs for status in statuses),
+                      sum(status.execs_per_second for status in statuses),
+                      max(status.cov for status in statuses),
+                      max(status.ft for status in statuses),
+                      max(status.corpus for status in statuses))
+
+    def sample(self, time_s: float) -> None:
+        status = self.status()
+        if status is None:
+            return
+        previous = self.samples[-1] if self.samples else None
+        if previous and time_s > previous.time_s and status.execs >= previous.execs:
+            execs_per_second = (status.execs - previous.execs) / (time_s - previous.time_s)
+        else:
+            execs_per_second = float(status.execs_per_second)
+        if previous is None or status.cov > previous.cov:
+            self.new_edges_s.append(time_s)
+        self.samples.append(
+            Sample(time_s, status.execs, execs_per_second, status.cov, status.ft, status.corpus,
+                   len(self.artifact_files())))
+
+    def summary(self, now_s: float) -> Dict[str, Any]:
+        intervals = [b - a for a, b in zip(self.new_edges_s, self.new_edges_s[1:])]
+        last = self.samples[-1] if self.samples else None
+        return {
+            'jobs': self.jobs,
+            'running': self.running(),
+            'execs': last.execs if last else 0,
+            'execs_per_second': last.execs_per_second if last else 0,
+            'cov': last.cov if last else 0,
+            'corpus': last.corpus if last else 0,
+            'merged_corpus': count_files(self.merged),
+            'last_new_edge_s': self.new_edges_s[-1] if self.new_edges_s else None,
+            'since_new_edge_s': now_s - self.new_edges_s[-1] if self.new_edges_s else None,
+            'mean_time_to_new_edge_s': sum(intervals) / len(intervals) if intervals else None,
+            'artifacts': self.artifact_files(),
+            'coverage_html': self.coverage_html,
+            'samples': [dataclasses.asdict(sample) for sample in self.samples],
+            'coverage': self.coverage,
+        }
+
+
+def count_files(directory: Path) -> int:
+    return sum(1 for path in directory.iterdir() if path.is_file()) if directory.exists() else 0
+
+
+def run(command: List[str], **kwargs) -> subprocess.CompletedProcess:
+    return subprocess.run(command,
+                          stdout=subprocess.PIPE,
+                          stderr=subprocess.STDOUT,
+                          check=True,
+                          **kwargs)
+
+
+def merge(fuzzer: Fuzzer) -> None:
+    '''
+    Adds the inputs of the campaign corpus with new coverage to the minimized
+    corpus.
+    '''
+    run([str(fuzzer.binary), '-merge=1',
+         str(fuzzer.merged), str(fuzzer.corpus)], cwd=fuzzer.work)
+
+
+def measure_coverage(fuzzer: Fuzzer, args: argparse.Namespace, time_s: float,
+                     html_report: bool) -> None:
+    '''
+    Runs the minimized corpus with the fuzzer of the coverage build, and adds
+    the totals of llvm-cov to the coverage of the fuzzer.
+    '''
+    assert fuzzer.coverage_binary is not None
+    profiles = fuzzer.work / 'profiles'
+    shutil.rmtree(profiles, ignore_errors=True)
+    profiles.mkdir()
+    env = dict(os.environ, LLVM_PROFILE_FILE=str(profiles / '%p.profraw'))
+    # Crashing inputs still write their profile
+    subprocess.run([str(fuzzer.coverage_binary), '-runs=0',
+                    str(fuzzer.merged)],
+                   cwd=fuzzer.work,
+                   env=env,
+                   stdout=subprocess.DEVNULL,
+                   stderr=subprocess.DEVNULL,
+                   check=False)
+    profdata = fuzzer.work / 'coverage.profdata'
+    run([args.llvm_profdata, 'merge', '-sparse', '-o',
+         str(profdata)] + [str(path) for path in profiles.glob('*.profraw')])
+    common = [
+        f'-instr-profile={profdata}', f'-ignore-filename-regex={args.ignore_filename_regex}',
+        str(fuzzer.coverage_binary)
+    ]
+    exported = json.loads(run([args.llvm_cov, 'export', '-summary-only'] + common).stdout)
+    totals = exported['data'][0]['totals']
+    fuzzer.coverage.append({
+        'time_s': time_s,
+        **{
+            kind: {key: totals[kind][key] for key in ['count', 'covered', 'percent']}
+            for kind in ['lines', 'functions', 'regions', 'branches'] if kind in totals
+        }
+    })
+    if html_report:
+        output = fuzzer.work / 'coverage_html'
+        run([args.llvm_cov, 'show', '-format=html', f'-output-dir={output}'] + common)
+        fuzzer.coverage_html = str(output.relative_to(args.work) / 'index.html')
+
+
+def merge_and_measure(fuzzers: List[Fuzzer], args: argparse.Namespace, time_s: float,
+                      final: bool) -> None:
+    merged = set()
+    for fuzzer in fuzzers:
+        # Fuzzers sharing a corpus are merged once
+        if fuzzer.merged not in merged:
+            merge(fuzzer)
+            merged.add(fuzzer.merged)
+    if args.coverage_build:
+        for fuzzer in fuzzers:
+            measure_coverage(fuzzer, args, time_s, html_report=final)
+
+
+COLORS = ['#1f77b4', '#d62728', '#2ca02c', '#9467bd', '#ff7f0e', '#8c564b']
+
+
+def svg_chart(title: str, series: List[Tuple[str, List[Tuple[float, float]]]]) -> str:
+    '''
+    Line chart of the series, over the time of the campaign.
+    '''
+    width, height, left, bottom = 640, 220, 60, 30
+    points = [point for _, values in series for point in values]
+    max_x = max((x for x, _ in points), default=0) or 1
+    max_y = max((y for _, y in points), default=0) or 1
+    plot_width, plot_height = width - left - 10, height - bottom - 25
+
+    def position(x: float, y: float) -> str:
+        return (f'{left + x / max_x * plot_width:.1f},'
+                f'{25 + plot_height - y / max_y * plot_height:.1f}')
+
+    parts = [
+        f'<svg xmlns="http://www.w3.org/2000/svg" width="{width}" height="{height}">',
+        f'<text x="{left}" y="15" font-weight="bold">{html.escape(title)}</text>',
+        f'<polyline fill="none" stroke="#888" points="{position(0, max_y)} {position(0, 0)} '
+        f'{position(max_x, 0)}"/>',
+        f'<text x="{left - 5}" y="30" text-anchor="end">{max_y:.4g}</text>',
+        f'<text x="{left - 5}" y="{25 + plot_height}" text-anchor="end">0</text>',
+        f'<text x="{width - 10}" y="{height - 5}" text-anchor="end">{max_x:.0f} s</text>',
+    ]
+    for index, (label, values) in enumerate(series):
+        color = COLORS[index % len(COLORS)]
+        path = ' '.join(position(x, y) for x, y in values)
+        parts.append(f'<polyline fill="none" stroke="{color}" stroke-width="2" points="{path}"/>')
+        parts.append(f'<text x="{left + 10 + 200 * index}" y="{height - 5}" fill="{color}">'
+                     f'{html.escape(label)}</text>')
+    parts.append('</svg>')
+    return '\n'.join(parts)
+
+
+def format_seconds(value: Optional[float]) -> str:
+    return '-' if value is None else f'{value:.0f} s'
+
+
+def write_report(fuzzers: List[Fuzzer], args: argparse.Namespace, started: float,
+                 now_s: float) -> None:
+    report = {
+        'started': time.strftime('%Y-%m-%dT%H:%M:%S', time.localtime(started)),
+        'elapsed_s': now_s,
+        'mode': args.mode,
+        'cores': args.cores,
+        'fuzzers': {fuzzer.name: fuzzer.summary(now_s)
+                    for fuzzer in fuzzers},
+    }
+    (args.work / 'report.json').write_text(json.dumps(report, indent=2), encoding='utf-8')
+
+    summaries = [fuzzer.summary(now_s) for fuzzer in fuzzers]
+    rows = []
+    for fuzzer, summary in zip(fuzzers, summaries):
+        coverage = summary['coverage'][-1] if summary['coverage'] else {}
+        lines = coverage.get('lines', {}).get('percent')
+        link = (f'<a href="{html.escape(summary["coverage_html"])}">{lines:.1f} %</a>'
+                if summary['coverage_html'] else '-' if lines is None else f'{lines:.1f} %')
+        artifacts = '<br>'.join(html.escape(artifact) for artifact in summary['artifacts'])
+        rows.append(f'<tr><td>{html.escape(fuzzer.name)}</td><td>{summary["jobs"]}</td>'
+                    f'<td>{summary["execs"]}</td><td>{summary["execs_per_second"]:.0f}</td>'
+                    f'<td>{summary["cov"]}</td><td>{summary["corpus"]}</td>'
+                    f'<td>{summary["merged_corpus"]}</td>'
+                    f'<td>{format_seconds(summary["since_new_edge_s"])}</td>'
+                    f'<td>{format_seconds(summary["mean_time_to_new_edge_s"])}</td>'
+                    f'<td>{link}</td><td>{artifacts or "-"}</td></tr>')
+
+    def series(key: str) -> List[Tuple[str, List[Tuple[float, float]]]]:
+        return [(fuzzer.name, [(sample.time_s, getattr(sample, key))
+                               for sample in fuzzer.samples]) for fuzzer in fuzzers]
+
+    def coverage_series(kind: str) -> List[Tuple[str, List[Tuple[float, float]]]]:
+        return [(fuzzer.name, [(entry['time_s'], entry[kind]['percent'])
+                               for entry in fuzzer.coverage if kind in entry])
+                for fuzzer in fuzzers]
+
+    charts = [
+        svg_chart('Executions per second', series('execs_per_second')),
+        svg_chart('Edges (cov)', series('cov')),
+        svg_chart('Corpus size', series('corpus')),
+    ]
+    if args.coverage_build:
+        charts += [
+            svg_chart('Line coverage of the minimized corpus (%)', coverage_series('lines')),
+            svg_chart('Branch coverage of the minimized corpus (%)', coverage_series('branches')),
+        ]
+
+    (args.work / 'report.html').write_text(f'''<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<title>Fuzzing campaign</title>
+<style>
+body {{ font-family: sans-serif; }}
+table {{ border-collapse: collapse; }}
+td, th {{ border: 1px solid #ccc; padding: 4px 8px; text-align: right; }}
+svg {{ display: block; margin: 16px 0; font-size: 12px; }}
+</style>
+</head>
+<body>
+<h1>Fuzzing campaign</h1>
+<p>Started {report["started"]}, {now_s:.0f} s elapsed, {args.cores} cores, {args.mode} mode.</p>
+<table>
+<tr><th>Fuzzer</th><th>Jobs</th><th>Executions</th><th>Exec/s</th><th>Edges</th>
+<th>Corpus</th><th>Minimized</th><th>Since new edge</th><th>Mean time to new edge</th>
+<th>Line coverage</th><th>Artifacts</th></tr>
+{"".join(rows)}
+</table>
+{"".join(charts)}
+</body>
+</html>
+''',
+                                           encoding='utf-8')
+
+
+def share_cores(cores: int, count: int) -> List[int]:
+    return [max(1, cores // count + (1 if index < cores % count else 0)) for index in range(count)]
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--build', type=Path, default=FUZZING_DIR / 'build')
+    parser.add_argument('--coverage-build',
+                        type=Path,
+                        help='build with -DFUZZ_COVERAGE=ON, to measure coverage')
+    parser.add_argument('--work', type=Path, default=FUZZING_DIR / 'campaign')
+    parser.add_argument('--fuzzers', nargs='+', choices=list(FUZZERS), default=list(FUZZERS))
+    parser.add_argument('--mode', choices=['fork', 'jobs'], default='fork')
+    parser.add_argument('--cores', type=int, default=os.cpu_count() or 1)
+    parser.add_argument('--duration', type=float, default=3600, help='in seconds')
+    parser.add_argument('--sample-interval', type=float, default=10, help='in seconds')
+    parser.add_argument('--merge-interval', type=float, default=600, help='in seconds')
+    parser.add_argument('--fuzzer-arg',
+                        action='append',
+                        default=[],
+                        help='option passed to every fuzzer, such as -max_len=4096')
+    parser.add_argument('--llvm-cov', default='llvm-cov')
+    parser.add_argument('--llvm-profdata', default='llvm-profdata')
+    parser.add_argument('--ignore-filename-regex', default=DEFAULT_IGNORE_FILENAME_REGEX)
+    args = parser.parse_args()
+    args.build = args.build.resolve()
+    args.work = args.work.resolve()
+    if args.coverage_build:
+        args.coverage_build = args.coverage_build.resolve()
+
+    fuzzers = [
+        Fuzzer(name, args, jobs)
+        for name, jobs in zip(args.fuzzers, share_cores(args.cores, len(args.fuzzers)))
+    ]
+    for fuzzer in fuzzers:
+        if not fuzzer.binary.exists():
+            parser.error(f'{fuzzer.binary} not found')
+        if fuzzer.coverage_binary and not fuzzer.coverage_binary.exists():
+            parser.error(f'{fuzzer.coverage_binary} not found')
+
+    started = time.time()
+    start = time.monotonic()
+    next_merge = args.merge_interval
+    for fuzzer in fuzzers:
+        fuzzer.start()
+        print(f'{fuzzer.name}: {fuzzer.jobs} jobs, log in {fuzzer.work}')
+    try:
+        while True:
+            time.sleep(args.sample_interval)
+            now_s = time.monotonic() - start
+            for fuzzer in fuzzers:
+                fuzzer.sample(now_s)
+            if now_s >= args.duration or not any(fuzzer.running() for fuzzer in fuzzers):
+                break
+            if now_s >= next_merge:
+                merge_and_measure(fuzzers, args, now_s, final=False)
+                next_merge = now_s + args.merge_interval
+            write_report(fuzzers, args, started, now_s)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        for fuzzer in fuzzers:
+            fuzzer.stop()
+
+    now_s = time.monotonic() - start
+    merge_and_measure(fuzzers, args, now_s, final=True)
+    write_report(fuzzers, args, started, now_s)
+    print(f'Report in {args.work / "report.html"}')
+    return 1 if any(fuzzer.artifact_files() for fuzzer in fuzzers) else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
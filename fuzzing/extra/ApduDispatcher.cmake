@@ -0,0 +1,49 @@
+# APDU handlers of the app, built against the host mock of the SDK in mock/.
+# The mock headers shadow the headers of the SDK that cannot be built for the
+# host, and must come first in the include path.
+add_library(apdudispatcher
+    ${BOLOS_SDK}/lib_standard_app/format.c
+    ${BOLOS_SDK}/lib_standard_app/buffer.c
+    ${BOLOS_SDK}/lib_standard_app/read.c
+    ${BOLOS_SDK}/lib_standard_app/varint.c
+    ${BOLOS_SDK}/lib_standard_app/bip32.c
+    ${BOLOS_SDK}/lib_standard_app/write.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/apdu/dispatcher.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/handler/get_address.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/handler/get_app_name.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/handler/get_chunk_size.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/handler/get_stats.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/handler/get_version.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/handler/set_tx_template.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/handler/sign_message.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/handler/sign_tx.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/helper/send_response.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/transaction/deserialize.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/ui/action/validate.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/ui/common.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/buffer_util.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/address.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/arena.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/lz_decoder.c
+    ${CMAKE_CURRENT_LIST_DIR}/../../src/stats.c
+    ${CMAKE_CURRENT_LIST_DIR}/../mock/mock_app.c
+    ${CMAKE_CURRENT_LIST_DIR}/../mock/mock_sdk.c
+    ${CMAKE_CURRENT_LIST_DIR}/../mock/secp256k1.c
+)
+
+target_compile_definitions(apdudispatcher PUBLIC
+    HAVE_SHA256
+    APPNAME="Partisia Blockchain"
+    MAJOR_VERSION=1
+    MINOR_VERSION=0
+    PATCH_VERSION=0
+)
+
+target_include_directories(apdudispatcher BEFORE PUBLIC
+    ${CMAKE_CURRENT_LIST_DIR}/../mock
+)
+
+target_include_directories(apdudispatcher PUBLIC
+    ${CMAKE_CURRENT_LIST_DIR}/../../src
+    ${BOLOS_SDK}/lib_standard_app
+)
@@ -0,0 +1,89 @@
+# Generates a libFuzzer dictionary from the headers of the app, such that the
+# fuzzers find the well known contracts and invocations without guessing them
+# byte by byte.
+#
+#   cmake -DWELL_KNOWN=<well_known.h> [-DCOMMANDS=<types.h>] -DOUTPUT=<dict> -P GenerateDictionary.cmake
+#
+# Every address of WELL_KNOWN becomes an entry of 21 bytes, and every byte
+# constant an entry of one byte. When COMMANDS is given, the instructions of
+# command_e become entries of APDU headers in the input format of
+# fuzz_apdu_dispatcher: INS, P1 and P2.
+
+# Formats a list of byte values as an escaped dictionary string.
+function(escape_bytes output)
+    set(escaped "")
+    foreach(byte ${ARGN})
+        math(EXPR byte "${byte}" OUTPUT_FORMAT HEXADECIMAL)
+        string(SUBSTRING "${byte}" 2 -1 digits)
+        string(LENGTH "${digits}" length)
+        if(length EQUAL 1)
+            set(digits "0${digits}")
+        endif()
+        string(APPEND escaped "\\x${digits}")
+    endforeach()
+    set(${output} "${escaped}" PARENT_SCOPE)
+endfunction()
+
+file(READ ${WELL_KNOWN} well_known)
+get_filename_component(well_known_name ${WELL_KNOWN} NAME)
+set(dictionary "# Generated from ${well_known_name} by GenerateDictionary.cmake\n")
+
+# #define NAME ((blockchain_address_s){.raw_bytes = {0x01, ...}})
+string(REGEX MATCHALL "#define[ \t]+[A-Z0-9_]+[^#]*raw_bytes[ \t]*=[ \t]*{[^}]*}"
+       addresses "${well_known}")
+foreach(address ${addresses})
+    string(REGEX MATCH "#define[ \t]+([A-Z0-9_]+)" _ "${address}")
+    set(name ${CMAKE_MATCH_1})
+    string(REGEX REPLACE ".*raw_bytes" "" bytes "${address}")
+    string(REGEX MATCHALL "0x[0-9a-fA-F]+" bytes "${bytes}")
+    list(LENGTH bytes length)
+    if(NOT length EQUAL 21)
+        message(FATAL_ERROR "${name} has ${length} bytes instead of 21")
+    endif()
+    escape_bytes(escaped ${bytes})
+    string(APPEND dictionary "${name}=\"${escaped}\"\n")
+endforeach()
+
+# #define NAME 3
+string(REGEX MATCHALL "#define[ \t]+[A-Z0-9_]+[ \t]+(0x[0-9a-fA-F]+|[0-9]+)[ \t]*\n"
+       constants "${well_known}")
+foreach(constant ${constants})
+    string(REGEX MATCH "#define[ \t]+([A-Z0-9_]+)[ \t]+([0-9a-fA-Fx]+)" _ "${constant}")
+    set(name ${CMAKE_MATCH_1})
+    math(EXPR value "${CMAKE_MATCH_2}")
+    if(value LESS 256)
+        escape_bytes(escaped ${value})
+        string(APPEND dictionary "${name}=\"${escaped}\"\n")
+    endif()
+endforeach()
+
+if(DEFINED COMMANDS)
+    file(READ ${COMMANDS} commands)
+    string(REGEX MATCH "typedef enum {[^}]*} command_e" commands "${commands}")
+    string(REGEX MATCHALL "[A-Z_]+ = 0x[0-9a-fA-F]+" instructions "${commands}")
+    if(NOT instructions)
+        message(FATAL_ERROR "No instructions found in ${COMMANDS}")
+    endif()
+    foreach(instruction ${instructions})
+        string(REGEX MATCH "([A-Z_]+) = (0x[0-9a-fA-F]+)" _ "${instruction}")
+        set(name ${CMAKE_MATCH_1})
+        set(ins ${CMAKE_MATCH_2})
+        # First and last chunk, first of several chunks, next chunk, last chunk
+        escape_bytes(escaped ${ins} 0 0)
+        string(APPEND dictionary "${name}_FIRST_LAST=\"${escaped}\"\n")
+        escape_bytes(escaped ${ins} 0 0x80)
+        string(APPEND dictionary "${name}_FIRST=\"${escaped}\"\n")
+        escape_bytes(escaped ${ins} 1 0x80)
+        string(APPEND dictionary "${name}_NEXT=\"${escaped}\"\n")
+        escape_bytes(escaped ${ins} 1 0)
+        string(APPEND dictionary "${name}_LAST=\"${escaped}\"\n")
+    endforeach()
+    # Pseudo-APDUs approving and rejecting the review
+    string(APPEND dictionary "UI_APPROVE=\"\\x00\\x01\\x00\\x00\"\n")
+    string(APPEND dictionary "UI_REJECT=\"\\x00\\x00\\x00\\x00\"\n")
+    # BIP32 path m/44'/3757'/0'/0/0 with its length
+    escape_bytes(escaped 5 0x80 0 0 0x2c 0x80 0 0x0e 0xad 0x80 0 0 0 0 0 0 0 0 0 0 0)
+    string(APPEND dictionary "BIP32_PATH=\"${escaped}\"\n")
+endif()
+
+file(WRITE ${OUTPUT} "${dictionary}")
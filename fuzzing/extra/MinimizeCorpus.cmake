@@ -0,0 +1,85 @@
+# Minimizes the corpus of a fuzzer with a merge of libFuzzer, and merges into
+# it the inputs found by other fuzzing runs.
+#
+#   cmake -DFUZZER=<fuzzer> -DCORPUS=<dir> [-DMERGE_DIRS=<dir;...>] -DWORK_DIR=<dir> -P MinimizeCorpus.cmake
+#
+# Inputs in subdirectories of CORPUS, such as valid examples and regressions,
+# are kept as they are. The inputs at the top of CORPUS are replaced by those
+# of CORPUS and MERGE_DIRS which add coverage over the kept inputs. Inputs that
+# are kept keep their name.
+
+foreach(variable FUZZER CORPUS WORK_DIR)
+    if(NOT DEFINED ${variable})
+        message(FATAL_ERROR "${variable} is not set")
+    endif()
+endforeach()
+
+set(merged ${WORK_DIR}/merged)
+file(REMOVE_RECURSE ${merged})
+file(MAKE_DIRECTORY ${merged})
+
+# The kept inputs are the initial corpus of the merge, such that only inputs
+# adding coverage over them are merged
+file(GLOB entries LIST_DIRECTORIES true ${CORPUS}/*)
+set(inputs "")
+set(kept_names "")
+foreach(entry ${entries})
+    if(IS_DIRECTORY ${entry})
+        get_filename_component(directory ${entry} NAME)
+        file(GLOB_RECURSE kept ${entry}/*)
+        foreach(input ${kept})
+            get_filename_component(name ${input} NAME)
+            configure_file(${input} ${merged}/${directory}-${name} COPYONLY)
+            list(APPEND kept_names ${directory}-${name})
+        endforeach()
+    else()
+        list(APPEND inputs ${entry})
+    endif()
+endforeach()
+list(LENGTH inputs before)
+
+# Names of the inputs at the top of CORPUS by their digest, as libFuzzer names
+# merged inputs by the SHA-1 of their content
+foreach(input ${inputs})
+    file(SHA1 ${input} digest)
+    get_filename_component(name ${input} NAME)
+    set(name_of_${digest} ${name})
+endforeach()
+
+execute_process(
+    COMMAND ${FUZZER} -merge=1 ${merged} ${CORPUS} ${MERGE_DIRS}
+    RESULT_VARIABLE result
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Merge with ${FUZZER} failed, ${CORPUS} is left as it was:\n${output}")
+endif()
+
+file(GLOB merged_inputs ${merged}/*)
+set(minimized "")
+foreach(input ${merged_inputs})
+    get_filename_component(name ${input} NAME)
+    list(FIND kept_names ${name} index)
+    if(index EQUAL -1)
+        list(APPEND minimized ${input})
+    endif()
+endforeach()
+if(before GREATER 0 AND NOT minimized)
+    message(FATAL_ERROR "Merge with ${FUZZER} kept no input, ${CORPUS} is left as it was")
+endif()
+
+if(inputs)
+    file(REMOVE ${inputs})
+endif()
+foreach(input ${minimized})
+    file(SHA1 ${input} digest)
+    get_filename_component(name ${input} NAME)
+    if(DEFINED name_of_${digest})
+        set(name ${name_of_${digest}})
+    endif()
+    configure_file(${input} ${CORPUS}/${name} COPYONLY)
+endforeach()
+
+list(LENGTH minimized after)
+list(LENGTH kept_names kept_count)
+message(STATUS "${CORPUS}: ${before} inputs before, ${after} after, ${kept_count} kept in subdirectories")
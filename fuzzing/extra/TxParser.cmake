@@ -21,6 +21,7 @@ add_library(txparser
     ${CMAKE_CURRENT_SOURCE_DIR}/../src/transaction/deserialize.c
     ${CMAKE_CURRENT_SOURCE_DIR}/../src/buffer_util.c
     ${CMAKE_CURRENT_SOURCE_DIR}/../src/address.c
+    ${CMAKE_CURRENT_SOURCE_DIR}/../src/arena.c
 )
 
 set_target_properties(txparser PROPERTIES SOVERSION 1)
@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+#include "cx.h"
+#include "io.h"
+#include "parser.h"
+#include "read.h"
+
+#include "apdu/dispatcher.h"
+#include "constants.h"
+#include "globals.h"
+#include "status_words.h"
+#include "types.h"
+#include "mock_app.h"
+#include "mock_sdk.h"
+
+/*
+ * Stateful fuzz target for the APDU handlers.
+ *
+ * The input is a sequence of APDUs, each encoded as INS, P1, P2, Lc and Lc
+ * bytes of data. CLA is always the CLA of the application. INS 0x00 is not an
+ * APDU, but approves (P1 odd) or rejects (P1 even) the review shown to the
+ * user.
+ *
+ * Each APDU is copied to a buffer of exactly Lc bytes before being dispatched,
+ * such that reads out of bounds are detected by the address sanitizer.
+ *
+ * Besides crashes, the following invariants are checked:
+ *
+ * - Each APDU gets exactly one response, unless it starts a review.
+ * - A review gets exactly one response when approved or rejected.
+ * - When a transaction is reviewed, the digest to sign is the SHA-256 of the
+ *   streamed transaction followed by the chain id. Compressed chunks are
+ *   decompressed by a reference decoder that keeps the whole output.
+ * - When a message is reviewed, the digest to sign is the SHA-256 of the
+ *   signing prefix, the message length and the streamed message.
+ */
+
+/** INS of the pseudo-APDU approving or rejecting the review. */
+#define INS_UI_CHOICE 0x00
+
+/** Length of an APDU header in the input. */
+#define INPUT_HEADER_LEN 4
+
+/** Checks an invariant, aborting with the given message if violated. */
+#define CHECK(test, message)                           \
+    do {                                               \
+        if (!(test)) {                                 \
+            fprintf(stderr, "Invariant: %s\n", message); \
+            abort();                                   \
+        }                                              \
+    } while (0)
+
+/**
+ * Independent model of the bytes digested for the request being streamed,
+ * computed from the APDUs that the application accepted.
+ */
+typedef struct {
+    /** Whether the digest is known. Cleared when a chunk is rejected. */
+    bool active;
+    /** Request type of the digest. */
+    request_type_e req_type;
+    /** Digest of the accepted bytes. */
+    cx_sha256_t digest;
+    /** Chain id of the transaction. */
+    uint8_t chain_id[CHAIN_ID_MAX_LENGTH];
+    /** Length of the chain id. */
+    uint8_t chain_id_len;
+    /** Accepted compressed chunks, digested once decompressed at the review. */
+    uint8_t *compressed;
+    /** Length of compressed. */
+    size_t compressed_len;
+} expected_digest_t;
+
+/**
+ * Independent model of a transaction template.
+ */
+typedef struct {
+    /** Whether the template has been set. */
+    bool is_set;
+    /** Chain id of the transactions. */
+    uint8_t chain_id[CHAIN_ID_MAX_LENGTH];
+    /** Length of the chain id. */
+    uint8_t chain_id_len;
+    /** Gas cost and contract address, as serialized in the header. */
+    uint8_t gas_and_address[8 + ADDRESS_LEN];
+} expected_template_t;
+
+static expected_digest_t expected;
+static expected_template_t expected_templates[TX_TEMPLATE_COUNT];
+
+/**
+ * Offset of the data following the BIP32 path at the start of the given data.
+ * Only called on data accepted by the application.
+ */
+static size_t skip_bip32_path(const uint8_t *data) {
+    return 1 + 4 * (size_t) data[0];
+}
+
+/**
+ * Reads the chain id at the given offset of data accepted by the application.
+ */
+static size_t read_chain_id(const uint8_t *data,
+                            size_t offset,
+                            uint8_t chain_id[CHAIN_ID_MAX_LENGTH],
+                            uint8_t *chain_id_len) {
+    *chain_id_len = (uint8_t) read_u32_be(data, offset);
+    memcpy(chain_id, data + offset + 4, *chain_id_len);
+    return offset + 4 + *chain_id_len;
+}
+
+static void expected_start(request_type_e req_type) {
+    expected.active = true;
+    expected.req_type = req_type;
+    expected.compressed_len = 0;
+    cx_hash_init((cx_hash_t *) &expected.digest, CX_SHA256);
+}
+
+static void expected_update(const uint8_t *data, size_t len) {
+    cx_hash_update((cx_hash_t *) &expected.digest, data, len);
+}
+
+static void expected_update_compressed(const uint8_t *data, size_t len) {
+    expected.compressed = realloc(expected.compressed, expected.compressed_len + len);
+    memcpy(expected.compressed + expected.compressed_len, data, len);
+    expected.compressed_len += len;
+}
+
+/**
+ * Digests the decompressed bytes of the accepted compressed chunks. Only called
+ * on streams accepted by the application.
+ */
+static void expected_update_decompressed(void) {
+    const uint8_t *in = expected.compressed;
+    // A token of 3 bytes decompresses to at most 130 bytes
+    uint8_t *out = malloc(expected.compressed_len * 44 + 1);
+    size_t out_len = 0;
+
+    size_t i = 0;
+    while (i < expected.compressed_len) {
+        const uint8_t token = in[i++];
+        if (token < 0x80) {
+            memcpy(out + out_len, in + i, token + 1);
+            out_len += token + 1;
+            i += token + 1;
+        } else {
+            const size_t distance = (size_t) in[i] << 8 | in[i + 1];
+            i += 2;
+            for (size_t k = 0; k < (size_t) (token & 0x7F) + 3; k++, out_len++) {
+                out[out_len] = out[out_len - distance];
+            }
+        }
+    }
+
+    expected_update(out, out_len);
+    free(out);
+}
+
+/**
+ * Checks that the digest to sign matches the model, once a review has been
+ * started.
+ */
+static void check_digest_of_review(void) {
+    if (!expected.active) {
+        return;
+    }
+    expected.active = false;
+
+    if (expected.req_type == CONFIRM_TRANSACTION) {
+        CHECK(G_mock_review == MOCK_REVIEW_TRANSACTION, "transaction review expected");
+        expected_update_decompressed();
+        const uint8_t chain_id_prefix[4] = {0, 0, 0, expected.chain_id_len};
+        expected_update(chain_id_prefix, sizeof(chain_id_prefix));
+        expected_update(expected.chain_id, expected.chain_id_len);
+    } else {
+        CHECK(G_mock_review == MOCK_REVIEW_MESSAGE, "message review expected");
+    }
+
+    uint8_t digest[CX_SHA256_SIZE];
+    cx_hash_final((cx_hash_t *) &expected.digest, digest);
+    CHECK(memcmp(digest, G_context.m_hash, sizeof(digest)) == 0, "digest to sign");
+}
+
+/**
+ * Updates the model with an APDU that has been accepted, either with SW_OK or
+ * by starting a review.
+ */
+static void model_accepted_apdu(const command_t *cmd) {
+    const uint8_t *data = cmd->data;
+
+    switch (cmd->ins) {
+        case SIGN_TX:
+            if (cmd->p1 == P1_FIRST_CHUNK) {
+                expected_start(CONFIRM_TRANSACTION);
+                read_chain_id(data,
+                              skip_bip32_path(data),
+                              expected.chain_id,
+                              &expected.chain_id_len);
+            } else if (cmd->p1 == P1_TEMPLATE_FIRST_CHUNK) {
+                const expected_template_t *tx_template = &expected_templates[data[0]];
+                CHECK(tx_template->is_set, "transaction template must be set");
+                expected_start(CONFIRM_TRANSACTION);
+                memcpy(expected.chain_id, tx_template->chain_id, tx_template->chain_id_len);
+                expected.chain_id_len = tx_template->chain_id_len;
+
+                // Header: nonce and valid-to time, template fields, RPC length
+                expected_update(data + 1, 16);
+                expected_update(tx_template->gas_and_address,
+                                sizeof(tx_template->gas_and_address));
+                expected_update(data + 1 + 16, cmd->lc - 1 - 16);
+            } else if (cmd->p1 == P1_COMPRESSED_CHUNK && expected.active) {
+                expected_update_compressed(data, cmd->lc);
+            } else if (expected.active) {
+                expected_update(data, cmd->lc);
+            }
+            break;
+        case SIGN_MESSAGE:
+            if (cmd->p1 == P1_FIRST_CHUNK) {
+                expected_start(CONFIRM_MESSAGE);
+                expected_update((const uint8_t *) MESSAGE_SIGNING_PREFIX,
+                                sizeof(MESSAGE_SIGNING_PREFIX) - 1);
+                expected_update(data + skip_bip32_path(data), 4);
+            } else if (expected.active) {
+                expected_update(data, cmd->lc);
+            }
+            break;
+        case SET_TX_TEMPLATE: {
+            expected_template_t *tx_template = &expected_templates[cmd->p1];
+            size_t offset = read_chain_id(data,
+                                          skip_bip32_path(data),
+                                          tx_template->chain_id,
+                                          &tx_template->chain_id_len);
+            memcpy(tx_template->gas_and_address,
+                   data + offset,
+                   sizeof(tx_template->gas_and_address));
+            tx_template->is_set = true;
+            break;
+        }
+        case GET_ADDRESS:
+            // Resets the global context, ending the request being streamed
+            expected.active = false;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Dispatches a single APDU and checks the invariants.
+ */
+static void run_apdu(const command_t *cmd) {
+    // A review started by the APDU replaces the review shown
+    const mock_review_e review_before = G_mock_review;
+    G_mock_review = MOCK_REVIEW_NONE;
+    mock_io_reset();
+
+    if (apdu_dispatcher(cmd) < 0) {
+        return;
+    }
+
+    if (G_mock_io.count == 0) {
+        CHECK(G_mock_review != MOCK_REVIEW_NONE, "APDU without response must start a review");
+        model_accepted_apdu(cmd);
+        check_digest_of_review();
+        return;
+    }
+
+    CHECK(G_mock_io.count == 1, "APDU must have exactly one response");
+    CHECK(G_mock_review == MOCK_REVIEW_NONE, "APDU with response must not start a review");
+    G_mock_review = review_before;
+
+    if (G_mock_io.sw == SW_OK) {
+        model_accepted_apdu(cmd);
+    } else if (cmd->ins == SIGN_TX || cmd->ins == SIGN_MESSAGE || cmd->ins == GET_ADDRESS) {
+        // The rejected chunk is not digested, and the context may be reset
+        expected.active = false;
+    }
+}
+
+/**
+ * Approves or rejects the review shown, and checks the invariants.
+ */
+static void run_ui_choice(bool approve) {
+    const mock_review_e review = G_mock_review;
+    mock_io_reset();
+    mock_ui_choose(approve);
+
+    if (review == MOCK_REVIEW_NONE) {
+        CHECK(G_mock_io.count == 0, "response without review");
+        return;
+    }
+
+    CHECK(G_mock_io.count == 1, "review must have exactly one response");
+    if (!approve) {
+        CHECK(G_mock_io.sw == SW_DENY, "rejected review must be denied");
+    } else if (review == MOCK_REVIEW_ADDRESS) {
+        CHECK(G_mock_io.sw == SW_OK && G_mock_io.data_len == ADDRESS_LEN, "address response");
+    } else if (G_mock_io.sw == SW_OK) {
+        CHECK(G_mock_io.data_len == 1 + 32 + 32, "signature response");
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    mock_app_reset();
+    free(expected.compressed);
+    memset(&expected, 0, sizeof(expected));
+    memset(expected_templates, 0, sizeof(expected_templates));
+
+    size_t offset = 0;
+    while (size - offset >= INPUT_HEADER_LEN) {
+        command_t cmd = {.cla = CLA,
+                         .ins = data[offset],
+                         .p1 = data[offset + 1],
+                         .p2 = data[offset + 2],
+                         .lc = data[offset + 3],
+                         .data = NULL};
+        offset += INPUT_HEADER_LEN;
+
+        if (cmd.ins == INS_UI_CHOICE) {
+            run_ui_choice(cmd.p1 & 1);
+            continue;
+        }
+
+        // Truncated data is shortened to the rest of the input
+        if (cmd.lc > size - offset) {
+            cmd.lc = (uint8_t) (size - offset);
+        }
+
+        // Copied to an exactly sized buffer, to detect reads out of bounds
+        uint8_t *apdu_data = NULL;
+        if (cmd.lc > 0) {
+            apdu_data = malloc(cmd.lc);
+            memcpy(apdu_data, data + offset, cmd.lc);
+            cmd.data = apdu_data;
+        }
+        offset += cmd.lc;
+
+        run_apdu(&cmd);
+        free(apdu_data);
+    }
+
+    return 0;
+}
@@ -6,8 +6,12 @@
 
 #include "transaction/deserialize.h"
 #include "transaction/types.h"
+#include "arena.h"
+#include "constants.h"
 #include "format.h"
 
+static uint8_t arena_buffer[ARENA_SIZE];
+
 static bool check_status_invariants(parser_status_e status) {
   // Zero is reserved.
   if (status == 0) {
@@ -15,7 +19,7 @@ static bool check_status_invariants(parser_status_e status) {
   }
 
   // Status must be known
-  return status == PARSING_DONE || status == PARSING_CONTINUE || PARSING_FAILED_MPC_MEMO <= status;
+  return PARSING_STATUS_MIN <= status && status <= PARSING_CONTINUE;
 }
 
 int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
@@ -24,8 +28,11 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
     transaction_t tx;
     memset(&tx, 0, sizeof(tx));
 
+    arena_t arena;
+    arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+
     transaction_parsing_state_t state;
-    transaction_parser_init(&state);
+    transaction_parser_init(&state, &arena);
     parser_status_e status = transaction_parser_update(&state, &buf, &tx);
 
     // Check that status cannot lie outside the expected set.
@@ -0,0 +1,36 @@
+#pragma once
+
+/**
+ * \file Host mock of the key derivation helpers of the SDK.
+ *
+ * Keys are not derived from a seed: the private key is a digest of the BIP32
+ * path, see mock_sdk.c. Public keys and signatures are valid secp256k1 keys
+ * and ECDSA signatures of that private key, computed by secp256k1.c.
+ *
+ * With MOCK_FAST_KEYS, as used by the fuzzing targets, the public key and
+ * signatures are instead plain digests of the path and signed hash. They are
+ * deterministic and cheap, but are not valid keys or signatures.
+ */
+
+#include <stdint.h>  // uint*_t
+#include <stddef.h>  // size_t
+
+#include "cx.h"
+
+cx_err_t bip32_derive_get_pubkey_256(cx_curve_t curve,
+                                     const uint32_t *path,
+                                     size_t path_len,
+                                     uint8_t raw_pubkey[static 65],
+                                     uint8_t *chain_code,
+                                     cx_md_t chain_code_hash);
+
+cx_err_t bip32_derive_ecdsa_sign_rs_hash_256(cx_curve_t curve,
+                                             const uint32_t *path,
+                                             size_t path_len,
+                                             uint32_t sign_mode,
+                                             cx_md_t hash_id,
+                                             const uint8_t *hash,
+                                             size_t hash_len,
+                                             uint8_t sig_r[static 32],
+                                             uint8_t sig_s[static 32],
+                                             uint32_t *info);
@@ -0,0 +1,50 @@
+#pragma once
+
+/**
+ * \file Host mock of the parts of the cryptographic library used by the
+ * application. Only SHA-256 is supported, implemented in software.
+ */
+
+#include <stdint.h>  // uint*_t
+#include <stddef.h>  // size_t
+
+#include "lcx_sha256.h"
+
+/** Error code of the cryptographic library. */
+typedef uint32_t cx_err_t;
+
+/** Success. */
+#define CX_OK 0x00000000
+/** Invalid parameter, such as an unsupported algorithm. */
+#define CX_INVALID_PARAMETER 0xFFFFFF84
+
+/** Hash algorithm identifiers. */
+typedef enum {
+    CX_SHA256 = 3,
+    CX_SHA512 = 5,
+} cx_md_t;
+
+/** Elliptic curve identifiers. */
+typedef enum {
+    CX_CURVE_256K1 = 0x21,
+} cx_curve_t;
+
+/** Finalizes the hash in cx_hash_no_throw. */
+#define CX_LAST (1 << 0)
+/** Deterministic ECDSA nonces. */
+#define CX_RND_RFC6979 (3 << 9)
+/** The y-coordinate of R in an ECDSA signature is odd. */
+#define CX_ECCINFO_PARITY_ODD 1
+
+cx_err_t cx_hash_init(cx_hash_t *hash, cx_md_t hash_id);
+
+cx_err_t cx_hash_update(cx_hash_t *hash, const uint8_t *in, size_t in_len);
+
+cx_err_t cx_hash_final(cx_hash_t *hash, uint8_t *digest);
+
+cx_err_t cx_hash_no_throw(cx_hash_t *hash,
+                          uint32_t mode,
+                          const uint8_t *in,
+                          size_t len,
+                          uint8_t *out,
+                          size_t out_len);
@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * \file Host mock of the APDU I/O of the SDK. Responses are recorded instead of
+ * being sent, see mock_sdk.h.
+ */
+
+#include <stdint.h>  // uint*_t
+#include <stddef.h>  // size_t
+
+#include "decorators.h"  // WARN_UNUSED_RESULT
+#include "os.h"
+#include "parser.h"  // command_t
+
+/** Size of the APDU buffer. */
+#define IO_APDU_BUFFER_SIZE 260
+/** Size of the buffer for interactions between SE and MCU. Unused on the host. */
+#define IO_SEPROXYHAL_BUFFER_SIZE_B 300
+
+/** UX state. Unused on the host. */
+typedef int ux_state_t;
+/** Parameters of the BOLOS UX application. Unused on the host. */
+typedef int bolos_ux_params_t;
+
+extern uint8_t G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
+
+/**
+ * Records a response with the given status word and no data.
+ *
+ * @return zero or positive integer if success, negative integer otherwise.
+ */
+int io_send_sw(uint16_t sw);
+
+/**
+ * Records a response with the given data and status word.
+ *
+ * @return zero or positive integer if success, negative integer otherwise.
+ */
+int io_send_response_pointer(const uint8_t *ptr, size_t size, uint16_t sw);
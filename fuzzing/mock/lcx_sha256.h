@@ -0,0 +1,29 @@
+#pragma once
+
+/**
+ * \file Host mock of the SHA-256 context of the cryptographic library.
+ */
+
+#include <stdint.h>  // uint*_t
+#include <stddef.h>  // size_t
+
+/** Size of a SHA-256 digest. */
+#define CX_SHA256_SIZE 32
+
+/** Generic hash context. */
+typedef struct {
+    /** Hash algorithm, see cx_hash_init. */
+    int algo;
+} cx_hash_t;
+
+/** SHA-256 hash context. */
+typedef struct {
+    /** Generic part of the context. */
+    cx_hash_t header;
+    /** Number of bytes hashed so far. */
+    uint64_t length;
+    /** Intermediate hash value. */
+    uint32_t state[8];
+    /** Bytes of the current, incomplete block. */
+    uint8_t block[64];
+} cx_sha256_t;
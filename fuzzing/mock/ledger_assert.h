@@ -0,0 +1,17 @@
+#pragma once
+
+/**
+ * \file Host mock of the assertions of the SDK. Failed assertions abort, such
+ * that they are reported by fuzzers and sanitizers.
+ */
+
+#include <stdio.h>   // fprintf
+#include <stdlib.h>  // abort
+
+#define LEDGER_ASSERT(test, message)                                   \
+    do {                                                               \
+        if (!(test)) {                                                 \
+            fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, message); \
+            abort();                                                   \
+        }                                                              \
+    } while (0)
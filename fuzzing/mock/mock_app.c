@@ -0,0 +1,137 @@
+#include <stdbool.h>  // bool
+#include <string.h>   // explicit_bzero
+
+#include "io.h"
+
+#include "mock_app.h"
+#include "mock_sdk.h"
+#include "constants.h"
+#include "globals.h"
+#include "status_words.h"
+#include "ui/common.h"
+#include "ui/display.h"
+#include "ui/menu.h"
+#include "ui/action/validate.h"
+
+/*** Globals of app_main.c ***/
+
+global_ctx_t G_context;
+
+static uint8_t G_arena_buffer[ARENA_SIZE];
+arena_t G_arena;
+
+tx_template_t G_tx_templates[TX_TEMPLATE_COUNT];
+
+/** Blind signing is allowed, such that every transaction can be approved. */
+const internal_storage_t N_storage_real = {.initialized = 0x01, .allow_blind_signing = 0x01};
+
+mock_review_e G_mock_review;
+
+void mock_app_reset(void) {
+    explicit_bzero(&G_context, sizeof(G_context));
+    arena_init(&G_arena, G_arena_buffer, sizeof(G_arena_buffer));
+    explicit_bzero(&G_tx_templates, sizeof(G_tx_templates));
+    G_mock_review = MOCK_REVIEW_NONE;
+    mock_io_reset();
+}
+
+/*** Headless UI ***/
+
+void ui_menu_main(void) {
+    G_mock_review = MOCK_REVIEW_NONE;
+}
+
+void ui_menu_settings(void (*exit_callback)(void)) {
+    (void) exit_callback;
+}
+
+void ui_menu_about(void) {
+}
+
+int ui_display_address(void) {
+    if (G_context.req_type != CONFIRM_ADDRESS || G_context.state != STATE_NONE) {
+        G_context.state = STATE_NONE;
+        return io_send_sw(SW_BAD_STATE);
+    }
+
+    clear_g_fields();
+    if (!set_g_address(&G_context.pk_info.address)) {
+        return io_send_sw(SW_DISPLAY_ADDRESS_FAIL);
+    }
+
+    G_mock_review = MOCK_REVIEW_ADDRESS;
+    return 0;
+}
+
+int ui_display_transaction(void) {
+    if (G_context.req_type != CONFIRM_TRANSACTION || G_context.state != STATE_PARSED) {
+        G_context.state = STATE_NONE;
+        return io_send_sw(SW_BAD_STATE);
+    }
+
+    clear_g_fields();
+    if (!set_g_token_amount(G_context.display.gas_cost,
+                            sizeof(G_context.display.gas_cost),
+                            "Gas",
+                            G_context.tx_info.transaction.basic.gas_cost,
+                            0)) {
+        return io_send_sw(SW_DISPLAY_AMOUNT_FAIL);
+    }
+    if (!set_g_chain_id(&G_context.tx_info.chain_id)) {
+        return io_send_sw(SW_DISPLAY_CHAIN_ID_FAIL);
+    }
+
+    if (G_context.tx_info.transaction.type == MPC_TRANSFER) {
+        if (!set_g_fields_for_mpc_transfer(&G_context.tx_info.transaction.mpc_transfer)) {
+            return io_send_sw(SW_DISPLAY_AMOUNT_FAIL);
+        }
+    } else if (G_context.tx_info.transaction.type == ZK_INVOCATION) {
+        if (!set_g_address(&G_context.tx_info.transaction.basic.contract_address)) {
+            return io_send_sw(SW_DISPLAY_ADDRESS_FAIL);
+        }
+        if (!set_g_fields_for_zk_invocation(&G_context.tx_info.transaction.zk_invocation)) {
+            return io_send_sw(SW_DISPLAY_ZK_INVOCATION_FAIL);
+        }
+    } else {
+        if (!set_g_address(&G_context.tx_info.transaction.basic.contract_address)) {
+            return io_send_sw(SW_DISPLAY_ADDRESS_FAIL);
+        }
+    }
+
+    G_mock_review = MOCK_REVIEW_TRANSACTION;
+    return 0;
+}
+
+int ui_display_message(void) {
+    if (G_context.req_type != CONFIRM_MESSAGE || G_context.state != STATE_PARSED) {
+        G_context.state = STATE_NONE;
+        return io_send_sw(SW_BAD_STATE);
+    }
+
+    clear_g_fields();
+    if (!set_g_fields_for_message(&G_context.msg_info, G_context.m_hash)) {
+        return io_send_sw(SW_DISPLAY_MESSAGE_FAIL);
+    }
+
+    G_mock_review = MOCK_REVIEW_MESSAGE;
+    return 0;
+}
+
+void mock_ui_choose(bool approve) {
+    const mock_review_e review = G_mock_review;
+    G_mock_review = MOCK_REVIEW_NONE;
+
+    switch (review) {
+        case MOCK_REVIEW_ADDRESS:
+            validate_address(approve);
+            break;
+        case MOCK_REVIEW_TRANSACTION:
+            validate_transaction(approve);
+            break;
+        case MOCK_REVIEW_MESSAGE:
+            validate_message(approve);
+            break;
+        case MOCK_REVIEW_NONE:
+            break;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+/**
+ * \file Host replacement of the parts of the application that depend on the
+ * device: the globals defined in app_main.c, and a headless UI.
+ *
+ * The headless UI sets up the displayed fields like the UI of the device, and
+ * records which review has been started instead of showing it. The review is
+ * then approved or rejected with mock_ui_choose.
+ */
+
+#include <stdbool.h>  // bool
+
+/**
+ * Reviews that can be shown to the user.
+ */
+typedef enum {
+    /** No review is shown. */
+    MOCK_REVIEW_NONE,
+    /** Address verification, see ui_display_address. */
+    MOCK_REVIEW_ADDRESS,
+    /** Transaction review, see ui_display_transaction. */
+    MOCK_REVIEW_TRANSACTION,
+    /** Message review, see ui_display_message. */
+    MOCK_REVIEW_MESSAGE,
+} mock_review_e;
+
+/**
+ * Review currently shown to the user.
+ */
+extern mock_review_e G_mock_review;
+
+/**
+ * Resets the application state, like starting the application: clears the
+ * global context, arena, transaction templates and recorded responses.
+ */
+void mock_app_reset(void);
+
+/**
+ * Approves or rejects the review currently shown, as the user would. Does
+ * nothing when no review is shown.
+ */
+void mock_ui_choose(bool approve);
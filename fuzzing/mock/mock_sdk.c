@@ -0,0 +1,291 @@
+#include <stdint.h>  // uint*_t
+#include <stddef.h>  // size_t
+#include <string.h>  // memcpy, memset
+
+#include "cx.h"
+#include "io.h"
+#include "crypto_helpers.h"
+#include "secp256k1.h"
+
+#include "mock_sdk.h"
+
+/*** I/O ***/
+
+uint8_t G_io_apdu_buffer[IO_APDU_BUFFER_SIZE];
+
+mock_io_t G_mock_io;
+
+void mock_io_reset(void) {
+    memset(&G_mock_io, 0, sizeof(G_mock_io));
+}
+
+int io_send_response_pointer(const uint8_t *ptr, size_t size, uint16_t sw) {
+    // Data and status word must fit in the APDU buffer
+    if (size > sizeof(G_mock_io.data) - 2) {
+        return -1;
+    }
+
+    G_mock_io.count++;
+    G_mock_io.sw = sw;
+    G_mock_io.data_len = size;
+    if (size > 0) {
+        memcpy(G_mock_io.data, ptr, size);
+    }
+    return (int) size + 2;
+}
+
+int io_send_sw(uint16_t sw) {
+    return io_send_response_pointer(NULL, 0, sw);
+}
+
+/*** SHA-256 ***/
+
+static const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+    0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+    0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+    0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+    0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+    0xc67178f2};
+
+static const uint32_t SHA256_INITIAL_STATE[8] = {0x6a09e667,
+                                                 0xbb67ae85,
+                                                 0x3c6ef372,
+                                                 0xa54ff53a,
+                                                 0x510e527f,
+                                                 0x9b05688c,
+                                                 0x1f83d9ab,
+                                                 0x5be0cd19};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/**
+ * Adds the current block of the context to the intermediate hash value.
+ */
+static void sha256_compress(cx_sha256_t *ctx) {
+    uint32_t w[64];
+    for (size_t i = 0; i < 16; i++) {
+        w[i] = (uint32_t) ctx->block[4 * i] << 24 | (uint32_t) ctx->block[4 * i + 1] << 16 |
+               (uint32_t) ctx->block[4 * i + 2] << 8 | (uint32_t) ctx->block[4 * i + 3];
+    }
+    for (size_t i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t v[8];
+    memcpy(v, ctx->state, sizeof(v));
+    for (size_t i = 0; i < 64; i++) {
+        uint32_t s1 = ROTR(v[4], 6) ^ ROTR(v[4], 11) ^ ROTR(v[4], 25);
+        uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+        uint32_t t1 = v[7] + s1 + ch + SHA256_K[i] + w[i];
+        uint32_t s0 = ROTR(v[0], 2) ^ ROTR(v[0], 13) ^ ROTR(v[0], 22);
+        uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+        uint32_t t2 = s0 + maj;
+        memmove(&v[1], &v[0], 7 * sizeof(uint32_t));
+        v[4] += t1;
+        v[0] = t1 + t2;
+    }
+
+    for (size_t i = 0; i < 8; i++) {
+        ctx->state[i] += v[i];
+    }
+}
+
+cx_err_t cx_hash_init(cx_hash_t *hash, cx_md_t hash_id) {
+    if (hash_id != CX_SHA256) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    cx_sha256_t *ctx = (cx_sha256_t *) hash;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->header.algo = CX_SHA256;
+    memcpy(ctx->state, SHA256_INITIAL_STATE, sizeof(ctx->state));
+    return CX_OK;
+}
+
+cx_err_t cx_hash_update(cx_hash_t *hash, const uint8_t *in, size_t in_len) {
+    if (hash->algo != CX_SHA256) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    cx_sha256_t *ctx = (cx_sha256_t *) hash;
+    for (size_t i = 0; i < in_len; i++) {
+        ctx->block[ctx->length % 64] = in[i];
+        ctx->length++;
+        if (ctx->length % 64 == 0) {
+            sha256_compress(ctx);
+        }
+    }
+    return CX_OK;
+}
+
+cx_err_t cx_hash_final(cx_hash_t *hash, uint8_t *digest) {
+    if (hash->algo != CX_SHA256) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    cx_sha256_t *ctx = (cx_sha256_t *) hash;
+    const uint64_t bit_length = ctx->length * 8;
+
+    // Padding: a one bit, zeroes up to 8 bytes before the end of a block, and
+    // the length in bits
+    const uint8_t one = 0x80;
+    const uint8_t zero = 0x00;
+    cx_hash_update(hash, &one, 1);
+    while (ctx->length % 64 != 56) {
+        cx_hash_update(hash, &zero, 1);
+    }
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        const uint8_t byte = (uint8_t) (bit_length >> shift);
+        cx_hash_update(hash, &byte, 1);
+    }
+
+    for (size_t i = 0; i < 8; i++) {
+        digest[4 * i] = (uint8_t) (ctx->state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t) (ctx->state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t) (ctx->state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t) ctx->state[i];
+    }
+    return CX_OK;
+}
+
+cx_err_t cx_hash_no_throw(cx_hash_t *hash,
+                          uint32_t mode,
+                          const uint8_t *in,
+                          size_t len,
+                          uint8_t *out,
+                          size_t out_len) {
+    cx_err_t error = cx_hash_update(hash, in, len);
+    if (error != CX_OK || !(mode & CX_LAST)) {
+        return error;
+    }
+    if (out_len < CX_SHA256_SIZE) {
+        return CX_INVALID_PARAMETER;
+    }
+    return cx_hash_final(hash, out);
+}
+
+/*** Key derivation ***/
+
+/**
+ * Digest of the given BIP32 path, followed by the given data.
+ */
+static void digest_of_path(const uint32_t *path,
+                           size_t path_len,
+                           const uint8_t *data,
+                           size_t data_len,
+                           uint8_t out[static CX_SHA256_SIZE]) {
+    cx_sha256_t ctx;
+    cx_hash_init((cx_hash_t *) &ctx, CX_SHA256);
+    cx_hash_update((cx_hash_t *) &ctx, (const uint8_t *) path, path_len * sizeof(uint32_t));
+    cx_hash_update((cx_hash_t *) &ctx, data, data_len);
+    cx_hash_final((cx_hash_t *) &ctx, out);
+}
+
+#ifndef MOCK_FAST_KEYS
+
+/**
+ * Private key of the given BIP32 path: the first valid scalar of the digests
+ * of the path and a counter.
+ */
+static void private_key_of_path(const uint32_t *path,
+                                size_t path_len,
+                                uint8_t private_key[static SECP256K1_SCALAR_LEN]) {
+    for (uint8_t counter = 0;; counter++) {
+        digest_of_path(path, path_len, &counter, 1, private_key);
+        if (secp256k1_is_valid_scalar(private_key)) {
+            return;
+        }
+    }
+}
+
+#endif
+
+cx_err_t bip32_derive_get_pubkey_256(cx_curve_t curve,
+                                     const uint32_t *path,
+                                     size_t path_len,
+                                     uint8_t raw_pubkey[static 65],
+                                     uint8_t *chain_code,
+                                     cx_md_t chain_code_hash) {
+    (void) chain_code_hash;
+    if (curve != CX_CURVE_256K1) {
+        return CX_INVALID_PARAMETER;
+    }
+
+#ifdef MOCK_FAST_KEYS
+    // Uncompressed point prefix, and the path digest as x and y
+    raw_pubkey[0] = 0x04;
+    digest_of_path(path, path_len, (const uint8_t *) "x", 1, raw_pubkey + 1);
+    digest_of_path(path, path_len, (const uint8_t *) "y", 1, raw_pubkey + 33);
+#else
+    uint8_t private_key[SECP256K1_SCALAR_LEN];
+    private_key_of_path(path, path_len, private_key);
+    secp256k1_pubkey(private_key, raw_pubkey);
+    explicit_bzero(private_key, sizeof(private_key));
+#endif
+    if (chain_code != NULL) {
+        digest_of_path(path, path_len, (const uint8_t *) "c", 1, chain_code);
+    }
+    return CX_OK;
+}
+
+cx_err_t bip32_derive_ecdsa_sign_rs_hash_256(cx_curve_t curve,
+                                             const uint32_t *path,
+                                             size_t path_len,
+                                             uint32_t sign_mode,
+                                             cx_md_t hash_id,
+                                             const uint8_t *hash,
+                                             size_t hash_len,
+                                             uint8_t sig_r[static 32],
+                                             uint8_t sig_s[static 32],
+                                             uint32_t *info) {
+    (void) sign_mode;
+    (void) hash_id;
+    if (curve != CX_CURVE_256K1) {
+        return CX_INVALID_PARAMETER;
+    }
+
+#ifdef MOCK_FAST_KEYS
+    digest_of_path(path, path_len, hash, hash_len, sig_r);
+    digest_of_path(path, path_len, sig_r, 32, sig_s);
+    if (info != NULL) {
+        *info = sig_s[31] & CX_ECCINFO_PARITY_ODD;
+    }
+#else
+    if (hash_len != SECP256K1_SCALAR_LEN) {
+        return CX_INVALID_PARAMETER;
+    }
+
+    uint8_t private_key[SECP256K1_SCALAR_LEN];
+    private_key_of_path(path, path_len, private_key);
+
+    // Deterministic nonce: digest of the private key, hash and a counter
+    bool odd_y = false;
+    for (uint8_t counter = 0;; counter++) {
+        uint8_t nonce[SECP256K1_SCALAR_LEN];
+        cx_sha256_t ctx;
+        cx_hash_init((cx_hash_t *) &ctx, CX_SHA256);
+        cx_hash_update((cx_hash_t *) &ctx, private_key, sizeof(private_key));
+        cx_hash_update((cx_hash_t *) &ctx, hash, hash_len);
+        cx_hash_update((cx_hash_t *) &ctx, &counter, 1);
+        cx_hash_final((cx_hash_t *) &ctx, nonce);
+        const bool signed_ok = secp256k1_sign(private_key, nonce, hash, sig_r, sig_s, &odd_y);
+        explicit_bzero(nonce, sizeof(nonce));
+        if (signed_ok) {
+            break;
+        }
+    }
+    explicit_bzero(private_key, sizeof(private_key));
+
+    if (info != NULL) {
+        *info = odd_y ? CX_ECCINFO_PARITY_ODD : 0;
+    }
+#endif
+    return CX_OK;
+}
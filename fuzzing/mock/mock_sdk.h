@@ -0,0 +1,34 @@
+#pragma once
+
+/**
+ * \file Inspection of the host mock of the SDK.
+ */
+
+#include <stdint.h>  // uint*_t
+#include <stddef.h>  // size_t
+
+#include "io.h"
+
+/**
+ * Responses recorded by io_send_sw and io_send_response_pointer.
+ */
+typedef struct {
+    /** Number of responses sent since the last mock_io_reset. */
+    size_t count;
+    /** Status word of the last response. */
+    uint16_t sw;
+    /** Data of the last response. */
+    uint8_t data[IO_APDU_BUFFER_SIZE];
+    /** Length of the data of the last response. */
+    size_t data_len;
+} mock_io_t;
+
+/**
+ * Responses sent by the application.
+ */
+extern mock_io_t G_mock_io;
+
+/**
+ * Forgets all recorded responses.
+ */
+void mock_io_reset(void);
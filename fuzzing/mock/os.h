@@ -0,0 +1,15 @@
+#pragma once
+
+/**
+ * \file Host mock of the parts of `os.h` used by the application.
+ */
+
+#include <stdint.h>  // uint*_t
+#include <stddef.h>  // size_t
+#include <stdio.h>   // snprintf
+#include <string.h>  // explicit_bzero
+
+#include "decorators.h"  // WARN_UNUSED_RESULT
+
+/** Position independent code is not relocated on the host. */
+#define PIC(x) ((void *) (x))
@@ -0,0 +1,475 @@
+#include <string.h>  // memcpy, memset
+
+#include "secp256k1.h"
+
+/*
+ * Numbers are 256-bit unsigned integers, stored as eight 32-bit limbs with the
+ * least significant limb first.
+ *
+ * Both the field prime p and the group order n are of the form 2^256 - c with
+ * a small c, such that products are reduced by folding the upper half onto
+ * the lower half multiplied by c.
+ */
+
+#define LIMBS 8
+
+typedef struct {
+    uint32_t v[LIMBS];
+} u256_t;
+
+/**
+ * Modulus of the form 2^256 - c, with c of at most five limbs.
+ */
+typedef struct {
+    u256_t m;
+    uint32_t c[5];
+} modulus_t;
+
+/** Field prime: 2^256 - 2^32 - 977. */
+static const modulus_t P = {
+    .m = {{0xFFFFFC2F, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+           0xFFFFFFFF}},
+    .c = {0x000003D1, 0x00000001, 0, 0, 0},
+};
+
+/** Order of the group. */
+static const modulus_t N = {
+    .m = {{0xD0364141, 0xBFD25E8C, 0xAF48A03B, 0xBAAEDCE6, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF,
+           0xFFFFFFFF}},
+    .c = {0x2FC9BEBF, 0x402DA173, 0x50B75FC4, 0x45512319, 0x00000001},
+};
+
+/**
+ * Point in Jacobian coordinates: (x / z^2, y / z^3). The point at infinity has
+ * z = 0.
+ */
+typedef struct {
+    u256_t x;
+    u256_t y;
+    u256_t z;
+} point_t;
+
+/** Generator of the group. */
+static const point_t G = {
+    .x = {{0x16F81798, 0x59F2815B, 0x2DCE28D9, 0x029BFCDB, 0xCE870B07, 0x55A06295, 0xF9DCBBAC,
+           0x79BE667E}},
+    .y = {{0xFB10D4B8, 0x9C47D08F, 0xA6855419, 0xFD17B448, 0x0E1108A8, 0x5DA4FBFC, 0x26A3C465,
+           0x483ADA77}},
+    .z = {{1, 0, 0, 0, 0, 0, 0, 0}},
+};
+
+/*** 256-bit integers ***/
+
+static void u256_from_be(u256_t *out, const uint8_t in[static SECP256K1_SCALAR_LEN]) {
+    for (int i = 0; i < LIMBS; i++) {
+        const uint8_t *limb = in + 4 * (LIMBS - 1 - i);
+        out->v[i] = (uint32_t) limb[0] << 24 | (uint32_t) limb[1] << 16 |
+                    (uint32_t) limb[2] << 8 | (uint32_t) limb[3];
+    }
+}
+
+static void u256_to_be(uint8_t out[static SECP256K1_SCALAR_LEN], const u256_t *in) {
+    for (int i = 0; i < LIMBS; i++) {
+        uint8_t *limb = out + 4 * (LIMBS - 1 - i);
+        limb[0] = (uint8_t) (in->v[i] >> 24);
+        limb[1] = (uint8_t) (in->v[i] >> 16);
+        limb[2] = (uint8_t) (in->v[i] >> 8);
+        limb[3] = (uint8_t) in->v[i];
+    }
+}
+
+static bool u256_is_zero(const u256_t *a) {
+    for (int i = 0; i < LIMBS; i++) {
+        if (a->v[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int u256_cmp(const u256_t *a, const u256_t *b) {
+    for (int i = LIMBS - 1; i >= 0; i--) {
+        if (a->v[i] != b->v[i]) {
+            return a->v[i] < b->v[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Computes a + b modulo 2^256, and returns the carry.
+ */
+static uint32_t u256_add(u256_t *out, const u256_t *a, const u256_t *b) {
+    uint64_t carry = 0;
+    for (int i = 0; i < LIMBS; i++) {
+        carry += (uint64_t) a->v[i] + b->v[i];
+        out->v[i] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    return (uint32_t) carry;
+}
+
+/**
+ * Computes a - b modulo 2^256, and returns the borrow.
+ */
+static uint32_t u256_sub(u256_t *out, const u256_t *a, const u256_t *b) {
+    int64_t borrow = 0;
+    for (int i = 0; i < LIMBS; i++) {
+        int64_t diff = (int64_t) a->v[i] - b->v[i] + borrow;
+        out->v[i] = (uint32_t) diff;
+        borrow = diff < 0 ? -1 : 0;
+    }
+    return borrow != 0;
+}
+
+static bool u256_bit(const u256_t *a, int bit) {
+    return (a->v[bit / 32] >> (bit % 32)) & 1;
+}
+
+/*** Modular arithmetic ***/
+
+/**
+ * Reduces a 512-bit number modulo the given modulus.
+ */
+static void mod_reduce(u256_t *out, const uint32_t wide[static 2 * LIMBS], const modulus_t *mod) {
+    uint32_t t[2 * LIMBS + 1] = {0};
+    memcpy(t, wide, 2 * LIMBS * sizeof(uint32_t));
+
+    // Fold the upper limbs onto the lower limbs: hi * 2^256 = hi * c
+    for (;;) {
+        bool has_upper = false;
+        for (int i = LIMBS; i < 2 * LIMBS + 1; i++) {
+            has_upper |= t[i] != 0;
+        }
+        if (!has_upper) {
+            break;
+        }
+
+        uint32_t folded[2 * LIMBS + 1] = {0};
+        memcpy(folded, t, LIMBS * sizeof(uint32_t));
+        for (int i = 0; i < LIMBS + 1; i++) {
+            uint64_t carry = 0;
+            int j = 0;
+            for (; j < 5; j++) {
+                carry += (uint64_t) folded[i + j] + (uint64_t) t[LIMBS + i] * mod->c[j];
+                folded[i + j] = (uint32_t) carry;
+                carry >>= 32;
+            }
+            for (j += i; carry != 0 && j < 2 * LIMBS + 1; j++) {
+                carry += folded[j];
+                folded[j] = (uint32_t) carry;
+                carry >>= 32;
+            }
+        }
+        memcpy(t, folded, sizeof(t));
+    }
+
+    memcpy(out->v, t, sizeof(out->v));
+    while (u256_cmp(out, &mod->m) >= 0) {
+        u256_sub(out, out, &mod->m);
+    }
+}
+
+static void mod_mul(u256_t *out, const u256_t *a, const u256_t *b, const modulus_t *mod) {
+    uint32_t wide[2 * LIMBS] = {0};
+    for (int i = 0; i < LIMBS; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; j < LIMBS; j++) {
+            carry += (uint64_t) wide[i + j] + (uint64_t) a->v[i] * b->v[j];
+            wide[i + j] = (uint32_t) carry;
+            carry >>= 32;
+        }
+        wide[i + LIMBS] = (uint32_t) carry;
+    }
+    mod_reduce(out, wide, mod);
+}
+
+static void mod_add(u256_t *out, const u256_t *a, const u256_t *b, const modulus_t *mod) {
+    if (u256_add(out, a, b) != 0 || u256_cmp(out, &mod->m) >= 0) {
+        u256_sub(out, out, &mod->m);
+    }
+}
+
+static void mod_sub(u256_t *out, const u256_t *a, const u256_t *b, const modulus_t *mod) {
+    if (u256_sub(out, a, b) != 0) {
+        u256_add(out, out, &mod->m);
+    }
+}
+
+/**
+ * Computes the inverse of a non-zero number, as a^(m - 2).
+ */
+static void mod_inv(u256_t *out, const u256_t *a, const modulus_t *mod) {
+    u256_t exponent;
+    const u256_t two = {{2, 0, 0, 0, 0, 0, 0, 0}};
+    u256_sub(&exponent, &mod->m, &two);
+
+    u256_t result = {{1, 0, 0, 0, 0, 0, 0, 0}};
+    for (int bit = 255; bit >= 0; bit--) {
+        mod_mul(&result, &result, &result, mod);
+        if (u256_bit(&exponent, bit)) {
+            mod_mul(&result, &result, a, mod);
+        }
+    }
+    *out = result;
+}
+
+/*** Points ***/
+
+static bool point_is_infinity(const point_t *p) {
+    return u256_is_zero(&p->z);
+}
+
+static void point_double(point_t *out, const point_t *p) {
+    if (point_is_infinity(p) || u256_is_zero(&p->y)) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+
+    u256_t a, b, c, d, e, f, t;
+    mod_mul(&a, &p->x, &p->x, &P);  // A = X^2
+    mod_mul(&b, &p->y, &p->y, &P);  // B = Y^2
+    mod_mul(&c, &b, &b, &P);        // C = B^2
+
+    // D = 2 * ((X + B)^2 - A - C)
+    mod_add(&t, &p->x, &b, &P);
+    mod_mul(&t, &t, &t, &P);
+    mod_sub(&t, &t, &a, &P);
+    mod_sub(&t, &t, &c, &P);
+    mod_add(&d, &t, &t, &P);
+
+    // E = 3 * A, F = E^2
+    mod_add(&e, &a, &a, &P);
+    mod_add(&e, &e, &a, &P);
+    mod_mul(&f, &e, &e, &P);
+
+    // Z3 = 2 * Y * Z, computed first as out may alias p
+    mod_mul(&t, &p->y, &p->z, &P);
+    mod_add(&out->z, &t, &t, &P);
+
+    // X3 = F - 2 * D
+    mod_sub(&out->x, &f, &d, &P);
+    mod_sub(&out->x, &out->x, &d, &P);
+
+    // Y3 = E * (D - X3) - 8 * C
+    mod_sub(&t, &d, &out->x, &P);
+    mod_mul(&t, &e, &t, &P);
+    mod_add(&c, &c, &c, &P);
+    mod_add(&c, &c, &c, &P);
+    mod_add(&c, &c, &c, &P);
+    mod_sub(&out->y, &t, &c, &P);
+}
+
+static void point_add(point_t *out, const point_t *p, const point_t *q) {
+    if (point_is_infinity(p)) {
+        *out = *q;
+        return;
+    }
+    if (point_is_infinity(q)) {
+        *out = *p;
+        return;
+    }
+
+    u256_t z1z1, z2z2, u1, u2, s1, s2, h, r, hh, hhh, t;
+    mod_mul(&z1z1, &p->z, &p->z, &P);
+    mod_mul(&z2z2, &q->z, &q->z, &P);
+    mod_mul(&u1, &p->x, &z2z2, &P);
+    mod_mul(&u2, &q->x, &z1z1, &P);
+    mod_mul(&s1, &p->y, &z2z2, &P);
+    mod_mul(&s1, &s1, &q->z, &P);
+    mod_mul(&s2, &q->y, &z1z1, &P);
+    mod_mul(&s2, &s2, &p->z, &P);
+
+    if (u256_cmp(&u1, &u2) == 0) {
+        if (u256_cmp(&s1, &s2) == 0) {
+            point_double(out, p);
+        } else {
+            memset(out, 0, sizeof(*out));
+        }
+        return;
+    }
+
+    mod_sub(&h, &u2, &u1, &P);
+    mod_sub(&r, &s2, &s1, &P);
+    mod_mul(&hh, &h, &h, &P);
+    mod_mul(&hhh, &hh, &h, &P);
+
+    // Z3 = H * Z1 * Z2
+    mod_mul(&t, &p->z, &q->z, &P);
+    mod_mul(&out->z, &t, &h, &P);
+
+    // X3 = R^2 - H^3 - 2 * U1 * H^2
+    mod_mul(&u1, &u1, &hh, &P);
+    mod_mul(&out->x, &r, &r, &P);
+    mod_sub(&out->x, &out->x, &hhh, &P);
+    mod_sub(&out->x, &out->x, &u1, &P);
+    mod_sub(&out->x, &out->x, &u1, &P);
+
+    // Y3 = R * (U1 * H^2 - X3) - S1 * H^3
+    mod_sub(&t, &u1, &out->x, &P);
+    mod_mul(&t, &r, &t, &P);
+    mod_mul(&s1, &s1, &hhh, &P);
+    mod_sub(&out->y, &t, &s1, &P);
+}
+
+static void point_mul(point_t *out, const u256_t *scalar, const point_t *p) {
+    point_t result;
+    memset(&result, 0, sizeof(result));
+    for (int bit = 255; bit >= 0; bit--) {
+        point_double(&result, &result);
+        if (u256_bit(scalar, bit)) {
+            point_add(&result, &result, p);
+        }
+    }
+    *out = result;
+}
+
+/**
+ * Converts a point that is not the point at infinity to affine coordinates.
+ */
+static void point_to_affine(u256_t *x, u256_t *y, const point_t *p) {
+    u256_t z_inv, z_inv2;
+    mod_inv(&z_inv, &p->z, &P);
+    mod_mul(&z_inv2, &z_inv, &z_inv, &P);
+    mod_mul(x, &p->x, &z_inv2, &P);
+    mod_mul(&z_inv2, &z_inv2, &z_inv, &P);
+    mod_mul(y, &p->y, &z_inv2, &P);
+}
+
+/*** Keys and signatures ***/
+
+static bool is_valid_scalar(const u256_t *a) {
+    return !u256_is_zero(a) && u256_cmp(a, &N.m) < 0;
+}
+
+/**
+ * Interprets a hash as a scalar.
+ */
+static void hash_to_scalar(u256_t *out, const uint8_t hash[static SECP256K1_SCALAR_LEN]) {
+    u256_from_be(out, hash);
+    if (u256_cmp(out, &N.m) >= 0) {
+        u256_sub(out, out, &N.m);
+    }
+}
+
+bool secp256k1_is_valid_scalar(const uint8_t scalar[static SECP256K1_SCALAR_LEN]) {
+    u256_t a;
+    u256_from_be(&a, scalar);
+    return is_valid_scalar(&a);
+}
+
+bool secp256k1_pubkey(const uint8_t private_key[static SECP256K1_SCALAR_LEN],
+                      uint8_t pubkey[static SECP256K1_PUBKEY_LEN]) {
+    u256_t d, x, y;
+    u256_from_be(&d, private_key);
+    if (!is_valid_scalar(&d)) {
+        return false;
+    }
+
+    point_t q;
+    point_mul(&q, &d, &G);
+    point_to_affine(&x, &y, &q);
+
+    pubkey[0] = 0x04;
+    u256_to_be(pubkey + 1, &x);
+    u256_to_be(pubkey + 1 + SECP256K1_SCALAR_LEN, &y);
+    return true;
+}
+
+bool secp256k1_sign(const uint8_t private_key[static SECP256K1_SCALAR_LEN],
+                    const uint8_t nonce[static SECP256K1_SCALAR_LEN],
+                    const uint8_t hash[static SECP256K1_SCALAR_LEN],
+                    uint8_t r[static SECP256K1_SCALAR_LEN],
+                    uint8_t s[static SECP256K1_SCALAR_LEN],
+                    bool *odd_y) {
+    u256_t d, k, z, x, y;
+    u256_from_be(&d, private_key);
+    u256_from_be(&k, nonce);
+    if (!is_valid_scalar(&d) || !is_valid_scalar(&k)) {
+        return false;
+    }
+    hash_to_scalar(&z, hash);
+
+    // r = x(k * G) mod n
+    point_t kg;
+    point_mul(&kg, &k, &G);
+    point_to_affine(&x, &y, &kg);
+    u256_t sig_r = x;
+    if (u256_cmp(&sig_r, &N.m) >= 0) {
+        u256_sub(&sig_r, &sig_r, &N.m);
+    }
+    if (u256_is_zero(&sig_r)) {
+        return false;
+    }
+
+    // s = k^-1 * (z + r * d) mod n
+    u256_t sig_s, k_inv;
+    mod_mul(&sig_s, &sig_r, &d, &N);
+    mod_add(&sig_s, &sig_s, &z, &N);
+    mod_inv(&k_inv, &k, &N);
+    mod_mul(&sig_s, &sig_s, &k_inv, &N);
+    if (u256_is_zero(&sig_s)) {
+        return false;
+    }
+
+    u256_to_be(r, &sig_r);
+    u256_to_be(s, &sig_s);
+    *odd_y = u256_bit(&y, 0);
+    return true;
+}
+
+bool secp256k1_verify(const uint8_t pubkey[static SECP256K1_PUBKEY_LEN],
+                      const uint8_t hash[static SECP256K1_SCALAR_LEN],
+                      const uint8_t r[static SECP256K1_SCALAR_LEN],
+                      const uint8_t s[static SECP256K1_SCALAR_LEN]) {
+    if (pubkey[0] != 0x04) {
+        return false;
+    }
+
+    point_t q = {.z = {{1, 0, 0, 0, 0, 0, 0, 0}}};
+    u256_from_be(&q.x, pubkey + 1);
+    u256_from_be(&q.y, pubkey + 1 + SECP256K1_SCALAR_LEN);
+    if (u256_cmp(&q.x, &P.m) >= 0 || u256_cmp(&q.y, &P.m) >= 0) {
+        return false;
+    }
+
+    // The public key must be on the curve: y^2 = x^3 + 7
+    u256_t lhs, rhs;
+    const u256_t seven = {{7, 0, 0, 0, 0, 0, 0, 0}};
+    mod_mul(&lhs, &q.y, &q.y, &P);
+    mod_mul(&rhs, &q.x, &q.x, &P);
+    mod_mul(&rhs, &rhs, &q.x, &P);
+    mod_add(&rhs, &rhs, &seven, &P);
+    if (u256_cmp(&lhs, &rhs) != 0) {
+        return false;
+    }
+
+    u256_t sig_r, sig_s, z;
+    u256_from_be(&sig_r, r);
+    u256_from_be(&sig_s, s);
+    if (!is_valid_scalar(&sig_r) || !is_valid_scalar(&sig_s)) {
+        return false;
+    }
+    hash_to_scalar(&z, hash);
+
+    // u1 * G + u2 * Q, with u1 = z / s and u2 = r / s
+    u256_t s_inv, u1, u2;
+    mod_inv(&s_inv, &sig_s, &N);
+    mod_mul(&u1, &z, &s_inv, &N);
+    mod_mul(&u2, &sig_r, &s_inv, &N);
+
+    point_t u1g, u2q, sum;
+    point_mul(&u1g, &u1, &G);
+    point_mul(&u2q, &u2, &q);
+    point_add(&sum, &u1g, &u2q);
+    if (point_is_infinity(&sum)) {
+        return false;
+    }
+
+    u256_t x, y;
+    point_to_affine(&x, &y, &sum);
+    if (u256_cmp(&x, &N.m) >= 0) {
+        u256_sub(&x, &x, &N.m);
+    }
+    return u256_cmp(&x, &sig_r) == 0;
+}
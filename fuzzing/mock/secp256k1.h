@@ -0,0 +1,57 @@
+#pragma once
+
+/**
+ * \file Software implementation of the secp256k1 operations needed by the
+ * host mock of the SDK: public keys, and ECDSA signatures and their
+ * verification.
+ *
+ * Written for tests: simple and portable, but neither fast nor constant time.
+ * Must never be used with real keys.
+ */
+
+#include <stdbool.h>  // bool
+#include <stdint.h>   // uint*_t
+
+/** Length of a serialized scalar or coordinate. */
+#define SECP256K1_SCALAR_LEN 32
+/** Length of an uncompressed public key: 0x04, x and y. */
+#define SECP256K1_PUBKEY_LEN 65
+
+/**
+ * Determines whether the given big-endian scalar is a valid private key or
+ * nonce: non-zero and smaller than the order of the curve.
+ */
+bool secp256k1_is_valid_scalar(const uint8_t scalar[static SECP256K1_SCALAR_LEN]);
+
+/**
+ * Computes the uncompressed public key of the given private key.
+ *
+ * @return false if the private key is not valid.
+ */
+bool secp256k1_pubkey(const uint8_t private_key[static SECP256K1_SCALAR_LEN],
+                      uint8_t pubkey[static SECP256K1_PUBKEY_LEN]);
+
+/**
+ * Signs a hash with the given private key and nonce.
+ *
+ * @param[out] odd_y
+ *   Whether the y-coordinate of the nonce point is odd, used to recover the
+ *   public key from the signature.
+ *
+ * @return false if the private key or nonce is not valid, or the signature is
+ * degenerate, in which case another nonce must be used.
+ */
+bool secp256k1_sign(const uint8_t private_key[static SECP256K1_SCALAR_LEN],
+                    const uint8_t nonce[static SECP256K1_SCALAR_LEN],
+                    const uint8_t hash[static SECP256K1_SCALAR_LEN],
+                    uint8_t r[static SECP256K1_SCALAR_LEN],
+                    uint8_t s[static SECP256K1_SCALAR_LEN],
+                    bool *odd_y);
+
+/**
+ * Verifies a signature of a hash against an uncompressed public key.
+ */
+bool secp256k1_verify(const uint8_t pubkey[static SECP256K1_PUBKEY_LEN],
+                      const uint8_t hash[static SECP256K1_SCALAR_LEN],
+                      const uint8_t r[static SECP256K1_SCALAR_LEN],
+                      const uint8_t s[static SECP256K1_SCALAR_LEN]);
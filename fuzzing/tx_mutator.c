@@ -0,0 +1,136 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "write.h"
+
+#include "address.h"
+#include "transaction/types.h"
+#include "well_known.h"
+
+/*
+ * Structure-aware mutator for the transaction parser, linked into
+ * fuzz_tx_parser_structured together with the fuzz target of fuzz_tx_parser.
+ *
+ * Byte-level mutations of a serialized transaction mostly break the RPC length
+ * of the header, and the parser then rejects the input before parsing the RPC.
+ * This mutator mutates the header and the RPC separately, and then writes the
+ * length of the mutated RPC into the header. The memo length of an MPC transfer
+ * with large memo is kept consistent in the same way. A few mutations keep the
+ * lengths inconsistent, such that the checks of the lengths remain covered.
+ *
+ * Besides the byte-level mutations of libFuzzer, the contract address is
+ * replaced by a well known address or an address of another type, and the
+ * first byte of the RPC by a well known shortname or invocation kind.
+ */
+
+/** Byte-level mutation of libFuzzer. */
+size_t LLVMFuzzerMutate(uint8_t *data, size_t size, size_t max_size);
+
+/** Offset of the contract address in the header. */
+#define CONTRACT_ADDRESS_OFFSET (8 + 8 + 8)
+/** Offset of the RPC length in the header. */
+#define RPC_LENGTH_OFFSET (TRANSACTION_HEADER_LEN - 4)
+/** Offset of the memo length in the RPC of an MPC transfer with large memo. */
+#define MPC_MEMO_LENGTH_OFFSET (1 + ADDRESS_LEN + 8)
+
+/** One in this many mutations keeps inconsistent lengths. */
+#define INCONSISTENT_LENGTH_ONE_IN 16
+
+/** Well known first bytes of the RPC. */
+static const uint8_t RPC_FIRST_BYTES[] = {
+    MPC_TOKEN_SHORTNAME_TRANSFER,
+    MPC_TOKEN_SHORTNAME_TRANSFER_MEMO_SMALL,
+    MPC_TOKEN_SHORTNAME_TRANSFER_MEMO_LARGE,
+    ZK_INVOCATION_KIND_SECRET_INPUT_OFF_CHAIN,
+    ZK_INVOCATION_KIND_SECRET_INPUT_ON_CHAIN,
+    ZK_INVOCATION_KIND_OPEN,
+};
+
+typedef enum {
+    MUTATE_HEADER,
+    MUTATE_CONTRACT_ADDRESS,
+    MUTATE_RPC_FIRST_BYTE,
+    MUTATE_RPC,
+    MUTATION_COUNT,
+} mutation_e;
+
+/** Xorshift generator, seeded by libFuzzer. */
+static uint32_t next_random(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static void mutate_contract_address(uint8_t *address, uint32_t *random) {
+    if (next_random(random) % 2 == 0) {
+        const blockchain_address_s mpc_token = MPC_TOKEN_ADDRESS;
+        memcpy(address, mpc_token.raw_bytes, ADDRESS_LEN);
+    } else {
+        address[0] = (uint8_t) (next_random(random) % (BLOCKCHAIN_ADDRESS_CONTRACT_GOVERNANCE + 1));
+    }
+}
+
+/**
+ * Writes the RPC length, and the memo length of an MPC transfer with large
+ * memo, of the transaction of the given size.
+ */
+static void fix_lengths(uint8_t *data, size_t size) {
+    const size_t rpc_len = size - TRANSACTION_HEADER_LEN;
+    const uint8_t *rpc = data + TRANSACTION_HEADER_LEN;
+    write_u32_be(data, RPC_LENGTH_OFFSET, (uint32_t) rpc_len);
+
+    const blockchain_address_s mpc_token = MPC_TOKEN_ADDRESS;
+    if (memcmp(data + CONTRACT_ADDRESS_OFFSET, mpc_token.raw_bytes, ADDRESS_LEN) == 0 &&
+        rpc_len >= MPC_MEMO_LENGTH_OFFSET + 4 && rpc[0] == MPC_TOKEN_SHORTNAME_TRANSFER_MEMO_LARGE) {
+        write_u32_be(data + TRANSACTION_HEADER_LEN,
+                     MPC_MEMO_LENGTH_OFFSET,
+                     (uint32_t) (rpc_len - MPC_MEMO_LENGTH_OFFSET - 4));
+    }
+}
+
+size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size, size_t max_size, unsigned int seed) {
+    if (max_size < TRANSACTION_HEADER_LEN) {
+        return LLVMFuzzerMutate(data, size, max_size);
+    }
+    uint32_t random = seed != 0 ? seed : 1;
+
+    // Inputs shorter than the header are completed with zeroes
+    if (size < TRANSACTION_HEADER_LEN) {
+        memset(data + size, 0, TRANSACTION_HEADER_LEN - size);
+        size = TRANSACTION_HEADER_LEN;
+    }
+    uint8_t *rpc = data + TRANSACTION_HEADER_LEN;
+    size_t rpc_len = size - TRANSACTION_HEADER_LEN;
+
+    switch ((mutation_e) (next_random(&random) % MUTATION_COUNT)) {
+        case MUTATE_HEADER:
+            // Fields before the RPC length, in place. Bytes removed by the
+            // mutation are left as they were.
+            LLVMFuzzerMutate(data, RPC_LENGTH_OFFSET, RPC_LENGTH_OFFSET);
+            break;
+        case MUTATE_CONTRACT_ADDRESS:
+            mutate_contract_address(data + CONTRACT_ADDRESS_OFFSET, &random);
+            break;
+        case MUTATE_RPC_FIRST_BYTE:
+            if (rpc_len == 0 && max_size > TRANSACTION_HEADER_LEN) {
+                rpc_len = 1;
+            }
+            if (rpc_len > 0) {
+                rpc[0] = RPC_FIRST_BYTES[next_random(&random) % sizeof(RPC_FIRST_BYTES)];
+            }
+            break;
+        default:
+            rpc_len = LLVMFuzzerMutate(rpc, rpc_len, max_size - TRANSACTION_HEADER_LEN);
+            break;
+    }
+    size = TRANSACTION_HEADER_LEN + rpc_len;
+
+    if (next_random(&random) % INCONSISTENT_LENGTH_ONE_IN != 0) {
+        fix_lengths(data, size);
+    }
+    return size;
+}
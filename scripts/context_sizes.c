@@ -0,0 +1,39 @@
+/**
+ * Reports the sizes of the components of the global context.
+ *
+ * This file is not part of the application. It is compiled to assembly by
+ * `make context-sizes`, using the same flags as the application, and the sizes
+ * are extracted from the generated assembly. This allows inspecting the RAM
+ * footprint of each component for the selected target, without running
+ * anything on the target.
+ */
+
+#include "types.h"
+
+/**
+ * Emits a marker with the size of the given expression into the generated
+ * assembly.
+ */
+#define REPORT_SIZE(name, size) __asm__ volatile("\n.ascii \"->" name " %0\"" : : "i"(size))
+
+/**
+ * Emits a marker with the size of the given member of global_ctx_t.
+ */
+#define REPORT_MEMBER(member) REPORT_SIZE(#member, sizeof(((global_ctx_t *) 0)->member))
+
+void report_context_sizes(void) {
+    REPORT_SIZE("global_ctx_t", sizeof(global_ctx_t));
+    REPORT_MEMBER(bip32_path);
+    REPORT_MEMBER(pk_info);
+    REPORT_MEMBER(tx_info);
+    REPORT_MEMBER(tx_info.transaction_parser_state);
+    REPORT_MEMBER(tx_info.transaction);
+    REPORT_MEMBER(tx_info.chain_id);
+    REPORT_MEMBER(msg_info);
+    REPORT_MEMBER(digest_state);
+    REPORT_MEMBER(lz_decoder);
+    REPORT_MEMBER(display);
+    REPORT_MEMBER(m_hash);
+    REPORT_MEMBER(signature);
+    REPORT_SIZE("G_tx_templates", TX_TEMPLATE_COUNT * sizeof(tx_template_t));
+}
@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+'''
+Reports the flash and RAM footprint of each object file of the application,
+and compares it against a committed baseline.
+
+The sizes per object are read from the linker map file, split into text,
+rodata, data and bss by the name of the input sections. The totals are read
+from the section headers of the ELF file, such that the report also covers
+sections that are not attributed to an object, such as the stack.
+
+Meant to be run through `make footprint` and `make footprint-baseline`, which
+pass the ELF and map file of the selected device.
+'''
+
+import argparse
+import json
+import re
+import struct
+import sys
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+KINDS = ['text', 'rodata', 'data', 'bss']
+
+# Kinds stored in flash and RAM respectively. Initialized data takes up both.
+FLASH_KINDS = ['text', 'rodata', 'data']
+RAM_KINDS = ['data', 'bss']
+
+Sizes = Dict[str, int]
+
+SHT_NOBITS = 8
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+SHF_EXECINSTR = 0x4
+
+# Input section line of a map file:
+#  .text.app_main  0xc0de02b4       0x58 build/nanos2/obj/app/src/app_main.o
+# Long section names are followed by a line break before the address.
+MAP_SECTION = re.compile(r'^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+
+
+def empty_sizes() -> Sizes:
+    return {kind: 0 for kind in KINDS}
+
+
+def flash(sizes: Sizes) -> int:
+    return sum(sizes[kind] for kind in FLASH_KINDS)
+
+
+def ram(sizes: Sizes) -> int:
+    return sum(sizes[kind] for kind in RAM_KINDS)
+
+
+def kind_of_input_section(name: str) -> Optional[str]:
+    '''
+    Kind of the given input section, or None if it takes up no space on the
+    device.
+    '''
+    for prefix, kind in [('.text', 'text'), ('.rodata', 'rodata'),
+                         ('.data', 'data'), ('.bss', 'bss'),
+                         ('COMMON', 'bss')]:
+        if name == prefix or name.startswith(prefix + '.'):
+            return kind
+    return None
+
+
+def object_name(path: str) -> str:
+    '''
+    Name of an object in reports: the path below the object directory of the
+    build, or the archive member for libraries.
+    '''
+    path = path.strip()
+    if '/obj/' in path:
+        path = path.split('/obj/', 1)[1]
+    return path
+
+
+def read_map(map_path: Path) -> Dict[str, Sizes]:
+    '''
+    Reads the sizes per object from a GNU ld map file.
+    '''
+    objects: Dict[str, Sizes] = {}
+    in_memory_map = False
+    pending_section: Optional[str] = None
+
+    with open(map_path, encoding='utf-8', errors='replace') as map_file:
+        for line in map_file:
+            line = line.rstrip('\n')
+            if not in_memory_map:
+                in_memory_map = line.startswith('Linker script and memory map')
+                continue
+            if line.startswith('/DISCARD/'):
+                break
+
+            match = MAP_SECTION.match(line)
+            if match is None:
+                # A long input section name is on a line of its own
+                stripped = line.strip()
+                pending_section = stripped if line.startswith(' ') and \
+                    ' ' not in stripped and stripped else None
+                continue
+
+            section = match.group(1) or pending_section
+            pending_section = None
+            if section is None:
+                continue
+            kind = kind_of_input_section(section)
+            size = int(match.group(3), 16)
+            if kind is None or size == 0:
+                continue
+
+            sizes = objects.setdefault(object_name(match.group(4)),
+                                       empty_sizes())
+            sizes[kind] += size
+
+    return objects
+
+
+def read_elf_totals(elf_path: Path) -> Sizes:
+    '''
+    Reads the total sizes of the allocated sections of an ELF file.
+    '''
+    data = elf_path.read_bytes()
+    if data[:4] != b'\x7fELF':
+        raise ValueError(f'{elf_path} is not an ELF file')
+    is_64 = data[4] == 2
+    endian = '<' if data[5] == 1 else '>'
+
+    if is_64:
+        shoff, = struct.unpack_from(endian + 'Q', data, 0x28)
+        shentsize, shnum = struct.unpack_from(endian + 'HH', data, 0x3A)
+        header = endian + 'IIQQQQ'
+    else:
+        shoff, = struct.unpack_from(endian + 'I', data, 0x20)
+        shentsize, shnum = struct.unpack_from(endian + 'HH', data, 0x2E)
+        header = endian + 'IIIIII'
+
+    totals = empty_sizes()
+    for index in range(shnum):
+        _, sh_type, sh_flags, _, _, sh_size = struct.unpack_from(
+            header, data, shoff + index * shentsize)
+        if not sh_flags & SHF_ALLOC:
+            continue
+        if sh_type == SHT_NOBITS:
+            kind = 'bss'
+        elif sh_flags & SHF_EXECINSTR:
+            kind = 'text'
+        elif sh_flags & SHF_WRITE:
+            kind = 'data'
+        else:
+            kind = 'rodata'
+        totals[kind] += sh_size
+    return totals
+
+
+def diff(current: Sizes, baseline: Optional[Sizes]) -> Sizes:
+    base = baseline if baseline is not None else empty_sizes()
+    return {kind: current[kind] - base.get(kind, 0) for kind in KINDS}
+
+
+def format_delta(delta: int) -> str:
+    return f'{delta:+d}' if delta else ''
+
+
+def report(objects: Dict[str, Sizes], totals: Sizes,
+           baseline: Optional[dict], tolerance: int) -> List[str]:
+    '''
+    Prints the footprint, compared to the baseline if given, and returns the
+    names of the objects whose flash or RAM footprint grew by more than the
+    tolerance.
+    '''
+    base_objects: Dict[str, Sizes] = baseline['objects'] if baseline else {}
+    base_totals: Optional[Sizes] = baseline['totals'] if baseline else None
+    regressions: List[str] = []
+
+    names = sorted(set(objects) | set(base_objects))
+    width = max([len(name) for name in names] + [len('TOTAL')])
+    print(f'{"object":<{width}} ' +
+          ' '.join(f'{kind:>8} {"delta":>7}' for kind in KINDS) +
+          f' {"flash":>8} {"ram":>7}')
+
+    rows: List[Tuple[str, Sizes, Optional[Sizes]]] = [
+        (name, objects.get(name, empty_sizes()), base_objects.get(name))
+        for name in names
+    ]
+    rows.append(('TOTAL', totals, base_totals))
+
+    for name, sizes, base in rows:
+        delta = diff(sizes, base)
+        flash_delta = flash(delta)
+        ram_delta = ram(delta)
+        regressed = baseline is not None and (flash_delta > tolerance
+                                              or ram_delta > tolerance)
+        if regressed:
+            regressions.append(name)
+        print(f'{name:<{width}} ' +
+              ' '.join(f'{sizes[kind]:>8} {format_delta(delta[kind]):>7}'
+                       for kind in KINDS) +
+              f' {flash(sizes):>8} {ram(sizes):>7}' +
+              (' REGRESSION' if regressed else ''))
+
+    return regressions
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    parser.add_argument('--elf', type=Path, required=True,
+                        help='linked application')
+    parser.add_argument('--map', type=Path, required=True,
+                        help='linker map file of the application')
+    parser.add_argument('--baseline', type=Path, required=True,
+                        help='baseline to compare against, as JSON')
+    parser.add_argument('--update-baseline', action='store_true',
+                        help='write the current footprint to the baseline')
+    parser.add_argument('--tolerance', type=int, default=0,
+                        help='bytes an object may grow before it is flagged')
+    args = parser.parse_args()
+
+    objects = read_map(args.map)
+    totals = read_elf_totals(args.elf)
+
+    if args.update_baseline:
+        args.baseline.parent.mkdir(parents=True, exist_ok=True)
+        with open(args.baseline, 'w', encoding='utf-8') as baseline_file:
+            json.dump({'objects': objects, 'totals': totals}, baseline_file,
+                      indent=2, sort_keys=True)
+            baseline_file.write('\n')
+        print(f'Wrote baseline {args.baseline}')
+        return 0
+
+    if not args.baseline.exists():
+        # Reported anyway, such that the footprint can be read from the log
+        report(objects, totals, None, args.tolerance)
+        print(f'No baseline {args.baseline}, create it with '
+              '`make footprint-baseline`', file=sys.stderr)
+        return 1
+
+    with open(args.baseline, encoding='utf-8') as baseline_file:
+        baseline = json.load(baseline_file)
+
+    regressions = report(objects, totals, baseline, args.tolerance)
+    if regressions:
+        print(f'Footprint grew by more than {args.tolerance} bytes: ' +
+              ', '.join(regressions), file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,4 +1,15 @@
 #!/usr/bin/bash
+# With --parallel, runs the tests of all devices at once, on one emulator per
+# device, or on the given number of emulators per device.
+if [ "$1" = "--parallel" ]; then
+    shift
+    instances=1
+    if [[ "$1" =~ ^[0-9]+$ ]]; then
+        instances=$1
+        shift
+    fi
+    exec python3 "$(dirname "$0")/../tests/parallel_ui_tests.py" --instances "$instances" -- "$@"
+fi
 pytest -v --tb=short --device nanos $@
 pytest -v --tb=short --device nanosp $@
 pytest -v --tb=short --device nanox $@
@@ -29,8 +29,13 @@
 #include "../status_words.h"
 #include "../handler/get_version.h"
 #include "../handler/get_app_name.h"
+#include "../handler/get_chunk_size.h"
 #include "../handler/get_address.h"
 #include "../handler/sign_tx.h"
+#include "../handler/sign_message.h"
+#include "../handler/set_tx_template.h"
+#include "../handler/get_stats.h"
+#include "../handler/get_stack_usage.h"
 
 WARN_UNUSED_RESULT
 int apdu_dispatcher(const command_t *cmd) {
@@ -55,6 +60,12 @@ int apdu_dispatcher(const command_t *cmd) {
             }
 
             return handler_get_app_name();
+        case GET_CHUNK_SIZE:
+            if (cmd->p1 != 0 || cmd->p2 != 0) {
+                return io_send_sw(SW_WRONG_P1P2);
+            }
+
+            return handler_get_chunk_size();
         case GET_ADDRESS:
             if (cmd->p1 > 1 || cmd->p2 > 0) {
                 return io_send_sw(SW_WRONG_P1P2);
@@ -72,7 +83,8 @@ int apdu_dispatcher(const command_t *cmd) {
         case SIGN_TX:
             if (cmd->p1 == P1_FIRST_CHUNK && cmd->p2 != P2_NOT_LAST_CHUNK) {
                 return io_send_sw(SW_WRONG_P1P2);
-            } else if (cmd->p1 != P1_FIRST_CHUNK && cmd->p1 != P1_NOT_FIRST_CHUNK) {
+            } else if (cmd->p1 != P1_FIRST_CHUNK && cmd->p1 != P1_NOT_FIRST_CHUNK &&
+                       cmd->p1 != P1_TEMPLATE_FIRST_CHUNK && cmd->p1 != P1_COMPRESSED_CHUNK) {
                 return io_send_sw(SW_WRONG_P1P2);
             } else if (cmd->p2 != P2_LAST_CHUNK && cmd->p2 != P2_NOT_LAST_CHUNK) {
                 return io_send_sw(SW_WRONG_P1P2);
@@ -86,9 +98,64 @@ int apdu_dispatcher(const command_t *cmd) {
             buf.size = cmd->lc;
             buf.offset = 0;
 
-            bool first_chunk = !((bool) (cmd->p1 & P1_NOT_FIRST_CHUNK));
             bool not_last_chunk = (bool) (cmd->p2 & P2_NOT_LAST_CHUNK);
+            if (cmd->p1 == P1_TEMPLATE_FIRST_CHUNK) {
+                return handler_sign_tx_from_template(&buf, not_last_chunk);
+            } else if (cmd->p1 == P1_COMPRESSED_CHUNK) {
+                return handler_sign_tx_compressed(&buf, not_last_chunk);
+            }
+            bool first_chunk = !((bool) (cmd->p1 & P1_NOT_FIRST_CHUNK));
             return handler_sign_tx(&buf, first_chunk, not_last_chunk);
+        case SIGN_MESSAGE:
+            if (cmd->p1 == P1_FIRST_CHUNK && cmd->p2 != P2_NOT_LAST_CHUNK) {
+                return io_send_sw(SW_WRONG_P1P2);
+            } else if (cmd->p1 != P1_FIRST_CHUNK && cmd->p1 != P1_NOT_FIRST_CHUNK) {
+                return io_send_sw(SW_WRONG_P1P2);
+            } else if (cmd->p2 != P2_LAST_CHUNK && cmd->p2 != P2_NOT_LAST_CHUNK) {
+                return io_send_sw(SW_WRONG_P1P2);
+            }
+
+            if (!cmd->data) {
+                return io_send_sw(SW_WRONG_DATA_LENGTH);
+            }
+
+            buf.ptr = cmd->data;
+            buf.size = cmd->lc;
+            buf.offset = 0;
+
+            return handler_sign_message(&buf,
+                                        !((bool) (cmd->p1 & P1_NOT_FIRST_CHUNK)),
+                                        (bool) (cmd->p2 & P2_NOT_LAST_CHUNK));
+        case SET_TX_TEMPLATE:
+            if (cmd->p2 != 0) {
+                return io_send_sw(SW_WRONG_P1P2);
+            }
+
+            if (!cmd->data) {
+                return io_send_sw(SW_WRONG_DATA_LENGTH);
+            }
+
+            buf.ptr = cmd->data;
+            buf.size = cmd->lc;
+            buf.offset = 0;
+
+            return handler_set_tx_template(&buf, cmd->p1);
+#ifdef HAVE_STATS
+        case GET_STATS:
+            if (cmd->p1 != 0 || cmd->p2 != 0) {
+                return io_send_sw(SW_WRONG_P1P2);
+            }
+
+            return handler_get_stats();
+#endif
+#ifdef HAVE_STACK_USAGE
+        case GET_STACK_USAGE:
+            if (cmd->p1 != 0 || cmd->p2 != 0) {
+                return io_send_sw(SW_WRONG_P1P2);
+            }
+
+            return handler_get_stack_usage();
+#endif
         default:
             return io_send_sw(SW_INS_NOT_SUPPORTED);
     }
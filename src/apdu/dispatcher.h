@@ -6,6 +6,10 @@
 #define P1_FIRST_CHUNK 0x00
 /** SIGN_TX: Parameter 1 to indicate any non-first APDU chunks. */
 #define P1_NOT_FIRST_CHUNK 0x01
+/** SIGN_TX: Parameter 1 to indicate the first APDU chunk, referencing a transaction template. */
+#define P1_TEMPLATE_FIRST_CHUNK 0x02
+/** SIGN_TX: Parameter 1 to indicate a non-first APDU chunk of compressed RPC bytes. */
+#define P1_COMPRESSED_CHUNK 0x03
 /** GET_ADDRESS: Parameter 1 to skip screen confirmation. */
 #define P1_SILENT 0x00
 /** GET_ADDRESS: Parameter 1 for screen confirmation */
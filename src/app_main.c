@@ -18,12 +18,20 @@
 #include "os.h"
 
 #include "globals.h"
+#include "stats.h"
+#include "stack_usage.h"
+#include "constants.h"
 #include "status_words.h"
 #include "ui/menu.h"
 #include "apdu/dispatcher.h"
 
 global_ctx_t G_context;
 
+static uint8_t G_arena_buffer[ARENA_SIZE];
+arena_t G_arena;
+
+tx_template_t G_tx_templates[TX_TEMPLATE_COUNT];
+
 const internal_storage_t N_storage_real;
 
 /**
@@ -34,6 +42,10 @@ void app_main() {
     int input_len = 0;
     // Structured APDU command
     command_t cmd;
+#ifdef HAVE_STACK_USAGE
+    // Instruction of the previous APDU, to attribute its stack usage to
+    uint8_t previous_ins = 0;
+#endif
 
     io_init();
 
@@ -41,6 +53,8 @@ void app_main() {
 
     // Reset context
     explicit_bzero(&G_context, sizeof(G_context));
+    arena_init(&G_arena, G_arena_buffer, sizeof(G_arena_buffer));
+    explicit_bzero(&G_tx_templates, sizeof(G_tx_templates));
 
     // Initialize the NVM data if required
     if (N_storage.initialized != 0x01) {
@@ -56,13 +70,21 @@ void app_main() {
             return;
         }
 
+        STACK_USAGE_RECORD(previous_ins);
+
         // Parse APDU command from G_io_apdu_buffer
         if (!apdu_parser(&cmd, G_io_apdu_buffer, input_len)) {
             io_send_sw(SW_WRONG_DATA_LENGTH);
             continue;
         }
 
+#ifdef HAVE_STACK_USAGE
+        previous_ins = cmd.ins;
+#endif
+        STACK_USAGE_PAINT();
+
         // Dispatch structured APDU command to handler
+        STATS_PHASE(STATS_PHASE_DISPATCH);
         if (apdu_dispatcher(&cmd) < 0) {
             return;
         }
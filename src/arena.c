@@ -0,0 +1,43 @@
+#include <string.h>  // memset, explicit_bzero
+
+#include "arena.h"
+
+#if defined(TEST) || defined(FUZZ)
+#include "assert.h"
+#define LEDGER_ASSERT(x, y) assert(x)
+#else
+#include "ledger_assert.h"
+#endif
+
+void arena_init(arena_t *arena, uint8_t *buffer, size_t capacity) {
+    LEDGER_ASSERT(arena != NULL, "NULL arena");
+    LEDGER_ASSERT(buffer != NULL, "NULL buffer");
+
+    arena->buffer = buffer;
+    arena->capacity = capacity;
+    arena->used = 0;
+    arena->high_water_mark = 0;
+    memset(buffer, 0, capacity);
+}
+
+void arena_reset(arena_t *arena) {
+    explicit_bzero(arena->buffer, arena->used);
+    arena->used = 0;
+}
+
+uint8_t *arena_alloc(arena_t *arena, size_t size) {
+    if (size > arena_available(arena)) {
+        return NULL;
+    }
+
+    uint8_t *allocated = arena->buffer + arena->used;
+    arena->used += size;
+    if (arena->used > arena->high_water_mark) {
+        arena->high_water_mark = arena->used;
+    }
+    return allocated;
+}
+
+size_t arena_available(const arena_t *arena) {
+    return arena->capacity - arena->used;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint*_t
+
+/**
+ * Bump-pointer allocator over a fixed buffer in static RAM.
+ *
+ * Used for the variable-size fields of a request, such that these share a
+ * common budget instead of each reserving space for their worst case. The
+ * arena is reset at the start of every request; there is no way to free
+ * individual allocations.
+ */
+typedef struct {
+    /** Buffer to allocate from. */
+    uint8_t *buffer;
+    /** Size of buffer. */
+    size_t capacity;
+    /** Number of bytes allocated since the last reset. */
+    size_t used;
+    /** Largest number of bytes that have been allocated between two resets. */
+    size_t high_water_mark;
+} arena_t;
+
+/**
+ * Initializes the arena to allocate from the given buffer.
+ */
+void arena_init(arena_t *arena, uint8_t *buffer, size_t capacity);
+
+/**
+ * Frees all allocations of the arena, and clears the allocated memory. The
+ * high water mark is kept.
+ */
+void arena_reset(arena_t *arena);
+
+/**
+ * Allocates size bytes of zeroed memory from the arena.
+ *
+ * Allocations are byte-aligned, and must only be used for byte data.
+ *
+ * @return pointer to allocated memory, or NULL if the arena does not have size
+ * bytes available.
+ */
+uint8_t *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Determines the number of bytes that can still be allocated from the arena.
+ */
+size_t arena_available(const arena_t *arena);
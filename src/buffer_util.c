@@ -45,6 +45,28 @@ bool buffer_read_contract_address(buffer_t *buffer, blockchain_address_s *out) {
     return buffer_read_bytes_precisely(buffer, out->raw_bytes, sizeof(out->raw_bytes));
 }
 
+bool buffer_read_leb128_u32(buffer_t *buffer, uint32_t *out) {
+    uint32_t value = 0;
+    for (uint8_t shift = 0; shift < 32; shift += 7) {
+        uint8_t byte;
+        if (!buffer_read_u8(buffer, &byte)) {
+            return false;
+        }
+
+        // The fifth byte may only contain the upper four bits
+        if (shift == 28 && byte > 0x0f) {
+            return false;
+        }
+
+        value |= ((uint32_t) (byte & 0x7f)) << shift;
+        if ((byte & 0x80) == 0) {
+            *out = value;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool buffer_read_chain_id(buffer_t *buffer, chain_id_t *out) {
     uint32_t chain_id_len;
     if (!buffer_read_u32(buffer, &chain_id_len, BE)) {
@@ -19,6 +19,12 @@ bool buffer_read_bytes_precisely(buffer_t *buffer, uint8_t *out, size_t out_len)
  */
 bool buffer_read_contract_address(buffer_t *buffer, blockchain_address_s *out);
 
+/**
+ * Reads an unsigned LEB128 encoded integer of at most 32 bits from the given
+ * buffer.
+ */
+bool buffer_read_leb128_u32(buffer_t *buffer, uint32_t *out);
+
 /**
  * Reads a chain_id_t from the given buffer.
  */
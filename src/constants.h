@@ -20,7 +20,73 @@
  */
 #define MAX_APPNAME_LEN 64
 
+/**
+ * Length of the header of an APDU command: CLA, INS, P1, P2 and Lc.
+ */
+#define APDU_HEADER_LEN 5
+
+/**
+ * Maximum length of the data of a chunk of a SIGN_TX or SIGN_MESSAGE command
+ * (bytes). Commands are short APDUs, whose data length fits in a single byte,
+ * so chunks are limited to 255 bytes, even on devices with a larger APDU buffer.
+ */
+#define MAX_CHUNK_LEN 255
+
+/**
+ * Preferred granularity of chunk lengths (bytes). The payload of a USB HID
+ * packet, after its channel, tag and sequence number. An APDU whose length
+ * prefix, header and data fill whole packets takes no partially filled packet.
+ */
+#define CHUNK_GRANULARITY (64 - 5)
+
 /**
  * Maximum transaction length (bytes).
  */
 #define MAX_TRANSACTION_LEN 510
+
+/**
+ * Prefix hashed before signed messages, to separate them from transactions.
+ *
+ * The byte at offset 24, where the contract address type of a transaction would
+ * be, is not a valid address type, so no signed message is also a valid
+ * transaction.
+ */
+#define MESSAGE_SIGNING_PREFIX "\x19Partisia Blockchain Signed Message:\n"
+
+/**
+ * Maximum number of message bytes shown as a preview when signing a message.
+ */
+#define MESSAGE_PREVIEW_LENGTH 64
+
+/**
+ * Size of the arena that variable-size fields of a request are allocated from
+ * (bytes).
+ */
+#define ARENA_SIZE 128
+
+/**
+ * Number of transaction templates that can be stored at once.
+ */
+#define TX_TEMPLATE_COUNT 2
+
+/**
+ * Length of the window of the decoder of compressed RPC bytes (bytes). Copies
+ * reach at most this far back. Must be a power of two. The window is part of
+ * the global context, and is shorter on the Nano S, which has the least RAM.
+ * Reported to the host by GET_CHUNK_SIZE.
+ */
+#ifdef TARGET_NANOS
+#define COMPRESSION_WINDOW_LEN 256
+#else
+#define COMPRESSION_WINDOW_LEN 1024
+#endif
+
+/**
+ * Maximum length of an unsigned 64-bit integer formatted as a decimal string.
+ */
+#define PRIu64_MAX_LENGTH 20
+
+/**
+ * Length of the token suffix shown after formatted token amounts.
+ */
+#define TOKEN_SUFFIX_LEN 3
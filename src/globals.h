@@ -2,6 +2,7 @@
 
 #include "io.h"
 #include "types.h"
+#include "arena.h"
 
 /**
  * Global buffer for interactions between SE and MCU.
@@ -23,6 +24,18 @@ extern bolos_ux_params_t G_ux_params;
  */
 extern global_ctx_t G_context;
 
+/**
+ * Global arena for the variable-size fields of user requests. Reset at the
+ * start of every request.
+ */
+extern arena_t G_arena;
+
+/**
+ * Global transaction templates, indexed by template id. Kept across requests,
+ * but not persisted.
+ */
+extern tx_template_t G_tx_templates[TX_TEMPLATE_COUNT];
+
 /**
  * Global structure for NVM data storage.
  */
@@ -32,10 +32,12 @@
 #include "../status_words.h"
 #include "../ui/display.h"
 #include "../helper/send_response.h"
+#include "../stats.h"
 
 WARN_UNUSED_RESULT
 int handler_get_address(buffer_t *cdata, bool display) {
     explicit_bzero(&G_context, sizeof(G_context));
+    arena_reset(&G_arena);
     G_context.req_type = CONFIRM_ADDRESS;
     G_context.state = STATE_NONE;
 
@@ -47,6 +49,7 @@ int handler_get_address(buffer_t *cdata, bool display) {
 
     // Derive public key from path
     uint8_t raw_pubkey[65];
+    STATS_PHASE(STATS_PHASE_DERIVE);
     cx_err_t error = bip32_derive_get_pubkey_256(CX_CURVE_256K1,
                                                  G_context.bip32_path,
                                                  G_context.bip32_path_len,
@@ -65,6 +68,7 @@ int handler_get_address(buffer_t *cdata, bool display) {
 
     // Display or send
     if (display) {
+        STATS_PHASE(STATS_PHASE_UI);
         return ui_display_address();
     }
 
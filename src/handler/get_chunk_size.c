@@ -0,0 +1,46 @@
+/*****************************************************************************
+ *   Ledger App Boilerplate.
+ *   (c) 2020 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+#include <stdint.h>  // uint*_t
+#include <assert.h>  // _Static_assert
+
+#include "io.h"
+#include "write.h"
+
+#include "get_chunk_size.h"
+#include "../constants.h"
+#include "../status_words.h"
+
+/**
+ * Length of the response: buffer size, maximum chunk length, granularity and
+ * window length of compressed chunks.
+ */
+#define CHUNK_SIZE_RESPONSE_LEN (2 + 2 + 2 + 2)
+
+WARN_UNUSED_RESULT
+int handler_get_chunk_size(void) {
+    _Static_assert(MAX_CHUNK_LEN <= IO_APDU_BUFFER_SIZE - APDU_HEADER_LEN,
+                   "Chunks must fit in the APDU buffer!");
+
+    uint8_t response[CHUNK_SIZE_RESPONSE_LEN];
+    write_u16_be(response, 0, IO_APDU_BUFFER_SIZE);
+    write_u16_be(response, 2, MAX_CHUNK_LEN);
+    write_u16_be(response, 4, CHUNK_GRANULARITY);
+    write_u16_be(response, 6, COMPRESSION_WINDOW_LEN);
+
+    return io_send_response_pointer(response, sizeof(response), SW_OK);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+/**
+ * Handler for GET_CHUNK_SIZE command. Send APDU response with the size of the
+ * APDU buffer, the maximum length of the data of a chunk, the preferred
+ * granularity of chunk lengths, and the window length of compressed chunks.
+ *
+ * @see MAX_CHUNK_LEN, CHUNK_GRANULARITY and COMPRESSION_WINDOW_LEN in
+ * constants.h.
+ *
+ * @return zero or positive integer if success, negative integer otherwise.
+ *
+ */
+WARN_UNUSED_RESULT
+int handler_get_chunk_size(void);
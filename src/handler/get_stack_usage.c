@@ -0,0 +1,51 @@
+/*****************************************************************************
+ *   Ledger App Boilerplate.
+ *   (c) 2020 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+#ifdef HAVE_STACK_USAGE
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint*_t
+
+#include "io.h"
+#include "write.h"
+
+#include "get_stack_usage.h"
+#include "../stack_usage.h"
+#include "../status_words.h"
+
+/** Length of the serialized high-water marks. */
+#define STACK_USAGE_RESPONSE_LEN (4 + 1 + 5 * STACK_USAGE_INS_COUNT)
+
+WARN_UNUSED_RESULT
+int handler_get_stack_usage(void) {
+    uint8_t response[STACK_USAGE_RESPONSE_LEN];
+    size_t offset = 0;
+
+    write_u32_be(response, offset, stack_usage_size());
+    offset += 4;
+
+    response[offset++] = STACK_USAGE_INS_COUNT;
+    for (uint8_t ins = STACK_USAGE_INS_MIN; ins <= STACK_USAGE_INS_MAX; ins++) {
+        response[offset++] = ins;
+        write_u32_be(response, offset, stack_usage_high_water(ins));
+        offset += 4;
+    }
+
+    return io_send_response_pointer(response, offset, SW_OK);
+}
+
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+#ifdef HAVE_STACK_USAGE
+
+/**
+ * Handler for GET_STACK_USAGE command. Send APDU response with the size of the
+ * stack and the deepest stack usage measured for each instruction.
+ *
+ * @see stack_usage_record
+ *
+ * @return zero or positive integer if success, negative integer otherwise.
+ *
+ */
+WARN_UNUSED_RESULT
+int handler_get_stack_usage(void);
+
+#endif
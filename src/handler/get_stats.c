@@ -0,0 +1,60 @@
+/*****************************************************************************
+ *   Ledger App Boilerplate.
+ *   (c) 2020 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+#ifdef HAVE_STATS
+
+#include <stddef.h>  // size_t
+#include <stdint.h>  // uint*_t
+
+#include "io.h"
+#include "write.h"
+
+#include "get_stats.h"
+#include "../stats.h"
+#include "../status_words.h"
+
+/** Length of the serialized counters. */
+#define STATS_RESPONSE_LEN (1 + 4 * STATS_PHASE_COUNT + 1 + 2 * 4 * STATS_PARSER_STATUS_COUNT)
+
+WARN_UNUSED_RESULT
+int handler_get_stats(void) {
+    // Serialize counters
+    uint8_t response[STATS_RESPONSE_LEN];
+    size_t offset = 0;
+
+    response[offset++] = STATS_PHASE_COUNT;
+    for (size_t i = 0; i < STATS_PHASE_COUNT; i++) {
+        write_u32_be(response, offset, G_stats.phases[i]);
+        offset += 4;
+    }
+
+    response[offset++] = STATS_PARSER_STATUS_COUNT;
+    for (size_t i = 0; i < STATS_PARSER_STATUS_COUNT; i++) {
+        write_u32_be(response, offset, G_stats.parser_status[i]);
+        offset += 4;
+    }
+    for (size_t i = 0; i < STATS_PARSER_STATUS_COUNT; i++) {
+        write_u32_be(response, offset, G_stats.blind_fallback[i]);
+        offset += 4;
+    }
+
+    stats_reset();
+
+    return io_send_response_pointer(response, offset, SW_OK);
+}
+
+#endif
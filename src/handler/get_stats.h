@@ -0,0 +1,17 @@
+#pragma once
+
+#ifdef HAVE_STATS
+
+/**
+ * Handler for GET_STATS command. Send APDU response with the instrumentation
+ * counters, and reset them.
+ *
+ * @see G_stats
+ *
+ * @return zero or positive integer if success, negative integer otherwise.
+ *
+ */
+WARN_UNUSED_RESULT
+int handler_get_stats(void);
+
+#endif
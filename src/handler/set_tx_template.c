@@ -0,0 +1,80 @@
+/*****************************************************************************
+ *   Ledger App Boilerplate.
+ *   (c) 2020 Ledger SAS.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+#include <stdint.h>   // uint*_t
+#include <stdbool.h>  // bool
+#include <stddef.h>   // size_t
+#include <string.h>   // memcpy, explicit_bzero
+
+#include "io.h"  // io_send_sw
+#include "buffer.h"
+
+#include "set_tx_template.h"
+#include "../constants.h"
+#include "../status_words.h"
+#include "../globals.h"
+#include "../buffer_util.h"
+
+WARN_UNUSED_RESULT
+int handler_set_tx_template(buffer_t *cdata, uint8_t template_id) {
+    // Templates are not reviewed when set, as every field of a template is
+    // shown to the user when signing a transaction with it.
+
+    if (template_id >= TX_TEMPLATE_COUNT) {
+        return io_send_sw(SW_WRONG_P1P2);
+    }
+
+    tx_template_t tx_template;
+    explicit_bzero(&tx_template, sizeof(tx_template));
+
+    // Read length of BIP-32 path
+    if (!buffer_read_u8(cdata, &tx_template.bip32_path_len)) {
+        return io_send_sw(SW_WRONG_DATA_LENGTH);
+    }
+
+    // Read BIP-32 path
+    if (!buffer_read_bip32_path(cdata,
+                                tx_template.bip32_path,
+                                (size_t) tx_template.bip32_path_len)) {
+        return io_send_sw(SW_WRONG_DATA_LENGTH);
+    }
+
+    // Read chain id
+    if (!buffer_read_chain_id(cdata, &tx_template.chain_id)) {
+        return io_send_sw(SW_INVALID_CHAIN_ID);
+    }
+
+    // Read gas cost
+    if (!buffer_read_u64(cdata, &tx_template.gas_cost, BE)) {
+        return io_send_sw(SW_WRONG_DATA_LENGTH);
+    }
+
+    // Read contract address
+    if (!buffer_read_contract_address(cdata, &tx_template.contract_address)) {
+        return io_send_sw(SW_WRONG_DATA_LENGTH);
+    }
+
+    if (cdata->offset != cdata->size) {
+        return io_send_sw(SW_WRONG_DATA_LENGTH);
+    }
+
+    // Only replace the stored template once the entire template has been read
+    tx_template.is_set = true;
+    memcpy(&G_tx_templates[template_id], &tx_template, sizeof(tx_template));
+
+    return io_send_sw(SW_OK);
+}
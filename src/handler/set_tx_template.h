@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>  // uint*_t
+
+#include "buffer.h"
+
+/**
+ * Handler for SET_TX_TEMPLATE command. If successfully parse BIP32 path, chain
+ * id, gas cost and contract address, store them as the transaction template
+ * with the given id, and send APDU response.
+ *
+ * @see G_tx_templates
+ *
+ * @param[in,out] cdata
+ *   Command data with BIP32 path, chain id, gas cost and contract address.
+ * @param[in]     template_id
+ *   Id of the template to set.
+ *
+ * @return zero or positive integer if success, negative integer otherwise.
+ *
+ */
+WARN_UNUSED_RESULT
+int handler_set_tx_template(buffer_t *cdata, uint8_t template_id);
@@ -0,0 +1,135 @@
+#include <stdint.h>   // uint*_t
+#include <stdbool.h>  // bool
+#include <stddef.h>   // size_t
+#include <string.h>   // memcpy, explicit_bzero
+
+#include "io.h"  // io_send_sw
+#include "os.h"
+#include "cx.h"
+#include "buffer.h"
+#include "write.h"
+
+#include "sign_message.h"
+#include "../constants.h"
+#include "../status_words.h"
+#include "../globals.h"
+#include "../ui/display.h"
+#include "../stats.h"
+
+/**
+ * Adds the given bytes to the message hash.
+ *
+ * @return true if successful, false otherwise.
+ */
+WARN_UNUSED_RESULT
+static bool hash_update(const uint8_t *data, size_t data_len) {
+    return cx_hash_update((cx_hash_t *) &G_context.digest_state, data, data_len) == CX_OK;
+}
+
+WARN_UNUSED_RESULT
+int handler_sign_message(buffer_t *chunk_data,
+                         bool first_chunk,
+                         bool anymore_blocks_after_this_one) {
+    // The message is never stored in full. Each chunk is added to the hash as it
+    // arrives, and only the first MESSAGE_PREVIEW_LENGTH bytes are kept for
+    // display.
+    //
+    // Signed hash: SHA256(MESSAGE_SIGNING_PREFIX || u32 length || message)
+
+    // first chunk, parse BIP32 path and message length
+    if (first_chunk) {
+        explicit_bzero(&G_context, sizeof(G_context));
+        arena_reset(&G_arena);
+        G_context.req_type = CONFIRM_MESSAGE;
+        G_context.state = STATE_NONE;
+
+        // Read length of BIP-32 path
+        if (!buffer_read_u8(chunk_data, &G_context.bip32_path_len)) {
+            return io_send_sw(SW_WRONG_DATA_LENGTH);
+        }
+
+        // Read BIP-32 path
+        if (!buffer_read_bip32_path(chunk_data,
+                                    G_context.bip32_path,
+                                    (size_t) G_context.bip32_path_len)) {
+            return io_send_sw(SW_WRONG_DATA_LENGTH);
+        }
+
+        // Read message length
+        if (!buffer_read_u32(chunk_data, &G_context.msg_info.length, BE)) {
+            return io_send_sw(SW_WRONG_DATA_LENGTH);
+        }
+
+        // Message chunks must be non-empty, so an empty message cannot be sent
+        if (G_context.msg_info.length == 0) {
+            return io_send_sw(SW_WRONG_MESSAGE_LENGTH);
+        }
+
+        G_context.msg_info.preview = arena_alloc(&G_arena, MESSAGE_PREVIEW_LENGTH);
+        if (G_context.msg_info.preview == NULL) {
+            return io_send_sw(SW_BAD_STATE);
+        }
+
+        // Initial hashing context, with the domain separating prefix and length
+        uint8_t length_bytes[4];
+        write_u32_be(length_bytes, 0, G_context.msg_info.length);
+        if (cx_hash_init((cx_hash_t *) &G_context.digest_state, CX_SHA256) != CX_OK ||
+            !hash_update((const uint8_t *) MESSAGE_SIGNING_PREFIX,
+                         sizeof(MESSAGE_SIGNING_PREFIX) - 1) ||
+            !hash_update(length_bytes, sizeof(length_bytes))) {
+            return io_send_sw(SW_TX_HASH_FAIL);
+        }
+
+        return io_send_sw(SW_OK);
+
+        // message chunk
+    } else {
+        // Check that state is consistent
+        if (G_context.req_type != CONFIRM_MESSAGE || G_context.state != STATE_NONE) {
+            return io_send_sw(SW_BAD_STATE);
+        }
+
+        // Check that the chunk fits within the announced length
+        const uint8_t *chunk = chunk_data->ptr + chunk_data->offset;
+        size_t chunk_len = chunk_data->size - chunk_data->offset;
+        if (chunk_len > G_context.msg_info.length - G_context.msg_info.received) {
+            return io_send_sw(SW_WRONG_MESSAGE_LENGTH);
+        }
+
+        // Keep the start of the message for the preview
+        if (G_context.msg_info.received < MESSAGE_PREVIEW_LENGTH) {
+            size_t preview_len = MESSAGE_PREVIEW_LENGTH - G_context.msg_info.received;
+            if (preview_len > chunk_len) {
+                preview_len = chunk_len;
+            }
+            memcpy(G_context.msg_info.preview + G_context.msg_info.received, chunk, preview_len);
+        }
+
+        // Update hash digest
+        STATS_PHASE(STATS_PHASE_HASH);
+        if (!hash_update(chunk, chunk_len)) {
+            return io_send_sw(SW_TX_HASH_FAIL);
+        }
+        G_context.msg_info.received += chunk_len;
+
+        if (anymore_blocks_after_this_one) {
+            return io_send_sw(SW_OK);
+        }
+
+        // Check that the entire message was received
+        if (G_context.msg_info.received != G_context.msg_info.length) {
+            return io_send_sw(SW_WRONG_MESSAGE_LENGTH);
+        }
+
+        // Finalize hash
+        if (cx_hash_final((cx_hash_t *) &G_context.digest_state, G_context.m_hash) != CX_OK) {
+            return io_send_sw(SW_TX_HASH_FAIL);
+        }
+
+        G_context.state = STATE_PARSED;
+
+        // We finally have enough information to display UI.
+        STATS_PHASE(STATS_PHASE_UI);
+        return ui_display_message();
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>   // uint*_t
+#include <stdbool.h>  // bool
+
+#include "buffer.h"
+
+/**
+ * Handler for SIGN_MESSAGE command. Streams the message into the message hash,
+ * and when the entire message has been received, displays it for the user to
+ * sign.
+ *
+ * @see G_context.bip32_path, G_context.msg_info, G_context.m_hash and
+ * G_context.signature.
+ *
+ * @param[in,out] chunk_data
+ *   Command data with BIP32 path and message length for the first chunk, and
+ *   message data for the following chunks.
+ * @param[in]     first_chunk
+ *   Whether this chunk is the first
+ * @param[in]     anymore_blocks_after_this_one
+ *   Whether there will continue to arrive chunks after this one.
+ *
+ * @return zero or positive integer if success, negative integer otherwise.
+ *
+ */
+WARN_UNUSED_RESULT
+int handler_sign_message(buffer_t *chunk_data,
+                         bool first_chunk,
+                         bool anymore_blocks_after_this_one);
@@ -18,20 +18,157 @@
 #include <stdint.h>   // uint*_t
 #include <stdbool.h>  // bool
 #include <stddef.h>   // size_t
-#include <string.h>   // memset, explicit_bzero
+#include <string.h>   // memcpy, explicit_bzero
 
 #include "io.h"  // io_send_sw
 #include "os.h"
 #include "cx.h"
 #include "buffer.h"
+#include "write.h"
 
 #include "sign_tx.h"
+#include "../constants.h"
 #include "../status_words.h"
 #include "../globals.h"
 #include "../ui/display.h"
 #include "../buffer_util.h"
 #include "../transaction/types.h"
 #include "../transaction/deserialize.h"
+#include "../lz_decoder.h"
+#include "../stats.h"
+
+/**
+ * Resets the global context in preparation for a new transaction.
+ */
+static void start_transaction(void) {
+    explicit_bzero(&G_context, sizeof(G_context));
+    arena_reset(&G_arena);
+    G_context.req_type = CONFIRM_TRANSACTION;
+    G_context.state = STATE_NONE;
+    transaction_parser_init(&G_context.tx_info.transaction_parser_state, &G_arena);
+}
+
+/**
+ * Parses and digests bytes of the transaction.
+ *
+ * @param[in,out] status_parsing
+ *   Set to the status of the parser after the bytes.
+ *
+ * @return SW_OK if successful, the status word to respond with otherwise.
+ */
+WARN_UNUSED_RESULT
+static uint16_t digest_transaction_bytes(buffer_t *chunk_data, parser_status_e *status_parsing) {
+    // Update parsing state
+    STATS_PHASE(STATS_PHASE_PARSE);
+    *status_parsing = transaction_parser_update(&G_context.tx_info.transaction_parser_state,
+                                                chunk_data,
+                                                &G_context.tx_info.transaction);
+    STATS_PARSER_STATUS(*status_parsing);
+
+    if (*status_parsing < 0) {
+        return SW_TX_PARSING_FAIL | -*status_parsing;
+    } else if (*status_parsing == PARSING_DONE && chunk_data->offset != chunk_data->size) {
+        // Transaction parser is done, but there is more data to process.
+        return SW_TX_PARSING_FAIL_EXPECTED_LESS_DATA;
+    }
+
+    // Update hash digest
+    STATS_PHASE(STATS_PHASE_HASH);
+    cx_err_t status_hashing =
+        cx_hash_update((cx_hash_t *) &G_context.digest_state, chunk_data->ptr, chunk_data->size);
+
+    if (status_hashing != CX_OK) {
+        return SW_TX_HASH_FAIL;
+    }
+    return SW_OK;
+}
+
+/**
+ * Responds to a chunk of the transaction whose bytes have been digested, and
+ * displays the transaction when the last chunk has been received.
+ */
+WARN_UNUSED_RESULT
+static int end_transaction_chunk(parser_status_e status_parsing,
+                                 bool anymore_blocks_after_this_one) {
+    if (status_parsing == PARSING_CONTINUE && !anymore_blocks_after_this_one) {
+        // Transaction parser expected more data, but there is no more data.
+        return io_send_sw(SW_TX_PARSING_FAIL_EXPECTED_MORE_DATA);
+    } else if (status_parsing == PARSING_DONE && anymore_blocks_after_this_one) {
+        // Transaction parser is done, but there is more data to process.
+        return io_send_sw(SW_TX_PARSING_FAIL_EXPECTED_LESS_DATA);
+    }
+
+    if (anymore_blocks_after_this_one) {
+        // anymore_blocks_after_this_one APDUs with transaction part are expected.
+        // Send a SW_OK to signal that we have received the chunk
+        return io_send_sw(SW_OK);
+    }
+
+    G_context.state = STATE_PARSED;
+
+    // Add chain id to hash
+    uint8_t CHAIN_ID_PREFIX[4] = {0, 0, 0, G_context.tx_info.chain_id.length};
+    cx_err_t status_hashing = cx_hash_update((cx_hash_t *) &G_context.digest_state,
+                                             (uint8_t *) CHAIN_ID_PREFIX,
+                                             sizeof(CHAIN_ID_PREFIX));
+    if (status_hashing != CX_OK) {
+        return io_send_sw(SW_TX_HASH_FAIL);
+    }
+    status_hashing = cx_hash_update((cx_hash_t *) &G_context.digest_state,
+                                    G_context.tx_info.chain_id.raw_bytes,
+                                    G_context.tx_info.chain_id.length);
+    if (status_hashing != CX_OK) {
+        return io_send_sw(SW_TX_HASH_FAIL);
+    }
+
+    // Finalize hash
+    status_hashing = cx_hash_final((cx_hash_t *) &G_context.digest_state, G_context.m_hash);
+    if (status_hashing != CX_OK) {
+        return io_send_sw(SW_TX_HASH_FAIL);
+    }
+
+    if (G_context.tx_info.transaction.type == GENERIC_TRANSACTION) {
+        STATS_BLIND_FALLBACK(G_context.tx_info.transaction.rpc_parsing_error);
+    }
+
+    // We finally have enough information to display UI.
+    STATS_PHASE(STATS_PHASE_UI);
+    return ui_display_transaction();
+}
+
+/**
+ * Parses and digests a chunk of the transaction, and displays the transaction
+ * when the last chunk has been received.
+ */
+WARN_UNUSED_RESULT
+static int process_transaction_chunk(buffer_t *chunk_data, bool anymore_blocks_after_this_one) {
+    parser_status_e status_parsing;
+    uint16_t sw = digest_transaction_bytes(chunk_data, &status_parsing);
+    if (sw != SW_OK) {
+        return io_send_sw(sw);
+    }
+    return end_transaction_chunk(status_parsing, anymore_blocks_after_this_one);
+}
+
+/**
+ * State of the sink of the decompressed bytes of a chunk.
+ */
+typedef struct {
+    /** Status word of the first failure, SW_OK if none. */
+    uint16_t sw;
+    /** Status of the parser after the last decompressed bytes. */
+    parser_status_e status_parsing;
+} decompressed_sink_t;
+
+/**
+ * Parses and digests decompressed bytes of the transaction.
+ */
+static bool digest_decompressed_bytes(void *context, const uint8_t *data, size_t size) {
+    decompressed_sink_t *sink = (decompressed_sink_t *) context;
+    buffer_t decompressed = {.ptr = data, .size = size, .offset = 0};
+    sink->sw = digest_transaction_bytes(&decompressed, &sink->status_parsing);
+    return sink->sw == SW_OK;
+}
 
 WARN_UNUSED_RESULT
 int handler_sign_tx(buffer_t *chunk_data, bool first_chunk, bool anymore_blocks_after_this_one) {
@@ -46,9 +183,7 @@ int handler_sign_tx(buffer_t *chunk_data, bool first_chunk, bool anymore_blocks_
 
     // first chunk, parse BIP32 path
     if (first_chunk) {
-        explicit_bzero(&G_context, sizeof(G_context));
-        G_context.req_type = CONFIRM_TRANSACTION;
-        G_context.state = STATE_NONE;
+        start_transaction();
 
         // Read length of BIP-32 path
         if (!buffer_read_u8(chunk_data, &G_context.bip32_path_len)) {
@@ -68,7 +203,7 @@ int handler_sign_tx(buffer_t *chunk_data, bool first_chunk, bool anymore_blocks_
         }
 
         // Initial hashing context in preparation
-        if (cx_hash_init((cx_hash_t *) &G_context.tx_info.digest_state, CX_SHA256) != CX_OK) {
+        if (cx_hash_init((cx_hash_t *) &G_context.digest_state, CX_SHA256) != CX_OK) {
             return io_send_sw(SW_TX_HASH_FAIL);
         }
 
@@ -76,67 +211,120 @@ int handler_sign_tx(buffer_t *chunk_data, bool first_chunk, bool anymore_blocks_
 
         // parse transaction chunk
     } else {
-        // Check that state is consistent
-        if (G_context.req_type != CONFIRM_TRANSACTION) {
+        // Check that state is consistent. Once the RPC is compressed, it stays
+        // compressed until the last chunk.
+        if (G_context.req_type != CONFIRM_TRANSACTION || G_context.tx_info.rpc_compressed) {
             return io_send_sw(SW_BAD_STATE);
         }
 
-        // Update parsing state
-        parser_status_e status_parsing =
-            transaction_parser_update(&G_context.tx_info.transaction_parser_state,
-                                      chunk_data,
-                                      &G_context.tx_info.transaction);
-
-        if (status_parsing < 0) {
-            return io_send_sw(SW_TX_PARSING_FAIL | -status_parsing);
-        } else if (status_parsing == PARSING_CONTINUE && !anymore_blocks_after_this_one) {
-            // Transaction parser expected more data, but there is no more data.
-            return io_send_sw(SW_TX_PARSING_FAIL_EXPECTED_MORE_DATA);
-        } else if (status_parsing == PARSING_DONE && anymore_blocks_after_this_one) {
-            // Transaction parser is done, but there is more data to process.
-            return io_send_sw(SW_TX_PARSING_FAIL_EXPECTED_LESS_DATA);
-        }
+        return process_transaction_chunk(chunk_data, anymore_blocks_after_this_one);
+    }
+}
 
-        // Update hash digest
-        cx_err_t status_hashing = cx_hash_update((cx_hash_t *) &G_context.tx_info.digest_state,
-                                                 chunk_data->ptr,
-                                                 chunk_data->size);
+/**
+ * Ends the transaction after a compressed chunk that failed. The decoder and
+ * the parser cannot resume after a failure, so the context is cleared, and the
+ * chunks that follow are rejected with SW_BAD_STATE.
+ */
+WARN_UNUSED_RESULT
+static int abort_compressed_transaction(uint16_t sw) {
+    explicit_bzero(&G_context, sizeof(G_context));
+    return io_send_sw(sw);
+}
 
-        if (status_hashing != CX_OK) {
-            return io_send_sw(SW_TX_HASH_FAIL);
-        }
+WARN_UNUSED_RESULT
+int handler_sign_tx_compressed(buffer_t *chunk_data, bool anymore_blocks_after_this_one) {
+    // Compressed chunks continue the RPC after the transaction chunks that the
+    // parser has already seen. The RPC is digested as if it had been sent
+    // decompressed, so the signature does not depend on the compression.
+    transaction_parsing_state_t *parser_state = &G_context.tx_info.transaction_parser_state;
+    if (G_context.req_type != CONFIRM_TRANSACTION || G_context.state != STATE_NONE ||
+        !parser_state->rpc_parsing_attempted) {
+        return io_send_sw(SW_BAD_STATE);
+    }
 
-        if (anymore_blocks_after_this_one) {
-            // anymore_blocks_after_this_one APDUs with transaction part are expected.
-            // Send a SW_OK to signal that we have received the chunk
-            return io_send_sw(SW_OK);
-        }
+    if (!G_context.tx_info.rpc_compressed) {
+        G_context.tx_info.rpc_compressed = true;
+        lz_decoder_init(&G_context.lz_decoder);
+    }
 
-        G_context.state = STATE_PARSED;
+    // The parser status if no bytes are decompressed from this chunk
+    decompressed_sink_t sink = {
+        .sw = SW_OK,
+        .status_parsing = parser_state->rpc_bytes_parsed == parser_state->rpc_bytes_total
+                              ? PARSING_DONE
+                              : PARSING_CONTINUE,
+    };
+    lz_decode_status_e status_decoding =
+        lz_decoder_update(&G_context.lz_decoder, chunk_data, digest_decompressed_bytes, &sink);
+    if (status_decoding == LZ_DECODE_ABORTED) {
+        return abort_compressed_transaction(sink.sw);
+    } else if (status_decoding != LZ_DECODE_OK ||
+               (!anymore_blocks_after_this_one &&
+                !lz_decoder_at_token_boundary(&G_context.lz_decoder))) {
+        return abort_compressed_transaction(SW_TX_DECOMPRESSION_FAIL);
+    }
 
-        // Add chain id to hash
-        uint8_t CHAIN_ID_PREFIX[4] = {0, 0, 0, G_context.tx_info.chain_id.length};
-        status_hashing = cx_hash_update((cx_hash_t *) &G_context.tx_info.digest_state,
-                                        (uint8_t *) CHAIN_ID_PREFIX,
-                                        sizeof(CHAIN_ID_PREFIX));
-        if (status_hashing != CX_OK) {
-            return io_send_sw(SW_TX_HASH_FAIL);
-        }
-        status_hashing = cx_hash_update((cx_hash_t *) &G_context.tx_info.digest_state,
-                                        G_context.tx_info.chain_id.raw_bytes,
-                                        G_context.tx_info.chain_id.length);
-        if (status_hashing != CX_OK) {
-            return io_send_sw(SW_TX_HASH_FAIL);
-        }
+    return end_transaction_chunk(sink.status_parsing, anymore_blocks_after_this_one);
+}
 
-        // Finalize hash
-        status_hashing =
-            cx_hash_final((cx_hash_t *) &G_context.tx_info.digest_state, G_context.tx_info.m_hash);
-        if (status_hashing != CX_OK) {
-            return io_send_sw(SW_TX_HASH_FAIL);
-        }
+WARN_UNUSED_RESULT
+int handler_sign_tx_from_template(buffer_t *chunk_data, bool anymore_blocks_after_this_one) {
+    // The first chunk references a template, and contains the fields of the
+    // header that are not part of the template. The header is reconstructed
+    // from these and the template, before being parsed and digested as if it
+    // had been sent by the client.
 
-        // We finally have enough information to display UI.
-        return ui_display_transaction();
+    start_transaction();
+
+    // Read template id
+    uint8_t template_id;
+    if (!buffer_read_u8(chunk_data, &template_id)) {
+        return io_send_sw(SW_WRONG_DATA_LENGTH);
+    }
+    if (template_id >= TX_TEMPLATE_COUNT || !G_tx_templates[template_id].is_set) {
+        return io_send_sw(SW_UNKNOWN_TX_TEMPLATE);
+    }
+    const tx_template_t *tx_template = &G_tx_templates[template_id];
+
+    // BIP-32 path and chain id from template
+    G_context.bip32_path_len = tx_template->bip32_path_len;
+    memcpy(G_context.bip32_path, tx_template->bip32_path, sizeof(G_context.bip32_path));
+    memcpy(&G_context.tx_info.chain_id, &tx_template->chain_id, sizeof(chain_id_t));
+
+    // Reconstruct header: nonce and valid-to time, gas cost, contract address, RPC length
+    uint8_t header[TRANSACTION_HEADER_LEN];
+    if (!buffer_read_bytes_precisely(chunk_data, header, 8 + 8)) {
+        return io_send_sw(SW_WRONG_DATA_LENGTH);
+    }
+    write_u64_be(header, 16, tx_template->gas_cost);
+    memcpy(header + 24, tx_template->contract_address.raw_bytes, ADDRESS_LEN);
+    if (!buffer_read_bytes_precisely(chunk_data, header + 24 + ADDRESS_LEN, 4)) {
+        return io_send_sw(SW_WRONG_DATA_LENGTH);
     }
+
+    // Parse and digest header
+    buffer_t header_chunk = {.ptr = header, .size = sizeof(header), .offset = 0};
+    parser_status_e status_parsing =
+        transaction_parser_update_header(&G_context.tx_info.transaction_parser_state,
+                                         &header_chunk,
+                                         &G_context.tx_info.transaction);
+    if (status_parsing < 0) {
+        return io_send_sw(SW_TX_PARSING_FAIL | -status_parsing);
+    }
+
+    if (cx_hash_init((cx_hash_t *) &G_context.digest_state, CX_SHA256) != CX_OK ||
+        cx_hash_update((cx_hash_t *) &G_context.digest_state, header, sizeof(header)) != CX_OK) {
+        return io_send_sw(SW_TX_HASH_FAIL);
+    }
+
+    // RPC starts in the next chunk
+    buffer_t rpc_chunk = {.ptr = chunk_data->ptr + chunk_data->offset,
+                          .size = chunk_data->size - chunk_data->offset,
+                          .offset = 0};
+    if (rpc_chunk.size == 0 && anymore_blocks_after_this_one) {
+        return io_send_sw(SW_OK);
+    }
+
+    return process_transaction_chunk(&rpc_chunk, anymore_blocks_after_this_one);
 }
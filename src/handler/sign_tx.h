@@ -10,7 +10,7 @@
  * and transaction, sign transaction and send APDU response.
  *
  * @see G_context.bip32_path, G_context.tx_info.raw_transaction,
- * G_context.tx_info.signature and G_context.tx_info.v.
+ * G_context.signature and G_context.tx_info.v.
  *
  * @param[in,out] chunk_data
  *   Command data with BIP32 path and raw transaction serialized.
@@ -25,3 +25,42 @@
  */
 WARN_UNUSED_RESULT
 int handler_sign_tx(buffer_t *chunk_data, bool first_chunk, bool anymore_blocks_after_this_one);
+
+/**
+ * Handler for the first chunk of a SIGN_TX command referencing a transaction
+ * template. The BIP32 path, chain id, gas cost and contract address are taken
+ * from the template, and the remaining chunks are handled by
+ * #handler_sign_tx.
+ *
+ * @see G_tx_templates
+ *
+ * @param[in,out] chunk_data
+ *   Command data with template id, nonce, valid-to time, RPC length and the
+ *   start of the RPC.
+ * @param[in]     anymore_blocks_after_this_one
+ *   Whether there will continue to arrive chunks after this one.
+ *
+ * @return zero or positive integer if success, negative integer otherwise.
+ *
+ */
+WARN_UNUSED_RESULT
+int handler_sign_tx_from_template(buffer_t *chunk_data, bool anymore_blocks_after_this_one);
+
+/**
+ * Handler for a non-first chunk of a SIGN_TX command containing compressed RPC
+ * bytes. The chunks are decompressed by #lz_decoder_update, and the
+ * decompressed bytes are parsed and digested as by #handler_sign_tx.
+ *
+ * Compressed chunks must follow the chunk that contains the start of the RPC,
+ * and only compressed chunks may follow them.
+ *
+ * @param[in,out] chunk_data
+ *   Command data with the next bytes of the compressed RPC.
+ * @param[in]     anymore_blocks_after_this_one
+ *   Whether there will continue to arrive chunks after this one.
+ *
+ * @return zero or positive integer if success, negative integer otherwise.
+ *
+ */
+WARN_UNUSED_RESULT
+int handler_sign_tx_compressed(buffer_t *chunk_data, bool anymore_blocks_after_this_one);
@@ -39,9 +39,9 @@ WARN_UNUSED_RESULT
 int helper_send_response_sig(void) {
     // Serialize signature
     uint8_t signature_bytes[32 + 32 + 1] = {0};
-    signature_bytes[0] = G_context.tx_info.signature.recovery_id;
-    memmove(&signature_bytes[1], G_context.tx_info.signature.r, 32);
-    memmove(&signature_bytes[33], G_context.tx_info.signature.s, 32);
+    signature_bytes[0] = G_context.signature.recovery_id;
+    memmove(&signature_bytes[1], G_context.signature.r, 32);
+    memmove(&signature_bytes[33], G_context.signature.s, 32);
 
     // Send signature
     return io_send_response_pointer(signature_bytes, sizeof(signature_bytes), SW_OK);
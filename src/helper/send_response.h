@@ -17,7 +17,7 @@ int helper_send_response_address(void);
  * Helper to send APDU response with signature and v (parity of
  * y-coordinate of R).
  *
- * response = G_context.tx_info.signature (65)
+ * response = G_context.signature (65)
  *
  * @return zero or positive integer if success, -1 otherwise.
  *
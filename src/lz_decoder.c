@@ -0,0 +1,118 @@
+#include <string.h>  // memcpy
+
+#include "lz_decoder.h"
+
+_Static_assert((COMPRESSION_WINDOW_LEN & (COMPRESSION_WINDOW_LEN - 1)) == 0,
+               "COMPRESSION_WINDOW_LEN must be a power of two");
+_Static_assert(COMPRESSION_WINDOW_LEN <= UINT16_MAX + 1, "Distances are u16");
+
+#define WINDOW_MASK (COMPRESSION_WINDOW_LEN - 1)
+
+/**
+ * Appends bytes to the window.
+ */
+static void append_to_window(lz_decoder_t *decoder, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        const size_t position = decoder->produced & WINDOW_MASK;
+        size_t len = COMPRESSION_WINDOW_LEN - position;
+        if (len > size) {
+            len = size;
+        }
+        memcpy(decoder->window + position, data, len);
+        decoder->produced += len;
+        data += len;
+        size -= len;
+    }
+}
+
+/**
+ * Produces the bytes of the current copy in the window, and passes them to
+ * sink, one contiguous span of the window at a time.
+ */
+static bool copy_match(lz_decoder_t *decoder, lz_sink_t sink, void *context) {
+    while (decoder->remaining > 0) {
+        const size_t position = decoder->produced & WINDOW_MASK;
+        size_t len = COMPRESSION_WINDOW_LEN - position;
+        if (len > decoder->remaining) {
+            len = decoder->remaining;
+        }
+        // Byte by byte, as the copy may overlap the bytes it produces
+        for (size_t i = 0; i < len; i++) {
+            decoder->window[position + i] =
+                decoder->window[(position + i - decoder->distance) & WINDOW_MASK];
+        }
+        decoder->produced += len;
+        decoder->remaining -= len;
+        if (!sink(context, decoder->window + position, len)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void lz_decoder_init(lz_decoder_t *decoder) {
+    decoder->produced = 0;
+    decoder->remaining = 0;
+    decoder->distance = 0;
+    decoder->state = LZ_STATE_TOKEN;
+}
+
+lz_decode_status_e lz_decoder_update(lz_decoder_t *decoder,
+                                     buffer_t *input,
+                                     lz_sink_t sink,
+                                     void *context) {
+    while (input->offset < input->size) {
+        const uint8_t *next = input->ptr + input->offset;
+        const size_t available = input->size - input->offset;
+
+        switch (decoder->state) {
+            case LZ_STATE_TOKEN:
+                if (*next < 0x80) {
+                    decoder->remaining = (uint16_t) (*next + 1);
+                    decoder->state = LZ_STATE_LITERALS;
+                } else {
+                    decoder->remaining = (uint16_t) ((*next & 0x7F) + LZ_MIN_MATCH_LEN);
+                    decoder->state = LZ_STATE_DISTANCE_HIGH;
+                }
+                input->offset++;
+                break;
+            case LZ_STATE_LITERALS: {
+                // Literals are passed on straight from the input
+                const size_t len =
+                    available < decoder->remaining ? available : decoder->remaining;
+                append_to_window(decoder, next, len);
+                decoder->remaining -= (uint16_t) len;
+                input->offset += len;
+                if (decoder->remaining == 0) {
+                    decoder->state = LZ_STATE_TOKEN;
+                }
+                if (!sink(context, next, len)) {
+                    return LZ_DECODE_ABORTED;
+                }
+                break;
+            }
+            case LZ_STATE_DISTANCE_HIGH:
+                decoder->distance = (uint16_t) (*next << 8);
+                decoder->state = LZ_STATE_DISTANCE_LOW;
+                input->offset++;
+                break;
+            case LZ_STATE_DISTANCE_LOW:
+                decoder->distance |= *next;
+                input->offset++;
+                if (decoder->distance == 0 || decoder->distance > COMPRESSION_WINDOW_LEN ||
+                    decoder->distance > decoder->produced) {
+                    return LZ_DECODE_INVALID_DISTANCE;
+                }
+                decoder->state = LZ_STATE_TOKEN;
+                if (!copy_match(decoder, sink, context)) {
+                    return LZ_DECODE_ABORTED;
+                }
+                break;
+        }
+    }
+    return LZ_DECODE_OK;
+}
+
+bool lz_decoder_at_token_boundary(const lz_decoder_t *decoder) {
+    return decoder->state == LZ_STATE_TOKEN;
+}
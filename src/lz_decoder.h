@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdbool.h>  // bool
+#include <stddef.h>   // size_t
+#include <stdint.h>   // uint*_t
+
+#include "buffer.h"
+
+#include "constants.h"
+
+/**
+ * Streaming decoder of the compressed transfer encoding of RPC bytes.
+ *
+ * The compressed stream is a sequence of tokens:
+ *
+ * - A token byte t below 0x80 is followed by t + 1 literal bytes.
+ * - A token byte t of 0x80 or above copies (t & 0x7F) + 3 bytes, starting the
+ *   given distance back in the decompressed bytes. The distance follows as an
+ *   u16 big endian, from 1 to #COMPRESSION_WINDOW_LEN. A copy may overlap the
+ *   bytes it produces.
+ *
+ * The input can be split anywhere, also inside a token. The decoder keeps the
+ * last #COMPRESSION_WINDOW_LEN decompressed bytes, and no other buffer.
+ */
+
+/** Shortest copy of a token. */
+#define LZ_MIN_MATCH_LEN 3
+/** Longest copy of a token. */
+#define LZ_MAX_MATCH_LEN (0x7F + LZ_MIN_MATCH_LEN)
+/** Longest run of literal bytes of a token. */
+#define LZ_MAX_LITERAL_LEN (0x7F + 1)
+
+/**
+ * Receives decompressed bytes.
+ *
+ * @return true to continue decompressing, false to stop with
+ * #LZ_DECODE_ABORTED.
+ */
+typedef bool (*lz_sink_t)(void *context, const uint8_t *data, size_t size);
+
+typedef enum {
+    LZ_DECODE_OK = 1,
+    /** A copy starts before the first decompressed byte, or outside of the window. */
+    LZ_DECODE_INVALID_DISTANCE = -1,
+    /** The sink stopped the decompression. */
+    LZ_DECODE_ABORTED = -2,
+} lz_decode_status_e;
+
+typedef enum {
+    LZ_STATE_TOKEN = 0,
+    LZ_STATE_LITERALS,
+    LZ_STATE_DISTANCE_HIGH,
+    LZ_STATE_DISTANCE_LOW,
+} lz_state_e;
+
+typedef struct {
+    /** Last decompressed bytes, at their position modulo the window length. */
+    uint8_t window[COMPRESSION_WINDOW_LEN];
+    /** Number of bytes decompressed so far. */
+    uint32_t produced;
+    /** Literal bytes, or bytes of the copy, left of the current token. */
+    uint16_t remaining;
+    /** Distance of the current copy. */
+    uint16_t distance;
+    /** Part of the token expected next. */
+    lz_state_e state;
+} lz_decoder_t;
+
+/**
+ * Initializes the decoder for a new compressed stream.
+ */
+void lz_decoder_init(lz_decoder_t *decoder);
+
+/**
+ * Decompresses the remaining bytes of input, and passes the decompressed bytes
+ * to sink. The bytes of a token that has not been received completely are
+ * decompressed by the next update.
+ *
+ * @return LZ_DECODE_OK if all of input was consumed, a negative status
+ * otherwise, after which the decoder must not be updated again.
+ */
+lz_decode_status_e lz_decoder_update(lz_decoder_t *decoder,
+                                     buffer_t *input,
+                                     lz_sink_t sink,
+                                     void *context);
+
+/**
+ * Determines whether the compressed stream may end here, that is whether the
+ * last token has been received completely.
+ */
+bool lz_decoder_at_token_boundary(const lz_decoder_t *decoder);
@@ -0,0 +1,64 @@
+#ifdef HAVE_STACK_USAGE
+
+#include <stdint.h>  // uint*_t, uintptr_t
+
+#include "stack_usage.h"
+
+/** Byte the unused part of the stack is painted with. */
+#define STACK_PAINT_PATTERN 0xA5
+
+/**
+ * Bytes left unpainted below the stack pointer, as a safety margin for the
+ * frame of stack_usage_paint itself.
+ */
+#define STACK_PAINT_MARGIN 64
+
+/**
+ * Bytes left unpainted at the bottom of the stack, which holds the stack
+ * canary of the SDK.
+ */
+#define STACK_PAINT_GUARD 16
+
+/** Lowest address of the stack, provided by the linker script of the SDK. */
+extern uint8_t _stack;
+/** Address just past the top of the stack, provided by the linker script. */
+extern uint8_t _estack;
+
+/** Deepest stack usage per instruction, indexed by ins - #STACK_USAGE_INS_MIN. */
+static uint32_t G_stack_high_water[STACK_USAGE_INS_COUNT];
+
+uint32_t stack_usage_size(void) {
+    return (uint32_t) ((uintptr_t) &_estack - (uintptr_t) &_stack);
+}
+
+uint32_t stack_usage_high_water(uint8_t ins) {
+    if (ins < STACK_USAGE_INS_MIN || ins > STACK_USAGE_INS_MAX) {
+        return 0;
+    }
+    return G_stack_high_water[ins - STACK_USAGE_INS_MIN];
+}
+
+void stack_usage_paint(void) {
+    // Painted byte by byte in this frame: calling memset would overwrite its
+    // own frame.
+    volatile uint8_t marker = 0;
+    volatile uint8_t *end = &marker - STACK_PAINT_MARGIN;
+    for (volatile uint8_t *p = &_stack + STACK_PAINT_GUARD; p < end; p++) {
+        *p = STACK_PAINT_PATTERN;
+    }
+}
+
+void stack_usage_record(uint8_t ins) {
+    const volatile uint8_t *p = &_stack + STACK_PAINT_GUARD;
+    while (p < &_estack && *p == STACK_PAINT_PATTERN) {
+        p++;
+    }
+    const uint32_t used = (uint32_t) ((uintptr_t) &_estack - (uintptr_t) p);
+
+    if (ins >= STACK_USAGE_INS_MIN && ins <= STACK_USAGE_INS_MAX &&
+        used > G_stack_high_water[ins - STACK_USAGE_INS_MIN]) {
+        G_stack_high_water[ins - STACK_USAGE_INS_MIN] = used;
+    }
+}
+
+#endif
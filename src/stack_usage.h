@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>  // uint*_t
+
+#include "types.h"
+
+/**
+ * \file Stack high-water marks per instruction.
+ *
+ * Only compiled in when HAVE_STACK_USAGE is defined (`make ENABLE_STACK_USAGE=1`).
+ * When it is not, the STACK_USAGE_* macros expand to nothing.
+ *
+ * The unused part of the stack is painted with a known pattern before an APDU
+ * is dispatched. When the next APDU is received, the lowest overwritten byte
+ * gives the deepest stack usage since the previous APDU, which is attributed to
+ * the instruction of that APDU. This includes the UI callbacks, such as the
+ * signing done when a review is approved, as these run while waiting for the
+ * next APDU.
+ *
+ * The high-water marks are returned by the GET_STACK_USAGE instruction.
+ */
+
+/** Lowest measured #command_e. */
+#define STACK_USAGE_INS_MIN GET_VERSION
+/** Highest measured #command_e. Must be updated when adding instructions. */
+#define STACK_USAGE_INS_MAX GET_CHUNK_SIZE
+/** Number of measured instructions. */
+#define STACK_USAGE_INS_COUNT (STACK_USAGE_INS_MAX - STACK_USAGE_INS_MIN + 1)
+
+#ifdef HAVE_STACK_USAGE
+
+/**
+ * Total size in bytes of the application stack.
+ */
+uint32_t stack_usage_size(void);
+
+/**
+ * Deepest stack usage in bytes measured for the given instruction, or zero if
+ * it has not been measured.
+ */
+uint32_t stack_usage_high_water(uint8_t ins);
+
+/**
+ * Paints the unused part of the stack, below the stack pointer of the caller.
+ */
+void stack_usage_paint(void);
+
+/**
+ * Measures the stack usage since the last call to stack_usage_paint, and
+ * attributes it to the given instruction.
+ */
+void stack_usage_record(uint8_t ins);
+
+/** Paints the stack before dispatching an APDU. */
+#define STACK_USAGE_PAINT() stack_usage_paint()
+/** Attributes the stack usage since the last paint to the given instruction. */
+#define STACK_USAGE_RECORD(ins) stack_usage_record(ins)
+
+#else
+
+#define STACK_USAGE_PAINT()
+#define STACK_USAGE_RECORD(ins)
+
+#endif
@@ -0,0 +1,35 @@
+#ifdef HAVE_STATS
+
+#include <string.h>  // explicit_bzero
+
+#include "stats.h"
+
+stats_t G_stats;
+
+void stats_record_phase(stats_phase_e phase) {
+    G_stats.phases[phase]++;
+}
+
+/**
+ * Increments the counter of the given status, if it is in range.
+ */
+static void increment_status(uint32_t counters[STATS_PARSER_STATUS_COUNT],
+                             parser_status_e status) {
+    if (status >= STATS_PARSER_STATUS_MIN && status <= STATS_PARSER_STATUS_MAX) {
+        counters[status - STATS_PARSER_STATUS_MIN]++;
+    }
+}
+
+void stats_record_parser_status(parser_status_e status) {
+    increment_status(G_stats.parser_status, status);
+}
+
+void stats_record_blind_fallback(parser_status_e reason) {
+    increment_status(G_stats.blind_fallback, reason);
+}
+
+void stats_reset(void) {
+    explicit_bzero(&G_stats, sizeof(G_stats));
+}
+
+#endif
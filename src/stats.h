@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stdint.h>  // uint*_t
+
+#include "transaction/types.h"
+
+/**
+ * \file Instrumentation counters for the hot paths of the application.
+ *
+ * Only compiled in when HAVE_STATS is defined (`make ENABLE_STATS=1`). When it
+ * is not, the STATS_* macros expand to nothing, such that instrumentation has
+ * no overhead in release builds.
+ *
+ * The counters are returned and reset by the GET_STATS instruction. They only
+ * count occurrences: apps have no clock that advances while an APDU is being
+ * handled, the ticker events being processed in io_exchange only.
+ */
+
+/**
+ * Instrumented phases of a request.
+ */
+typedef enum {
+    /** Dispatching and handling an APDU, see apdu_dispatcher. */
+    STATS_PHASE_DISPATCH,
+    /** Parsing a transaction chunk, see transaction_parser_update. */
+    STATS_PHASE_PARSE,
+    /**
+     * Adding request data to the digest, see cx_hash_update. Counted once per
+     * chunk of data, or per span decompressed from a compressed chunk, as for
+     * #STATS_PHASE_PARSE. The prefixes and the chain id hashed around the
+     * data are not counted.
+     */
+    STATS_PHASE_HASH,
+    /** Deriving keys and signatures, see bip32_derive_*. */
+    STATS_PHASE_DERIVE,
+    /** Setting up the review UI. */
+    STATS_PHASE_UI,
+    /** Number of phases. */
+    STATS_PHASE_COUNT,
+} stats_phase_e;
+
+/** Lowest #parser_status_e. */
+#define STATS_PARSER_STATUS_MIN PARSING_STATUS_MIN
+/** Highest #parser_status_e. */
+#define STATS_PARSER_STATUS_MAX PARSING_CONTINUE
+/** Number of counted parser statuses. */
+#define STATS_PARSER_STATUS_COUNT (STATS_PARSER_STATUS_MAX - STATS_PARSER_STATUS_MIN + 1)
+
+#ifdef HAVE_STATS
+
+/**
+ * Instrumentation counters.
+ */
+typedef struct {
+    /** Number of times each phase has been entered, indexed by #stats_phase_e. */
+    uint32_t phases[STATS_PHASE_COUNT];
+    /**
+     * Occurrences of each status returned by transaction_parser_update,
+     * indexed by status - #STATS_PARSER_STATUS_MIN.
+     */
+    uint32_t parser_status[STATS_PARSER_STATUS_COUNT];
+    /**
+     * Occurrences of each reason for falling back to blind signing, indexed by
+     * status - #STATS_PARSER_STATUS_MIN.
+     */
+    uint32_t blind_fallback[STATS_PARSER_STATUS_COUNT];
+} stats_t;
+
+/**
+ * Global instrumentation counters.
+ */
+extern stats_t G_stats;
+
+/**
+ * Counts an occurrence of the given phase.
+ */
+void stats_record_phase(stats_phase_e phase);
+
+/**
+ * Counts an occurrence of the given status returned by the transaction parser.
+ */
+void stats_record_parser_status(parser_status_e status);
+
+/**
+ * Counts a transaction that fell back to blind signing for the given reason.
+ */
+void stats_record_blind_fallback(parser_status_e reason);
+
+/**
+ * Resets all counters.
+ */
+void stats_reset(void);
+
+/** Counts an occurrence of the given phase. */
+#define STATS_PHASE(phase) stats_record_phase(phase)
+/** Counts an occurrence of the given parser status. */
+#define STATS_PARSER_STATUS(status) stats_record_parser_status(status)
+/** Counts a fall back to blind signing for the given reason. */
+#define STATS_BLIND_FALLBACK(reason) stats_record_blind_fallback(reason)
+
+#else
+
+#define STATS_PHASE(phase)
+#define STATS_PARSER_STATUS(status)
+#define STATS_BLIND_FALLBACK(reason)
+
+#endif
@@ -76,6 +76,28 @@
  * Status word for failing to transmit data response.
  */
 #define SW_RESPONSE_FAILURE 0xB00C
+/**
+ * Status word for receiving a message that does not match the announced
+ * message length.
+ */
+#define SW_WRONG_MESSAGE_LENGTH 0xB00D
+/**
+ * Status word for fail to display message.
+ */
+#define SW_DISPLAY_MESSAGE_FAIL 0xB00E
+/**
+ * Status word for referencing a transaction template that has not been set.
+ */
+#define SW_UNKNOWN_TX_TEMPLATE 0xB00F
+/**
+ * Status word for compressed transaction chunks that cannot be decompressed.
+ */
+#define SW_TX_DECOMPRESSION_FAIL 0xB010
+/**
+ * Status word for fail to display the action or secret input of a ZK contract
+ * invocation.
+ */
+#define SW_DISPLAY_ZK_INVOCATION_FAIL 0xB011
 /**
  * Basis status word for failure to parse a transaction. Is or'ed with
  * parser_status_e to determine the specific error.
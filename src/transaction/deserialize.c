@@ -31,10 +31,12 @@
 #include "ledger_assert.h"
 #endif
 
-void transaction_parser_init(transaction_parsing_state_t *state) {
+void transaction_parser_init(transaction_parsing_state_t *state, arena_t *arena) {
     state->rpc_bytes_total = 0;
     state->rpc_bytes_parsed = 0;
-    state->first_block_parsed = false;
+    state->header_parsed = false;
+    state->rpc_parsing_attempted = false;
+    state->arena = arena;
 }
 
 /**
@@ -44,7 +46,9 @@ static uint32_t min(uint32_t a, uint32_t b) {
     return a < b ? a : b;
 }
 
-static parser_status_e parse_rpc_mpc_token(buffer_t *chunk, transaction_t *tx) {
+static parser_status_e parse_rpc_mpc_token(transaction_parsing_state_t *state,
+                                           buffer_t *chunk,
+                                           transaction_t *tx) {
     // Read shortname
     uint8_t shortname;
     if (!buffer_read_u8(chunk, &shortname)) {
@@ -108,17 +112,20 @@ static parser_status_e parse_rpc_mpc_token(buffer_t *chunk, transaction_t *tx) {
             return PARSING_FAILED_MPC_MEMO;
         }
 
-        // Check that the memo can be read into the buffer
-        if (memo_length > sizeof(tx->mpc_transfer.memo)) {
+        // Check that the entire memo is present, and not just a part (such
+        // that the rest of the memo is on the next chunk.)
+        if (!buffer_can_read(chunk, memo_length)) {
             return PARSING_FAILED_MPC_MEMO;
         }
 
-        // Read long memo
-        size_t read_bytes = buffer_read_bytes(chunk, tx->mpc_transfer.memo, memo_length);
+        // Check that the memo, and its null terminator, fits in the arena
+        if (memo_length >= arena_available(state->arena)) {
+            return PARSING_FAILED_MPC_MEMO;
+        }
+        tx->mpc_transfer.memo = arena_alloc(state->arena, memo_length + 1);
 
-        // Check that the entire memo was read, and not just a part (such that
-        // the rest of the memo is on the next chunk.)
-        if (read_bytes < memo_length) {
+        // Read long memo
+        if (!buffer_read_bytes_precisely(chunk, tx->mpc_transfer.memo, memo_length)) {
             return PARSING_FAILED_MPC_MEMO;
         }
 
@@ -133,64 +140,191 @@ static parser_status_e parse_rpc_mpc_token(buffer_t *chunk, transaction_t *tx) {
 }
 
 /**
- * Invariants: Must either consume entire chunk (and return true), or consume any amount (and return
- * false).
+ * Parses the bit lengths of a secret input, and determines the total size of
+ * the secret input.
+ *
+ * Format: u32 number of elements, followed by an i32 bit length per element.
+ */
+static parser_status_e parse_zk_secret_input_bit_lengths(buffer_t *chunk, uint64_t *out_bits) {
+    uint32_t num_elements;
+    if (!buffer_read_u32(chunk, &num_elements, BE)) {
+        return PARSING_FAILED_ZK_SECRET_INPUT_BIT_LENGTHS;
+    }
+
+    uint64_t total_bits = 0;
+    for (uint32_t i = 0; i < num_elements; i++) {
+        uint32_t bit_length;
+        if (!buffer_read_u32(chunk, &bit_length, BE)) {
+            return PARSING_FAILED_ZK_SECRET_INPUT_BIT_LENGTHS;
+        }
+
+        // Bit lengths are signed, and must not be negative
+        if ((int32_t) bit_length < 0) {
+            return PARSING_FAILED_ZK_SECRET_INPUT_BIT_LENGTHS;
+        }
+        total_bits += bit_length;
+    }
+
+    *out_bits = total_bits;
+    return PARSING_CONTINUE;
+}
+
+/**
+ * Parses the leading part of an invocation of a zero-knowledge contract.
+ *
+ * Returns #PARSING_CONTINUE when the leading part has been parsed, as the
+ * remaining payload is not parsed.
  */
-static parser_status_e parse_rpc(buffer_t *chunk, transaction_t *tx) {
+static parser_status_e parse_rpc_zk_contract(buffer_t *chunk, transaction_t *tx) {
+    uint8_t kind;
+    if (!buffer_read_u8(chunk, &kind)) {
+        return PARSING_FAILED_ZK_INVOCATION_KIND;
+    }
+
+    zk_invocation_transaction_type_s *zk_invocation = &tx->zk_invocation;
+    if (kind == ZK_INVOCATION_KIND_OPEN) {
+        zk_invocation->kind = ZK_OPEN_INVOCATION;
+        zk_invocation->secret_input_bits = 0;
+
+        // Shortname of the invoked action
+        if (!buffer_read_leb128_u32(chunk, &zk_invocation->shortname)) {
+            return PARSING_FAILED_ZK_SHORTNAME;
+        }
+
+    } else if (kind == ZK_INVOCATION_KIND_SECRET_INPUT_OFF_CHAIN ||
+               kind == ZK_INVOCATION_KIND_SECRET_INPUT_ON_CHAIN) {
+        zk_invocation->kind = (zk_invocation_kind_e) kind;
+        zk_invocation->shortname = 0;
+
+        // Size of the committed secret input
+        parser_status_e status =
+            parse_zk_secret_input_bit_lengths(chunk, &zk_invocation->secret_input_bits);
+        if (status != PARSING_CONTINUE) {
+            return status;
+        }
+
+    } else {
+        // Unknown invocation kind
+        return PARSING_FAILED_ZK_INVOCATION_KIND;
+    }
+
+    tx->type = ZK_INVOCATION;
+    return PARSING_CONTINUE;
+}
+
+/**
+ * Invariants: Must either consume entire chunk (and return #PARSING_DONE), consume the leading part
+ * of the RPC, leaving the rest as an opaque payload (and return #PARSING_CONTINUE), or consume any
+ * amount (and return an error).
+ */
+static parser_status_e parse_rpc(transaction_parsing_state_t *state,
+                                 buffer_t *chunk,
+                                 transaction_t *tx) {
     if (blockchain_address_is_equal(&tx->basic.contract_address, &MPC_TOKEN_ADDRESS)) {
-        return parse_rpc_mpc_token(chunk, tx);
+        return parse_rpc_mpc_token(state, chunk, tx);
+    }
+    if (tx->basic.contract_address.raw_bytes[0] == BLOCKCHAIN_ADDRESS_CONTRACT_ZK) {
+        return parse_rpc_zk_contract(chunk, tx);
     }
     return PARSING_FAILED_ADDRESS_UNKNOWN;
 }
 
-parser_status_e transaction_parser_update(transaction_parsing_state_t *state,
-                                          buffer_t *chunk,
-                                          transaction_t *tx) {
+/**
+ * Parses the transaction header; everything preceding the RPC data.
+ */
+static parser_status_e parse_header(transaction_parsing_state_t *state,
+                                    buffer_t *chunk,
+                                    transaction_t *tx) {
+    state->header_parsed = true;
+
+    // nonce
+    if (!buffer_read_u64(chunk, &tx->basic.nonce, BE)) {
+        return PARSING_FAILED_NONCE;
+    }
+
+    // valid-to time
+    if (!buffer_read_u64(chunk, &tx->basic.valid_to_time, BE)) {
+        return PARSING_FAILED_VALID_TO_TIME;
+    }
+
+    // gas cost
+    if (!buffer_read_u64(chunk, &tx->basic.gas_cost, BE)) {
+        return PARSING_FAILED_GAS_COST;
+    }
+
+    // Contract address
+    if (!buffer_read_contract_address(chunk, &tx->basic.contract_address)) {
+        return PARSING_FAILED_CONTRACT_ADDRESS;
+    }
+
+    // Parse RPC length
+    if (!buffer_read_u32(chunk, &state->rpc_bytes_total, BE)) {
+        return PARSING_FAILED_RPC_LENGTH;
+    }
+
+    return PARSING_CONTINUE;
+}
+
+parser_status_e transaction_parser_update_header(transaction_parsing_state_t *state,
+                                                 buffer_t *chunk,
+                                                 transaction_t *tx) {
     LEDGER_ASSERT(state != NULL, "NULL state");
     LEDGER_ASSERT(chunk != NULL, "NULL chunk");
     LEDGER_ASSERT(tx != NULL, "NULL tx");
+    LEDGER_ASSERT(!state->header_parsed, "Header already parsed");
 
-    // First block
-    if (!state->first_block_parsed) {
-        state->first_block_parsed = true;
-
-        // nonce
-        if (!buffer_read_u64(chunk, &tx->basic.nonce, BE)) {
-            return PARSING_FAILED_NONCE;
-        }
+    parser_status_e status = parse_header(state, chunk, tx);
+    if (status != PARSING_CONTINUE) {
+        return status;
+    }
 
-        // valid-to time
-        if (!buffer_read_u64(chunk, &tx->basic.valid_to_time, BE)) {
-            return PARSING_FAILED_VALID_TO_TIME;
-        }
+    // The RPC must start in the next chunk
+    if (chunk->offset != chunk->size) {
+        return PARSING_FAILED_RPC_DATA;
+    }
+    return PARSING_CONTINUE;
+}
 
-        // gas cost
-        if (!buffer_read_u64(chunk, &tx->basic.gas_cost, BE)) {
-            return PARSING_FAILED_GAS_COST;
-        }
+parser_status_e transaction_parser_update(transaction_parsing_state_t *state,
+                                          buffer_t *chunk,
+                                          transaction_t *tx) {
+    LEDGER_ASSERT(state != NULL, "NULL state");
+    LEDGER_ASSERT(chunk != NULL, "NULL chunk");
+    LEDGER_ASSERT(tx != NULL, "NULL tx");
+    LEDGER_ASSERT(state->arena != NULL, "NULL arena");
 
-        // Contract address
-        if (!buffer_read_contract_address(chunk, &tx->basic.contract_address)) {
-            return PARSING_FAILED_CONTRACT_ADDRESS;
+    // Transaction header
+    if (!state->header_parsed) {
+        parser_status_e status = parse_header(state, chunk, tx);
+        if (status != PARSING_CONTINUE) {
+            return status;
         }
+    }
 
-        // Parse RPC length
-        if (!buffer_read_u32(chunk, &state->rpc_bytes_total, BE)) {
-            return PARSING_FAILED_RPC_LENGTH;
-        }
+    // Leading part of the RPC. Parsed from the chunk following the header.
+    if (!state->rpc_parsing_attempted) {
+        state->rpc_parsing_attempted = true;
 
         // Try to parse RPC
         size_t current_chunk_offset = chunk->offset;
-        parser_status_e rpc_parsing_status = parse_rpc(chunk, tx);
+        parser_status_e rpc_parsing_status = parse_rpc(state, chunk, tx);
         bool rpc_parsing_consumed_entire_chunk = chunk->offset == chunk->size;
-        if (rpc_parsing_status == PARSING_DONE && rpc_parsing_consumed_entire_chunk) {
+        size_t rpc_bytes_read = chunk->offset - current_chunk_offset;
+        if (rpc_parsing_status == PARSING_DONE && rpc_parsing_consumed_entire_chunk &&
+            rpc_bytes_read == state->rpc_bytes_total) {
             // If RPC could be parsed: No skipping required!
             state->rpc_bytes_parsed = state->rpc_bytes_total;
+        } else if (rpc_parsing_status == PARSING_CONTINUE &&
+                   rpc_bytes_read <= state->rpc_bytes_total) {
+            // If the leading part of the RPC could be parsed: Skip the payload.
+            state->rpc_bytes_parsed = rpc_bytes_read;
         } else {
             // If RPC couldn't be parsed. Mark as GENERIC. Reset and continue.
             chunk->offset = current_chunk_offset;
             tx->type = GENERIC_TRANSACTION;
-            tx->rpc_parsing_error = rpc_parsing_status;
+            tx->rpc_parsing_error = rpc_parsing_status == PARSING_CONTINUE
+                                        ? PARSING_FAILED_RPC_DATA  // Leading part exceeds the RPC
+                                        : rpc_parsing_status;
         }
     }
 
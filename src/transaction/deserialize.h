@@ -6,8 +6,13 @@
 
 /**
  * Initializes the transaction parse.
+ *
+ * @param[out] state
+ *   Parser state to initialize.
+ * @param[in] arena
+ *   Arena to allocate variable-size fields from.
  */
-void transaction_parser_init(transaction_parsing_state_t *state);
+void transaction_parser_init(transaction_parsing_state_t *state, arena_t *arena);
 
 /**
  * Deserialize raw transaction in structure.
@@ -23,3 +28,19 @@ void transaction_parser_init(transaction_parsing_state_t *state);
 parser_status_e transaction_parser_update(transaction_parsing_state_t *state,
                                           buffer_t *chunk,
                                           transaction_t *tx);
+
+/**
+ * Deserialize the header of a raw transaction in structure, when the header is
+ * given in a chunk of its own. The RPC is parsed from the next chunk given to
+ * #transaction_parser_update.
+ *
+ * @param[in, out] chunk
+ *   Pointer to buffer with exactly the serialized transaction header.
+ * @param[out]     tx
+ *   Pointer to transaction structure.
+ *
+ * @return PARSING_CONTINUE if success, error status otherwise.
+ */
+parser_status_e transaction_parser_update_header(transaction_parsing_state_t *state,
+                                                 buffer_t *chunk,
+                                                 transaction_t *tx);
@@ -11,13 +11,8 @@
 #include <stdint.h>  // uint*_t
 
 #include "address.h"
-
-/**
- * The maximum length of memo supported for #MPC_TRANSFER transactions. While
- * the MPC Token contract supports larger memoes, we need a limit for the
- * Ledger device.
- */
-#define MEMO_MAX_LENGTH 20
+#include "arena.h"
+#include "well_known.h"
 
 /**
  * The number of decimals used when formatting MPC values. MPC values are
@@ -36,8 +31,12 @@ typedef struct {
     uint32_t rpc_bytes_total;
     /** Number of RPC bytes read. */
     uint32_t rpc_bytes_parsed;
-    /** Whether the first transaction has been parsed? */
-    bool first_block_parsed;
+    /** Whether the transaction header has been parsed. */
+    bool header_parsed;
+    /** Whether the parsing of the RPC has been attempted. */
+    bool rpc_parsing_attempted;
+    /** Arena to allocate variable-size fields, such as memos, from. */
+    arena_t *arena;
 } transaction_parsing_state_t;
 
 /**
@@ -72,6 +71,14 @@ typedef enum {
     PARSING_FAILED_MPC_TOKEN_AMOUNT = -11,
     /** Parsing failed while parsing memo. */
     PARSING_FAILED_MPC_MEMO = -12,
+    /** Parsing failed because ZK invocation kind was unknown. */
+    PARSING_FAILED_ZK_INVOCATION_KIND = -13,
+    /** Parsing failed while parsing ZK contract shortname. */
+    PARSING_FAILED_ZK_SHORTNAME = -14,
+    /** Parsing failed while parsing ZK secret input bit lengths. */
+    PARSING_FAILED_ZK_SECRET_INPUT_BIT_LENGTHS = -15,
+    /** Lowest status. Must stay the last entry, equal to the last failure above. */
+    PARSING_STATUS_MIN = PARSING_FAILED_ZK_SECRET_INPUT_BIT_LENGTHS,
 } parser_status_e;
 
 /**
@@ -83,6 +90,8 @@ typedef enum {
     GENERIC_TRANSACTION = 1,
     /** MPC transfer involving the MPC Token contract. Can be clear-signed. */
     MPC_TRANSFER = 2,
+    /** Invocation of a zero-knowledge contract. Can be clear-signed. */
+    ZK_INVOCATION = 3,
 } transaction_type_e;
 
 /**
@@ -99,18 +108,51 @@ typedef struct {
      */
     uint64_t token_amount_10000ths;
     /** Length of associated memo. */
-    uint8_t memo_length;
+    uint32_t memo_length;
     /** Tag for which memo field is relevant. */
     bool has_u64_memo;
     /** Contents of memo. */
     union {
         /** Contents of memo when memo is an u64. */
         uint64_t memo_u64;
-        /** Contents of memo when memo is an string. Possibly cut off. */
-        uint8_t memo[MEMO_MAX_LENGTH];
+        /**
+         * Contents of memo when memo is an string. Allocated from the arena
+         * with room for a null terminator after the memo_length bytes.
+         */
+        uint8_t *memo;
     };
 } mpc_transfer_transaction_type_s;
 
+/**
+ * Kinds of invocations of zero-knowledge contracts.
+ */
+typedef enum {
+    /** Secret input, where the shares are sent off-chain to the nodes. */
+    ZK_SECRET_INPUT_OFF_CHAIN = ZK_INVOCATION_KIND_SECRET_INPUT_OFF_CHAIN,
+    /** Secret input, where the encrypted shares are sent on-chain. */
+    ZK_SECRET_INPUT_ON_CHAIN = ZK_INVOCATION_KIND_SECRET_INPUT_ON_CHAIN,
+    /** Open invocation of a public action of the contract. */
+    ZK_OPEN_INVOCATION = ZK_INVOCATION_KIND_OPEN,
+} zk_invocation_kind_e;
+
+/**
+ * Information about an invocation of a zero-knowledge contract.
+ *
+ * Only the leading part of the RPC is parsed. The remaining payload, such as
+ * the arguments or the encrypted shares, is hashed without being parsed.
+ */
+typedef struct {
+    /** Kind of invocation. */
+    zk_invocation_kind_e kind;
+    /** Shortname of the invoked action. Only for #ZK_OPEN_INVOCATION. */
+    uint32_t shortname;
+    /**
+     * Total size of the committed secret input in bits. Only for secret
+     * inputs.
+     */
+    uint64_t secret_input_bits;
+} zk_invocation_transaction_type_s;
+
 /**
  * Must be large enough to be able to contain both "Partisia Blockchain" and "Partisia Blockchain
  * Testnet".
@@ -140,6 +182,12 @@ typedef struct {
     blockchain_address_s contract_address;  /// contract address to interact with
 } transaction_basic_t;
 
+/**
+ * Length of the serialized transaction header: nonce, valid-to time, gas cost,
+ * contract address and RPC length.
+ */
+#define TRANSACTION_HEADER_LEN (8 + 8 + 8 + ADDRESS_LEN + 4)
+
 /**
  * Parsed transaction information, potentially including specific types of
  * well-known formats.
@@ -158,6 +206,8 @@ typedef struct {
     union {
         /** Only when transaction_t.type == #MPC_TRANSFER */
         mpc_transfer_transaction_type_s mpc_transfer;
+        /** Only when transaction_t.type == #ZK_INVOCATION */
+        zk_invocation_transaction_type_s zk_invocation;
         /** Only when transaction_t.type == #GENERIC_TRANSACTION */
         parser_status_e rpc_parsing_error;
     };
@@ -1,12 +1,14 @@
 #pragma once
 
-#include <stddef.h>  // size_t
-#include <stdint.h>  // uint*_t
+#include <stddef.h>   // size_t
+#include <stdint.h>   // uint*_t
+#include <stdbool.h>  // bool
 
 #include "bip32.h"
 #include "lcx_sha256.h"
 
 #include "constants.h"
+#include "lz_decoder.h"
 #include "transaction/types.h"
 
 /**
@@ -21,6 +23,16 @@ typedef enum {
     SIGN_TX = 0x06,
     /** Instruction to get the PBC blockchain address of the given BIP32 path. */
     GET_ADDRESS = 0x07,
+    /** Instruction to sign the given message with the given BIP32 path. */
+    SIGN_MESSAGE = 0x08,
+    /** Instruction to store a transaction template for later SIGN_TX commands. */
+    SET_TX_TEMPLATE = 0x09,
+    /** Instruction to get and reset the instrumentation counters. Requires HAVE_STATS. */
+    GET_STATS = 0x0A,
+    /** Instruction to get the stack high-water marks. Requires HAVE_STACK_USAGE. */
+    GET_STACK_USAGE = 0x0B,
+    /** Instruction to get the maximum and preferred lengths of chunks. */
+    GET_CHUNK_SIZE = 0x0C,
 } command_e;
 
 /**
@@ -42,7 +54,9 @@ typedef enum {
     /** Confirm address derived from public key. */
     CONFIRM_ADDRESS,
     /** Confirm transaction information. */
-    CONFIRM_TRANSACTION
+    CONFIRM_TRANSACTION,
+    /** Confirm message to sign. */
+    CONFIRM_MESSAGE
 } request_type_e;
 
 /**
@@ -83,30 +97,142 @@ typedef struct {
     transaction_t transaction;
     /** Which chain the transaction is targeting. */
     chain_id_t chain_id;
-    /** Message digest state. */
-    cx_sha256_t digest_state;
-    /** Message hash digest. */
-    uint8_t m_hash[CX_SHA256_SIZE];
-    /** Transaction signature. */
-    ecdsa_signature_t signature;
+    /** Whether compressed chunks of the RPC have been received. */
+    bool rpc_compressed;
 } transaction_ctx_t;
 
+/**
+ * Structure for a transaction template.
+ *
+ * Stores the fields that are repeated across many transactions, such that
+ * SIGN_TX commands only need to send the fields that change.
+ */
+typedef struct {
+    /** Whether the template has been set. */
+    bool is_set;
+    /** BIP32 path to sign with. */
+    uint32_t bip32_path[MAX_BIP32_PATH];
+    /** Length of BIP32 path. */
+    uint8_t bip32_path_len;
+    /** Which chain the transactions are targeting. */
+    chain_id_t chain_id;
+    /** Amount of gas to be used for the transactions. */
+    uint64_t gas_cost;
+    /** Contract address to interact with. */
+    blockchain_address_s contract_address;
+} tx_template_t;
+
+/**
+ * Structure for message information context.
+ */
+typedef struct {
+    /** Total length of the message, as announced in the first chunk. */
+    uint32_t length;
+    /** Number of message bytes received so far. */
+    uint32_t received;
+    /**
+     * First bytes of the message, shown as a preview. Allocated from the arena
+     * with room for #MESSAGE_PREVIEW_LENGTH bytes.
+     */
+    uint8_t *preview;
+} message_ctx_t;
+
+/**
+ * Text buffers for the fields shown while the user reviews a request.
+ */
+typedef struct {
+    union {
+        /** Text buffers for addresses and transactions. */
+        struct {
+            /** Text buffer for transaction gas cost. */
+            char gas_cost[PRIu64_MAX_LENGTH + 1 + TOKEN_SUFFIX_LEN + 1];
+            /** Text buffer for MPC transfer recipient or contract address. */
+            char address[2 * ADDRESS_LEN + 1];
+            union {
+                /** Text buffers for MPC transfers. */
+                struct {
+                    /** Text buffer for MPC transfer amounts, with a decimal point. */
+                    char transfer_amount[PRIu64_MAX_LENGTH + 1 + 1 + TOKEN_SUFFIX_LEN + 1];
+                    /** Text buffer for MPC transfer memos given as an u64. */
+                    char small_memo[PRIu64_MAX_LENGTH + 1 + TOKEN_SUFFIX_LEN + 1];
+                    /**
+                     * Text of the MPC transfer memo. Points either to
+                     * #small_memo or to the memo text in the arena.
+                     */
+                    const char *memo;
+                };
+                /** Text buffers for ZK contract invocations. */
+                struct {
+                    /** Text buffer for the invoked action. */
+                    char zk_action[sizeof("Open invocation 0xffffffff")];
+                    /** Text buffer for the size of the secret input. */
+                    char zk_secret_input_size[PRIu64_MAX_LENGTH + sizeof(" bits")];
+                };
+            };
+        };
+        /** Text buffers for messages. */
+        struct {
+            /** Text buffer for the message preview, possibly ending in "...". */
+            char message_preview[MESSAGE_PREVIEW_LENGTH + sizeof("...")];
+            /** Text buffer for the message hash, as hex. */
+            char message_hash[2 * CX_SHA256_SIZE + 1];
+        };
+    };
+    /** Text buffer for chain id. */
+    char chain_id[CHAIN_ID_MAX_LENGTH + 1];
+#ifdef HAVE_BAGL
+    /** Text buffer for the review step. */
+    char review_text[20];
+    /** Text buffer for the title of the address step. */
+    char address_title[10];
+#endif
+} display_ctx_t;
+
 /**
  * Global state for application.
+ *
+ * Request specific state is split by the phase it is needed in, so that
+ * scratch data for one phase can share RAM with the scratch data of another:
+ *
+ * - The digest state, and the decoder of compressed chunks, are only used while
+ *   the request data is streamed in.
+ * - The display strings are only used once the digest has been finalized, and
+ *   the user reviews the request.
+ *
+ * The window of the decoder is longer than the display strings, so that most of
+ * it adds to the size of the context. Its length is set per target, see
+ * #COMPRESSION_WINDOW_LEN.
  */
 typedef struct {
     /** state of the context. */
     state_e state;
-    union {
-        /** public key context. */
-        pubkey_ctx_t pk_info;
-        /** transaction context. */
-        transaction_ctx_t tx_info;
-    };
     /** User request. */
     request_type_e req_type;
     /** BIP32 path */
     uint32_t bip32_path[MAX_BIP32_PATH];
     /** length of BIP32 path */
     uint8_t bip32_path_len;
+    union {
+        /** public key context. */
+        pubkey_ctx_t pk_info;
+        /** transaction context. */
+        transaction_ctx_t tx_info;
+        /** message context. */
+        message_ctx_t msg_info;
+    };
+    union {
+        /** Used while streaming the request data. */
+        struct {
+            /** Message digest state. */
+            cx_sha256_t digest_state;
+            /** Decoder of compressed chunks of the transaction RPC. */
+            lz_decoder_t lz_decoder;
+        };
+        /** Display strings. Used while the user reviews the request. */
+        display_ctx_t display;
+    };
+    /** Hash digest of the transaction or message to sign. */
+    uint8_t m_hash[CX_SHA256_SIZE];
+    /** Signature of the hash digest. */
+    ecdsa_signature_t signature;
 } global_ctx_t;
@@ -25,6 +25,7 @@
 #include "../../status_words.h"
 #include "../../globals.h"
 #include "../../helper/send_response.h"
+#include "../../stats.h"
 
 void validate_address(bool choice) {
     if (choice) {
@@ -42,26 +43,30 @@ static int crypto_sign_message(void) {
     uint32_t info = 0;
 
     // Derives private key and signs the hash.
+    STATS_PHASE(STATS_PHASE_DERIVE);
     cx_err_t error = bip32_derive_ecdsa_sign_rs_hash_256(CX_CURVE_256K1,
                                                          G_context.bip32_path,
                                                          G_context.bip32_path_len,
                                                          CX_RND_RFC6979 | CX_LAST,
                                                          CX_SHA256,
-                                                         G_context.tx_info.m_hash,
-                                                         sizeof(G_context.tx_info.m_hash),
-                                                         G_context.tx_info.signature.r,
-                                                         G_context.tx_info.signature.s,
+                                                         G_context.m_hash,
+                                                         sizeof(G_context.m_hash),
+                                                         G_context.signature.r,
+                                                         G_context.signature.s,
                                                          &info);
     if (error != CX_OK) {
         return -1;
     }
 
-    G_context.tx_info.signature.recovery_id = info & (uint8_t) CX_ECCINFO_PARITY_ODD;
+    G_context.signature.recovery_id = info & (uint8_t) CX_ECCINFO_PARITY_ODD;
 
     return 0;
 }
 
-void validate_transaction(bool choice) {
+/**
+ * Signs G_context.m_hash when chosen, and sends the signature or the refusal.
+ */
+static void validate_signature(bool choice) {
     if (choice) {
         if (crypto_sign_message() != 0) {
             G_context.state = STATE_NONE;
@@ -79,3 +84,11 @@ void validate_transaction(bool choice) {
         io_send_sw(SW_DENY);
     }
 }
+
+void validate_transaction(bool choice) {
+    validate_signature(choice);
+}
+
+void validate_message(bool choice) {
+    validate_signature(choice);
+}
@@ -19,3 +19,11 @@ void validate_address(bool choice);
  *
  */
 void validate_transaction(bool choice);
+
+/**
+ * Action for message validation.
+ *
+ * @param[in] choice
+ *
+ */
+void validate_message(bool choice);
@@ -36,11 +36,6 @@
 #include "../transaction/types.h"
 #include "../menu.h"
 
-// Text buffer review text
-static char g_review_text[20];
-// Text buffer for title of address.
-static char g_address_title[10];
-
 static action_validate_cb g_validate_callback;
 
 // Validate/Invalidate public key and go back to home
@@ -55,14 +50,20 @@ static void ui_action_validate_transaction(bool choice) {
     ui_menu_main();
 }
 
+// Validate/Invalidate message and go back to home
+static void ui_action_validate_message(bool choice) {
+    validate_message(choice);
+    ui_menu_main();
+}
+
 // Step with icon and text
 UX_STEP_NOCB(ux_display_step_confirm_addr, pn, {&C_icon_eye, "Verify Address"});
 // Step with title/text for address
 UX_STEP_NOCB(ux_display_step_address,
              bnnn_paging,
              {
-                 .title = g_address_title,
-                 .text = g_address,
+                 .title = G_context.display.address_title,
+                 .text = G_context.display.address,
              });
 // Step with approve button
 UX_STEP_CB(ux_display_step_approve,
@@ -118,11 +119,12 @@ int ui_display_address() {
     }
 
     // Format address
+    clear_g_fields();
     if (!set_g_address(&G_context.pk_info.address)) {
         return io_send_sw(SW_DISPLAY_ADDRESS_FAIL);
     }
 
-    snprintf(g_address_title, sizeof(g_address_title), "Address");
+    snprintf(G_context.display.address_title, sizeof(G_context.display.address_title), "Address");
 
     // Start flow
     g_validate_callback = &ui_action_validate_address;
@@ -136,7 +138,7 @@ UX_STEP_NOCB(ux_display_step_review,
              {
                  &C_icon_eye,
                  "Review",
-                 g_review_text,
+                 G_context.display.review_text,
              });
 
 // Step with icon and text
@@ -153,27 +155,35 @@ UX_STEP_NOCB(ux_display_step_gas_cost,
              bnnn_paging,
              {
                  .title = "Fee",
-                 .text = g_gas_cost,
+                 .text = G_context.display.gas_cost,
              });
 
 UX_STEP_NOCB(ux_display_step_transfer_amount,
              bnnn_paging,
              {
                  .title = "Amount",
-                 .text = g_transfer_amount,
+                 .text = G_context.display.transfer_amount,
              });
 
-UX_STEP_NOCB(ux_display_step_memo,
+UX_STEP_NOCB(ux_display_step_zk_action,
              bnnn_paging,
              {
-                 .title = "Memo",
-                 .text = g_memo,
+                 .title = "Action",
+                 .text = G_context.display.zk_action,
              });
+
+UX_STEP_NOCB(ux_display_step_zk_secret_input_size,
+             bnnn_paging,
+             {
+                 .title = "Secret input",
+                 .text = G_context.display.zk_secret_input_size,
+             });
+
 UX_STEP_NOCB(ux_display_step_chain_id,
              bnnn_paging,
              {
                  .title = "Chain",
-                 .text = g_chain_id,
+                 .text = G_context.display.chain_id,
              });
 
 #define MAX_NUM_STEPS 9
@@ -195,8 +205,9 @@ int ui_display_transaction(void) {
     }
 
     // Update gas cost
-    if (!set_g_token_amount(g_gas_cost,
-                            sizeof(g_gas_cost),
+    clear_g_fields();
+    if (!set_g_token_amount(G_context.display.gas_cost,
+                            sizeof(G_context.display.gas_cost),
                             "Gas",
                             G_context.tx_info.transaction.basic.gas_cost,
                             0)) {
@@ -231,12 +242,41 @@ int ui_display_transaction(void) {
                 return io_send_sw(SW_DISPLAY_AMOUNT_FAIL);
             }
 
-            snprintf(g_review_text, sizeof(g_review_text), "MPC Transfer");
-            snprintf(g_address_title, sizeof(g_address_title), "Recipient");
+            snprintf(G_context.display.review_text,
+                     sizeof(G_context.display.review_text),
+                     "MPC Transfer");
+            snprintf(G_context.display.address_title,
+                     sizeof(G_context.display.address_title),
+                     "Recipient");
 
             ux_display_transaction_flow[ux_flow_idx++] = &ux_display_step_address;
             ux_display_transaction_flow[ux_flow_idx++] = &ux_display_step_transfer_amount;
 
+        } else if (G_context.tx_info.transaction.type == ZK_INVOCATION) {
+            // ZK contract invocation
+            zk_invocation_transaction_type_s *zk_invocation =
+                &G_context.tx_info.transaction.zk_invocation;
+
+            if (!set_g_address(&G_context.tx_info.transaction.basic.contract_address)) {
+                return io_send_sw(SW_DISPLAY_ADDRESS_FAIL);
+            }
+            if (!set_g_fields_for_zk_invocation(zk_invocation)) {
+                return io_send_sw(SW_DISPLAY_ZK_INVOCATION_FAIL);
+            }
+
+            snprintf(G_context.display.review_text,
+                     sizeof(G_context.display.review_text),
+                     "ZK Contract");
+            snprintf(G_context.display.address_title,
+                     sizeof(G_context.display.address_title),
+                     "Contract");
+
+            ux_display_transaction_flow[ux_flow_idx++] = &ux_display_step_address;
+            ux_display_transaction_flow[ux_flow_idx++] = &ux_display_step_zk_action;
+            if (zk_invocation->kind != ZK_OPEN_INVOCATION) {
+                ux_display_transaction_flow[ux_flow_idx++] = &ux_display_step_zk_secret_input_size;
+            }
+
         } else {
             // Blind sign
 
@@ -244,8 +284,12 @@ int ui_display_transaction(void) {
                 return io_send_sw(SW_DISPLAY_ADDRESS_FAIL);
             }
 
-            snprintf(g_review_text, sizeof(g_review_text), "Transaction");
-            snprintf(g_address_title, sizeof(g_address_title), "Contract");
+            snprintf(G_context.display.review_text,
+                     sizeof(G_context.display.review_text),
+                     "Transaction");
+            snprintf(G_context.display.address_title,
+                     sizeof(G_context.display.address_title),
+                     "Contract");
 
             // Warning
             ux_display_transaction_flow[ux_flow_idx++] = &ux_display_step_blind_sign_warning;
@@ -264,4 +308,53 @@ int ui_display_transaction(void) {
     return 0;
 }
 
+UX_STEP_NOCB(ux_display_step_message_preview,
+             bnnn_paging,
+             {
+                 .title = "Message",
+                 .text = G_context.display.message_preview,
+             });
+
+UX_STEP_NOCB(ux_display_step_message_hash,
+             bnnn_paging,
+             {
+                 .title = "Message hash",
+                 .text = G_context.display.message_hash,
+             });
+
+// FLOW to display message:
+// #1 screen: eye icon + "Review Message"
+// #2 screen: display message preview
+// #3 screen: display message hash
+// #4 screen: approve button
+// #5 screen: reject button
+UX_FLOW(ux_display_message_flow,
+        &ux_display_step_review,
+        &ux_display_step_message_preview,
+        &ux_display_step_message_hash,
+        &ux_display_step_approve,
+        &ux_display_step_reject);
+
+WARN_UNUSED_RESULT
+int ui_display_message(void) {
+    // Check current state
+    if (G_context.req_type != CONFIRM_MESSAGE || G_context.state != STATE_PARSED) {
+        G_context.state = STATE_NONE;
+        return io_send_sw(SW_BAD_STATE);
+    }
+
+    // Format preview and hash
+    clear_g_fields();
+    if (!set_g_fields_for_message(&G_context.msg_info, G_context.m_hash)) {
+        return io_send_sw(SW_DISPLAY_MESSAGE_FAIL);
+    }
+
+    snprintf(G_context.display.review_text, sizeof(G_context.display.review_text), "Message");
+
+    // Start flow
+    g_validate_callback = &ui_action_validate_message;
+    ux_flow_init(0, ux_display_message_flow, NULL);
+    return 0;
+}
+
 #endif
@@ -1,29 +1,19 @@
 
-#include <string.h>  // memset
+#include <string.h>  // memset, memcpy
 #include "format.h"
 #include "io.h"
 
 #include "common.h"
 #include "../address.h"
+#include "../globals.h"
 #include "../types.h"
 
-// Text buffer for transaction gas cost
-char g_gas_cost[PRIu64_MAX_LENGTH + 1];
-// Text buffer for MPC transfer amounts
-char g_transfer_amount[TOKEN_SUFFIX_LEN + 1 + PRIu64_MAX_LENGTH + 1];
-// Text buffer for MPC transfer recipient or contract address
-char g_address[2 * ADDRESS_LEN + 1];
-// Text buffer for MPC transfer memo
-char g_memo[MEMO_MAX_LENGTH + 1];
-// Text buffer for Chain Id
-char g_chain_id[CHAIN_ID_MAX_LENGTH + 1];
-
 /**
  * Formats a blockchain_address_s as a hex string.
  */
 WARN_UNUSED_RESULT
 static bool blockchain_address_format(blockchain_address_s* address, char* out, size_t out_len) {
-    memset(g_address, 0, sizeof(g_address));
+    memset(out, 0, out_len);
     return format_hex(address->raw_bytes, ADDRESS_LEN, out, out_len) != -1;
 }
 
@@ -41,34 +31,36 @@ static void replace_unreadable(char* str, size_t str_len) {
 }
 
 /**
- * Sets the memo text.
+ * Sets the memo text. The text is made readable in place, and must be followed
+ * by a null terminator.
  */
 static void set_g_memo_text(uint8_t* text, size_t text_len) {
-    size_t g_memo_len = sizeof(g_memo);
-    size_t copy_amount = text_len < g_memo_len ? text_len : g_memo_len;
+    char* memo = (char*) text;
+    replace_unreadable(memo, text_len);
+    G_context.display.memo = memo;
+}
 
-    memcpy(g_memo, text, copy_amount);
-    replace_unreadable(g_memo, copy_amount);
-    g_memo[copy_amount - 1] = 0;
+void clear_g_fields(void) {
+    explicit_bzero(&G_context.display, sizeof(G_context.display));
 }
 
 WARN_UNUSED_RESULT
 bool set_g_address(blockchain_address_s* address) {
-    memset(g_address, 0, sizeof(g_address));
-    return blockchain_address_format(address, g_address, sizeof(g_address));
+    return blockchain_address_format(address,
+                                     G_context.display.address,
+                                     sizeof(G_context.display.address));
 }
 
 WARN_UNUSED_RESULT
 bool set_g_chain_id(chain_id_t* chain_id) {
-    int num_written_chars = snprintf(g_chain_id,
-                                     sizeof(g_chain_id),
-                                     "%.*s",
-                                     (int) chain_id->length,
-                                     chain_id->raw_bytes);
-    if (!(0 <= num_written_chars && (size_t) num_written_chars < sizeof(g_chain_id))) {
+    char* out = G_context.display.chain_id;
+    size_t out_size = sizeof(G_context.display.chain_id);
+    int num_written_chars =
+        snprintf(out, out_size, "%.*s", (int) chain_id->length, chain_id->raw_bytes);
+    if (!(0 <= num_written_chars && (size_t) num_written_chars < out_size)) {
         return false;
     }
-    replace_unreadable(g_chain_id, sizeof(g_chain_id));
+    replace_unreadable(out, out_size);
     return true;
 }
 
@@ -102,8 +94,8 @@ bool set_g_fields_for_mpc_transfer(mpc_transfer_transaction_type_s* mpc_transfer
     }
 
     // Display token transfer amount
-    if (!set_g_token_amount(g_transfer_amount,
-                            sizeof(g_transfer_amount),
+    if (!set_g_token_amount(G_context.display.transfer_amount,
+                            sizeof(G_context.display.transfer_amount),
                             "MPC",
                             mpc_transfer->token_amount_10000ths,
                             MPC_TOKEN_DECIMALS)) {
@@ -111,13 +103,77 @@ bool set_g_fields_for_mpc_transfer(mpc_transfer_transaction_type_s* mpc_transfer
     }
 
     // Display Memo
+    G_context.display.memo = G_context.display.small_memo;
     if (mpc_transfer->memo_length > 0) {
         if (mpc_transfer->has_u64_memo) {
-            return set_g_token_amount(g_memo, sizeof(g_memo), "   ", mpc_transfer->memo_u64, 0);
+            return set_g_token_amount(G_context.display.small_memo,
+                                      sizeof(G_context.display.small_memo),
+                                      "   ",
+                                      mpc_transfer->memo_u64,
+                                      0);
         } else {
-            set_g_memo_text(mpc_transfer->memo, sizeof(mpc_transfer->memo));
+            set_g_memo_text(mpc_transfer->memo, mpc_transfer->memo_length);
         }
     }
 
     return true;
 }
+
+WARN_UNUSED_RESULT
+bool set_g_fields_for_zk_invocation(zk_invocation_transaction_type_s* zk_invocation) {
+    char* action = G_context.display.zk_action;
+    size_t action_size = sizeof(G_context.display.zk_action);
+    int num_written_chars;
+
+    // Display action
+    if (zk_invocation->kind == ZK_OPEN_INVOCATION) {
+        num_written_chars = snprintf(action,
+                                     action_size,
+                                     "Open invocation 0x%x",
+                                     (unsigned int) zk_invocation->shortname);
+    } else if (zk_invocation->kind == ZK_SECRET_INPUT_ON_CHAIN) {
+        num_written_chars = snprintf(action, action_size, "Secret input (on-chain)");
+    } else {
+        num_written_chars = snprintf(action, action_size, "Secret input (off-chain)");
+    }
+    if (!(0 <= num_written_chars && (size_t) num_written_chars < action_size)) {
+        return false;
+    }
+
+    // Display size of the secret input
+    if (zk_invocation->kind == ZK_OPEN_INVOCATION) {
+        return true;
+    }
+    char number_buffer[PRIu64_MAX_LENGTH + 1] = {0};
+    if (!format_u64(number_buffer, sizeof(number_buffer), zk_invocation->secret_input_bits)) {
+        return false;
+    }
+    num_written_chars = snprintf(G_context.display.zk_secret_input_size,
+                                 sizeof(G_context.display.zk_secret_input_size),
+                                 "%s bits",
+                                 number_buffer);
+    return 0 <= num_written_chars &&
+           (size_t) num_written_chars < sizeof(G_context.display.zk_secret_input_size);
+}
+
+WARN_UNUSED_RESULT
+bool set_g_fields_for_message(message_ctx_t* message, const uint8_t hash[CX_SHA256_SIZE]) {
+    // Display preview
+    char* preview = G_context.display.message_preview;
+    size_t preview_len =
+        message->length < MESSAGE_PREVIEW_LENGTH ? message->length : MESSAGE_PREVIEW_LENGTH;
+    for (size_t i = 0; i < preview_len; i++) {
+        // Null bytes are replaced too, as the preview is not null terminated
+        char c = (char) message->preview[i];
+        preview[i] = (c < ' ' || '~' < c) ? '?' : c;
+    }
+    if (message->length > MESSAGE_PREVIEW_LENGTH) {
+        memcpy(preview + preview_len, "...", sizeof("..."));
+    }
+
+    // Display hash
+    return format_hex(hash,
+                      CX_SHA256_SIZE,
+                      G_context.display.message_hash,
+                      sizeof(G_context.display.message_hash)) != -1;
+}
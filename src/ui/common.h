@@ -3,26 +3,23 @@
 #include <stdbool.h>  // bool
 
 #include "../address.h"
+#include "../constants.h"
 #include "../types.h"
 
-#define PRIu64_MAX_LENGTH 20
-#define TOKEN_SUFFIX_LEN  3
-
 /*** Common UI fields ***/
 
-// Text buffer for transaction gas cost
-extern char g_gas_cost[PRIu64_MAX_LENGTH + 1];
-// Text buffer for MPC transfer amounts
-extern char g_transfer_amount[TOKEN_SUFFIX_LEN + 1 + PRIu64_MAX_LENGTH + 1];
-// Text buffer for MPC transfer recipient or contract address
-extern char g_address[2 * ADDRESS_LEN + 1];
-// Text buffer for MPC transfer memo
-extern char g_memo[MEMO_MAX_LENGTH + 1];
-// Text buffer for Chain Id
-extern char g_chain_id[CHAIN_ID_MAX_LENGTH + 1];
+// The text buffers for the UI fields are stored in G_context.display, which
+// shares memory with the digest state. They must only be set once the digest
+// has been finalized.
 
 /*** Common UI methods ***/
 
+/**
+ * Clears all displayed fields. Must be called before setting any field, as the
+ * display fields share memory with the digest state.
+ */
+void clear_g_fields(void);
+
 /**
  * Replaces the displayed address with the given address.
  *
@@ -52,6 +49,15 @@ bool set_g_token_amount(char* out,
 WARN_UNUSED_RESULT
 bool set_g_fields_for_mpc_transfer(mpc_transfer_transaction_type_s* mpc_transfer);
 
+/**
+ * Replaces the fields for displaying an invocation of a zero-knowledge contract
+ * with the values from the given invocation.
+ *
+ * @return false when any field failed to be displayed.
+ */
+WARN_UNUSED_RESULT
+bool set_g_fields_for_zk_invocation(zk_invocation_transaction_type_s* zk_invocation);
+
 /**
  * Replaces the fields for displaying the chain id, with the given chain id.
  *
@@ -59,3 +65,12 @@ bool set_g_fields_for_mpc_transfer(mpc_transfer_transaction_type_s* mpc_transfer
  */
 WARN_UNUSED_RESULT
 bool set_g_chain_id(chain_id_t* chain_id);
+
+/**
+ * Replaces the fields for displaying a message with a preview of the given
+ * message and its hash.
+ *
+ * @return false when any field failed to be displayed.
+ */
+WARN_UNUSED_RESULT
+bool set_g_fields_for_message(message_ctx_t* message, const uint8_t hash[CX_SHA256_SIZE]);
@@ -24,3 +24,12 @@ int ui_display_address(void);
  */
 WARN_UNUSED_RESULT
 int ui_display_transaction(void);
+
+/**
+ * Display message preview and hash on the device and ask confirmation to sign.
+ *
+ * @return 0 if success, negative integer otherwise.
+ *
+ */
+WARN_UNUSED_RESULT
+int ui_display_message(void);
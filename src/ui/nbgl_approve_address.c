@@ -62,7 +62,7 @@ static void review_choice(bool confirm) {
 }
 
 static void continue_review(void) {
-    nbgl_useCaseAddressConfirmation(g_address, review_choice);
+    nbgl_useCaseAddressConfirmation(G_context.display.address, review_choice);
 }
 
 WARN_UNUSED_RESULT
@@ -72,6 +72,7 @@ int ui_display_address() {
         return io_send_sw(SW_BAD_STATE);
     }
 
+    clear_g_fields();
     if (!set_g_address(&G_context.pk_info.address)) {
         return io_send_sw(SW_DISPLAY_ADDRESS_FAIL);
     }
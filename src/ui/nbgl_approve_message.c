@@ -0,0 +1,92 @@
+#ifdef HAVE_NBGL
+
+#include <stdbool.h>  // bool
+
+#include "os.h"
+#include "glyphs.h"
+#include "nbgl_use_case.h"
+#include "io.h"
+
+#include "common.h"
+#include "display.h"
+#include "constants.h"
+#include "../globals.h"
+#include "../status_words.h"
+#include "action/validate.h"
+#include "../menu.h"
+
+static nbgl_layoutTagValue_t pairs[2];
+static nbgl_layoutTagValueList_t pairList;
+static nbgl_pageInfoLongPress_t infoLongPress;
+
+static void confirm_message_rejection(void) {
+    // display a status page and go back to main
+    validate_message(false);
+    nbgl_useCaseStatus("Message rejected", false, ui_menu_main);
+}
+
+static void ask_message_rejection_confirmation(void) {
+    // display a choice to confirm/cancel rejection
+    nbgl_useCaseConfirm("Reject message?",
+                        NULL,
+                        "Yes, Reject",
+                        "Go back to message",
+                        confirm_message_rejection);
+}
+
+// called when long press button on 3rd page is long-touched or when reject footer is touched
+static void review_choice(bool confirm) {
+    if (confirm) {
+        // display a status page and go back to main
+        validate_message(true);
+        nbgl_useCaseStatus("MESSAGE\nSIGNED", true, ui_menu_main);
+    } else {
+        ask_message_rejection_confirmation();
+    }
+}
+
+static void review_message(void) {
+    // Setup data to display
+    pairs[0].item = "Message";
+    pairs[0].value = G_context.display.message_preview;
+    pairs[1].item = "Message hash";
+    pairs[1].value = G_context.display.message_hash;
+
+    // Setup list
+    pairList.nbMaxLinesForValue = 0;
+    pairList.nbPairs = 2;
+    pairList.pairs = pairs;
+
+    // Info long press
+    infoLongPress.icon = &C_app_pbc_64px;
+    infoLongPress.text = "Sign message?";
+    infoLongPress.longPressText = "Hold to sign";
+
+    nbgl_useCaseStaticReview(&pairList, &infoLongPress, "Reject message", review_choice);
+}
+
+// Public function to start the message review
+// - Check if the app is in the right state for message review
+// - Format the preview and hash strings in the G_context.display buffers
+// - Display the first screen of the message review
+int ui_display_message(void) {
+    if (G_context.req_type != CONFIRM_MESSAGE || G_context.state != STATE_PARSED) {
+        G_context.state = STATE_NONE;
+        return io_send_sw(SW_BAD_STATE);
+    }
+
+    clear_g_fields();
+    if (!set_g_fields_for_message(&G_context.msg_info, G_context.m_hash)) {
+        return io_send_sw(SW_DISPLAY_MESSAGE_FAIL);
+    }
+
+    nbgl_useCaseReviewStart(&C_app_pbc_64px,
+                            "Review message",
+                            NULL,
+                            "Reject message",
+                            review_message,
+                            ask_message_rejection_confirmation);
+    return 0;
+}
+
+#endif
@@ -82,11 +82,11 @@ static void review_choice(bool confirm) {
 static void review_blind_transaction(void) {
     // Setup data to display
     pairs[0].item = "Chain";
-    pairs[0].value = g_chain_id;
+    pairs[0].value = G_context.display.chain_id;
     pairs[2].item = "Contract";
-    pairs[2].value = g_address;
+    pairs[2].value = G_context.display.address;
     pairs[1].item = "Fees";
-    pairs[1].value = g_gas_cost;
+    pairs[1].value = G_context.display.gas_cost;
 
     // Setup list
     pairList.nbMaxLinesForValue = 0;
@@ -104,15 +104,15 @@ static void review_blind_transaction(void) {
 static void review_mpc_transfer(void) {
     // Setup data to display
     pairs[0].item = "Chain";
-    pairs[0].value = g_chain_id;
+    pairs[0].value = G_context.display.chain_id;
     pairs[1].item = "To";
-    pairs[1].value = g_address;
+    pairs[1].value = G_context.display.address;
     pairs[2].item = "Amount";
-    pairs[2].value = g_transfer_amount;
+    pairs[2].value = G_context.display.transfer_amount;
     pairs[3].item = "Memo";
-    pairs[3].value = g_memo;
+    pairs[3].value = G_context.display.memo;
     pairs[4].item = "Fees";
-    pairs[4].value = g_gas_cost;
+    pairs[4].value = G_context.display.gas_cost;
 
     // Setup list
     pairList.nbMaxLinesForValue = 0;
@@ -127,6 +127,35 @@ static void review_mpc_transfer(void) {
     nbgl_useCaseStaticReview(&pairList, &infoLongPress, "Reject transaction", review_choice);
 }
 
+static void review_zk_invocation(void) {
+    // Setup data to display
+    uint8_t nb_pairs = 0;
+    pairs[nb_pairs].item = "Chain";
+    pairs[nb_pairs++].value = G_context.display.chain_id;
+    pairs[nb_pairs].item = "Contract";
+    pairs[nb_pairs++].value = G_context.display.address;
+    pairs[nb_pairs].item = "Action";
+    pairs[nb_pairs++].value = G_context.display.zk_action;
+    if (G_context.tx_info.transaction.zk_invocation.kind != ZK_OPEN_INVOCATION) {
+        pairs[nb_pairs].item = "Secret input";
+        pairs[nb_pairs++].value = G_context.display.zk_secret_input_size;
+    }
+    pairs[nb_pairs].item = "Fees";
+    pairs[nb_pairs++].value = G_context.display.gas_cost;
+
+    // Setup list
+    pairList.nbMaxLinesForValue = 0;
+    pairList.nbPairs = nb_pairs;
+    pairList.pairs = pairs;
+
+    // Info long press
+    infoLongPress.icon = &C_app_pbc_64px;
+    infoLongPress.text = "Sign transaction\nto ZK contract?";
+    infoLongPress.longPressText = "Hold to sign";
+
+    nbgl_useCaseStaticReview(&pairList, &infoLongPress, "Reject transaction", review_choice);
+}
+
 static void review_blind_transaction_callback_after_initial_warning(void) {
     nbgl_useCaseReviewStart(&C_app_pbc_64px,
                             "Review transaction",
@@ -146,6 +175,14 @@ static void ui_display_transaction_inner(void) {
                                 "Reject transaction",
                                 review_mpc_transfer,
                                 ask_transaction_rejection_confirmation);
+    } else if (G_context.tx_info.transaction.type == ZK_INVOCATION) {
+        // ZK contract invocation
+        nbgl_useCaseReviewStart(&C_app_pbc_64px,
+                                "Review transaction to ZK contract",
+                                NULL,
+                                "Reject transaction",
+                                review_zk_invocation,
+                                ask_transaction_rejection_confirmation);
     } else if (!N_storage.allow_blind_signing) {
         // Blind sign warning when disabled
 
@@ -170,7 +207,7 @@ static void ui_display_transaction_inner(void) {
 
 // Public function to start the transaction review
 // - Check if the app is in the right state for transaction review
-// - Format the amount and address strings in g_amount and g_address buffers
+// - Format the amount and address strings in the G_context.display buffers
 // - Display the first screen of the transaction review
 int ui_display_transaction(void) {
     if (G_context.req_type != CONFIRM_TRANSACTION || G_context.state != STATE_PARSED) {
@@ -179,8 +216,9 @@ int ui_display_transaction(void) {
     }
 
     // Update gas cost
-    if (!set_g_token_amount(g_gas_cost,
-                            sizeof(g_gas_cost),
+    clear_g_fields();
+    if (!set_g_token_amount(G_context.display.gas_cost,
+                            sizeof(G_context.display.gas_cost),
                             "Gas",
                             G_context.tx_info.transaction.basic.gas_cost,
                             0)) {
@@ -199,6 +237,15 @@ int ui_display_transaction(void) {
             return io_send_sw(SW_DISPLAY_AMOUNT_FAIL);
         }
 
+    } else if (G_context.tx_info.transaction.type == ZK_INVOCATION) {
+        // ZK contract invocation
+        if (!set_g_address(&G_context.tx_info.transaction.basic.contract_address)) {
+            return io_send_sw(SW_DISPLAY_ADDRESS_FAIL);
+        }
+        if (!set_g_fields_for_zk_invocation(&G_context.tx_info.transaction.zk_invocation)) {
+            return io_send_sw(SW_DISPLAY_ZK_INVOCATION_FAIL);
+        }
+
     } else {
         // Display contract address
         if (!set_g_address(&G_context.tx_info.transaction.basic.contract_address)) {
@@ -28,3 +28,18 @@
 #define MPC_TOKEN_SHORTNAME_TRANSFER_MEMO_SMALL 13
 /** Byte shortname of the MPC transfer with large memo invocation. */
 #define MPC_TOKEN_SHORTNAME_TRANSFER_MEMO_LARGE 23
+
+/**
+ * Invocation kind of secret inputs to zero-knowledge contracts, where the
+ * shares are sent off-chain.
+ *
+ * @see documentation/ZK_CONTRACT_FORMAT.md
+ */
+#define ZK_INVOCATION_KIND_SECRET_INPUT_OFF_CHAIN 0x04
+/**
+ * Invocation kind of secret inputs to zero-knowledge contracts, where the
+ * encrypted shares are sent on-chain.
+ */
+#define ZK_INVOCATION_KIND_SECRET_INPUT_ON_CHAIN 0x05
+/** Invocation kind of open invocations of zero-knowledge contracts. */
+#define ZK_INVOCATION_KIND_OPEN 0x09
@@ -0,0 +1,191 @@
+'''
+Persistent cache of the addresses of a device, such that a client does not
+derive the addresses of all its paths on the device again on every start.
+
+Addresses are stored in an SQLite file, keyed by the identity of the device
+and the BIP32 path. The identity of a device is its address at a fixed canary
+path, which is requested once when the cache is opened. A device with another
+seed thus has another identity, and none of the addresses cached for the
+previous seed are returned for it.
+
+A sample of the cache hits is checked against the device. A cached address
+that differs from the address of the device, because the file was altered or
+corrupted, raises AddressCacheMismatchError and drops every address cached for
+the device.
+
+    with AddressCache('addresses.sqlite', backend) as cache:
+        addresses = [cache.get_address(path) for path in paths]
+'''
+
+import random
+import sqlite3
+import threading
+from typing import Dict, Iterable, List, Optional
+
+from ragger.backend.interface import BackendInterface
+from ragger.bip import pack_derivation_path
+
+from .command_sender import PbcCommandSender
+from .response_unpacker import unpack_get_address_response
+from .transaction import Address
+
+# Path of the address identifying the device. Not used for accounts.
+CANARY_PATH = "m/44'/3757'/2147483647'/2147483647/2147483647"
+
+SCHEMA = '''
+CREATE TABLE IF NOT EXISTS addresses (
+    device BLOB NOT NULL,
+    path BLOB NOT NULL,
+    address BLOB NOT NULL,
+    PRIMARY KEY (device, path)
+) WITHOUT ROWID
+'''
+
+
+class AddressCacheMismatchError(Exception):
+    '''
+    A cached address differs from the address returned by the device.
+    '''
+
+
+class AddressCache:
+    '''
+    Cache of the addresses of a single device. Addresses can be requested from
+    several threads at once.
+    '''
+
+    def __init__(self,
+                 filename: str,
+                 backend: BackendInterface,
+                 sample_rate: float = 0.05,
+                 canary_path: str = CANARY_PATH,
+                 rng: Optional[random.Random] = None) -> None:
+        '''
+        :param filename: SQLite file of the cache, created if missing. May be
+            shared by the caches of several devices.
+        :param sample_rate: fraction of the cache hits that are checked
+            against the device.
+        :param rng: source of the samples, for reproducible tests.
+        '''
+        self.sender = PbcCommandSender(backend)
+        self.sample_rate = sample_rate
+        self.rng = rng if rng is not None else random.Random()
+        self.hits = 0
+        self.misses = 0
+        self.samples = 0
+
+        self._lock = threading.Lock()
+        self._db = sqlite3.connect(filename, check_same_thread=False)
+        self._db.execute('PRAGMA journal_mode=WAL')
+        self._db.execute(SCHEMA)
+        self._db.commit()
+
+        self.device = self._derive(canary_path).serialize()
+
+    def close(self) -> None:
+        self._db.close()
+
+    def __enter__(self) -> 'AddressCache':
+        return self
+
+    def __exit__(self, *exc_info) -> None:
+        self.close()
+
+    def _derive(self, path: str) -> Address:
+        return unpack_get_address_response(self.sender.get_address(path).data)
+
+    def _lookup(self, key: bytes) -> Optional[Address]:
+        with self._lock:
+            row = self._db.execute('SELECT address FROM addresses WHERE device = ? AND path = ?',
+                                   (self.device, key)).fetchone()
+        return Address.deserialize(row[0]) if row is not None else None
+
+    def _store(self, entries: Dict[bytes, Address]) -> None:
+        with self._lock, self._db:
+            self._db.executemany('INSERT OR REPLACE INTO addresses VALUES (?, ?, ?)',
+                                 [(self.device, key, address.serialize())
+                                  for key, address in entries.items()])
+
+    def _check(self, path: str, cached: Address) -> Address:
+        self.samples += 1
+        address = self._derive(path)
+        if address != cached:
+            self.clear()
+            raise AddressCacheMismatchError(f'Cached address of {path} differs from the device')
+        return address
+
+    def get_address(self, path: str) -> Address:
+        '''
+        Address of the given path, from the cache if present, and from the
+        device otherwise.
+        '''
+        key = pack_derivation_path(path)
+        cached = self._lookup(key)
+        if cached is None:
+            self.misses += 1
+            address = self._derive(path)
+            self._store({key: address})
+            return address
+
+        self.hits += 1
+        if self.rng.random() < self.sample_rate:
+            return self._check(path, cached)
+        return cached
+
+    def get_addresses(self, paths: Iterable[str]) -> List[Address]:
+        '''
+        Addresses of the given paths. The addresses missing from the cache are
+        stored in a single transaction.
+        '''
+        addresses: List[Address] = []
+        derived: Dict[bytes, Address] = {}
+        for path in paths:
+            key = pack_derivation_path(path)
+            cached = derived.get(key) or self._lookup(key)
+            if cached is None:
+                self.misses += 1
+                derived[key] = self._derive(path)
+                addresses.append(derived[key])
+                continue
+            self.hits += 1
+            if key not in derived and self.rng.random() < self.sample_rate:
+                cached = self._check(path, cached)
+            addresses.append(cached)
+        if derived:
+            self._store(derived)
+        return addresses
+
+    def verify(self, count: int) -> int:
+        '''
+        Checks up to the given number of randomly chosen cached addresses
+        against the device, and returns the number checked.
+        '''
+        with self._lock:
+            keys = [
+                row[0] for row in self._db.execute(
+                    'SELECT path FROM addresses WHERE device = ?', (self.device, ))
+            ]
+        chosen = self.rng.sample(keys, min(count, len(keys)))
+        for key in chosen:
+            cached = self._lookup(key)
+            if cached is not None:
+                self._check(unpack_derivation_path(key), cached)
+        return len(chosen)
+
+    def clear(self) -> None:
+        '''
+        Drops every address cached for the device.
+        '''
+        with self._lock, self._db:
+            self._db.execute('DELETE FROM addresses WHERE device = ?', (self.device, ))
+
+
+def unpack_derivation_path(packed: bytes) -> str:
+    '''
+    Path of a derivation path packed by pack_derivation_path.
+    '''
+    indexes = [
+        int.from_bytes(packed[1 + 4 * i:5 + 4 * i], byteorder='big') for i in range(packed[0])
+    ]
+    return 'm/' + '/'.join(
+        f"{index & 0x7FFFFFFF}'" if index & 0x80000000 else str(index) for index in indexes)
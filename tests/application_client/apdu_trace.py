@@ -0,0 +1,346 @@
+'''
+Traces of the APDUs exchanged with the application, for reproducing problems
+and slowdowns seen with real traffic.
+
+RecordingBackend wraps the backend of a client, and writes every APDU it
+exchanges with its response and timing to a trace:
+
+    with TraceWriter('signing.pbctrace') as trace:
+        client = PbcCommandSender(RecordingBackend(backend, trace))
+
+A trace is replayed on the host build of the APDU handlers by replay_trace.py,
+or on Speculos by test_replay_trace.py. compare_replay compares the replayed
+responses with the recorded ones, and reports the timing of every APDU.
+
+Trace format, all integers big endian:
+
+    header: magic 'PBCTRACE', u16 version, u64 start time in ns since the epoch
+    record: u8 flags, u8 CLA, u8 INS, u8 P1, u8 P2, u8 Lc,
+            varint start in us since the previous record, varint duration in us,
+            data (Lc bytes), u16 status word, u16 response length, response data
+
+Varints are unsigned LEB128. The start of the first record is relative to the
+start time of the trace.
+'''
+
+import dataclasses
+import struct
+import time
+from contextlib import contextmanager
+from typing import BinaryIO, Dict, Generator, Iterator, List, Optional, Union
+
+from ragger.backend.interface import BackendInterface, RAPDU
+from ragger.error import ExceptionRAPDU
+
+from .command_sender import CLA, InsType
+
+MAGIC = b'PBCTRACE'
+VERSION = 1
+HEADER = struct.Struct('>8sHQ')
+APDU_HEADER = struct.Struct('>5B')
+U16 = struct.Struct('>H')
+
+# The APDU was sent awaiting a review on the device
+FLAG_ASYNC = 0x01
+
+SW_OK = 0x9000
+SW_DENY = 0x6985
+
+# Responses that depend on the keys of the device, which differ between the
+# recording device and the replay unless they hold the same seed
+KEY_DEPENDENT_INS = [InsType.GET_ADDRESS, InsType.SIGN_TX, InsType.SIGN_MESSAGE]
+
+
+class TraceError(Exception):
+    pass
+
+
+@dataclasses.dataclass(frozen=True)
+class TraceRecord:
+    '''
+    APDU of a trace, with its response and timing.
+    '''
+    cla: int
+    ins: int
+    p1: int
+    p2: int
+    data: bytes
+    sw: int
+    response: bytes
+    # Since the start of the trace, in us
+    start_us: int
+    duration_us: int
+    # Whether the APDU was sent awaiting a review on the device
+    asynchronous: bool = False
+
+    def reviewed(self) -> bool:
+        '''
+        Whether the response followed a review on the device. APDUs sent
+        awaiting a review may also be rejected before any review.
+        '''
+        return self.asynchronous and self.sw in (SW_OK, SW_DENY)
+
+    def approved(self) -> bool:
+        '''
+        Whether the review of the APDU, if any, was approved.
+        '''
+        return self.sw != SW_DENY
+
+
+def write_varint(value: int) -> bytes:
+    assert value >= 0
+    result = bytearray()
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value == 0:
+            result.append(byte)
+            return bytes(result)
+        result.append(byte | 0x80)
+
+
+def read_varint(stream: BinaryIO) -> int:
+    value = 0
+    shift = 0
+    while True:
+        byte = stream.read(1)
+        if not byte:
+            raise TraceError('Truncated varint')
+        value |= (byte[0] & 0x7f) << shift
+        if byte[0] & 0x80 == 0:
+            return value
+        shift += 7
+        if shift > 63:
+            raise TraceError('Overflowing varint')
+
+
+def read_exactly(stream: BinaryIO, length: int, field: str) -> bytes:
+    result = stream.read(length)
+    if len(result) != length:
+        raise TraceError(f'Truncated {field}')
+    return result
+
+
+class TraceWriter:
+    '''
+    Writes the records of a trace to a file, as they are made.
+    '''
+
+    def __init__(self, filename: str) -> None:
+        self.file = open(filename, 'wb')  # pylint: disable=consider-using-with
+        self.start_ns = time.perf_counter_ns()
+        self.file.write(HEADER.pack(MAGIC, VERSION, time.time_ns()))
+        self.last_start_us = 0
+
+    def close(self) -> None:
+        self.file.close()
+
+    def __enter__(self) -> 'TraceWriter':
+        return self
+
+    def __exit__(self, *exc_info) -> None:
+        self.close()
+
+    def elapsed_us(self, ns: int) -> int:
+        return (ns - self.start_ns) // 1000
+
+    def write(self, record: TraceRecord) -> None:
+        self.file.write(b''.join([
+            bytes([FLAG_ASYNC if record.asynchronous else 0]),
+            APDU_HEADER.pack(record.cla, record.ins, record.p1, record.p2, len(record.data)),
+            write_varint(record.start_us - self.last_start_us),
+            write_varint(record.duration_us),
+            record.data,
+            U16.pack(record.sw),
+            U16.pack(len(record.response)),
+            record.response,
+        ]))
+        self.file.flush()
+        self.last_start_us = record.start_us
+
+
+def read_trace(filename: str) -> List[TraceRecord]:
+    with open(filename, 'rb') as stream:
+        return list(iter_trace(stream))
+
+
+def iter_trace(stream: BinaryIO) -> Iterator[TraceRecord]:
+    magic, version, _ = HEADER.unpack(read_exactly(stream, HEADER.size, 'header'))
+    if magic != MAGIC:
+        raise TraceError('Not an APDU trace')
+    if version != VERSION:
+        raise TraceError(f'Unsupported trace version {version}')
+
+    start_us = 0
+    while True:
+        flags = stream.read(1)
+        if not flags:
+            return
+        cla, ins, p1, p2, lc = APDU_HEADER.unpack(read_exactly(stream, APDU_HEADER.size, 'APDU'))
+        start_us += read_varint(stream)
+        duration_us = read_varint(stream)
+        data = read_exactly(stream, lc, 'data')
+        sw, = U16.unpack(read_exactly(stream, U16.size, 'status word'))
+        response_len, = U16.unpack(read_exactly(stream, U16.size, 'response length'))
+        response = read_exactly(stream, response_len, 'response')
+        yield TraceRecord(cla, ins, p1, p2, data, sw, response, start_us, duration_us,
+                          bool(flags[0] & FLAG_ASYNC))
+
+
+class RecordingBackend:
+    '''
+    Backend recording the APDUs exchanged by another backend to a trace. APDUs
+    rejected with an error status word are recorded before the error is
+    raised.
+    '''
+
+    def __init__(self, backend: BackendInterface, trace: TraceWriter) -> None:
+        self.backend = backend
+        self.trace = trace
+
+    def __getattr__(self, name):
+        return getattr(self.backend, name)
+
+    def _record(self, cla: int, ins: int, p1: int, p2: int, data: bytes, start_ns: int,
+                response: Optional[RAPDU], error: Optional[ExceptionRAPDU],
+                asynchronous: bool) -> None:
+        end_ns = time.perf_counter_ns()
+        if response is not None:
+            sw, response_data = response.status, bytes(response.data)
+        elif error is not None:
+            sw, response_data = error.status, bytes(error.data or b'')
+        else:
+            return
+        self.trace.write(
+            TraceRecord(cla, ins, p1, p2, bytes(data), sw, response_data,
+                        self.trace.elapsed_us(start_ns), (end_ns - start_ns) // 1000,
+                        asynchronous))
+
+    def exchange(self,
+                 cla: int,
+                 ins: int,
+                 p1: int = 0,
+                 p2: int = 0,
+                 data: Union[bytes, memoryview] = b'',
+                 **kwargs) -> RAPDU:
+        start_ns = time.perf_counter_ns()
+        try:
+            response = self.backend.exchange(cla=cla, ins=ins, p1=p1, p2=p2, data=data, **kwargs)
+        except ExceptionRAPDU as e:
+            self._record(cla, ins, p1, p2, data, start_ns, None, e, False)
+            raise
+        self._record(cla, ins, p1, p2, data, start_ns, response, None, False)
+        return response
+
+    @contextmanager
+    def exchange_async(self,
+                       cla: int,
+                       ins: int,
+                       p1: int = 0,
+                       p2: int = 0,
+                       data: Union[bytes, memoryview] = b'',
+                       **kwargs) -> Generator[None, None, None]:
+        start_ns = time.perf_counter_ns()
+        try:
+            with self.backend.exchange_async(cla=cla, ins=ins, p1=p1, p2=p2, data=data,
+                                             **kwargs) as response:
+                yield response
+        except ExceptionRAPDU as e:
+            self._record(cla, ins, p1, p2, data, start_ns, None, e, True)
+            raise
+        self._record(cla, ins, p1, p2, data, start_ns, self.backend.last_async_response, None,
+                     True)
+
+
+@dataclasses.dataclass(frozen=True)
+class ReplayedApdu:
+    '''
+    Response to an APDU of a trace when replayed. Skipped APDUs are not sent.
+    '''
+    sw: int
+    response: bytes
+    duration_us: int
+    skipped: bool = False
+
+
+def same_response(record: TraceRecord, replayed: ReplayedApdu, exact: bool) -> bool:
+    '''
+    Whether the replayed response matches the recorded one. Unless exact, the
+    data of responses that depend on the keys of the device are only compared
+    by length.
+    '''
+    if replayed.sw != record.sw:
+        return False
+    if not exact and record.cla == CLA and record.ins in KEY_DEPENDENT_INS:
+        return len(replayed.response) == len(record.response)
+    return replayed.response == record.response
+
+
+def compare_replay(records: List[TraceRecord], replayed: List[ReplayedApdu],
+                   exact: bool) -> Dict[str, object]:
+    '''
+    Report of a replay: the outcome and timing delta of every APDU, and the
+    recorded and replayed time per INS, without the APDUs with a review, whose
+    time includes the user.
+    '''
+    apdus = []
+    per_ins: Dict[str, Dict[str, int]] = {}
+    for index, (record, result) in enumerate(zip(records, replayed)):
+        entry = {
+            'index': index,
+            'ins': f'{record.cla:02x}{record.ins:02x}',
+            'p1': record.p1,
+            'p2': record.p2,
+            'lc': len(record.data),
+            'review': record.reviewed(),
+            'recorded_sw': f'{record.sw:04x}',
+            'recorded_us': record.duration_us,
+        }
+        if result.skipped:
+            entry['outcome'] = 'skipped'
+        else:
+            entry.update({
+                'outcome': 'match' if same_response(record, result, exact) else 'mismatch',
+                'replayed_sw': f'{result.sw:04x}',
+                'replayed_us': result.duration_us,
+                'delta_us': result.duration_us - record.duration_us,
+            })
+            if not record.reviewed():
+                totals = per_ins.setdefault(str(entry['ins']), {
+                    'count': 0,
+                    'recorded_us': 0,
+                    'replayed_us': 0
+                })
+                totals['count'] += 1
+                totals['recorded_us'] += record.duration_us
+                totals['replayed_us'] += result.duration_us
+        apdus.append(entry)
+
+    return {
+        'apdus': apdus,
+        'per_ins': per_ins,
+        'mismatches': sum(1 for entry in apdus if entry['outcome'] == 'mismatch'),
+        'skipped': sum(1 for entry in apdus if entry['outcome'] == 'skipped'),
+    }
+
+
+def format_report(report: Dict[str, object]) -> str:
+    lines = [
+        f"{'#':>5} {'ins':>4} {'p1':>3} {'p2':>3} {'lc':>4} {'sw':>9} {'recorded us':>12} "
+        f"{'replayed us':>12} {'delta us':>10}  outcome"
+    ]
+    for entry in report['apdus']:  # type: ignore[attr-defined]
+        sw = entry['recorded_sw']
+        if 'replayed_sw' in entry and entry['replayed_sw'] != sw:
+            sw = f"{sw}>{entry['replayed_sw']}"
+        review = ' (review)' if entry['review'] else ''
+        lines.append(f"{entry['index']:>5} {entry['ins']:>4} {entry['p1']:>3} {entry['p2']:>3} "
+                     f"{entry['lc']:>4} {sw:>9} {entry['recorded_us']:>12} "
+                     f"{entry.get('replayed_us', '-'):>12} {entry.get('delta_us', '-'):>10}  "
+                     f"{entry['outcome']}{review}")
+    lines.append('')
+    for ins, totals in report['per_ins'].items():  # type: ignore[attr-defined]
+        lines.append(f"INS {ins}: {totals['count']} APDUs, recorded {totals['recorded_us']} us, "
+                     f"replayed {totals['replayed_us']} us")
+    lines.append(f"{report['mismatches']} mismatches, {report['skipped']} skipped")
+    return '\n'.join(lines)
@@ -0,0 +1,219 @@
+'''
+Asyncio client of the application, for driving one or more devices from a
+single event loop.
+
+Ragger backends are blocking, so the exchanges with a device run on a thread
+dedicated to that device, one request at a time as the device requires. The
+host-side work of a request runs concurrently with the exchanges of other
+requests:
+
+- Serialization and chunking of a request are done while the device is still
+  busy with the previous request.
+- Signatures are verified on an executor, while the device already handles the
+  next request.
+
+Requests to the same device are sent in the order they were made. Requests to
+different senders run concurrently, such that one event loop keeps several
+devices busy:
+
+    senders = [AsyncPbcCommandSender(backend) for backend in backends]
+    signatures = await asyncio.gather(*[
+        sender.sign_tx(path, transaction, chain_id) for sender in senders
+    ])
+
+Reviews must be approved on the device, by the user or by automation, while
+the signing requests are awaited.
+'''
+
+import asyncio
+import dataclasses
+from concurrent.futures import Executor, ThreadPoolExecutor
+from typing import Callable, Dict, List, Optional, Tuple, TypeVar
+
+from ragger.backend.interface import BackendInterface, RAPDU
+from ragger.bip import pack_derivation_path
+from ragger.error import ExceptionRAPDU
+
+from .command_sender import (MAX_APDU_LEN, P1, P2, ApduPacket, Errors, InsType,
+                             negotiated_chunk_len, sign_message_packets, sign_tx_packets,
+                             sign_tx_with_template_packets, tx_template_data)
+from .response_unpacker import (unpack_get_address_response, unpack_get_app_name_response,
+                                unpack_get_version_response, unpack_sign_tx_response)
+from .transaction import (Address, Signature, message_signed_bytes, transaction_signed_bytes,
+                          verify_signature)
+
+T = TypeVar('T')
+
+
+class SignatureVerificationError(Exception):
+    '''
+    The device returned a signature that is not a signature of the request by
+    the key of the signing path.
+    '''
+
+
+class AsyncPbcCommandSender:
+    '''
+    Asyncio version of PbcCommandSender for a single device.
+
+    Addresses of signing paths are requested from the device once, and are
+    used to verify the signatures returned by the device.
+    '''
+
+    def __init__(self,
+                 backend: BackendInterface,
+                 host_executor: Optional[Executor] = None,
+                 verify_signatures: bool = True) -> None:
+        '''
+        :param host_executor: executor for serialization, chunking and
+            signature verification. The default executor of the event loop
+            when None.
+        '''
+        self.backend = backend
+        self.host_executor = host_executor
+        self.verify_signatures = verify_signatures
+        # Length of the chunks of the signing requests, see
+        # negotiate_chunk_size
+        self.max_chunk_len = MAX_APDU_LEN
+        # Exchanges with the device, on a single thread
+        self._device_executor = ThreadPoolExecutor(max_workers=1)
+        # Held for all the packets of a request. Waiters acquire it in order.
+        # Created in the event loop that uses it.
+        self._device_lock: Optional[asyncio.Lock] = None
+        self._addresses: Dict[str, 'asyncio.Future[Address]'] = {}
+
+    def close(self) -> None:
+        self._device_executor.shutdown(wait=True)
+
+    async def __aenter__(self) -> 'AsyncPbcCommandSender':
+        return self
+
+    async def __aexit__(self, *exc_info) -> None:
+        self.close()
+
+    # Scheduling
+
+    async def _on_host(self, function: Callable[..., T], *args) -> T:
+        return await asyncio.get_running_loop().run_in_executor(
+            self.host_executor, function, *args)
+
+    def _exchange_all(self, packets: List[ApduPacket]) -> RAPDU:
+        '''
+        Sends the packets of a request, and returns the response to the last
+        one. Runs on the thread of the device.
+        '''
+        response = None
+        for packet in packets:
+            response = self.backend.exchange(**dataclasses.asdict(packet))
+        assert response is not None
+        return response
+
+    async def send_packets(self, packets: List[ApduPacket]) -> RAPDU:
+        '''
+        Sends the packets of a request once the device is done with the
+        requests made before. Error status words raise like for the blocking
+        backend.
+        '''
+        if self._device_lock is None:
+            self._device_lock = asyncio.Lock()
+        async with self._device_lock:
+            return await asyncio.get_running_loop().run_in_executor(
+                self._device_executor, self._exchange_all, packets)
+
+    async def _send(self, ins: InsType, p1: int = P1.P1_FIRST_CHUNK, data: bytes = b'') -> RAPDU:
+        return await self.send_packets(
+            [ApduPacket(ins, p1, P2.P2_LAST_CHUNK, data)])  # type: ignore[arg-type]
+
+    # Commands
+
+    async def get_version(self) -> Tuple[int, int, int]:
+        response = await self._send(InsType.GET_VERSION)
+        return unpack_get_version_response(response.data)
+
+    async def get_app_name(self) -> str:
+        response = await self._send(InsType.GET_APP_NAME)
+        return unpack_get_app_name_response(response.data)
+
+    async def negotiate_chunk_size(self, packet_payload: Optional[int] = None) -> int:
+        '''
+        Sets the length of the chunks of the signing requests, like
+        PbcCommandSender.negotiate_chunk_size.
+        '''
+        try:
+            response = await self._send(InsType.GET_CHUNK_SIZE)
+        except ExceptionRAPDU as e:
+            if e.status != Errors.SW_INS_NOT_SUPPORTED:
+                raise
+            return self.max_chunk_len
+        self.max_chunk_len = negotiated_chunk_len(response.data, packet_payload)
+        return self.max_chunk_len
+
+    async def get_address(self, path: str) -> Address:
+        response = await self._send(InsType.GET_ADDRESS, P1.P1_SILENT, pack_derivation_path(path))
+        return unpack_get_address_response(response.data)
+
+    async def address_of_path(self, path: str) -> Address:
+        '''
+        Address of the given path, requested from the device only once, also
+        when requested concurrently.
+        '''
+        if path not in self._addresses:
+            future = asyncio.ensure_future(self.get_address(path))
+            self._addresses[path] = future
+            try:
+                await future
+            except Exception:
+                del self._addresses[path]
+                raise
+        return await self._addresses[path]
+
+    async def set_tx_template(self, template_id: int, path: str, chain_id: bytes, gas_cost: int,
+                              contract_address: bytes) -> None:
+        data = tx_template_data(path, chain_id, gas_cost, contract_address)
+        await self.send_packets([
+            ApduPacket(InsType.SET_TX_TEMPLATE, template_id, P2.P2_LAST_CHUNK,
+                       data)  # type: ignore[arg-type]
+        ])
+
+    async def _sign(self, path: Optional[str], packets: List[ApduPacket],
+                    signed_bytes: bytes) -> Signature:
+        '''
+        Sends a signing request, and verifies the returned signature against
+        the address of the signing path, if known.
+        '''
+        address = None
+        if self.verify_signatures and path is not None:
+            address = await self.address_of_path(path)
+        response = await self.send_packets(packets)
+        signature = unpack_sign_tx_response(response.data)
+
+        if address is not None and not await self._on_host(verify_signature, address, signature,
+                                                            signed_bytes):
+            raise SignatureVerificationError(f'Invalid signature for {path}')
+        return signature
+
+    async def sign_tx(self, path: str, transaction: bytes, chain_id: bytes) -> Signature:
+        packets = await self._on_host(sign_tx_packets, path, transaction, chain_id,
+                                      self.max_chunk_len)
+        return await self._sign(path, packets, transaction_signed_bytes(transaction, chain_id))
+
+    async def sign_tx_with_template(self,
+                                    template_id: int,
+                                    transaction: bytes,
+                                    path: Optional[str] = None,
+                                    chain_id: Optional[bytes] = None) -> Signature:
+        '''
+        Signs a transaction with a template. The signature is only verified
+        when the path and chain id of the template are given.
+        '''
+        packets = await self._on_host(sign_tx_with_template_packets, template_id, transaction,
+                                      self.max_chunk_len)
+        if chain_id is None:
+            path = None
+            chain_id = b''
+        return await self._sign(path, packets, transaction_signed_bytes(transaction, chain_id))
+
+    async def sign_message(self, path: str, message: bytes) -> Signature:
+        packets = await self._on_host(sign_message_packets, path, message, self.max_chunk_len)
+        return await self._sign(path, packets, message_signed_bytes(message))
+
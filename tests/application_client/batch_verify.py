@@ -0,0 +1,175 @@
+'''
+Verification of many signatures of transactions and messages at once, for
+reconciling signatures made by the application.
+
+Signatures are verified with the native secp256k1 library of coincurve when it
+is installed. Otherwise they are verified with the pure Python ecdsa package,
+on a pool of processes.
+
+Like verify_signature_with_address of Transaction, a signature is valid when
+it is a signature of the signed bytes by the key of the address. The recovery
+id of the signature is only used to find that key faster.
+
+    verifier = BatchVerifier()
+    result = verifier.verify_transactions(
+        (transaction, chain_id, signature, address) for ... in signatures)
+    print(result.signatures_per_second, result.invalid)
+'''
+
+import dataclasses
+import os
+import time
+from concurrent.futures import ProcessPoolExecutor
+from hashlib import sha256
+from typing import Iterable, List, Optional, Sequence, Tuple, Union
+
+from .transaction import (Address, Serializable, Signature, message_signed_bytes,
+                          transaction_signed_bytes, verify_signature)
+
+try:
+    import coincurve  # type: ignore
+except ImportError:
+    coincurve = None
+
+BACKEND_NATIVE = 'coincurve'
+BACKEND_PROCESSES = 'ecdsa'
+
+# Signed bytes, signature and address of a signature to verify. Plain bytes,
+# such that items are cheap to send to the processes of the pool.
+Item = Tuple[bytes, bytes, bytes]
+
+
+@dataclasses.dataclass(frozen=True)
+class BatchResult:
+    '''
+    Validity of every signature of a batch, in the order of the batch.
+    '''
+    valid: List[bool]
+    seconds: float
+    backend: str
+
+    @property
+    def invalid(self) -> List[int]:
+        return [index for index, valid in enumerate(self.valid) if not valid]
+
+    @property
+    def signatures_per_second(self) -> float:
+        return len(self.valid) / self.seconds if self.seconds > 0 else float('inf')
+
+
+def sha256_digest(data: bytes) -> bytes:
+    return sha256(data).digest()
+
+
+def native_available() -> bool:
+    return coincurve is not None
+
+
+def verify_native(items: Sequence[Item]) -> List[bool]:
+    '''
+    Verifies signatures with libsecp256k1, by recovering the key of each
+    signature and comparing its address.
+    '''
+    results = []
+    for signed_bytes, signature, address in items:
+        valid = False
+        # The recovery id of the signature first, then the others
+        recovery_ids = [signature[0]] + [i for i in range(4) if i != signature[0]]
+        for recovery_id in recovery_ids:
+            try:
+                public_key = coincurve.PublicKey.from_signature_and_message(
+                    signature[1:] + bytes([recovery_id]), signed_bytes, hasher=sha256_digest)
+            except ValueError:
+                continue
+            if Address.from_public_key(public_key.format(compressed=False)).raw_bytes == address:
+                valid = True
+                break
+        results.append(valid)
+    return results
+
+
+def verify_python(items: Sequence[Item]) -> List[bool]:
+    '''
+    Verifies signatures with the ecdsa package. Runs in the processes of the
+    pool.
+    '''
+    return [
+        verify_signature(Address(address), Signature.deserialize(signature), signed_bytes)
+        for signed_bytes, signature, address in items
+    ]
+
+
+class BatchVerifier:
+    '''
+    Verifies batches of signatures. The pool of processes, if any, is started
+    on the first batch large enough to need it, and kept until closed.
+    '''
+
+    def __init__(self,
+                 backend: Optional[str] = None,
+                 processes: Optional[int] = None,
+                 chunk_size: int = 256) -> None:
+        '''
+        :param backend: BACKEND_NATIVE or BACKEND_PROCESSES. The native
+            backend if available when None.
+        :param processes: size of the pool. The number of CPUs when None.
+        :param chunk_size: signatures sent to a process at once. Batches of
+            at most this size are verified without the pool.
+        '''
+        if backend is None:
+            backend = BACKEND_NATIVE if native_available() else BACKEND_PROCESSES
+        if backend == BACKEND_NATIVE and not native_available():
+            raise ValueError('coincurve is not installed')
+        if backend not in (BACKEND_NATIVE, BACKEND_PROCESSES):
+            raise ValueError(f'Unknown backend: {backend}')
+        self.backend = backend
+        self.processes = processes or os.cpu_count() or 1
+        self.chunk_size = chunk_size
+        self._pool: Optional[ProcessPoolExecutor] = None
+
+    def close(self) -> None:
+        if self._pool is not None:
+            self._pool.shutdown()
+            self._pool = None
+
+    def __enter__(self) -> 'BatchVerifier':
+        return self
+
+    def __exit__(self, *exc_info) -> None:
+        self.close()
+
+    def verify(self, items: Iterable[Item]) -> BatchResult:
+        items = list(items)
+        start = time.perf_counter()
+        if self.backend == BACKEND_NATIVE:
+            valid = verify_native(items)
+        elif len(items) <= self.chunk_size or self.processes == 1:
+            valid = verify_python(items)
+        else:
+            if self._pool is None:
+                self._pool = ProcessPoolExecutor(max_workers=self.processes)
+            chunks = [
+                items[offset:offset + self.chunk_size]
+                for offset in range(0, len(items), self.chunk_size)
+            ]
+            valid = [result for chunk in self._pool.map(verify_python, chunks) for result in chunk]
+        return BatchResult(valid, time.perf_counter() - start, self.backend)
+
+    def verify_transactions(
+        self, signatures: Iterable[Tuple[Union[bytes, Serializable], bytes, Signature, Address]]
+    ) -> BatchResult:
+        '''
+        Verifies (transaction, chain id, signature, address) tuples.
+        '''
+        return self.verify((transaction_signed_bytes(
+            transaction if isinstance(transaction, bytes) else transaction.serialize(),
+            chain_id), signature.serialize(), address.raw_bytes)
+                           for transaction, chain_id, signature, address in signatures)
+
+    def verify_messages(self, signatures: Iterable[Tuple[bytes, Signature,
+                                                         Address]]) -> BatchResult:
+        '''
+        Verifies (message, signature, address) tuples.
+        '''
+        return self.verify((message_signed_bytes(message), signature.serialize(),
+                            address.raw_bytes) for message, signature, address in signatures)
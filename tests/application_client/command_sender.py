@@ -1,15 +1,25 @@
 from __future__ import annotations # More sane typing
 
 import dataclasses
+import time
 from enum import IntEnum
-from typing import Generator, List, Optional
+from typing import Generator, Iterator, List, Optional, Tuple, Union
 from contextlib import contextmanager
 
 from ragger.backend.interface import BackendInterface, RAPDU
 from ragger.bip import pack_derivation_path
+from ragger.error import ExceptionRAPDU
+
+from .response_unpacker import unpack_get_chunk_size_response
+from .rpc_compression import COMPRESSION_WINDOW_LEN, compress
+from .transaction import Serializable
 
 MAX_APDU_LEN: int = 255
 
+# Bytes framing an APDU on the transport besides its data: the length prefix of
+# the APDU, and the CLA, INS, P1, P2 and Lc header.
+APDU_FRAMING_LEN: int = 2 + 5
+
 CLA: int = 0xE0
 
 
@@ -18,6 +28,10 @@ class P1(IntEnum):
     P1_FIRST_CHUNK = 0x00
     # SIGN_TX: Parameter 1 indicating non-first chunk.
     P1_NOT_FIRST_CHUNK = 0x01
+    # SIGN_TX: Parameter 1 indicating first chunk, referencing a template
+    P1_TEMPLATE_FIRST_CHUNK = 0x02
+    # SIGN_TX: Parameter 1 indicating non-first chunk of compressed RPC bytes
+    P1_COMPRESSED_CHUNK = 0x03
     # GET_ADDRESS: Parameter 1 to skip screen confirmation
     P1_SILENT = 0x00
     # GET_ADDRESS: Parameter 1 for screen confirmation
@@ -36,6 +50,11 @@ class InsType(IntEnum):
     GET_APP_NAME = 0x04
     SIGN_TX = 0x06
     GET_ADDRESS = 0x07
+    SIGN_MESSAGE = 0x08
+    SET_TX_TEMPLATE = 0x09
+    GET_STATS = 0x0A
+    GET_STACK_USAGE = 0x0B
+    GET_CHUNK_SIZE = 0x0C
 
 
 class Errors(IntEnum):
@@ -55,6 +74,10 @@ class Errors(IntEnum):
     SW_SIGNATURE_FAIL = 0xB008
     SW_TX_PARSING_FAIL_EXPECTED_MORE_DATA = 0xB00A
     SW_TX_PARSING_FAIL_EXPECTED_LESS_DATA = 0xB00B
+    SW_WRONG_MESSAGE_LENGTH = 0xB00D
+    SW_UNKNOWN_TX_TEMPLATE = 0xB00F
+    SW_TX_DECOMPRESSION_FAIL = 0xB010
+    SW_DISPLAY_ZK_INVOCATION_FAIL = 0xB011
 
     @staticmethod
     def from_code(code: int) -> Errors | None:
@@ -76,6 +99,29 @@ class ApduPacket:
         return dataclasses.replace(self, **kwargs)
 
 
+def aligned_chunk_len(max_chunk_len: int, packet_payload: int) -> int:
+    '''
+    Largest chunk length of at most max_chunk_len bytes whose APDU fills whole
+    transport packets of packet_payload bytes, or max_chunk_len if no APDU
+    fills a packet.
+    '''
+    packets = (APDU_FRAMING_LEN + max_chunk_len) // packet_payload
+    if packets == 0:
+        return max_chunk_len
+    return packets * packet_payload - APDU_FRAMING_LEN
+
+
+def negotiated_chunk_len(chunk_size_response: bytes, packet_payload: Optional[int] = None) -> int:
+    '''
+    Length of the chunks of the signing requests for the given GET_CHUNK_SIZE
+    response: as long as the app accepts, which takes the fewest APDUs. When
+    packet_payload is given, chunks are shortened to fill whole transport
+    packets of packet_payload bytes.
+    '''
+    _, max_chunk_len, _, _ = unpack_get_chunk_size_response(chunk_size_response)
+    return aligned_chunk_len(max_chunk_len, packet_payload) if packet_payload else max_chunk_len
+
+
 def split_message(message: bytes, max_size: int) -> List[bytes]:
     return [message[x:x + max_size] for x in range(0, len(message), max_size)]
 
@@ -92,8 +138,81 @@ def create_apdu_packets_from_contents(
     return packets
 
 
-def sign_tx_packets(path: str, transaction: bytes,
-                    chain_id: bytes) -> list[ApduPacket]:
+# Chunk of a streamed request: P1, P2 and a view of the data of the chunk
+StreamChunk = Tuple[P1, P2, memoryview]
+
+
+def stream_chunks(first: bytes, rest: memoryview,
+                  max_size: int) -> Iterator[StreamChunk]:
+    '''
+    Chunks of a request whose first chunk is the given bytes, followed by
+    chunks of at most max_size bytes of the rest. The chunks are views of the
+    given data, which is not copied.
+    '''
+    p1 = P1.P1_FIRST_CHUNK
+    chunk = memoryview(first)
+    offset = 0
+    while True:
+        last = offset == len(rest)
+        yield p1, P2.P2_LAST_CHUNK if last else P2.P2_NOT_LAST_CHUNK, chunk
+        if last:
+            return
+        p1 = P1.P1_NOT_FIRST_CHUNK
+        chunk = rest[offset:offset + max_size]
+        offset += len(chunk)
+
+
+def serialize_to_view(serializable: Union[bytes, Serializable]) -> memoryview:
+    '''
+    View of the serialization, written into a single preallocated buffer
+    unless already given as bytes.
+    '''
+    if isinstance(serializable, bytes):
+        return memoryview(serializable)
+    # Slice assignment to a bytearray copies the assigned bytes first, unlike
+    # slice assignment to a memoryview.
+    buffer = memoryview(bytearray(serializable.serialized_size()))
+    end = serializable.serialize_into(buffer, 0)
+    assert end == len(buffer)
+    return buffer
+
+
+def sign_tx_stream(path: str,
+                   transaction: Union[bytes, Serializable],
+                   chain_id: bytes,
+                   max_chunk_len: int = MAX_APDU_LEN) -> Iterator[StreamChunk]:
+    '''
+    Chunks of SIGN_TX, like sign_tx_packets, without intermediate copies of
+    the transaction.
+    '''
+    initial_packet_contents = b''.join([
+        pack_derivation_path(path),
+        len(chain_id).to_bytes(4, byteorder="big"),
+        chain_id,
+    ])
+    return stream_chunks(initial_packet_contents,
+                         serialize_to_view(transaction), max_chunk_len)
+
+
+def sign_message_stream(path: str,
+                        message: bytes,
+                        max_chunk_len: int = MAX_APDU_LEN) -> Iterator[StreamChunk]:
+    '''
+    Chunks of SIGN_MESSAGE, like sign_message_packets, without copies of the
+    message.
+    '''
+    initial_packet_contents = b''.join([
+        pack_derivation_path(path),
+        len(message).to_bytes(4, byteorder="big"),
+    ])
+    return stream_chunks(initial_packet_contents, memoryview(message),
+                         max_chunk_len)
+
+
+def sign_tx_packets(path: str,
+                    transaction: bytes,
+                    chain_id: bytes,
+                    max_chunk_len: int = MAX_APDU_LEN) -> list[ApduPacket]:
 
     # Initial packet includes key path and chain id
     initial_packet_contents = b''.join([
@@ -103,14 +222,102 @@ def sign_tx_packets(path: str, transaction: bytes,
     ])
 
     packet_contents = [initial_packet_contents] + split_message(
-        transaction, MAX_APDU_LEN)
+        transaction, max_chunk_len)
     return create_apdu_packets_from_contents(InsType.SIGN_TX, packet_contents)
 
 
+def sign_tx_compressed_packets(path: str,
+                               transaction: bytes,
+                               chain_id: bytes,
+                               max_chunk_len: int = MAX_APDU_LEN,
+                               window_len: int = COMPRESSION_WINDOW_LEN) -> list[ApduPacket]:
+    '''
+    Packets of SIGN_TX with the RPC after the first transaction chunk
+    compressed, with copies from at most window_len bytes back. The first
+    transaction chunk is sent as is, such that the app parses the header and
+    the start of the RPC. Falls back on sign_tx_packets when compression does
+    not make the transaction shorter.
+    '''
+    packets = sign_tx_packets(path, transaction[:max_chunk_len], chain_id,
+                              max_chunk_len)
+    compressed = compress(transaction[max_chunk_len:], window_len)
+    if len(compressed) >= len(transaction) - max_chunk_len:
+        return sign_tx_packets(path, transaction, chain_id, max_chunk_len)
+
+    packets[-1] = packets[-1].replace(p2=P2.P2_NOT_LAST_CHUNK)
+    chunks = split_message(compressed, max_chunk_len)
+    for chunk_idx, chunk in enumerate(chunks):
+        p2 = P2.P2_NOT_LAST_CHUNK if chunk_idx != len(
+            chunks) - 1 else P2.P2_LAST_CHUNK
+        packets.append(
+            ApduPacket(InsType.SIGN_TX, P1.P1_COMPRESSED_CHUNK, p2, chunk))
+    return packets
+
+
+# Length of the transaction header fields: nonce, valid-to time, gas cost,
+# contract address and RPC length.
+TRANSACTION_HEADER_LEN: int = 8 + 8 + 8 + 21 + 4
+
+
+def tx_template_data(path: str, chain_id: bytes, gas_cost: int,
+                     contract_address: bytes) -> bytes:
+    return b''.join([
+        pack_derivation_path(path),
+        len(chain_id).to_bytes(4, byteorder="big"),
+        chain_id,
+        gas_cost.to_bytes(8, byteorder="big"),
+        contract_address,
+    ])
+
+
+def sign_tx_with_template_packets(
+        template_id: int,
+        transaction: bytes,
+        max_chunk_len: int = MAX_APDU_LEN) -> list[ApduPacket]:
+
+    # Initial packet includes the template id and the header fields that are
+    # not part of the template, followed by the start of the RPC.
+    initial_packet_contents = b''.join([
+        template_id.to_bytes(1, byteorder="big"),
+        transaction[0:16],
+        transaction[TRANSACTION_HEADER_LEN - 4:TRANSACTION_HEADER_LEN],
+    ])
+    rpc = transaction[TRANSACTION_HEADER_LEN:]
+    first_rpc_len = max_chunk_len - len(initial_packet_contents)
+
+    packet_contents = [initial_packet_contents + rpc[:first_rpc_len]
+                      ] + split_message(rpc[first_rpc_len:], max_chunk_len)
+    packets = create_apdu_packets_from_contents(InsType.SIGN_TX,
+                                                packet_contents)
+    packets[0] = packets[0].replace(p1=P1.P1_TEMPLATE_FIRST_CHUNK)
+    return packets
+
+
+def sign_message_packets(path: str,
+                         message: bytes,
+                         max_chunk_len: int = MAX_APDU_LEN) -> list[ApduPacket]:
+
+    # Initial packet includes key path and message length
+    initial_packet_contents = b''.join([
+        pack_derivation_path(path),
+        len(message).to_bytes(4, byteorder="big"),
+    ])
+
+    packet_contents = [initial_packet_contents] + split_message(
+        message, max_chunk_len)
+    return create_apdu_packets_from_contents(InsType.SIGN_MESSAGE,
+                                             packet_contents)
+
+
 class PbcCommandSender:
 
     def __init__(self, backend: BackendInterface) -> None:
         self.backend = backend
+        # Length of the chunks of SIGN_TX and SIGN_MESSAGE, see
+        # negotiate_chunk_size
+        self.max_chunk_len = MAX_APDU_LEN
+        # Window of the compressed chunks of SIGN_TX, see negotiate_chunk_size
+        self.compression_window_len = COMPRESSION_WINDOW_LEN
 
     def get_app_and_version(self) -> RAPDU:
         return self.backend.exchange(
@@ -134,6 +341,50 @@ class PbcCommandSender:
                                      p2=P2.P2_LAST_CHUNK,
                                      data=b"")
 
+    def get_stats(self) -> RAPDU:
+        return self.backend.exchange(cla=CLA,
+                                     ins=InsType.GET_STATS,
+                                     p1=P1.P1_FIRST_CHUNK,
+                                     p2=P2.P2_LAST_CHUNK,
+                                     data=b"")
+
+    def get_stack_usage(self) -> RAPDU:
+        return self.backend.exchange(cla=CLA,
+                                     ins=InsType.GET_STACK_USAGE,
+                                     p1=P1.P1_FIRST_CHUNK,
+                                     p2=P2.P2_LAST_CHUNK,
+                                     data=b"")
+
+    def get_chunk_size(self) -> RAPDU:
+        return self.backend.exchange(cla=CLA,
+                                     ins=InsType.GET_CHUNK_SIZE,
+                                     p1=P1.P1_FIRST_CHUNK,
+                                     p2=P2.P2_LAST_CHUNK,
+                                     data=b"")
+
+    def negotiate_chunk_size(self, packet_payload: Optional[int] = None) -> int:
+        '''Sets the length of the chunks of the signing requests
+
+        Chunks are as long as the app accepts. When packet_payload is given,
+        such as the payload of a BLE packet for the MTU of the connection,
+        chunks are shortened to fill whole transport packets. Versions of the
+        app without GET_CHUNK_SIZE keep chunks of MAX_APDU_LEN.
+
+        Also sets the window of compressed chunks to the one of the device.
+        '''
+        try:
+            response = self.get_chunk_size()
+        except ExceptionRAPDU as e:
+            if e.status != Errors.SW_INS_NOT_SUPPORTED:
+                raise
+            return self.max_chunk_len
+        if response.status != 0x9000:
+            return self.max_chunk_len
+
+        self.max_chunk_len = negotiated_chunk_len(response.data, packet_payload)
+        _, _, _, self.compression_window_len = unpack_get_chunk_size_response(response.data)
+        return self.max_chunk_len
+
     def get_address(self, path: str) -> RAPDU:
         return self.backend.exchange(cla=CLA,
                                      ins=InsType.GET_ADDRESS,
@@ -142,16 +393,43 @@ class PbcCommandSender:
                                      data=pack_derivation_path(path))
 
     @contextmanager
-    def send_packets(self,
-                     packets: list[ApduPacket]) -> Generator[None, None, None]:
-        '''Capable of sending raw packets and returning a response'''
+    def send_packets(
+        self,
+        packets: list[ApduPacket],
+        durations: Optional[list[float]] = None
+    ) -> Generator[None, None, None]:
+        '''Capable of sending raw packets and returning a response
+
+        When durations is given, the round-trip time in seconds of each packet
+        but the last is appended to it.
+        '''
         for packet in packets[:-1]:
+            start = time.perf_counter()
             self.backend.exchange(**dataclasses.asdict(packet))
+            if durations is not None:
+                durations.append(time.perf_counter() - start)
 
         with self.backend.exchange_async(
                 **dataclasses.asdict(packets[-1])) as response:
             yield response
 
+    @contextmanager
+    def send_stream(self, ins: InsType,
+                    chunks: Iterator[StreamChunk]) -> Generator[None, None, None]:
+        '''Sends the chunks of a streamed request straight to the backend
+
+        Each chunk is sent as soon as the next one is known, such that the
+        request is never held in packets.
+        '''
+        p1, p2, data = next(chunks)
+        for next_chunk in chunks:
+            self.backend.exchange(cla=CLA, ins=ins, p1=p1, p2=p2, data=data)
+            p1, p2, data = next_chunk
+
+        with self.backend.exchange_async(cla=CLA, ins=ins, p1=p1, p2=p2,
+                                         data=data) as response:
+            yield response
+
     @contextmanager
     def get_address_with_confirmation(self,
                                       path: str) -> Generator[None, None, None]:
@@ -166,8 +444,61 @@ class PbcCommandSender:
     @contextmanager
     def sign_tx(self, path: str, transaction: bytes,
                 chain_id: bytes) -> Generator[None, None, None]:
-        with self.send_packets(sign_tx_packets(path, transaction,
-                                               chain_id)) as response:
+        with self.send_packets(
+                sign_tx_packets(path, transaction, chain_id,
+                                self.max_chunk_len)) as response:
+            yield response
+
+    @contextmanager
+    def sign_tx_compressed(self, path: str, transaction: bytes,
+                           chain_id: bytes) -> Generator[None, None, None]:
+        with self.send_packets(
+                sign_tx_compressed_packets(path, transaction, chain_id, self.max_chunk_len,
+                                           self.compression_window_len)) as response:
+            yield response
+
+    @contextmanager
+    def sign_tx_streamed(self, path: str, transaction: Union[bytes, Serializable],
+                         chain_id: bytes) -> Generator[None, None, None]:
+        with self.send_stream(InsType.SIGN_TX,
+                              sign_tx_stream(path, transaction, chain_id,
+                                             self.max_chunk_len)) as response:
+            yield response
+
+    def set_tx_template(self, template_id: int, path: str, chain_id: bytes,
+                        gas_cost: int, contract_address: bytes) -> RAPDU:
+        return self.backend.exchange(cla=CLA,
+                                     ins=InsType.SET_TX_TEMPLATE,
+                                     p1=template_id,
+                                     p2=P2.P2_LAST_CHUNK,
+                                     data=tx_template_data(
+                                         path, chain_id, gas_cost,
+                                         contract_address))
+
+    @contextmanager
+    def sign_tx_with_template(
+            self, template_id: int,
+            transaction: bytes) -> Generator[None, None, None]:
+        with self.send_packets(
+                sign_tx_with_template_packets(
+                    template_id, transaction,
+                    self.max_chunk_len)) as response:
+            yield response
+
+    @contextmanager
+    def sign_message(self, path: str,
+                     message: bytes) -> Generator[None, None, None]:
+        with self.send_packets(
+                sign_message_packets(path, message,
+                                     self.max_chunk_len)) as response:
+            yield response
+
+    @contextmanager
+    def sign_message_streamed(self, path: str,
+                              message: bytes) -> Generator[None, None, None]:
+        with self.send_stream(InsType.SIGN_MESSAGE,
+                              sign_message_stream(path, message,
+                                                  self.max_chunk_len)) as response:
             yield response
 
     def get_async_response(self) -> Optional[RAPDU]:
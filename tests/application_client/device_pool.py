@@ -0,0 +1,319 @@
+'''
+Pool of devices holding the same seed, for signing with several devices at
+once.
+
+Each request is dispatched to the healthy device with the fewest requests in
+flight. A device handles one request at a time; further requests to it wait
+for their turn. Transport errors mark the device as unhealthy for a cooldown
+period, and the request is retried on another device. Status words returned by
+the application, such as a rejected review, are not retried.
+
+Retrying a signing request is safe: the devices hold the same seed and sign
+deterministically, so the same request gets the same signature on every
+device.
+
+The latency of every request is recorded per device and command in a
+histogram. The latency of signing includes the review by the user. Requests
+failed by the application, such as a rejected review, are counted per device
+and command instead, and do not weigh on the choice of device.
+'''
+
+import bisect
+import threading
+import time
+from typing import Callable, Dict, List, Optional, Sequence, Tuple, Type, TypeVar
+
+from ragger.backend.interface import BackendInterface
+
+from .command_sender import PbcCommandSender
+from .response_unpacker import unpack_get_address_response, unpack_sign_tx_response
+from .transaction import Address, Signature, transaction_signed_bytes, verify_signature
+
+T = TypeVar('T')
+
+
+class PoolError(Exception):
+    pass
+
+
+class NoHealthyDeviceError(PoolError):
+    '''
+    Every device of the pool is unhealthy, or has failed the request.
+    '''
+
+
+class SeedMismatchError(PoolError):
+    '''
+    A device does not hold the same seed as the other devices of the pool.
+    '''
+
+
+class LatencyHistogram:
+    '''
+    Histogram of latencies, with buckets of roughly logarithmic size.
+    '''
+
+    # Upper bounds of the buckets, in seconds. The last bucket is unbounded.
+    BOUNDS = (0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0, 2.0, 5.0, 10.0, 30.0,
+              60.0)
+
+    def __init__(self) -> None:
+        self.counts = [0] * (len(self.BOUNDS) + 1)
+        self.count = 0
+        self.total = 0.0
+
+    def record(self, seconds: float) -> None:
+        self.counts[bisect.bisect_left(self.BOUNDS, seconds)] += 1
+        self.count += 1
+        self.total += seconds
+
+    def mean(self) -> float:
+        return self.total / self.count if self.count else 0.0
+
+    def percentile(self, fraction: float) -> float:
+        '''
+        Upper bound of the bucket of the given percentile, or infinity if it is
+        in the unbounded bucket.
+        '''
+        if self.count == 0:
+            return 0.0
+        rank = fraction * self.count
+        seen = 0
+        for bucket, count in enumerate(self.counts):
+            seen += count
+            if seen >= rank and count > 0:
+                return self.BOUNDS[bucket] if bucket < len(self.BOUNDS) else float('inf')
+        return float('inf')
+
+    def as_dict(self) -> Dict[str, object]:
+        return {
+            'count': self.count,
+            'mean': self.mean(),
+            'p50': self.percentile(0.5),
+            'p99': self.percentile(0.99),
+            'buckets': dict(zip([str(bound) for bound in self.BOUNDS] + ['inf'], self.counts)),
+        }
+
+
+class PooledDevice:
+    '''
+    Device of a pool, with its load and health.
+    '''
+
+    def __init__(self, index: int, backend: BackendInterface) -> None:
+        self.index = index
+        self.backend = backend
+        self.sender = PbcCommandSender(backend)
+        # Held while the device handles a request
+        self.lock = threading.Lock()
+        # Requests dispatched to the device and not yet completed
+        self.in_flight = 0
+        self.consecutive_failures = 0
+        self.unhealthy_until = 0.0
+        # Whether the device signed with another seed, and is never used again
+        self.retired = False
+        self.latencies: Dict[str, LatencyHistogram] = {}
+        # Requests failed by the application, per command
+        self.errors: Dict[str, int] = {}
+
+    def is_healthy(self, now: float) -> bool:
+        return not self.retired and now >= self.unhealthy_until
+
+    def mean_latency(self) -> float:
+        count = sum(histogram.count for histogram in self.latencies.values())
+        total = sum(histogram.total for histogram in self.latencies.values())
+        return total / count if count else 0.0
+
+
+class DevicePool:
+    '''
+    Pool of devices holding the same seed. Requests can be made from several
+    threads at once.
+    '''
+
+    def __init__(self,
+                 backends: Sequence[BackendInterface],
+                 approve: Optional[Callable[[PooledDevice], None]] = None,
+                 transport_errors: Tuple[Type[BaseException], ...] = (OSError, ),
+                 max_attempts: int = 3,
+                 failures_before_unhealthy: int = 1,
+                 cooldown: float = 30.0) -> None:
+        '''
+        :param approve: called while a device shows a review, to approve it
+            by automation. The user approves the review when None.
+        :param transport_errors: exceptions of the backends that are retried
+            on another device.
+        :param max_attempts: devices to try a request on.
+        :param failures_before_unhealthy: consecutive transport errors after
+            which a device is unhealthy.
+        :param cooldown: seconds a device is unhealthy, before it is tried
+            again.
+        '''
+        if not backends:
+            raise ValueError('A pool needs at least one device')
+        self.devices = [PooledDevice(index, backend) for index, backend in enumerate(backends)]
+        self.approve = approve
+        self.transport_errors = transport_errors
+        self.max_attempts = max_attempts
+        self.failures_before_unhealthy = failures_before_unhealthy
+        self.cooldown = cooldown
+        # Guards the load and health of the devices, and the address cache
+        self._lock = threading.Lock()
+        self._addresses: Dict[str, Address] = {}
+
+    # Dispatching
+
+    def _acquire(self, excluded: List[PooledDevice]) -> PooledDevice:
+        '''
+        Picks the healthy device with the fewest requests in flight, and the
+        lowest mean latency among those.
+        '''
+        with self._lock:
+            now = time.monotonic()
+            candidates = [
+                device for device in self.devices
+                if device.is_healthy(now) and device not in excluded
+            ]
+            if not candidates:
+                raise NoHealthyDeviceError('No healthy device left for the request')
+            device = min(candidates, key=lambda d: (d.in_flight, d.mean_latency(), d.index))
+            device.in_flight += 1
+            return device
+
+    def _release(self,
+                 device: PooledDevice,
+                 command: str,
+                 latency: Optional[float],
+                 application_error: bool = False) -> None:
+        '''
+        Records a completed request. Transport errors and application errors
+        have no latency; only transport errors count against the health of
+        the device.
+        '''
+        with self._lock:
+            device.in_flight -= 1
+            if application_error:
+                # The device answered, but its latency depends on how the
+                # request failed, such as how long a review took to reject
+                device.consecutive_failures = 0
+                device.unhealthy_until = 0.0
+                device.errors[command] = device.errors.get(command, 0) + 1
+            elif latency is None:
+                device.consecutive_failures += 1
+                if device.consecutive_failures >= self.failures_before_unhealthy:
+                    device.unhealthy_until = time.monotonic() + self.cooldown
+            else:
+                device.consecutive_failures = 0
+                device.unhealthy_until = 0.0
+                device.latencies.setdefault(command, LatencyHistogram()).record(latency)
+
+    def run(self, command: str, operation: Callable[[PooledDevice], T]) -> T:
+        '''
+        Runs an operation on the least loaded healthy device, and on other
+        devices on transport errors.
+        '''
+        tried: List[PooledDevice] = []
+        last_error: Optional[BaseException] = None
+        for _ in range(self.max_attempts):
+            try:
+                device = self._acquire(tried)
+            except NoHealthyDeviceError as e:
+                raise e from last_error
+            tried.append(device)
+
+            # Latency of the device, without the wait for its previous requests
+            try:
+                with device.lock:
+                    start = time.perf_counter()
+                    result = operation(device)
+            except self.transport_errors as e:
+                self._release(device, command, None)
+                last_error = e
+                continue
+            except BaseException:
+                # Errors of the application, not of the device
+                self._release(device, command, None, application_error=True)
+                raise
+            self._release(device, command, time.perf_counter() - start)
+            return result
+        raise NoHealthyDeviceError(f'{command} failed on {len(tried)} devices') from last_error
+
+    # Commands
+
+    def get_address(self, path: str) -> Address:
+        return self.run(
+            'get_address',
+            lambda device: unpack_get_address_response(device.sender.get_address(path).data))
+
+    def address_of_path(self, path: str) -> Address:
+        '''
+        Address of the given path, requested from the pool only once.
+        '''
+        with self._lock:
+            address = self._addresses.get(path)
+        if address is None:
+            address = self.get_address(path)
+            with self._lock:
+                self._addresses[path] = address
+        return address
+
+    def check_same_seed(self, path: str) -> Address:
+        '''
+        Checks that every healthy device returns the same address for the
+        given path.
+        '''
+        addresses = set()
+        for device in self.devices:
+            if device.is_healthy(time.monotonic()):
+                # Wait for the requests already dispatched to the device
+                with device.lock:
+                    response = device.sender.get_address(path)
+                addresses.add(unpack_get_address_response(response.data))
+        if len(addresses) > 1:
+            raise SeedMismatchError(f'Devices return different addresses for {path}')
+        if not addresses:
+            raise NoHealthyDeviceError('No healthy device in the pool')
+        return addresses.pop()
+
+    def sign_tx(self, path: str, transaction: bytes, chain_id: bytes) -> Signature:
+        '''
+        Signs a transaction, and verifies the signature against the address of
+        the path, such that a device with another seed is detected.
+        '''
+        address = self.address_of_path(path)
+
+        def sign(device: PooledDevice) -> Signature:
+            with device.sender.sign_tx(path, transaction, chain_id):
+                if self.approve is not None:
+                    self.approve(device)
+            response = device.sender.get_async_response()
+            assert response is not None
+            signature = unpack_sign_tx_response(response.data)
+            if not verify_signature(address, signature,
+                                    transaction_signed_bytes(transaction, chain_id)):
+                device.retired = True
+                raise SeedMismatchError(f'Device {device.index} signed with another key')
+            return signature
+
+        return self.run('sign_tx', sign)
+
+    # Monitoring
+
+    def stats(self) -> List[Dict[str, object]]:
+        '''
+        Load, health, latency histograms and application errors of every
+        device.
+        '''
+        with self._lock:
+            now = time.monotonic()
+            return [{
+                'device': device.index,
+                'healthy': device.is_healthy(now),
+                'in_flight': device.in_flight,
+                'consecutive_failures': device.consecutive_failures,
+                'latency': {
+                    command: histogram.as_dict()
+                    for command, histogram in device.latencies.items()
+                },
+                'errors': dict(device.errors),
+            } for device in self.devices]
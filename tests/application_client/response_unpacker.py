@@ -1,4 +1,4 @@
-from typing import Tuple
+from typing import Dict, List, Tuple
 from struct import unpack
 from application_client.transaction import Signature, Address
 
@@ -59,3 +59,68 @@ def unpack_get_address_response(response: bytes) -> Address:
 # response = signature
 def unpack_sign_tx_response(response: bytes) -> Signature:
     return Signature.deserialize(response)
+
+
+# Names of the instrumented phases, in the order of the response
+STATS_PHASES = ['dispatch', 'parse', 'hash', 'derive', 'ui']
+
+
+# Unpack from response:
+# response = phase_count (1)
+#            count (4) * phase_count
+#            status_count (1)
+#            parser_status (4) * status_count
+#            blind_fallback (4) * status_count
+def unpack_get_stats_response(response: bytes) -> Dict[str, object]:
+    response, phase_count_raw = pop_sized_buf_from_buffer(response, 1)
+    phases: Dict[str, int] = {}
+    for phase in range(phase_count_raw[0]):
+        response, phase_raw = pop_sized_buf_from_buffer(response, 4)
+        name = STATS_PHASES[phase] if phase < len(STATS_PHASES) else str(phase)
+        phases[name] = unpack(">I", phase_raw)[0]
+
+    response, status_count_raw = pop_sized_buf_from_buffer(response, 1)
+    status_count = status_count_raw[0]
+    response, parser_status_raw = pop_sized_buf_from_buffer(
+        response, 4 * status_count)
+    response, blind_fallback_raw = pop_sized_buf_from_buffer(
+        response, 4 * status_count)
+
+    assert len(response) == 0
+
+    parser_status: List[int] = list(
+        unpack(f">{status_count}I", parser_status_raw))
+    blind_fallback: List[int] = list(
+        unpack(f">{status_count}I", blind_fallback_raw))
+    return {
+        'phases': phases,
+        'parser_status': parser_status,
+        'blind_fallback': blind_fallback,
+    }
+
+
+# Unpack from response:
+# response = stack_size (4)
+#            ins_count (1)
+#            [ins (1), high_water (4)] * ins_count
+def unpack_get_stack_usage_response(
+        response: bytes) -> Tuple[int, Dict[int, int]]:
+    response, stack_size_raw = pop_sized_buf_from_buffer(response, 4)
+    response, ins_count_raw = pop_sized_buf_from_buffer(response, 1)
+    high_water: Dict[int, int] = {}
+    for _ in range(ins_count_raw[0]):
+        response, entry_raw = pop_sized_buf_from_buffer(response, 5)
+        ins, used = unpack(">BI", entry_raw)
+        high_water[ins] = used
+
+    assert len(response) == 0
+
+    return unpack(">I", stack_size_raw)[0], high_water
+
+
+# Response = IO_BUFFER_SIZE (2) || MAX_CHUNK_LEN (2) || CHUNK_GRANULARITY (2)
+#            || COMPRESSION_WINDOW_LEN (2)
+def unpack_get_chunk_size_response(response: bytes) -> Tuple[int, int, int, int]:
+    assert len(response) == 8
+    io_buffer_size, max_chunk_len, granularity, window_len = unpack(">HHHH", response)
+    return io_buffer_size, max_chunk_len, granularity, window_len
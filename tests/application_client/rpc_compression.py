@@ -0,0 +1,107 @@
+from __future__ import annotations # More sane typing
+
+from collections import deque
+from typing import Deque, Dict
+
+# Compressed transfer encoding of RPC bytes, decompressed by src/lz_decoder.c.
+#
+# The stream is a sequence of tokens. A token byte t below 0x80 is followed by
+# t + 1 literal bytes. A token byte t of 0x80 or above copies (t & 0x7F) + 3
+# bytes, starting the u16 big endian distance that follows back in the
+# decompressed bytes.
+
+# Bytes kept by the app on every device, and farthest distance of a copy. Devices
+# with more RAM keep more, as reported by GET_CHUNK_SIZE.
+COMPRESSION_WINDOW_LEN: int = 256
+
+MIN_MATCH_LEN: int = 3
+MAX_MATCH_LEN: int = 0x7F + MIN_MATCH_LEN
+MAX_LITERAL_LEN: int = 0x7F + 1
+
+# Earlier positions with the same 3 bytes that are tried for a copy.
+MAX_CANDIDATES: int = 64
+
+
+class DecompressionError(Exception):
+    pass
+
+
+def _append_literals(out: bytearray, literals: bytes) -> None:
+    for start in range(0, len(literals), MAX_LITERAL_LEN):
+        run = literals[start:start + MAX_LITERAL_LEN]
+        out.append(len(run) - 1)
+        out += run
+
+
+def compress(data: bytes, window_len: int = COMPRESSION_WINDOW_LEN) -> bytes:
+    '''
+    Compresses data with greedy matching of the longest copy within the window.
+    '''
+    out = bytearray()
+    positions: Dict[bytes, Deque[int]] = {}
+    literals_start = 0
+    i = 0
+
+    def remember(position: int) -> None:
+        key = data[position:position + MIN_MATCH_LEN]
+        if len(key) == MIN_MATCH_LEN:
+            candidates = positions.setdefault(key, deque(maxlen=MAX_CANDIDATES))
+            candidates.append(position)
+
+    while i < len(data):
+        best_len, best_distance = 0, 0
+        longest = min(MAX_MATCH_LEN, len(data) - i)
+        for candidate in reversed(positions.get(data[i:i + MIN_MATCH_LEN], ())):
+            if i - candidate > window_len:
+                break
+            length = 0
+            while length < longest and data[candidate + length] == data[i + length]:
+                length += 1
+            if length > best_len:
+                best_len, best_distance = length, i - candidate
+                if length == longest:
+                    break
+
+        if best_len < MIN_MATCH_LEN:
+            remember(i)
+            i += 1
+            continue
+
+        _append_literals(out, data[literals_start:i])
+        out.append(0x80 | (best_len - MIN_MATCH_LEN))
+        out += best_distance.to_bytes(2, byteorder="big")
+        for position in range(i, i + best_len):
+            remember(position)
+        i += best_len
+        literals_start = i
+
+    _append_literals(out, data[literals_start:])
+    return bytes(out)
+
+
+def decompress(compressed: bytes,
+               window_len: int = COMPRESSION_WINDOW_LEN) -> bytes:
+    '''
+    Decompresses a complete stream, checking it like the app does.
+    '''
+    out = bytearray()
+    i = 0
+    while i < len(compressed):
+        token = compressed[i]
+        if token < 0x80:
+            literals = compressed[i + 1:i + 2 + token]
+            if len(literals) != token + 1:
+                raise DecompressionError("Stream ends inside literals")
+            out += literals
+            i += 2 + token
+            continue
+
+        if i + 3 > len(compressed):
+            raise DecompressionError("Stream ends inside a copy")
+        distance = int.from_bytes(compressed[i + 1:i + 3], byteorder="big")
+        if distance == 0 or distance > window_len or distance > len(out):
+            raise DecompressionError(f"Invalid distance {distance}")
+        for _ in range((token & 0x7F) + MIN_MATCH_LEN):
+            out.append(out[-distance])
+        i += 3
+    return bytes(out)
@@ -1,10 +1,12 @@
 from hashlib import sha256
 import dataclasses
+import struct
 from abc import ABC, abstractmethod
 from typing import Union
 
 from ecdsa.curves import SECP256k1  # type: ignore
-from ecdsa.keys import VerifyingKey  # type: ignore
+from ecdsa.errors import MalformedPointError  # type: ignore
+from ecdsa.keys import BadSignatureError, VerifyingKey  # type: ignore
 import ecdsa.util  # type: ignore
 
 UINT64_MAX: int = 2**64 - 1
@@ -16,12 +18,49 @@ class TransactionError(Exception):
     pass
 
 
+class Reader:
+    '''
+    Reads the fields of a serialized object, raising TransactionError naming
+    the field when the data ends early.
+    '''
+
+    def __init__(self, bts: bytes):
+        self.bts = bts
+        self.offset = 0
+
+    def read_bytes(self, length: int, field: str) -> bytes:
+        if length > len(self.bts) - self.offset:
+            raise TransactionError(f"Truncated {field}")
+        result = self.bts[self.offset:self.offset + length]
+        self.offset += length
+        return result
+
+    def read_int(self, length: int, field: str, signed: bool = False) -> int:
+        return int.from_bytes(self.read_bytes(length, field),
+                              byteorder='big',
+                              signed=signed)
+
+    def remaining(self) -> int:
+        return len(self.bts) - self.offset
+
+    def read_rest(self) -> bytes:
+        return self.read_bytes(self.remaining(), 'rest')
+
+    def expect_end(self, field: str):
+        if self.remaining() != 0:
+            raise TransactionError(f"Data after {field}")
+
+
 def from_hex(hexstr: str) -> bytes:
     print(hexstr)
     return bytes.fromhex(hexstr.replace("_", ''))
 
 
-# pylint: disable=too-few-public-methods
+# Writable buffer of serialize_into. Slices assigned to a memoryview are not
+# copied first, unlike slices assigned to a bytearray.
+Buffer = Union[bytearray, memoryview]
+
+
 class Serializable(ABC):
     '''
     A serializable transaction object.
@@ -31,6 +70,19 @@ class Serializable(ABC):
     def serialize(self) -> bytes:
         pass
 
+    def serialized_size(self) -> int:
+        return len(self.serialize())
+
+    def serialize_into(self, buffer: Buffer, offset: int) -> int:
+        '''
+        Writes the serialization into the buffer at the given offset, and
+        returns the offset after it. Objects without a serializer of their own
+        are serialized to bytes first.
+        '''
+        serialized = self.serialize()
+        buffer[offset:offset + len(serialized)] = serialized
+        return offset + len(serialized)
+
 
 @dataclasses.dataclass(frozen=True)
 class Address(Serializable):
@@ -48,6 +100,13 @@ class Address(Serializable):
     def serialize(self) -> bytes:
         return self.raw_bytes
 
+    def serialized_size(self) -> int:
+        return ADDRESS_LENGTH
+
+    def serialize_into(self, buffer: Buffer, offset: int) -> int:
+        buffer[offset:offset + ADDRESS_LENGTH] = self.raw_bytes
+        return offset + ADDRESS_LENGTH
+
     @staticmethod
     def from_hex(address: str) -> 'Address':
         assert len(address) == 21 * 2
@@ -91,6 +150,51 @@ class Signature(Serializable):
         ])
 
 
+def verify_signature(address: Address, signature: Signature, signed_bytes: bytes) -> bool:
+    '''
+    Verifies that the signature of the given bytes was made by the key of the
+    given address.
+    '''
+    rs_signature = signature.r + signature.s
+    try:
+        public_keys = VerifyingKey.from_public_key_recovery(rs_signature,
+                                                            signed_bytes,
+                                                            curve=SECP256k1,
+                                                            hashfunc=sha256)
+    except (ValueError, MalformedPointError):
+        return False
+
+    for public_key in public_keys:
+        if Address.from_public_key(public_key.to_string('uncompressed')) != address:
+            continue
+        try:
+            return public_key.verify(signature=rs_signature,
+                                     data=signed_bytes,
+                                     hashfunc=sha256,
+                                     sigdecode=ecdsa.util.sigdecode_string)
+        except BadSignatureError:
+            return False
+    return False
+
+
+def transaction_signed_bytes(transaction: bytes, chain_id: bytes) -> bytes:
+    '''
+    Bytes signed for a transaction: the transaction, followed by the length
+    prefixed chain id.
+    '''
+    return b''.join([transaction, len(chain_id).to_bytes(4, byteorder='big'), chain_id])
+
+
+def message_signed_bytes(message: bytes) -> bytes:
+    '''
+    Bytes signed for a message: the signing prefix, followed by the length
+    prefixed message.
+    '''
+    return b''.join(
+        [Message.SIGNING_PREFIX,
+         len(message).to_bytes(4, byteorder='big'), message])
+
+
 @dataclasses.dataclass(frozen=True)
 class Transaction(Serializable):
     '''
@@ -118,6 +222,27 @@ class Transaction(Serializable):
             raise TransactionError(
                 f"Bad address: '{self.contract_address}', expected Address!")
 
+    @staticmethod
+    def deserialize(bts: bytes) -> 'Transaction':
+        '''
+        Deserializes a transaction. The RPC is deserialized when it is a known
+        invocation of the contract, and kept as bytes otherwise.
+        '''
+        reader = Reader(bts)
+        nonce = reader.read_int(8, 'nonce')
+        valid_to_time = reader.read_int(8, 'valid_to_time')
+        gas_cost = reader.read_int(8, 'gas_cost')
+        contract_address = Address(
+            reader.read_bytes(ADDRESS_LENGTH, 'contract_address'))
+        rpc_length = reader.read_int(4, 'rpc_length')
+        if rpc_length > reader.remaining():
+            raise TransactionError("Truncated rpc")
+        rpc = reader.read_bytes(rpc_length, 'rpc')
+        reader.expect_end('rpc')
+
+        return Transaction(nonce, valid_to_time, gas_cost, contract_address,
+                           deserialize_rpc(contract_address, rpc))
+
     def serialize(self) -> bytes:
         rpc = self.rpc if isinstance(self.rpc, bytes) else self.rpc.serialize()
         return b"".join([
@@ -129,28 +254,60 @@ class Transaction(Serializable):
             rpc,
         ])
 
+    # Nonce, valid-to time and gas cost
+    HEADER_STRUCT = struct.Struct('>QQQ')
+    LENGTH_STRUCT = struct.Struct('>I')
+
+    def rpc_size(self) -> int:
+        if isinstance(self.rpc, bytes):
+            return len(self.rpc)
+        return self.rpc.serialized_size()
+
+    def serialized_size(self) -> int:
+        return Transaction.HEADER_STRUCT.size + ADDRESS_LENGTH + \
+            Transaction.LENGTH_STRUCT.size + self.rpc_size()
+
+    def serialize_into(self, buffer: Buffer, offset: int) -> int:
+        '''
+        Writes the transaction into the buffer without intermediate bytes,
+        also for an RPC of a known invocation.
+        '''
+        Transaction.HEADER_STRUCT.pack_into(buffer, offset, self.nonce,
+                                            self.valid_to_time, self.gas_cost)
+        offset = self.contract_address.serialize_into(
+            buffer, offset + Transaction.HEADER_STRUCT.size)
+        Transaction.LENGTH_STRUCT.pack_into(buffer, offset, self.rpc_size())
+        offset += Transaction.LENGTH_STRUCT.size
+        if isinstance(self.rpc, bytes):
+            buffer[offset:offset + len(self.rpc)] = self.rpc
+            return offset + len(self.rpc)
+        return self.rpc.serialize_into(buffer, offset)
+
     def verify_signature_with_address(self, address: Address,
                                       signature: Signature, chain_id: bytes):
         assert isinstance(address, Address)
+        return verify_signature(address, signature,
+                                transaction_signed_bytes(self.serialize(), chain_id))
 
-        # Determine the signed transaction
-        bytes_to_verify = b''.join([
-            self.serialize(),
-            len(chain_id).to_bytes(4, byteorder="big"),
-            chain_id,
-        ])
 
-        # Determine public key from the signature
-        rs_signature = signature.r + signature.s
-        pks: VerifyingKey = VerifyingKey.from_public_key_recovery(
-            rs_signature, bytes_to_verify, curve=SECP256k1, hashfunc=sha256)
+@dataclasses.dataclass(frozen=True)
+class Message(Serializable):
+    '''
+    Arbitrary off-chain message, signed with a prefix that separates it from
+    transactions.
+    '''
+
+    data: bytes
+
+    SIGNING_PREFIX = b'\x19Partisia Blockchain Signed Message:\n'
 
-        # Verify that derived public key is the desired address
+    def serialize(self) -> bytes:
+        return self.data
 
-        return pks[0].verify(signature=rs_signature,
-                             data=bytes_to_verify,
-                             hashfunc=sha256,
-                             sigdecode=ecdsa.util.sigdecode_string)
+    def verify_signature_with_address(self, address: Address,
+                                      signature: Signature):
+        assert isinstance(address, Address)
+        return verify_signature(address, signature, message_signed_bytes(self.data))
 
 
 @dataclasses.dataclass(frozen=True)
@@ -171,6 +328,29 @@ class MpcTokenTransfer(Serializable):
         if not isinstance(self.recipient_address, Address):
             raise TransactionError(f"Bad address: '{self.recipient_address}'!")
 
+    @staticmethod
+    def deserialize(bts: bytes) -> 'MpcTokenTransfer':
+        reader = Reader(bts)
+        shortname = reader.read_bytes(1, 'shortname')
+        if shortname not in [
+                MpcTokenTransfer.SHORTNAME_TRANSFER,
+                MpcTokenTransfer.SHORTNAME_TRANSFER_WITH_SMALL_MEMO,
+                MpcTokenTransfer.SHORTNAME_TRANSFER_WITH_LARGE_MEMO
+        ]:
+            raise TransactionError(f"Unknown shortname: '{shortname.hex()}'")
+        recipient_address = Address(
+            reader.read_bytes(ADDRESS_LENGTH, 'recipient_address'))
+        token_amount = reader.read_int(8, 'token_amount')
+
+        memo: Union[None, int, bytes] = None
+        if shortname == MpcTokenTransfer.SHORTNAME_TRANSFER_WITH_SMALL_MEMO:
+            memo = reader.read_int(8, 'memo')
+        elif shortname == MpcTokenTransfer.SHORTNAME_TRANSFER_WITH_LARGE_MEMO:
+            memo = reader.read_bytes(reader.read_int(4, 'memo_length'), 'memo')
+        reader.expect_end('memo')
+
+        return MpcTokenTransfer(recipient_address, token_amount, memo)
+
     def serialize(self) -> bytes:
         if self.memo is None:
             shortname = MpcTokenTransfer.SHORTNAME_TRANSFER
@@ -191,3 +371,177 @@ class MpcTokenTransfer(Serializable):
             self.token_amount.to_bytes(8, byteorder='big'),
             memo,
         ])
+
+    def serialized_size(self) -> int:
+        if self.memo is None:
+            memo_size = 0
+        elif isinstance(self.memo, int):
+            memo_size = 8
+        else:
+            memo_size = 4 + len(self.memo)
+        return 1 + ADDRESS_LENGTH + 8 + memo_size
+
+    def serialize_into(self, buffer: Buffer, offset: int) -> int:
+        if self.memo is None:
+            buffer[offset:offset + 1] = MpcTokenTransfer.SHORTNAME_TRANSFER
+        elif isinstance(self.memo, int):
+            buffer[offset:offset + 1] = MpcTokenTransfer.SHORTNAME_TRANSFER_WITH_SMALL_MEMO
+        else:
+            buffer[offset:offset + 1] = MpcTokenTransfer.SHORTNAME_TRANSFER_WITH_LARGE_MEMO
+        offset = self.recipient_address.serialize_into(buffer, offset + 1)
+        struct.pack_into('>Q', buffer, offset, self.token_amount)
+        offset += 8
+
+        if isinstance(self.memo, int):
+            struct.pack_into('>Q', buffer, offset, self.memo)
+            offset += 8
+        elif isinstance(self.memo, bytes):
+            struct.pack_into('>I', buffer, offset, len(self.memo))
+            offset += 4
+            buffer[offset:offset + len(self.memo)] = self.memo
+            offset += len(self.memo)
+        return offset
+
+
+def read_leb128_u32(reader: Reader, field: str) -> int:
+    '''
+    Reads an unsigned integer serialized as LEB128, of at most five bytes.
+    '''
+    value = 0
+    for shift in range(0, 35, 7):
+        byte = reader.read_int(1, field)
+        if shift == 28 and byte > 0x0f:
+            raise TransactionError(f"Overflowing {field}")
+        value |= (byte & 0x7f) << shift
+        if byte & 0x80 == 0:
+            return value
+    raise TransactionError(f"Overflowing {field}")
+
+
+def leb128_u32(value: int) -> bytes:
+    '''
+    Serializes an unsigned integer as LEB128.
+    '''
+    assert 0 <= value < 2**32
+    result = b''
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value == 0:
+            return result + bytes([byte])
+        result += bytes([byte | 0x80])
+
+
+@dataclasses.dataclass(frozen=True)
+class ZkOpenInvocation(Serializable):
+    '''
+    Open invocation of a public action of a zero-knowledge contract.
+    '''
+    shortname: int
+    arguments: bytes = b''
+
+    KIND = (0x09).to_bytes(1, byteorder='big')
+
+    @staticmethod
+    def deserialize(bts: bytes) -> 'ZkOpenInvocation':
+        reader = Reader(bts)
+        if reader.read_bytes(1, 'kind') != ZkOpenInvocation.KIND:
+            raise TransactionError("Not an open invocation")
+        shortname = read_leb128_u32(reader, 'shortname')
+        return ZkOpenInvocation(shortname, reader.read_rest())
+
+    def serialize(self) -> bytes:
+        return b''.join([
+            ZkOpenInvocation.KIND,
+            leb128_u32(self.shortname),
+            self.arguments,
+        ])
+
+
+@dataclasses.dataclass(frozen=True)
+class ZkSecretInput(Serializable):
+    '''
+    Secret input to a zero-knowledge contract. The payload following the bit
+    lengths (commitments or encrypted shares, and the public arguments) is not
+    interpreted.
+    '''
+    bit_lengths: list[int]
+    payload: bytes
+    on_chain: bool = True
+
+    KIND_OFF_CHAIN = (0x04).to_bytes(1, byteorder='big')
+    KIND_ON_CHAIN = (0x05).to_bytes(1, byteorder='big')
+
+    @staticmethod
+    def deserialize(bts: bytes) -> 'ZkSecretInput':
+        '''
+        Deserializes a secret input. Bit lengths must not be negative.
+        '''
+        reader = Reader(bts)
+        kind = reader.read_bytes(1, 'kind')
+        if kind not in [
+                ZkSecretInput.KIND_OFF_CHAIN, ZkSecretInput.KIND_ON_CHAIN
+        ]:
+            raise TransactionError("Not a secret input")
+        num_elements = reader.read_int(4, 'bit_lengths')
+        bit_lengths = []
+        for _ in range(num_elements):
+            bit_length = reader.read_int(4, 'bit_lengths', signed=True)
+            if bit_length < 0:
+                raise TransactionError(f"Negative bit length: {bit_length}")
+            bit_lengths.append(bit_length)
+        return ZkSecretInput(bit_lengths, reader.read_rest(),
+                             kind == ZkSecretInput.KIND_ON_CHAIN)
+
+    def serialize(self) -> bytes:
+        if self.on_chain:
+            kind = ZkSecretInput.KIND_ON_CHAIN
+        else:
+            kind = ZkSecretInput.KIND_OFF_CHAIN
+        return b''.join([
+            kind,
+            len(self.bit_lengths).to_bytes(4, byteorder='big'),
+            *[
+                bit_length.to_bytes(4, byteorder='big', signed=True)
+                for bit_length in self.bit_lengths
+            ],
+            self.payload,
+        ])
+
+    def serialized_size(self) -> int:
+        return 1 + 4 + 4 * len(self.bit_lengths) + len(self.payload)
+
+    def serialize_into(self, buffer: Buffer, offset: int) -> int:
+        if self.on_chain:
+            buffer[offset:offset + 1] = ZkSecretInput.KIND_ON_CHAIN
+        else:
+            buffer[offset:offset + 1] = ZkSecretInput.KIND_OFF_CHAIN
+        struct.pack_into(f'>I{len(self.bit_lengths)}i', buffer, offset + 1,
+                         len(self.bit_lengths), *self.bit_lengths)
+        offset += 1 + 4 + 4 * len(self.bit_lengths)
+        buffer[offset:offset + len(self.payload)] = self.payload
+        return offset + len(self.payload)
+
+
+MPC_TOKEN_ADDRESS = Address(
+    bytes.fromhex('01a4082d9d560749ecd0ffa1dcaaaee2c2cb25d881'))
+
+ADDRESS_TYPE_CONTRACT_ZK = 0x03
+
+
+def deserialize_rpc(contract_address: Address,
+                    rpc: bytes) -> Union[bytes, Serializable]:
+    '''
+    Deserializes the RPC of a transaction to the given contract, if it is a
+    known invocation. Unknown or malformed invocations are kept as bytes.
+    '''
+    try:
+        if contract_address == MPC_TOKEN_ADDRESS:
+            return MpcTokenTransfer.deserialize(rpc)
+        if contract_address.raw_bytes[0] == ADDRESS_TYPE_CONTRACT_ZK:
+            if rpc[:1] == ZkOpenInvocation.KIND:
+                return ZkOpenInvocation.deserialize(rpc)
+            return ZkSecretInput.deserialize(rpc)
+    except TransactionError:
+        pass
+    return rpc
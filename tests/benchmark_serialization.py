@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+'''
+Benchmark of the serialization and chunking of SIGN_TX requests on the host.
+
+Compares the packets of sign_tx_packets, built from Transaction.serialize, with
+the chunks of sign_tx_stream, which are views of a single buffer the
+transaction is serialized into. Both are consumed like a transport does, by
+taking the length of the data of every chunk.
+
+For every RPC size, reports the time per request and the peak memory
+allocated while building and consuming a request.
+'''
+
+import argparse
+import json
+import sys
+import timeit
+import tracemalloc
+from typing import Callable, Dict, List
+
+from application_client.command_sender import sign_tx_packets, sign_tx_stream
+from application_client.transaction import MPC_TOKEN_ADDRESS, Address, MpcTokenTransfer, \
+    Transaction
+from utils import CHAIN_IDS, KEY_PATH
+
+RECIPIENT = Address(bytes(21))
+
+
+def example_transaction(rpc_size: int) -> Transaction:
+    '''
+    MPC transfer whose RPC has about the given size, as a large memo.
+    '''
+    memo = bytes(range(256)) * (rpc_size // 256 + 1)
+    transfer = MpcTokenTransfer(RECIPIENT, 1000, memo[:max(rpc_size - 34, 0)])
+    return Transaction(1, 2, 3, MPC_TOKEN_ADDRESS, transfer)
+
+
+def packets_path(transaction: Transaction) -> int:
+    packets = sign_tx_packets(KEY_PATH, transaction.serialize(), CHAIN_IDS[0])
+    return sum(len(packet.data) for packet in packets)
+
+
+def stream_path(transaction: Transaction) -> int:
+    return sum(len(data) for _, _, data in sign_tx_stream(KEY_PATH, transaction, CHAIN_IDS[0]))
+
+
+def check_same_chunks(transaction: Transaction) -> None:
+    packets = sign_tx_packets(KEY_PATH, transaction.serialize(), CHAIN_IDS[0])
+    chunks = list(sign_tx_stream(KEY_PATH, transaction, CHAIN_IDS[0]))
+    assert [(packet.p1, packet.p2, packet.data) for packet in packets] == \
+        [(p1, p2, bytes(data)) for p1, p2, data in chunks]
+
+
+def peak_memory(path: Callable[[Transaction], int], transaction: Transaction) -> int:
+    tracemalloc.start()
+    tracemalloc.reset_peak()
+    start, _ = tracemalloc.get_traced_memory()
+    path(transaction)
+    _, peak = tracemalloc.get_traced_memory()
+    tracemalloc.stop()
+    return peak - start
+
+
+def measure(path: Callable[[Transaction], int], transaction: Transaction,
+            repetitions: int) -> Dict[str, float]:
+    timer = timeit.Timer(lambda: path(transaction))
+    number, _ = timer.autorange()
+    best = min(timer.repeat(repeat=repetitions, number=number)) / number
+    return {'us_per_request': best * 1e6, 'peak_bytes': peak_memory(path, transaction)}
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--sizes',
+                        type=int,
+                        nargs='+',
+                        default=[64, 1024, 16 * 1024, 64 * 1024],
+                        help='RPC sizes in bytes')
+    parser.add_argument('--repetitions', type=int, default=5)
+    parser.add_argument('--json', help='file to write the results to')
+    args = parser.parse_args()
+
+    results: List[Dict[str, object]] = []
+    print(f"{'rpc bytes':>10} {'packets us':>11} {'stream us':>10} {'speedup':>8} "
+          f"{'packets peak':>13} {'stream peak':>12}")
+    for size in args.sizes:
+        transaction = example_transaction(size)
+        check_same_chunks(transaction)
+        packets = measure(packets_path, transaction, args.repetitions)
+        stream = measure(stream_path, transaction, args.repetitions)
+        results.append({'rpc_size': size, 'packets': packets, 'stream': stream})
+        print(f"{size:>10} {packets['us_per_request']:>11.1f} {stream['us_per_request']:>10.1f} "
+              f"{packets['us_per_request'] / stream['us_per_request']:>7.2f}x "
+              f"{packets['peak_bytes']:>13} {stream['peak_bytes']:>12}")
+
+    if args.json:
+        with open(args.json, 'w', encoding='utf-8') as f:
+            json.dump(results, f, indent=2)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
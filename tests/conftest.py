@@ -1,4 +1,7 @@
-from ragger.conftest import configuration
+from contextlib import ExitStack
+
+import pytest
+from ragger.conftest import base_conftest, configuration
 
 ###########################
 ### CONFIGURATION START ###
@@ -13,3 +16,115 @@ from ragger.conftest import configuration
 
 # Pull all features from the base ragger conftest using the overridden configuration
 pytest_plugins = ("ragger.conftest.base_conftest", )
+
+
+def pytest_addoption(parser):
+    parser.addoption("--benchmark",
+                     action="store_true",
+                     default=False,
+                     help="run the latency benchmarks")
+    parser.addoption("--benchmark_output",
+                     default="latency.json",
+                     help="file to write latency benchmark results to")
+    parser.addoption("--benchmark_repetitions",
+                     type=int,
+                     default=5,
+                     help="number of samples per latency benchmark")
+    parser.addoption("--stack_budget",
+                     type=int,
+                     default=None,
+                     help="maximum stack usage in bytes of any instruction")
+    parser.addoption("--speculos_api_port",
+                     type=int,
+                     default=None,
+                     help="API port of the Speculos emulator, to run several in parallel")
+    parser.addoption("--speculos_apdu_port",
+                     type=int,
+                     default=None,
+                     help="APDU port of the Speculos emulator, the API port + 1 by default")
+    parser.addoption("--pool_size",
+                     type=int,
+                     default=3,
+                     help="number of Speculos emulators of the device pool tests")
+    parser.addoption("--replay_trace",
+                     action="append",
+                     default=[],
+                     help="APDU trace to replay in test_replay_trace.py, can be repeated")
+    parser.addoption("--replay_report",
+                     default=None,
+                     help="file to write the replay reports of the traces to as JSON")
+
+
+def pytest_configure(config):
+    config.addinivalue_line(
+        "markers", "benchmark: latency benchmark, only run with --benchmark")
+
+    api_port = config.getoption("--speculos_api_port")
+    if api_port is not None:
+        apdu_port = config.getoption("--speculos_apdu_port")
+        ConfigurableSpeculosBackend.api_port = api_port
+        ConfigurableSpeculosBackend.apdu_port = apdu_port if apdu_port is not None else api_port + 1
+    base_conftest.SpeculosBackend = ConfigurableSpeculosBackend
+
+
+class ConfigurableSpeculosBackend(base_conftest.SpeculosBackend):
+    """
+    Speculos backend created by ragger, listening on the given ports instead
+    of the default ones, such that several emulators can run at once.
+
+    The arguments ragger creates the backend with are kept, to start more
+    emulators of the same app with another().
+    """
+    api_port = None
+    apdu_port = None
+    arguments = None
+
+    def __init__(self, *args, api_port=None, apdu_port=None, **kwargs):
+        ConfigurableSpeculosBackend.arguments = (args, dict(kwargs))
+
+        api_port = api_port if api_port is not None else self.api_port
+        apdu_port = apdu_port if apdu_port is not None else self.apdu_port
+        if api_port is not None:
+            speculos_args = list(kwargs.pop("args", []))
+            speculos_args += ["--api-port", str(api_port), "--apdu-port", str(apdu_port)]
+            kwargs["args"] = speculos_args
+            kwargs["port"] = api_port
+        super().__init__(*args, **kwargs)
+
+    @classmethod
+    def another(cls, api_port):
+        """
+        Another emulator of the app of the backend created by ragger, on the
+        given API port and the next port.
+        """
+        args, kwargs = cls.arguments
+        return cls(*args, api_port=api_port, apdu_port=api_port + 1, **kwargs)
+
+
+@pytest.fixture
+def speculos_backends(backend, pytestconfig):
+    """
+    The backend of the test, followed by more Speculos emulators of the app,
+    for tests with several devices. Their ports are offset by multiples of
+    1000 from the port of the backend of the test, which leaves room for the
+    emulators of parallel_ui_tests.py.
+    """
+    if pytestconfig.getoption("backend") != "speculos":
+        pytest.skip("needs several Speculos emulators")
+
+    api_port = ConfigurableSpeculosBackend.api_port or 5000
+    with ExitStack() as stack:
+        backends = [backend]
+        for i in range(1, pytestconfig.getoption("--pool_size")):
+            backends.append(
+                stack.enter_context(ConfigurableSpeculosBackend.another(api_port + 1000 * i)))
+        yield backends
+
+
+def pytest_collection_modifyitems(config, items):
+    if config.getoption("--benchmark"):
+        return
+    skip_benchmark = pytest.mark.skip(reason="needs --benchmark to run")
+    for item in items:
+        if "benchmark" in item.keywords:
+            item.add_marker(skip_benchmark)
@@ -0,0 +1,164 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "cx.h"
+#include "io.h"
+#include "write.h"
+
+#include "apdu/dispatcher.h"
+#include "constants.h"
+#include "globals.h"
+#include "status_words.h"
+#include "types.h"
+#include "mock_app.h"
+#include "mock_sdk.h"
+
+/*
+ * Host library running SIGN_TX on a transaction, for the differential tests
+ * against the Python transaction model in tests/differential_tx_parser.py.
+ *
+ * The transaction is streamed to the APDU handlers like the client does, and
+ * the outcome is flattened to a structure that is mirrored with ctypes.
+ */
+
+/**
+ * Outcome of signing a transaction. Must match DeviceOutcome of the tests.
+ */
+typedef struct {
+    /** Whether the review of the transaction has been started. */
+    uint8_t reviewed;
+    /** Status word of the rejected chunk, if not reviewed. */
+    uint16_t sw;
+    /** Digest to sign, if reviewed. */
+    uint8_t digest[CX_SHA256_SIZE];
+
+    /** Fields of transaction_t, if reviewed. */
+    uint64_t nonce;
+    uint64_t valid_to_time;
+    uint64_t gas_cost;
+    uint8_t contract_address[ADDRESS_LEN];
+    int32_t type;
+    int32_t rpc_parsing_error;
+
+    /** Fields of mpc_transfer_transaction_type_s, for #MPC_TRANSFER. */
+    uint8_t recipient_address[ADDRESS_LEN];
+    uint64_t token_amount_10000ths;
+    uint32_t memo_length;
+    uint8_t has_u64_memo;
+    uint64_t memo_u64;
+    uint8_t memo[ARENA_SIZE];
+
+    /** Fields of zk_invocation_transaction_type_s, for #ZK_INVOCATION. */
+    int32_t zk_kind;
+    uint32_t zk_shortname;
+    uint64_t zk_secret_input_bits;
+} differential_outcome_t;
+
+/**
+ * Dispatches a single SIGN_TX APDU.
+ */
+static void send_chunk(uint8_t p1, bool last, const uint8_t *data, size_t len) {
+    // Copied to an exactly sized buffer, like the fuzzing targets
+    uint8_t *copy = malloc(len > 0 ? len : 1);
+    memcpy(copy, data, len);
+    command_t cmd = {.cla = CLA,
+                     .ins = SIGN_TX,
+                     .p1 = p1,
+                     .p2 = last ? P2_LAST_CHUNK : P2_NOT_LAST_CHUNK,
+                     .lc = (uint8_t) len,
+                     .data = copy};
+    mock_io_reset();
+    // Rejections are recorded by the mock, like any other response
+    int status = apdu_dispatcher(&cmd);
+    (void) status;
+    free(copy);
+}
+
+/**
+ * Copies the parsed transaction to the outcome.
+ */
+static void flatten_transaction(const transaction_t *tx, differential_outcome_t *out) {
+    out->nonce = tx->basic.nonce;
+    out->valid_to_time = tx->basic.valid_to_time;
+    out->gas_cost = tx->basic.gas_cost;
+    memcpy(out->contract_address, tx->basic.contract_address.raw_bytes, ADDRESS_LEN);
+    out->type = tx->type;
+
+    if (tx->type == MPC_TRANSFER) {
+        const mpc_transfer_transaction_type_s *mpc = &tx->mpc_transfer;
+        memcpy(out->recipient_address, mpc->recipient_address.raw_bytes, ADDRESS_LEN);
+        out->token_amount_10000ths = mpc->token_amount_10000ths;
+        out->memo_length = mpc->memo_length;
+        out->has_u64_memo = mpc->has_u64_memo;
+        if (mpc->has_u64_memo) {
+            out->memo_u64 = mpc->memo_u64;
+        } else if (mpc->memo_length > 0 && mpc->memo_length <= sizeof(out->memo)) {
+            memcpy(out->memo, mpc->memo, mpc->memo_length);
+        }
+    } else if (tx->type == ZK_INVOCATION) {
+        out->zk_kind = tx->zk_invocation.kind;
+        out->zk_shortname = tx->zk_invocation.shortname;
+        out->zk_secret_input_bits = tx->zk_invocation.secret_input_bits;
+    } else {
+        out->rpc_parsing_error = tx->rpc_parsing_error;
+    }
+}
+
+/**
+ * Signs the given transaction for the given chain id, sent in chunks of
+ * #MAX_CHUNK_LEN after the chunk with the BIP32 path and chain id.
+ *
+ * @return 0 on success, or -1 if the chain id is too long.
+ */
+int differential_sign_tx(const uint8_t *tx,
+                         size_t tx_len,
+                         const uint8_t *chain_id,
+                         size_t chain_id_len,
+                         differential_outcome_t *out) {
+    memset(out, 0, sizeof(*out));
+    mock_app_reset();
+
+    // First chunk: BIP32 path and chain id
+    uint8_t first[1 + 4 * 5 + 4 + CHAIN_ID_MAX_LENGTH];
+    if (chain_id_len > CHAIN_ID_MAX_LENGTH) {
+        return -1;
+    }
+    const uint32_t path[5] = {0x8000002c, 0x80000dd3, 0x80000000, 0, 0};
+    first[0] = 5;
+    for (size_t i = 0; i < 5; i++) {
+        write_u32_be(first, 1 + 4 * i, path[i]);
+    }
+    write_u32_be(first, 1 + 4 * 5, (uint32_t) chain_id_len);
+    memcpy(first + 1 + 4 * 5 + 4, chain_id, chain_id_len);
+    send_chunk(P1_FIRST_CHUNK, false, first, 1 + 4 * 5 + 4 + chain_id_len);
+    if (G_mock_io.sw != SW_OK) {
+        out->sw = G_mock_io.sw;
+        return 0;
+    }
+
+    // Transaction chunks. An empty transaction is sent as one empty chunk.
+    size_t offset = 0;
+    do {
+        size_t len = tx_len - offset < MAX_CHUNK_LEN ? tx_len - offset : MAX_CHUNK_LEN;
+        const bool last = offset + len == tx_len;
+        send_chunk(P1_NOT_FIRST_CHUNK, last, tx + offset, len);
+        offset += len;
+
+        if (G_mock_io.count == 0) {
+            out->reviewed = G_mock_review == MOCK_REVIEW_TRANSACTION;
+            break;
+        }
+        if (G_mock_io.sw != SW_OK) {
+            out->sw = G_mock_io.sw;
+            return 0;
+        }
+    } while (offset < tx_len);
+
+    if (out->reviewed) {
+        memcpy(out->digest, G_context.m_hash, sizeof(out->digest));
+        flatten_transaction(&G_context.tx_info.transaction, out);
+    }
+    return 0;
+}
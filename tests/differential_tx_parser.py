@@ -0,0 +1,499 @@
+#!/usr/bin/env python3
+'''
+Differential tests of the transaction parser of the application against the
+Python transaction model in application_client/transaction.py.
+
+Random valid transactions, and malformed mutations of these, are signed with
+the SIGN_TX handler built for the host (see differential/CMakeLists.txt), and
+the outcome is compared field by field, and on the digest to sign, with the
+outcome predicted from the Python model.
+
+The Python model deserializes the transaction format without any limits of the
+device. These are applied when predicting the outcome:
+
+- The leading part of the RPC is only parsed from the first chunk of the
+  transaction. A transaction whose leading part does not fit is blind-signed.
+- The memo of an MPC transfer must fit in the arena, and the RPC of an MPC
+  transfer must be entirely in the first chunk.
+
+Mismatches are minimized, and written as reproducers to the given directory.
+'''
+
+import argparse
+import ctypes
+import random
+import sys
+import time
+from dataclasses import dataclass
+from hashlib import sha256
+from pathlib import Path
+from typing import Callable, List, Optional, Union
+
+from application_client.transaction import (
+    ADDRESS_LENGTH, ADDRESS_TYPE_CONTRACT_ZK, MPC_TOKEN_ADDRESS, Address,
+    MpcTokenTransfer, Transaction, TransactionError, ZkOpenInvocation,
+    ZkSecretInput)
+from utils import CHAIN_IDS
+
+DEFAULT_LIBRARY = Path(__file__).parent / 'differential' / 'build' / \
+    'libpbc_tx_parser.so'
+
+# Limits of the device. See constants.h and transaction/types.h.
+MAX_CHUNK_LEN = 255
+ARENA_SIZE = 128
+TRANSACTION_HEADER_LEN = 8 + 8 + 8 + ADDRESS_LENGTH + 4
+
+# transaction_type_e
+GENERIC_TRANSACTION = 1
+MPC_TRANSFER = 2
+ZK_INVOCATION = 3
+
+# Status words of rejected transactions. See status_words.h.
+SW_TX_PARSING_FAIL_EXPECTED_MORE_DATA = 0xB00A
+SW_TX_PARSING_FAIL_EXPECTED_LESS_DATA = 0xB00B
+SW_TX_PARSING_FAIL = 0xB100
+
+# Header fields, with the status word of the parsing failure if truncated
+HEADER_FIELDS = [
+    (8, SW_TX_PARSING_FAIL | 1),  # nonce
+    (8, SW_TX_PARSING_FAIL | 2),  # valid-to time
+    (8, SW_TX_PARSING_FAIL | 3),  # gas cost
+    (ADDRESS_LENGTH, SW_TX_PARSING_FAIL | 4),  # contract address
+    (4, SW_TX_PARSING_FAIL | 5),  # RPC length
+]
+
+UINT64_BOUNDARIES = [0, 1, 2**32 - 1, 2**32, 2**63, 2**64 - 1]
+UINT32_BOUNDARIES = [0, 1, 127, 128, 2**14 - 1, 2**14, 2**31 - 1, 2**32 - 1]
+
+
+class DeviceOutcome(ctypes.Structure):
+    '''
+    Outcome of signing a transaction. Must match differential_outcome_t of
+    differential/tx_parser_lib.c.
+    '''
+    _fields_ = [
+        ('reviewed', ctypes.c_uint8),
+        ('sw', ctypes.c_uint16),
+        ('digest', ctypes.c_uint8 * 32),
+        ('nonce', ctypes.c_uint64),
+        ('valid_to_time', ctypes.c_uint64),
+        ('gas_cost', ctypes.c_uint64),
+        ('contract_address', ctypes.c_uint8 * ADDRESS_LENGTH),
+        ('type', ctypes.c_int32),
+        ('rpc_parsing_error', ctypes.c_int32),
+        ('recipient_address', ctypes.c_uint8 * ADDRESS_LENGTH),
+        ('token_amount_10000ths', ctypes.c_uint64),
+        ('memo_length', ctypes.c_uint32),
+        ('has_u64_memo', ctypes.c_uint8),
+        ('memo_u64', ctypes.c_uint64),
+        ('memo', ctypes.c_uint8 * ARENA_SIZE),
+        ('zk_kind', ctypes.c_int32),
+        ('zk_shortname', ctypes.c_uint32),
+        ('zk_secret_input_bits', ctypes.c_uint64),
+    ]
+
+
+class Device:
+    '''
+    SIGN_TX handler of the application, built for the host.
+    '''
+
+    def __init__(self, library: Path):
+        self.lib = ctypes.CDLL(str(library))
+        self.lib.differential_sign_tx.argtypes = [
+            ctypes.c_char_p, ctypes.c_size_t, ctypes.c_char_p,
+            ctypes.c_size_t,
+            ctypes.POINTER(DeviceOutcome)
+        ]
+        self.lib.differential_sign_tx.restype = ctypes.c_int
+        self.outcome = DeviceOutcome()
+
+    def sign(self, transaction: bytes, chain_id: bytes) -> DeviceOutcome:
+        status = self.lib.differential_sign_tx(transaction, len(transaction),
+                                               chain_id, len(chain_id),
+                                               ctypes.byref(self.outcome))
+        assert status == 0
+        return self.outcome
+
+
+@dataclass(frozen=True)
+class Expected:
+    '''
+    Outcome predicted from the Python model: either rejected with a status
+    word, or reviewed as the given transaction type.
+    '''
+    sw: Optional[int] = None
+    transaction: Optional[Transaction] = None
+    type: int = GENERIC_TRANSACTION
+
+
+def expected_rejection(transaction: bytes) -> int:
+    '''
+    Status word of a transaction that the Python model cannot deserialize.
+    '''
+    offset = 0
+    for length, sw in HEADER_FIELDS:
+        offset += length
+        if len(transaction) < offset:
+            return sw
+    rpc_length = int.from_bytes(transaction[offset - 4:offset], 'big')
+    if rpc_length > len(transaction) - offset:
+        return SW_TX_PARSING_FAIL_EXPECTED_MORE_DATA
+    return SW_TX_PARSING_FAIL_EXPECTED_LESS_DATA
+
+
+def leading_rpc_length(
+        rpc: Union[bytes, MpcTokenTransfer, ZkOpenInvocation, ZkSecretInput],
+        rpc_length: int) -> int:
+    '''
+    Length of the part of the RPC that is parsed by the device.
+    '''
+    if isinstance(rpc, ZkOpenInvocation):
+        return rpc_length - len(rpc.arguments)
+    if isinstance(rpc, ZkSecretInput):
+        return rpc_length - len(rpc.payload)
+    return rpc_length
+
+
+def expected_outcome(transaction: bytes) -> Expected:
+    '''
+    Predicts the outcome of signing the given transaction on the device.
+    '''
+    try:
+        tx = Transaction.deserialize(transaction)
+    except TransactionError:
+        return Expected(sw=expected_rejection(transaction))
+
+    rpc = tx.rpc
+    rpc_length = len(transaction) - TRANSACTION_HEADER_LEN
+    first_chunk_len = min(len(transaction), MAX_CHUNK_LEN)
+    fits_first_chunk = TRANSACTION_HEADER_LEN + leading_rpc_length(
+        rpc, rpc_length) <= first_chunk_len
+
+    if isinstance(rpc, MpcTokenTransfer):
+        memo_fits = not isinstance(rpc.memo, bytes) or \
+            len(rpc.memo) < ARENA_SIZE
+        if fits_first_chunk and memo_fits:
+            return Expected(transaction=tx, type=MPC_TRANSFER)
+    elif isinstance(rpc, (ZkOpenInvocation, ZkSecretInput)):
+        if fits_first_chunk:
+            return Expected(transaction=tx, type=ZK_INVOCATION)
+
+    return Expected(transaction=tx, type=GENERIC_TRANSACTION)
+
+
+def readable_memo(memo: bytes) -> bytes:
+    '''
+    Memo as shown by the device, which replaces unreadable characters in place.
+    '''
+    return bytes(byte if byte == 0 or 0x20 <= byte <= 0x7e else ord('?')
+                 for byte in memo)
+
+
+def compare_mpc_transfer(rpc: MpcTokenTransfer,
+                         device: DeviceOutcome) -> List[str]:
+    mismatches = []
+    if bytes(device.recipient_address) != rpc.recipient_address.serialize():
+        mismatches.append('recipient_address')
+    if device.token_amount_10000ths != rpc.token_amount:
+        mismatches.append('token_amount')
+
+    if rpc.memo is None:
+        if device.memo_length != 0:
+            mismatches.append('memo_length')
+    elif isinstance(rpc.memo, int):
+        if not device.has_u64_memo or device.memo_u64 != rpc.memo:
+            mismatches.append('memo_u64')
+    elif device.has_u64_memo or device.memo_length != len(rpc.memo) or \
+            bytes(device.memo[:device.memo_length]) != readable_memo(rpc.memo):
+        mismatches.append('memo')
+    return mismatches
+
+
+def compare_zk_invocation(rpc: Union[ZkOpenInvocation, ZkSecretInput],
+                          device: DeviceOutcome) -> List[str]:
+    if isinstance(rpc, ZkOpenInvocation):
+        kind = ZkOpenInvocation.KIND[0]
+        shortname = rpc.shortname
+        secret_input_bits = 0
+    else:
+        kind = (ZkSecretInput.KIND_ON_CHAIN
+                if rpc.on_chain else ZkSecretInput.KIND_OFF_CHAIN)[0]
+        shortname = 0
+        secret_input_bits = sum(rpc.bit_lengths)
+
+    mismatches = []
+    if device.zk_kind != kind:
+        mismatches.append('zk_kind')
+    if device.zk_shortname != shortname:
+        mismatches.append('zk_shortname')
+    if device.zk_secret_input_bits != secret_input_bits:
+        mismatches.append('zk_secret_input_bits')
+    return mismatches
+
+
+def compare(transaction: bytes, chain_id: bytes, expected: Expected,
+            device: DeviceOutcome) -> Optional[str]:
+    '''
+    Compares the outcome on the device with the expected outcome.
+
+    Returns a description of the mismatch, or None if these match.
+    '''
+    if expected.sw is not None:
+        if device.reviewed:
+            return f'expected rejection {expected.sw:04X}, but reviewed'
+        if device.sw != expected.sw:
+            return f'expected rejection {expected.sw:04X}, got {device.sw:04X}'
+        return None
+
+    if not device.reviewed:
+        return f'expected review, got rejection {device.sw:04X}'
+
+    tx = expected.transaction
+    assert tx is not None
+
+    mismatches = []
+    digest = sha256(transaction + len(chain_id).to_bytes(4, 'big') +
+                    chain_id).digest()
+    if bytes(device.digest) != digest:
+        mismatches.append('digest')
+    if device.nonce != tx.nonce:
+        mismatches.append('nonce')
+    if device.valid_to_time != tx.valid_to_time:
+        mismatches.append('valid_to_time')
+    if device.gas_cost != tx.gas_cost:
+        mismatches.append('gas_cost')
+    if bytes(device.contract_address) != tx.contract_address.serialize():
+        mismatches.append('contract_address')
+
+    if device.type != expected.type:
+        mismatches.append(f'type {device.type}, expected {expected.type}')
+    elif expected.type == MPC_TRANSFER:
+        assert isinstance(tx.rpc, MpcTokenTransfer)
+        mismatches += compare_mpc_transfer(tx.rpc, device)
+    elif expected.type == ZK_INVOCATION:
+        assert isinstance(tx.rpc, (ZkOpenInvocation, ZkSecretInput))
+        mismatches += compare_zk_invocation(tx.rpc, device)
+
+    return ', '.join(mismatches) if mismatches else None
+
+
+def check(device: Device, transaction: bytes, chain_id: bytes) -> Optional[str]:
+    return compare(transaction, chain_id, expected_outcome(transaction),
+                   device.sign(transaction, chain_id))
+
+
+# Generation
+
+
+def random_u64(rng: random.Random) -> int:
+    if rng.random() < 0.3:
+        return rng.choice(UINT64_BOUNDARIES)
+    return rng.getrandbits(64)
+
+
+def random_u32(rng: random.Random) -> int:
+    if rng.random() < 0.3:
+        return rng.choice(UINT32_BOUNDARIES)
+    return rng.getrandbits(32)
+
+
+def random_length(rng: random.Random, maximum: int) -> int:
+    '''
+    Random length, biased towards short lengths.
+    '''
+    return min(int(rng.expovariate(1 / 40)), maximum)
+
+
+def random_bytes(rng: random.Random, length: int) -> bytes:
+    return rng.getrandbits(8 * length).to_bytes(length, 'big')
+
+
+def random_address(rng: random.Random, address_type: int) -> Address:
+    return Address(bytes([address_type]) + random_bytes(rng, ADDRESS_LENGTH - 1))
+
+
+def random_mpc_transfer(rng: random.Random) -> MpcTokenTransfer:
+    memo: Union[None, int, bytes] = rng.choice([
+        None,
+        random_u64(rng),
+        random_bytes(rng, random_length(rng, 2 * ARENA_SIZE)),
+    ])
+    return MpcTokenTransfer(random_address(rng, rng.randrange(5)),
+                            random_u64(rng), memo)
+
+
+def random_zk_invocation(
+        rng: random.Random) -> Union[ZkOpenInvocation, ZkSecretInput]:
+    if rng.random() < 0.5:
+        return ZkOpenInvocation(random_u32(rng),
+                                random_bytes(rng, random_length(rng, 600)))
+    bit_lengths = [
+        rng.choice([0, 1, 32, 2**31 - 1, rng.getrandbits(31)])
+        for _ in range(random_length(rng, 80))
+    ]
+    return ZkSecretInput(bit_lengths,
+                         random_bytes(rng, random_length(rng, 600)),
+                         rng.random() < 0.5)
+
+
+def random_transaction(rng: random.Random) -> bytes:
+    '''
+    Random valid transaction, biased towards the transactions that are parsed.
+    '''
+    choice = rng.random()
+    rpc: Union[bytes, MpcTokenTransfer, ZkOpenInvocation, ZkSecretInput]
+    if choice < 0.4:
+        contract_address = MPC_TOKEN_ADDRESS
+        rpc = random_mpc_transfer(rng)
+    elif choice < 0.8:
+        contract_address = random_address(rng, ADDRESS_TYPE_CONTRACT_ZK)
+        rpc = random_zk_invocation(rng)
+    else:
+        contract_address = random_address(rng, rng.randrange(5))
+        rpc = random_bytes(rng, random_length(rng, 1000))
+
+    return Transaction(random_u64(rng), random_u64(rng), random_u64(rng),
+                       contract_address, rpc).serialize()
+
+
+def mutate(rng: random.Random, transaction: bytes) -> bytes:
+    '''
+    Applies a random mutation to a transaction, typically making it malformed.
+    '''
+    data = bytearray(transaction)
+    choice = rng.randrange(6)
+    if choice == 0:
+        # Truncate
+        del data[rng.randrange(len(data) + 1):]
+    elif choice == 1:
+        # Append
+        data += random_bytes(rng, 1 + random_length(rng, 300))
+    elif choice == 2 and len(data) >= TRANSACTION_HEADER_LEN:
+        # Change the RPC length
+        offset = TRANSACTION_HEADER_LEN - 4
+        rpc_length = int.from_bytes(data[offset:offset + 4], 'big')
+        rpc_length = rng.choice(
+            [rpc_length - 1, rpc_length + 1,
+             random_u32(rng)]) % 2**32
+        data[offset:offset + 4] = rpc_length.to_bytes(4, 'big')
+    elif choice == 3 and data:
+        # Change a byte of the start of the RPC
+        offset = min(TRANSACTION_HEADER_LEN + random_length(rng, 40),
+                     len(data) - 1)
+        data[offset] = rng.choice([0x00, 0x7f, 0x80, 0xff, rng.getrandbits(8)])
+    elif choice == 4 and data:
+        # Change any byte
+        data[rng.randrange(len(data))] = rng.getrandbits(8)
+    else:
+        # Insert or remove a byte at the start of the RPC
+        offset = min(TRANSACTION_HEADER_LEN + random_length(rng, 40),
+                     len(data))
+        if rng.random() < 0.5:
+            data.insert(offset, rng.getrandbits(8))
+        else:
+            del data[offset:offset + 1]
+    return bytes(data)
+
+
+def random_case(rng: random.Random) -> bytes:
+    transaction = random_transaction(rng)
+    if rng.random() < 0.5:
+        for _ in range(rng.randrange(1, 4)):
+            transaction = mutate(rng, transaction)
+    return transaction
+
+
+# Minimization
+
+
+def minimize(transaction: bytes, fails: Callable[[bytes], bool]) -> bytes:
+    '''
+    Removes ranges of bytes from a failing transaction, as long as it keeps
+    failing.
+    '''
+    chunk_len = max(len(transaction) // 2, 1)
+    while True:
+        offset = 0
+        while offset < len(transaction):
+            candidate = transaction[:offset] + transaction[offset + chunk_len:]
+            if fails(candidate):
+                transaction = candidate
+            else:
+                offset += chunk_len
+        if chunk_len == 1:
+            return transaction
+        chunk_len //= 2
+
+
+def report_mismatch(device: Device, transaction: bytes, chain_id: bytes,
+                    mismatch: str, reproducers: Path):
+    minimized = minimize(transaction,
+                         lambda tx: check(device, tx, chain_id) is not None)
+    reproducers.mkdir(parents=True, exist_ok=True)
+    path = reproducers / sha256(minimized + chain_id).hexdigest()[:16]
+    path.write_bytes(minimized)
+
+    print(f'Mismatch: {mismatch}', file=sys.stderr)
+    print(f'  chain id:    {chain_id.decode()}', file=sys.stderr)
+    print(f'  minimized:   {check(device, minimized, chain_id)}',
+          file=sys.stderr)
+    print(f'  transaction: {minimized.hex()}', file=sys.stderr)
+    print(f'  written to:  {path}', file=sys.stderr)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.strip().split('\n')[0])
+    parser.add_argument('--library', type=Path, default=DEFAULT_LIBRARY,
+                        help='SIGN_TX handler built for the host')
+    parser.add_argument('--cases', type=int, default=20000,
+                        help='number of random transactions to check')
+    parser.add_argument('--seed', type=int, default=None,
+                        help='seed of the random transactions')
+    parser.add_argument('--reproducers', type=Path,
+                        default=Path('differential_reproducers'),
+                        help='directory to write minimized mismatches to')
+    parser.add_argument('--max-mismatches', type=int, default=10,
+                        help='stop after this many mismatches')
+    parser.add_argument('reproduce', type=Path, nargs='*',
+                        help='check the given transactions instead')
+    args = parser.parse_args()
+
+    device = Device(args.library)
+
+    if args.reproduce:
+        failed = False
+        for path in args.reproduce:
+            for chain_id in CHAIN_IDS:
+                mismatch = check(device, path.read_bytes(), chain_id)
+                print(f'{path} ({chain_id.decode()}): {mismatch or "OK"}')
+                failed |= mismatch is not None
+        return 1 if failed else 0
+
+    seed = args.seed if args.seed is not None else random.randrange(2**32)
+    print(f'Seed: {seed}')
+    rng = random.Random(seed)
+
+    cases = 0
+    mismatches = 0
+    start = time.perf_counter()
+    while cases < args.cases:
+        cases += 1
+        transaction = random_case(rng)
+        chain_id = rng.choice(CHAIN_IDS)
+        mismatch = check(device, transaction, chain_id)
+        if mismatch is not None:
+            mismatches += 1
+            report_mismatch(device, transaction, chain_id, mismatch,
+                            args.reproducers)
+            if mismatches >= args.max_mismatches:
+                break
+    elapsed = time.perf_counter() - start
+
+    print(f'{cases} cases in {elapsed:.1f} s '
+          f'({cases / elapsed:.0f} cases/s), {mismatches} mismatches')
+    return 1 if mismatches else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
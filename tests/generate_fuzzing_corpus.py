@@ -4,10 +4,80 @@ Small utility for produces corpus for the fuzzing process from the example
 transactions in the functional tests.
 '''
 
+from ragger.bip import pack_derivation_path
+from application_client.command_sender import (ApduPacket, sign_tx_packets,
+                                                sign_message_packets,
+                                                tx_template_data,
+                                                sign_tx_with_template_packets,
+                                                sign_tx_compressed_packets,
+                                                InsType, P1)
+from application_client.transaction import Message
+from utils import KEY_PATH, CHAIN_IDS
 import transaction_examples
 
 CORPUS_PATH = '../fuzzing/corpus/valid-examples'
+APDU_CORPUS_PATH = '../fuzzing/corpus_apdu_dispatcher'
+
+# Pseudo-APDU of fuzz_apdu_dispatcher approving the review shown
+APPROVE = bytes([0x00, 0x01, 0x00, 0x00])
+
+
+def apdu_sequence(packets: list[ApduPacket]) -> bytes:
+    '''
+    Encodes APDUs as input for fuzz_apdu_dispatcher: INS, P1, P2, Lc and data.
+    '''
+    return b''.join(
+        bytes([packet.ins, packet.p1, packet.p2,
+               len(packet.data)]) + packet.data for packet in packets)
+
 
 for transaction_name, transaction in transaction_examples.VALID_TRANSACTIONS:
     with open('{}/{}'.format(CORPUS_PATH, transaction_name), 'wb') as f:
         f.write(transaction.serialize())
+
+    with open('{}/sign_tx_{}'.format(APDU_CORPUS_PATH, transaction_name),
+              'wb') as f:
+        f.write(
+            apdu_sequence(
+                sign_tx_packets(KEY_PATH, transaction.serialize(),
+                                CHAIN_IDS[0])) + APPROVE)
+
+for transaction_name, transaction in transaction_examples.MPC_TRANSFER_TRANSACTIONS:
+    set_template = ApduPacket(
+        InsType.SET_TX_TEMPLATE, 1, 0,
+        tx_template_data(KEY_PATH, CHAIN_IDS[1], transaction.gas_cost,
+                         transaction.contract_address.serialize()))
+    with open(
+            '{}/sign_tx_with_template_{}'.format(APDU_CORPUS_PATH,
+                                                  transaction_name),
+            'wb') as f:
+        f.write(
+            apdu_sequence([set_template] + sign_tx_with_template_packets(
+                1, transaction.serialize())) + APPROVE)
+
+for transaction_name, transaction in transaction_examples.BLIND_TRANSACTIONS:
+    packets = sign_tx_compressed_packets(KEY_PATH, transaction.serialize(),
+                                         CHAIN_IDS[0])
+    if any(packet.p1 == P1.P1_COMPRESSED_CHUNK for packet in packets):
+        with open(
+                '{}/sign_tx_compressed_{}'.format(APDU_CORPUS_PATH,
+                                                  transaction_name),
+                'wb') as f:
+            f.write(apdu_sequence(packets) + APPROVE)
+
+with open('{}/sign_message'.format(APDU_CORPUS_PATH), 'wb') as f:
+    f.write(
+        apdu_sequence(
+            sign_message_packets(KEY_PATH,
+                                 Message(b'Hello world').serialize())) +
+        APPROVE)
+
+with open('{}/get_address_with_confirmation'.format(APDU_CORPUS_PATH),
+          'wb') as f:
+    f.write(
+        apdu_sequence([
+            ApduPacket(InsType.GET_VERSION, 0, 0, b''),
+            ApduPacket(InsType.GET_APP_NAME, 0, 0, b''),
+            ApduPacket(InsType.GET_ADDRESS, 1, 0,
+                       pack_derivation_path(KEY_PATH)),
+        ]) + APPROVE)
@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+'''
+Runs the Ragger tests on several Speculos emulators in parallel.
+
+The tests of each device are collected, and sharded over one or more pytest
+processes per device, each with its own emulator on its own ports. The JUnit
+results of the shards, and the screenshots that differ from the golden
+snapshots, are collected into a single report:
+
+- report.json, with the outcome and duration of every test, and the snapshot
+  differences.
+- index.html, with the failures, and the differing snapshots side by side.
+
+The durations of the previous report in the same directory, if any, are used to
+balance the shards.
+
+Arguments after -- are passed to pytest, e.g. -- -k test_sign or
+-- --golden_run.
+'''
+
+import argparse
+import html
+import json
+import os
+import shutil
+import subprocess
+import sys
+import time
+import xml.etree.ElementTree as ET
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional
+
+TESTS_DIR = Path(__file__).parent
+DEVICES = ['nanos', 'nanosp', 'nanox', 'stax']
+
+# Ragger compares the screenshots in snapshots-tmp with those in snapshots
+GOLDEN_SNAPSHOTS_DIR = TESTS_DIR / 'snapshots'
+CURRENT_SNAPSHOTS_DIR = TESTS_DIR / 'snapshots-tmp'
+
+
+@dataclass
+class Shard:
+    device: str
+    index: int
+    api_port: int
+    test_ids: List[str] = field(default_factory=list)
+    expected_duration: float = 0.0
+    process: Optional[subprocess.Popen] = None
+
+    @property
+    def name(self) -> str:
+        return f'{self.device}-{self.index}'
+
+
+@dataclass
+class TestResult:
+    device: str
+    shard: str
+    test_id: str
+    outcome: str
+    duration: float
+    message: str = ''
+
+
+@dataclass
+class SnapshotDiff:
+    device: str
+    path: str
+    # 'changed' if the screenshot differs from the golden one, 'new' if there
+    # is no golden one
+    kind: str
+
+
+def pytest_command(device: str, pytest_args: List[str]) -> List[str]:
+    return [
+        sys.executable, '-m', 'pytest', '--device', device,
+        # The shards share the tests directory, so must not share the cache
+        '-p', 'no:cacheprovider', *pytest_args
+    ]
+
+
+def collect_tests(device: str, pytest_args: List[str]) -> List[str]:
+    '''
+    Ids of the tests of the given device.
+    '''
+    result = subprocess.run(pytest_command(device, ['--collect-only', '-q', *pytest_args]),
+                            cwd=TESTS_DIR,
+                            capture_output=True,
+                            text=True,
+                            check=False)
+    # Exit code 5: no tests collected
+    if result.returncode not in (0, 5):
+        sys.exit(f'Collecting tests for {device} failed:\n{result.stdout}{result.stderr}')
+    return [line for line in result.stdout.splitlines() if '::' in line]
+
+
+def previous_durations(report_dir: Path) -> Dict[str, float]:
+    '''
+    Durations of the tests of the previous report, keyed by device and test id.
+    '''
+    try:
+        report = json.loads((report_dir / 'report.json').read_text())
+    except (OSError, ValueError):
+        return {}
+    return {f"{test['device']}/{test['test_id']}": test['duration'] for test in report['tests']}
+
+
+def make_shards(tests: Dict[str, List[str]], instances: int, base_port: int,
+                durations: Dict[str, float]) -> List[Shard]:
+    '''
+    Distributes the tests of each device over the given number of shards.
+    Longest tests first, each to the shard expected to finish first. Tests
+    without a known duration count as the average one.
+    '''
+    shards: List[Shard] = []
+    for device, test_ids in tests.items():
+        device_shards = []
+        for index in range(min(instances, max(len(test_ids), 1))):
+            # API port and APDU port per emulator
+            api_port = base_port + 2 * len(shards)
+            shard = Shard(device, index, api_port)
+            shards.append(shard)
+            device_shards.append(shard)
+
+        known = [durations[f'{device}/{test_id}'] for test_id in test_ids
+                 if f'{device}/{test_id}' in durations]
+        default = sum(known) / len(known) if known else 1.0
+        weighted = sorted(test_ids,
+                          key=lambda test_id, d=device: -durations.get(f'{d}/{test_id}', default))
+        for test_id in weighted:
+            shard = min(device_shards, key=lambda s: s.expected_duration)
+            shard.test_ids.append(test_id)
+            shard.expected_duration += durations.get(f'{device}/{test_id}', default)
+    return [shard for shard in shards if shard.test_ids]
+
+
+def start_shard(shard: Shard, report_dir: Path, pytest_args: List[str]) -> None:
+    junit = report_dir / f'{shard.name}.xml'
+    log = (report_dir / f'{shard.name}.log').open('w')
+    args = [
+        '-v', '--tb=short', f'--speculos_api_port={shard.api_port}',
+        f'--speculos_apdu_port={shard.api_port + 1}', f'--junitxml={junit}', *pytest_args,
+        *shard.test_ids
+    ]
+    shard.process = subprocess.Popen(pytest_command(shard.device, args),
+                                     cwd=TESTS_DIR,
+                                     stdout=log,
+                                     stderr=subprocess.STDOUT)
+    log.close()
+
+
+def read_results(shard: Shard, report_dir: Path) -> List[TestResult]:
+    '''
+    Results of a shard from its JUnit report. A shard that crashed before
+    writing its report fails as a whole.
+    '''
+    junit = report_dir / f'{shard.name}.xml'
+    try:
+        root = ET.parse(junit).getroot()
+    except (OSError, ET.ParseError):
+        return [
+            TestResult(shard.device, shard.name, test_id, 'error', 0.0,
+                       f'no results, see {shard.name}.log') for test_id in shard.test_ids
+        ]
+
+    results = []
+    for case in root.iter('testcase'):
+        module = case.get('classname', '').replace('.', '/')
+        test_id = f"{module}.py::{case.get('name')}"
+        outcome, message = 'passed', ''
+        for child in case:
+            if child.tag in ('failure', 'error', 'skipped'):
+                outcome = 'failed' if child.tag == 'failure' else child.tag
+                message = child.get('message', '') or (child.text or '')
+                break
+        results.append(
+            TestResult(shard.device, shard.name, test_id, outcome, float(case.get('time', 0)),
+                       message))
+    return results
+
+
+def same_image(current: Path, golden: Path) -> bool:
+    '''
+    Compares screenshots by their pixels, like ragger, falling back to their
+    bytes without Pillow.
+    '''
+    try:
+        from PIL import Image  # pylint: disable=import-outside-toplevel
+    except ImportError:
+        return current.read_bytes() == golden.read_bytes()
+    with Image.open(current) as a, Image.open(golden) as b:
+        return a.size == b.size and a.convert('RGB').tobytes() == b.convert('RGB').tobytes()
+
+
+def snapshot_diffs(device: str) -> List[SnapshotDiff]:
+    '''
+    Screenshots of the run that differ from, or have no, golden snapshot.
+    '''
+    diffs = []
+    current_dir = CURRENT_SNAPSHOTS_DIR / device
+    if not current_dir.is_dir():
+        return diffs
+    for current in sorted(current_dir.rglob('*.png')):
+        relative = current.relative_to(current_dir)
+        golden = GOLDEN_SNAPSHOTS_DIR / device / relative
+        if not golden.is_file():
+            diffs.append(SnapshotDiff(device, str(relative), 'new'))
+        elif not same_image(current, golden):
+            diffs.append(SnapshotDiff(device, str(relative), 'changed'))
+    return diffs
+
+
+def copy_snapshots(diffs: List[SnapshotDiff], report_dir: Path) -> None:
+    '''
+    Copies the differing screenshots to the report, such that it is self-contained.
+    '''
+    for diff in diffs:
+        for kind, source_dir in (('current', CURRENT_SNAPSHOTS_DIR),
+                                 ('golden', GOLDEN_SNAPSHOTS_DIR)):
+            source = source_dir / diff.device / diff.path
+            if source.is_file():
+                target = report_dir / 'snapshots' / kind / diff.device / diff.path
+                target.parent.mkdir(parents=True, exist_ok=True)
+                shutil.copyfile(source, target)
+
+
+def write_html(report: dict, report_dir: Path) -> None:
+    esc = html.escape
+    rows = []
+    for device, summary in report['devices'].items():
+        rows.append(f"<tr><td>{esc(device)}</td><td>{summary['passed']}</td>"
+                    f"<td>{summary['failed']}</td><td>{summary['skipped']}</td>"
+                    f"<td>{summary['duration']:.1f} s</td></tr>")
+
+    failures = []
+    for test in report['tests']:
+        if test['outcome'] in ('failed', 'error'):
+            failures.append(f"<h3>{esc(test['device'])}: {esc(test['test_id'])}</h3>"
+                            f"<p><a href=\"{esc(test['shard'])}.log\">{esc(test['shard'])}.log"
+                            f"</a></p><pre>{esc(test['message'])}</pre>")
+
+    snapshots = []
+    for diff in report['snapshot_diffs']:
+        path = f"{diff['device']}/{diff['path']}"
+        golden = ('<td>(none)</td>' if diff['kind'] == 'new' else
+                  f'<td><img src="snapshots/golden/{esc(path)}"></td>')
+        snapshots.append(f"<tr><td>{esc(path)}</td><td>{diff['kind']}</td>{golden}"
+                         f'<td><img src="snapshots/current/{esc(path)}"></td></tr>')
+
+    page = f'''<!DOCTYPE html>
+<html>
+<head><meta charset="utf-8"><title>UI tests</title></head>
+<body>
+<h1>UI tests</h1>
+<p>{report['wall_time']:.1f} s wall time for {report['test_time']:.1f} s of tests, on
+{report['shards']} emulators.</p>
+<table border="1">
+<tr><th>Device</th><th>Passed</th><th>Failed</th><th>Skipped</th><th>Test time</th></tr>
+{''.join(rows)}
+</table>
+<h2>Failures</h2>
+{''.join(failures) or '<p>None.</p>'}
+<h2>Snapshot differences</h2>
+<table border="1">
+<tr><th>Snapshot</th><th>Difference</th><th>Golden</th><th>Current</th></tr>
+{''.join(snapshots)}
+</table>
+</body>
+</html>
+'''
+    (report_dir / 'index.html').write_text(page)
+
+
+def main() -> int:
+    argv = sys.argv[1:]
+    pytest_args: List[str] = []
+    if '--' in argv:
+        pytest_args = argv[argv.index('--') + 1:]
+        argv = argv[:argv.index('--')]
+
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--devices',
+                        nargs='+',
+                        choices=DEVICES,
+                        default=DEVICES,
+                        help='devices to test (default: all)')
+    parser.add_argument('--instances',
+                        type=int,
+                        default=1,
+                        help='emulators per device (default: 1)')
+    parser.add_argument('--base-port',
+                        type=int,
+                        default=5000,
+                        help='first port of the emulators, each uses two (default: 5000)')
+    parser.add_argument('--report',
+                        type=Path,
+                        default=TESTS_DIR / 'ui_report',
+                        help='directory to write the report to (default: ui_report)')
+    args = parser.parse_args(argv)
+    if args.instances < 1:
+        parser.error('--instances must be at least 1')
+
+    report_dir: Path = args.report.resolve()
+    durations = previous_durations(report_dir)
+    if report_dir.exists():
+        shutil.rmtree(report_dir)
+    report_dir.mkdir(parents=True)
+
+    tests = {device: collect_tests(device, pytest_args) for device in args.devices}
+    shards = make_shards(tests, args.instances, args.base_port, durations)
+
+    # Screenshots of earlier runs would be reported as differences
+    for device in args.devices:
+        shutil.rmtree(CURRENT_SNAPSHOTS_DIR / device, ignore_errors=True)
+
+    start = time.monotonic()
+    for shard in shards:
+        print(f'{shard.name}: {len(shard.test_ids)} tests on port {shard.api_port}')
+        start_shard(shard, report_dir, pytest_args)
+    for shard in shards:
+        assert shard.process is not None
+        shard.process.wait()
+    wall_time = time.monotonic() - start
+
+    results = [result for shard in shards for result in read_results(shard, report_dir)]
+    diffs = [diff for device in args.devices for diff in snapshot_diffs(device)]
+    copy_snapshots(diffs, report_dir)
+
+    devices = {}
+    for device in args.devices:
+        device_results = [r for r in results if r.device == device]
+        devices[device] = {
+            'passed': sum(r.outcome == 'passed' for r in device_results),
+            'failed': sum(r.outcome in ('failed', 'error') for r in device_results),
+            'skipped': sum(r.outcome == 'skipped' for r in device_results),
+            'duration': sum(r.duration for r in device_results),
+        }
+    report = {
+        'wall_time': wall_time,
+        'test_time': sum(r.duration for r in results),
+        'shards': len(shards),
+        'devices': devices,
+        'tests': [vars(r) for r in results],
+        'snapshot_diffs': [vars(d) for d in diffs],
+    }
+    (report_dir / 'report.json').write_text(json.dumps(report, indent=2) + '\n')
+    write_html(report, report_dir)
+
+    for device, summary in devices.items():
+        print(f"{device}: {summary['passed']} passed, {summary['failed']} failed, "
+              f"{summary['skipped']} skipped")
+    print(f"{len(diffs)} snapshot differences, {wall_time:.1f} s wall time for "
+          f"{report['test_time']:.1f} s of tests")
+    print(f'Report: {os.path.relpath(report_dir / "index.html")}')
+
+    failed = any(summary['failed'] for summary in devices.values())
+    return 1 if failed or diffs else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
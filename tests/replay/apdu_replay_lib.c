@@ -0,0 +1,95 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "io.h"
+
+#include "apdu/dispatcher.h"
+#include "constants.h"
+#include "types.h"
+#include "mock_app.h"
+#include "mock_sdk.h"
+
+/*
+ * Host library replaying the APDUs of a trace, for tests/replay_trace.py.
+ *
+ * Each APDU is dispatched to the handlers of the app like app_main does. When
+ * the APDU starts a review, the review is approved or rejected right away as
+ * recorded in the trace, and the response to the review is returned.
+ */
+
+/**
+ * Response to a replayed APDU. Must match ReplayResponse of replay_trace.py.
+ */
+typedef struct {
+    /** Whether the APDU started a review. */
+    uint8_t reviewed;
+    /** Whether the APDU got a response. */
+    uint8_t responded;
+    /** Status word of the response. */
+    uint16_t sw;
+    /** Length of the data of the response. */
+    uint16_t data_len;
+    /** Data of the response. */
+    uint8_t data[IO_APDU_BUFFER_SIZE];
+    /** Time spent in the handlers, in nanoseconds. */
+    uint64_t duration_ns;
+} replay_response_t;
+
+static uint64_t now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * Resets the application, like starting it.
+ */
+void replay_reset(void) {
+    mock_app_reset();
+}
+
+/**
+ * Dispatches a single APDU of the application, and approves or rejects the
+ * review it starts.
+ */
+void replay_apdu(uint8_t ins,
+                 uint8_t p1,
+                 uint8_t p2,
+                 const uint8_t *data,
+                 size_t lc,
+                 bool approve,
+                 replay_response_t *out) {
+    memset(out, 0, sizeof(*out));
+
+    // Copied to an exactly sized buffer, like the fuzzing targets
+    uint8_t *copy = malloc(lc > 0 ? lc : 1);
+    memcpy(copy, data, lc);
+    command_t cmd = {.cla = CLA,
+                     .ins = ins,
+                     .p1 = p1,
+                     .p2 = p2,
+                     .lc = (uint8_t) lc,
+                     .data = lc > 0 ? copy : NULL};
+
+    G_mock_review = MOCK_REVIEW_NONE;
+    mock_io_reset();
+    const uint64_t start = now_ns();
+    int status = apdu_dispatcher(&cmd);
+    (void) status;
+    if (G_mock_io.count == 0 && G_mock_review != MOCK_REVIEW_NONE) {
+        out->reviewed = 1;
+        mock_ui_choose(approve);
+    }
+    out->duration_ns = now_ns() - start;
+    free(copy);
+
+    if (G_mock_io.count > 0) {
+        out->responded = 1;
+        out->sw = G_mock_io.sw;
+        out->data_len = (uint16_t) G_mock_io.data_len;
+        memcpy(out->data, G_mock_io.data, G_mock_io.data_len);
+    }
+}
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+'''
+Replays APDU traces recorded with RecordingBackend on the APDU handlers of the
+application built for the host (see replay/CMakeLists.txt), and compares the
+responses and timing with the recorded ones.
+
+The application is reset before each trace. Reviews are approved or rejected
+as they were when recorded. APDUs of another CLA than the one of the
+application are handled by the OS of the device, and are skipped.
+
+The host build derives other keys than a device, so addresses and signatures
+are only compared by length, unless --exact is given. Its timing is the time
+spent in the handlers, without any transport.
+
+Replaying on Speculos instead is done by test_replay_trace.py.
+'''
+
+import argparse
+import ctypes
+import json
+import sys
+from pathlib import Path
+
+from application_client.apdu_trace import (ReplayedApdu, TraceRecord, compare_replay,
+                                           format_report, read_trace)
+from application_client.command_sender import CLA
+
+DEFAULT_LIBRARY = Path(__file__).parent / 'replay' / 'build' / 'libpbc_apdu_replay.so'
+
+# IO_APDU_BUFFER_SIZE of the SDK
+IO_APDU_BUFFER_SIZE = 260
+
+
+class ReplayResponse(ctypes.Structure):
+    '''
+    Mirror of replay_response_t of replay/apdu_replay_lib.c.
+    '''
+    _fields_ = [
+        ('reviewed', ctypes.c_uint8),
+        ('responded', ctypes.c_uint8),
+        ('sw', ctypes.c_uint16),
+        ('data_len', ctypes.c_uint16),
+        ('data', ctypes.c_uint8 * IO_APDU_BUFFER_SIZE),
+        ('duration_ns', ctypes.c_uint64),
+    ]
+
+
+class HostApp:
+    '''
+    APDU handlers of the application, built for the host.
+    '''
+
+    def __init__(self, library: Path) -> None:
+        self.lib = ctypes.CDLL(str(library))
+        self.lib.replay_reset.restype = None
+        self.lib.replay_apdu.restype = None
+        self.lib.replay_apdu.argtypes = [
+            ctypes.c_uint8, ctypes.c_uint8, ctypes.c_uint8, ctypes.c_char_p, ctypes.c_size_t,
+            ctypes.c_bool,
+            ctypes.POINTER(ReplayResponse)
+        ]
+
+    def reset(self) -> None:
+        self.lib.replay_reset()
+
+    def replay(self, record: TraceRecord) -> ReplayedApdu:
+        if record.cla != CLA:
+            return ReplayedApdu(0, b'', 0, skipped=True)
+        out = ReplayResponse()
+        self.lib.replay_apdu(record.ins, record.p1, record.p2, record.data, len(record.data),
+                             record.approved(), ctypes.byref(out))
+        # An APDU without response, such as one starting a review that was
+        # recorded before the review ended, has no status word
+        sw = out.sw if out.responded else 0
+        return ReplayedApdu(sw, bytes(out.data[:out.data_len]), out.duration_ns // 1000)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('traces', nargs='+', type=Path, help='traces to replay')
+    parser.add_argument('--library', type=Path, default=DEFAULT_LIBRARY)
+    parser.add_argument('--exact',
+                        action='store_true',
+                        help='also compare addresses and signatures')
+    parser.add_argument('--json', type=Path, help='file to write the reports to')
+    args = parser.parse_args()
+
+    app = HostApp(args.library)
+    reports = {}
+    mismatches = 0
+    for trace in args.traces:
+        records = read_trace(str(trace))
+        app.reset()
+        replayed = [app.replay(record) for record in records]
+        report = compare_replay(records, replayed, args.exact)
+        reports[str(trace)] = report
+        mismatches += report['mismatches']  # type: ignore[operator]
+        print(f'{trace}:')
+        print(format_report(report))
+
+    if args.json:
+        args.json.write_text(json.dumps(reports, indent=2), encoding='utf-8')
+    return 1 if mismatches else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
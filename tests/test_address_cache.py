@@ -0,0 +1,98 @@
+import random
+import sqlite3
+
+import pytest
+
+from application_client.address_cache import (AddressCache, AddressCacheMismatchError,
+                                              unpack_derivation_path)
+from application_client.command_sender import InsType, PbcCommandSender
+from application_client.response_unpacker import unpack_get_address_response
+from ragger.bip import pack_derivation_path
+from utils import KEY_PATH
+
+PATHS = [KEY_PATH, "m/3757'/0'/0/0/0", "m/3757'/0'/910'/0/0", "m/3757'/0'/255/255/255"]
+
+
+class CountingBackend:
+    '''
+    Backend counting the GET_ADDRESS requests sent to the device.
+    '''
+
+    def __init__(self, backend):
+        self.backend = backend
+        self.derivations = 0
+
+    def exchange(self, **kwargs):
+        if kwargs['ins'] == InsType.GET_ADDRESS:
+            self.derivations += 1
+        return self.backend.exchange(**kwargs)
+
+
+def test_unpack_derivation_path():
+    for path in PATHS + ["m/3757'/0'/2147483647/0/0/0/0/0/0/0"]:
+        assert unpack_derivation_path(pack_derivation_path(path)) == path
+
+
+# A warm restart only derives the canary address on the device
+def test_address_cache_warm_restart(backend, tmp_path):
+    filename = str(tmp_path / 'addresses.sqlite')
+    expected = [
+        unpack_get_address_response(PbcCommandSender(backend).get_address(path).data)
+        for path in PATHS
+    ]
+
+    counting = CountingBackend(backend)
+    with AddressCache(filename, counting, sample_rate=0.0) as cache:
+        assert cache.get_addresses(PATHS) == expected
+        assert cache.get_address(PATHS[0]) == expected[0]
+    assert counting.derivations == 1 + len(PATHS)
+
+    counting = CountingBackend(backend)
+    with AddressCache(filename, counting, sample_rate=0.0) as cache:
+        assert cache.get_addresses(PATHS) == expected
+        assert (cache.hits, cache.misses) == (len(PATHS), 0)
+    assert counting.derivations == 1
+
+    # Sampled hits are checked against the device
+    counting = CountingBackend(backend)
+    with AddressCache(filename, counting, sample_rate=1.0) as cache:
+        assert [cache.get_address(path) for path in PATHS] == expected
+        assert cache.samples == len(PATHS)
+        assert cache.verify(2) == 2
+    assert counting.derivations == 1 + len(PATHS) + 2
+
+
+# An altered cache file is detected when sampled, and the addresses of the
+# device are dropped
+def test_address_cache_detects_altered_address(backend, tmp_path):
+    filename = str(tmp_path / 'addresses.sqlite')
+    with AddressCache(filename, backend) as cache:
+        cache.get_addresses(PATHS)
+        other = cache.get_address(PATHS[1])
+
+    with sqlite3.connect(filename) as db:
+        db.execute('UPDATE addresses SET address = ? WHERE path = ?',
+                   (other.serialize(), pack_derivation_path(PATHS[0])))
+
+    with AddressCache(filename, backend, sample_rate=1.0) as cache:
+        with pytest.raises(AddressCacheMismatchError):
+            cache.get_address(PATHS[0])
+        cache.get_address(PATHS[1])
+        assert (cache.hits, cache.misses) == (1, 1)
+
+
+# The addresses cached for a device with another seed are not used
+def test_address_cache_other_seed(backend, tmp_path):
+    filename = str(tmp_path / 'addresses.sqlite')
+    with AddressCache(filename, backend) as cache:
+        expected = cache.get_addresses(PATHS)
+
+    # Device with the seed of the cached addresses is swapped for another
+    with sqlite3.connect(filename) as db:
+        db.execute('UPDATE addresses SET device = ?', (bytes(21), ))
+
+    counting = CountingBackend(backend)
+    with AddressCache(filename, counting, rng=random.Random(0)) as cache:
+        assert cache.get_addresses(PATHS) == expected
+        assert (cache.hits, cache.misses) == (0, len(PATHS))
+    assert counting.derivations == 1 + len(PATHS)
@@ -0,0 +1,87 @@
+import asyncio
+import threading
+
+from application_client.async_command_sender import AsyncPbcCommandSender
+from application_client.command_sender import MAX_APDU_LEN, PbcCommandSender
+from application_client.response_unpacker import unpack_get_address_response
+from test_sign_cmd import wait_for_first_screen_of_review_flow, approve_without_snapshots
+from test_chunk_size_cmd import USB_HID_PACKET_PAYLOAD
+from utils import KEY_PATH, CHAIN_IDS
+import transaction_examples
+
+PATHS = [KEY_PATH, "m/3757'/0'/0/0/0", "m/3757'/0'/910'/0/0"]
+
+
+def run_in_background(coroutine):
+    '''
+    Runs a coroutine on an event loop of its own thread, such that the review
+    can be approved from the test while it runs.
+    '''
+    loop = asyncio.new_event_loop()
+    thread = threading.Thread(target=loop.run_forever, daemon=True)
+    thread.start()
+    future = asyncio.run_coroutine_threadsafe(coroutine, loop)
+    future.add_done_callback(lambda _: loop.call_soon_threadsafe(loop.stop))
+    return future
+
+
+# The async client returns the same addresses as the blocking client, also
+# when the requests are made concurrently
+def test_async_get_address(backend):
+    expected = [
+        unpack_get_address_response(PbcCommandSender(backend).get_address(path).data)
+        for path in PATHS
+    ]
+
+    async def get_addresses():
+        async with AsyncPbcCommandSender(backend) as client:
+            return await asyncio.gather(*[client.get_address(path) for path in PATHS])
+
+    assert asyncio.run(get_addresses()) == expected
+
+
+# Several signing requests are submitted at once. They are reviewed one after
+# the other, and every signature is verified by the client.
+def test_async_sign_tx_pipelined(firmware, backend, navigator):
+    transactions = [
+        transaction for _, transaction in transaction_examples.MPC_TRANSFER_TRANSACTIONS[:3]
+    ]
+    chain_id = CHAIN_IDS[0]
+    address = unpack_get_address_response(PbcCommandSender(backend).get_address(KEY_PATH).data)
+
+    async def sign_all():
+        async with AsyncPbcCommandSender(backend) as client:
+            return await asyncio.gather(*[
+                client.sign_tx(KEY_PATH, transaction.serialize(), chain_id)
+                for transaction in transactions
+            ])
+
+    signatures = run_in_background(sign_all())
+    for _ in transactions:
+        wait_for_first_screen_of_review_flow(navigator)
+        approve_without_snapshots(firmware, navigator)
+
+    for transaction, signature in zip(transactions, signatures.result(timeout=30)):
+        assert transaction.verify_signature_with_address(address, signature, chain_id)
+
+
+# The async client negotiates the chunk length like the blocking client, and
+# signs in chunks of that length
+def test_async_sign_tx_negotiated_chunk_size(firmware, backend, navigator):
+    transaction = transaction_examples.TRANSACTION_MPC_TRANSFER_WITH_MEMO_LARGE
+    chain_id = CHAIN_IDS[0]
+    address = unpack_get_address_response(PbcCommandSender(backend).get_address(KEY_PATH).data)
+
+    async def sign():
+        async with AsyncPbcCommandSender(backend) as client:
+            assert await client.negotiate_chunk_size(USB_HID_PACKET_PAYLOAD) == \
+                PbcCommandSender(backend).negotiate_chunk_size(USB_HID_PACKET_PAYLOAD)
+            assert client.max_chunk_len < MAX_APDU_LEN
+            return await client.sign_tx(KEY_PATH, transaction.serialize(), chain_id)
+
+    signature = run_in_background(sign())
+    wait_for_first_screen_of_review_flow(navigator)
+    approve_without_snapshots(firmware, navigator)
+
+    assert transaction.verify_signature_with_address(address, signature.result(timeout=30),
+                                                     chain_id)
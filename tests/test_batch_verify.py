@@ -0,0 +1,94 @@
+from hashlib import sha256
+
+import pytest
+from ecdsa.curves import SECP256k1  # type: ignore
+from ecdsa.keys import SigningKey, VerifyingKey  # type: ignore
+import ecdsa.util  # type: ignore
+
+from application_client.batch_verify import (BACKEND_NATIVE, BACKEND_PROCESSES, BatchVerifier,
+                                             native_available)
+from application_client.command_sender import PbcCommandSender
+from application_client.response_unpacker import (unpack_get_address_response,
+                                                  unpack_sign_tx_response)
+from application_client.transaction import Address, Signature
+from test_sign_cmd import wait_for_first_screen_of_review_flow, approve_without_snapshots
+from utils import KEY_PATH, CHAIN_IDS
+import transaction_examples
+
+BACKENDS = [
+    BACKEND_PROCESSES,
+    pytest.param(BACKEND_NATIVE,
+                 marks=pytest.mark.skipif(not native_available(),
+                                          reason='coincurve is not installed')),
+]
+
+
+def tampered(signature: Signature) -> Signature:
+    return Signature(signature.recovery_id, signature.r, bytes([signature.s[0] ^ 1]) +
+                     signature.s[1:])
+
+
+def host_signatures(count: int):
+    '''
+    Transactions signed by keys of the host, with the recovery id of each
+    signature.
+    '''
+    signatures = []
+    for index in range(count):
+        key = SigningKey.from_secret_exponent(index + 1, curve=SECP256k1)
+        public_key = key.get_verifying_key()
+        address = Address.from_public_key(public_key.to_string('uncompressed'))
+        transaction = transaction_examples.TRANSACTION_MPC_TRANSFER_WITH_MEMO_SMALL.serialize(
+        ) + index.to_bytes(4, byteorder='big')
+        chain_id = CHAIN_IDS[index % len(CHAIN_IDS)]
+        signed_bytes = transaction + len(chain_id).to_bytes(4, byteorder='big') + chain_id
+        rs = key.sign_deterministic(signed_bytes,
+                                    hashfunc=sha256,
+                                    sigencode=ecdsa.util.sigencode_string)
+        recovered = VerifyingKey.from_public_key_recovery(rs,
+                                                          signed_bytes,
+                                                          curve=SECP256k1,
+                                                          hashfunc=sha256)
+        recovery_id = [k.to_string() for k in recovered].index(public_key.to_string())
+        signatures.append((transaction, chain_id, Signature(recovery_id, rs[:32],
+                                                            rs[32:]), address))
+    return signatures
+
+
+# Batches larger than a chunk are verified on the pool of processes, or with
+# the native library, and tampered signatures are reported in place
+@pytest.mark.parametrize("verifier_backend", BACKENDS)
+def test_batch_verify_host_signatures(verifier_backend):
+    signatures = host_signatures(20)
+    other_address = signatures[0][3]
+    signatures[3] = signatures[3][:2] + (tampered(signatures[3][2]), signatures[3][3])
+    signatures[7] = signatures[7][:3] + (other_address, )
+    signatures[11] = (signatures[11][0], b'Other chain') + signatures[11][2:]
+
+    with BatchVerifier(backend=verifier_backend, processes=2, chunk_size=4) as verifier:
+        result = verifier.verify_transactions(signatures)
+    assert result.backend == verifier_backend
+    assert result.invalid == [3, 7, 11]
+    assert result.signatures_per_second > 0
+
+
+# Signatures of the application verify in a batch
+def test_batch_verify_device_signatures(firmware, backend, navigator):
+    client = PbcCommandSender(backend)
+    address = unpack_get_address_response(client.get_address(path=KEY_PATH).data)
+    chain_id = CHAIN_IDS[0]
+
+    signatures = []
+    for _, transaction in transaction_examples.MPC_TRANSFER_TRANSACTIONS:
+        with client.sign_tx(path=KEY_PATH, transaction=transaction.serialize(),
+                            chain_id=chain_id):
+            wait_for_first_screen_of_review_flow(navigator)
+            approve_without_snapshots(firmware, navigator)
+        signature = unpack_sign_tx_response(client.get_async_response().data)
+        signatures.append((transaction, chain_id, signature, address))
+    signatures.append(signatures[0][:2] + (tampered(signatures[0][2]), address))
+
+    for name in [BACKEND_PROCESSES] + ([BACKEND_NATIVE] if native_available() else []):
+        with BatchVerifier(backend=name, processes=2, chunk_size=2) as verifier:
+            result = verifier.verify_transactions(signatures)
+        assert result.invalid == [len(signatures) - 1]
@@ -0,0 +1,92 @@
+import pytest
+
+from application_client.command_sender import (MAX_APDU_LEN, PbcCommandSender, aligned_chunk_len,
+                                               negotiated_chunk_len, sign_message_packets,
+                                               sign_tx_packets)
+from application_client.response_unpacker import (unpack_get_address_response,
+                                                  unpack_get_chunk_size_response,
+                                                  unpack_sign_tx_response)
+from application_client.rpc_compression import COMPRESSION_WINDOW_LEN
+from application_client.transaction import Message
+from test_sign_cmd import wait_for_first_screen_of_review_flow, approve_without_snapshots
+from test_sign_message_cmd import move_to_end_and_choose
+from utils import KEY_PATH, CHAIN_IDS
+import transaction_examples
+
+# Payload of a USB HID packet of 64 bytes
+USB_HID_PACKET_PAYLOAD = 64 - 5
+
+
+# The app reports the size of its APDU buffer and the chunks it accepts
+def test_get_chunk_size(firmware, backend):
+    client = PbcCommandSender(backend)
+    io_buffer_size, max_chunk_len, granularity, window_len = unpack_get_chunk_size_response(
+        client.get_chunk_size().data)
+
+    assert max_chunk_len == MAX_APDU_LEN
+    assert io_buffer_size >= 5 + max_chunk_len
+    assert granularity == USB_HID_PACKET_PAYLOAD
+    assert window_len == (COMPRESSION_WINDOW_LEN if firmware.device == "nanos" else 1024)
+
+    # Chunks are as long as the app accepts by default
+    assert client.negotiate_chunk_size() == max_chunk_len
+    assert client.negotiate_chunk_size(USB_HID_PACKET_PAYLOAD) == 229
+    # No APDU fills a packet of this payload
+    assert client.negotiate_chunk_size(1000) == max_chunk_len
+
+
+# Without a packet payload, the negotiated chunks are as long as the app
+# accepts, not aligned to the granularity it reports
+def test_negotiated_chunk_len():
+    response = b''.join(value.to_bytes(2, byteorder='big')
+                        for value in [300, MAX_APDU_LEN, USB_HID_PACKET_PAYLOAD, 1024])
+    assert negotiated_chunk_len(response) == MAX_APDU_LEN
+    assert negotiated_chunk_len(response, USB_HID_PACKET_PAYLOAD) == 229
+
+
+@pytest.mark.parametrize("packet_payload", [20, 59, 61, 244, 1000])
+def test_aligned_chunk_len(packet_payload):
+    chunk_len = aligned_chunk_len(MAX_APDU_LEN, packet_payload)
+    assert chunk_len <= MAX_APDU_LEN
+    if packet_payload <= 2 + 5 + MAX_APDU_LEN:
+        # Fills whole packets, and one more byte would need another packet
+        assert (2 + 5 + chunk_len) % packet_payload == 0
+        assert chunk_len + packet_payload > MAX_APDU_LEN
+    else:
+        assert chunk_len == MAX_APDU_LEN
+
+
+# Chunks of the negotiated length split the requests like the default length
+@pytest.mark.parametrize("max_chunk_len", [100, 229])
+def test_packets_of_negotiated_length(max_chunk_len):
+    transaction = transaction_examples.TRANSACTION_MPC_TRANSFER_WITH_MEMO_LARGE.serialize()
+    packets = sign_tx_packets(KEY_PATH, transaction, CHAIN_IDS[0], max_chunk_len)
+    assert all(len(packet.data) <= max_chunk_len for packet in packets)
+    assert b''.join(packet.data for packet in packets[1:]) == transaction
+
+    message = b'm' * 1000
+    packets = sign_message_packets(KEY_PATH, message, max_chunk_len)
+    assert all(len(packet.data) <= max_chunk_len for packet in packets)
+    assert b''.join(packet.data for packet in packets[1:]) == message
+
+
+# Signing with chunks of the negotiated length, aligned to USB HID packets
+def test_sign_with_negotiated_chunk_size(firmware, backend, navigator):
+    client = PbcCommandSender(backend)
+    client.negotiate_chunk_size(USB_HID_PACKET_PAYLOAD)
+    address = unpack_get_address_response(client.get_address(path=KEY_PATH).data)
+    chain_id = CHAIN_IDS[0]
+
+    transaction = transaction_examples.TRANSACTION_MPC_TRANSFER_WITH_MEMO_LARGE
+    with client.sign_tx(path=KEY_PATH, transaction=transaction.serialize(), chain_id=chain_id):
+        wait_for_first_screen_of_review_flow(navigator)
+        approve_without_snapshots(firmware, navigator)
+    signature = unpack_sign_tx_response(client.get_async_response().data)
+    assert transaction.verify_signature_with_address(address, signature, chain_id)
+
+    message = Message(b'Negotiated chunks ' * 40)
+    with client.sign_message_streamed(path=KEY_PATH, message=message.data):
+        wait_for_first_screen_of_review_flow(navigator)
+        move_to_end_and_choose(firmware, navigator, approve=True)
+    signature = unpack_sign_tx_response(client.get_async_response().data)
+    assert message.verify_signature_with_address(address, signature)
@@ -0,0 +1,95 @@
+import dataclasses
+import os
+
+import pytest
+from ragger.error import ExceptionRAPDU
+
+from application_client.command_sender import (Errors, P1, PbcCommandSender, sign_tx_packets,
+                                               sign_tx_compressed_packets)
+from application_client.response_unpacker import (unpack_get_address_response,
+                                                  unpack_sign_tx_response)
+from application_client.rpc_compression import (COMPRESSION_WINDOW_LEN, DecompressionError,
+                                                 compress, decompress)
+from test_sign_cmd import (enable_blind_sign, wait_for_first_screen_of_review_flow,
+                           approve_without_snapshots)
+from utils import KEY_PATH, CHAIN_IDS
+import transaction_examples
+
+# RPC resembling a contract deployment: repeated code with small differences,
+# and long runs of zeroes.
+DEPLOY_LIKE_RPC = b''.join(
+    bytes([0x20, 0x00, 0x41, i & 0xFF, 0x6a, 0x21, 0x01]) + bytes(i % 40)
+    for i in range(600))
+
+
+@pytest.mark.parametrize("data", [
+    b'',
+    b'a',
+    b'\x00' * 5000,
+    os.urandom(3000),
+    DEPLOY_LIKE_RPC,
+])
+def test_compression_round_trip(data):
+    compressed = compress(data)
+    assert decompress(compressed) == data
+
+
+# Copies reach at most the window of the app back
+def test_compression_window():
+    data = os.urandom(COMPRESSION_WINDOW_LEN) * 3
+    compressed = compress(data)
+    assert decompress(compressed) == data
+    assert len(compressed) < 2 * COMPRESSION_WINDOW_LEN
+
+    # Copies from out of the window are rejected
+    with pytest.raises(DecompressionError):
+        decompress(compress(os.urandom(600) * 2, window_len=1024), window_len=512)
+
+
+# Signing a large blind transaction with compressed chunks gives the signature
+# of the uncompressed transaction, in fewer chunks
+def test_sign_tx_compressed(firmware, backend, navigator):
+    client = PbcCommandSender(backend)
+    address = unpack_get_address_response(client.get_address(path=KEY_PATH).data)
+    chain_id = CHAIN_IDS[0]
+    enable_blind_sign(firmware, navigator)
+
+    transaction = dataclasses.replace(transaction_examples.TRANSACTION_GENERIC_CONTRACT,
+                                      rpc=DEPLOY_LIKE_RPC)
+    transaction_bytes = transaction.serialize()
+    packets = sign_tx_compressed_packets(KEY_PATH, transaction_bytes, chain_id)
+    assert packets[2].p1 == P1.P1_COMPRESSED_CHUNK
+    assert len(packets) < len(sign_tx_packets(KEY_PATH, transaction_bytes, chain_id))
+
+    # Chunks and copies as long as the device allows
+    client.negotiate_chunk_size()
+    signatures = []
+    for sign_tx in [client.sign_tx_compressed, client.sign_tx]:
+        with sign_tx(path=KEY_PATH, transaction=transaction_bytes, chain_id=chain_id):
+            wait_for_first_screen_of_review_flow(navigator)
+            approve_without_snapshots(firmware, navigator)
+        signatures.append(unpack_sign_tx_response(client.get_async_response().data))
+
+    assert transaction.verify_signature_with_address(address, signatures[0], chain_id)
+    assert signatures[0] == signatures[1]
+
+
+# Compressed chunks that cannot be decompressed are rejected
+def test_sign_tx_compressed_invalid(backend):
+    client = PbcCommandSender(backend)
+    transaction = transaction_examples.TRANSACTION_GENERIC_CONTRACT_PRECISELY_OVER_ONE_CHUNK
+    packets = sign_tx_packets(KEY_PATH, transaction.serialize(), CHAIN_IDS[0])
+
+    # Copy from before the first decompressed byte
+    packets[-1] = packets[-1].replace(p1=P1.P1_COMPRESSED_CHUNK, data=b'\x80\x00\x01')
+    with pytest.raises(ExceptionRAPDU) as e:
+        with client.send_packets(packets):
+            pass
+    assert e.value.status == Errors.SW_TX_DECOMPRESSION_FAIL
+
+    # Stream ending inside literals
+    packets[-1] = packets[-1].replace(data=b'\x01\xff')
+    with pytest.raises(ExceptionRAPDU) as e:
+        with client.send_packets(packets):
+            pass
+    assert e.value.status == Errors.SW_TX_DECOMPRESSION_FAIL
@@ -0,0 +1,139 @@
+from concurrent.futures import ThreadPoolExecutor
+
+import pytest
+
+from application_client.command_sender import PbcCommandSender, Errors
+from application_client.device_pool import DevicePool, NoHealthyDeviceError
+from application_client.response_unpacker import unpack_get_address_response
+from ragger.error import ExceptionRAPDU
+from ragger.navigator import NanoNavigator, StaxNavigator
+from test_sign_cmd import wait_for_first_screen_of_review_flow, approve_without_snapshots
+from utils import KEY_PATH, CHAIN_IDS
+import transaction_examples
+
+PATHS = [KEY_PATH, "m/3757'/0'/0/0/0", "m/3757'/0'/910'/0/0", "m/3757'/0'/255/255/255"]
+
+
+class UnreachableBackend:
+    '''
+    Backend of a device that was unplugged.
+    '''
+
+    def __init__(self, backend):
+        self.backend = backend
+        self.attempts = 0
+
+    def exchange(self, *args, **kwargs):
+        self.attempts += 1
+        raise ConnectionError('Device unreachable')
+
+    def exchange_async(self, *args, **kwargs):
+        self.attempts += 1
+        raise ConnectionError('Device unreachable')
+
+
+class RejectingBackend:
+    '''
+    Backend of a device on which the user rejects every review.
+    '''
+
+    def __init__(self, backend):
+        self.backend = backend
+
+    def exchange(self, *args, **kwargs):
+        raise ExceptionRAPDU(Errors.SW_DENY)
+
+    def exchange_async(self, *args, **kwargs):
+        raise ExceptionRAPDU(Errors.SW_DENY)
+
+
+def navigator_of(firmware, backend):
+    if firmware.device.startswith("nano"):
+        return NanoNavigator(backend, firmware, golden_run=False)
+    return StaxNavigator(backend, firmware, golden_run=False)
+
+
+# Every emulator of the pool returns the same addresses as the emulator of the
+# test, and requests made at once are spread over the emulators
+def test_pool_get_address(backend, speculos_backends):
+    expected = {
+        path: unpack_get_address_response(PbcCommandSender(backend).get_address(path).data)
+        for path in PATHS
+    }
+
+    pool = DevicePool(speculos_backends)
+    assert pool.check_same_seed(KEY_PATH) == expected[KEY_PATH]
+    with ThreadPoolExecutor(max_workers=2 * len(speculos_backends)) as executor:
+        paths = PATHS * 4
+        addresses = list(executor.map(pool.get_address, paths))
+    assert addresses == [expected[path] for path in paths]
+
+    stats = pool.stats()
+    assert all(device['healthy'] for device in stats)
+    assert sum(device['latency']['get_address']['count'] for device in stats) == len(paths)
+    assert sum(1 for device in stats if device['latency']) > 1
+
+
+# Transactions signed at once are spread over the emulators of the pool, and
+# the review of each is approved on the emulator that shows it
+def test_pool_sign_tx(firmware, speculos_backends):
+    navigators = [navigator_of(firmware, backend) for backend in speculos_backends]
+
+    def approve(device):
+        wait_for_first_screen_of_review_flow(navigators[device.index])
+        approve_without_snapshots(firmware, navigators[device.index])
+
+    pool = DevicePool(speculos_backends, approve=approve)
+    transactions = [
+        transaction for _, transaction in transaction_examples.MPC_TRANSFER_TRANSACTIONS
+    ]
+    chain_id = CHAIN_IDS[0]
+    address = pool.address_of_path(KEY_PATH)
+
+    with ThreadPoolExecutor(max_workers=len(transactions)) as executor:
+        signatures = list(
+            executor.map(
+                lambda transaction: pool.sign_tx(KEY_PATH, transaction.serialize(), chain_id),
+                transactions))
+
+    for transaction, signature in zip(transactions, signatures):
+        assert transaction.verify_signature_with_address(address, signature, chain_id)
+    assert sum(1 for device in pool.stats() if 'sign_tx' in device['latency']) > 1
+
+
+# Requests to an unreachable device are retried on the other device, and the
+# unreachable device is not used again until its cooldown is over
+def test_pool_retries_transport_errors(backend):
+    unreachable = UnreachableBackend(backend)
+    pool = DevicePool([unreachable, backend])
+
+    expected = unpack_get_address_response(PbcCommandSender(backend).get_address(KEY_PATH).data)
+    for _ in range(3):
+        assert pool.get_address(KEY_PATH) == expected
+    assert unreachable.attempts == 1
+
+    stats = pool.stats()
+    assert not stats[0]['healthy']
+    assert stats[1]['healthy']
+    assert stats[1]['latency']['get_address']['count'] == 3
+
+    # No device left
+    pool = DevicePool([unreachable], cooldown=0.0)
+    with pytest.raises(NoHealthyDeviceError):
+        pool.get_address(KEY_PATH)
+
+
+# Requests failed by the application are not retried, and are counted as errors
+# of the device instead of latencies, without making the device unhealthy
+def test_pool_counts_application_errors(backend):
+    pool = DevicePool([RejectingBackend(backend)])
+    for _ in range(2):
+        with pytest.raises(ExceptionRAPDU) as e:
+            pool.get_address(KEY_PATH)
+        assert e.value.status == Errors.SW_DENY
+
+    stats = pool.stats()
+    assert stats[0]['healthy']
+    assert stats[0]['consecutive_failures'] == 0
+    assert stats[0]['errors'] == {'get_address': 2}
+    assert stats[0]['latency'] == {}
@@ -0,0 +1,122 @@
+'''
+Replays APDU traces recorded with RecordingBackend on Speculos, and compares
+the responses and timing with the recorded ones. Reviews are approved or
+rejected by automation as they were when recorded.
+
+Traces are given with --replay_trace, and the test is skipped otherwise:
+
+    pytest --device nanosp --replay_trace signing.pbctrace -k test_replay_trace -s
+
+Unless the emulator holds the seed of the recording device, addresses and
+signatures are only compared by length. Timing includes the transport to the
+emulator.
+'''
+
+import json
+import time
+
+import pytest
+
+from application_client.apdu_trace import (RecordingBackend, ReplayedApdu, TraceRecord,
+                                           TraceWriter, compare_replay, format_report,
+                                           read_trace)
+from application_client.command_sender import Errors, InsType, PbcCommandSender
+from ragger.bip import pack_derivation_path
+from ragger.error import ExceptionRAPDU
+from ragger.navigator import NavInsID
+from test_sign_cmd import wait_for_first_screen_of_review_flow, approve_without_snapshots
+from test_sign_message_cmd import move_to_end_and_choose
+from utils import KEY_PATH, CHAIN_IDS
+import transaction_examples
+
+
+def choose_review(firmware, navigator, record: TraceRecord) -> None:
+    approve = record.approved()
+    if record.ins != InsType.GET_ADDRESS:
+        wait_for_first_screen_of_review_flow(navigator)
+        move_to_end_and_choose(firmware, navigator, approve)
+    elif firmware.device.startswith("nano"):
+        navigator.navigate_until_text(NavInsID.RIGHT_CLICK, [NavInsID.BOTH_CLICK],
+                                      "Approve" if approve else "Reject")
+    elif approve:
+        navigator.navigate([
+            NavInsID.USE_CASE_REVIEW_TAP, NavInsID.USE_CASE_ADDRESS_CONFIRMATION_CONFIRM,
+            NavInsID.USE_CASE_STATUS_DISMISS
+        ])
+    else:
+        navigator.navigate([NavInsID.USE_CASE_REVIEW_REJECT, NavInsID.USE_CASE_STATUS_DISMISS])
+
+
+def replay(firmware, backend, navigator, record: TraceRecord) -> ReplayedApdu:
+    apdu = {'cla': record.cla, 'ins': record.ins, 'p1': record.p1, 'p2': record.p2,
+            'data': record.data}
+    start = time.perf_counter()
+    try:
+        if record.reviewed():
+            with backend.exchange_async(**apdu):
+                choose_review(firmware, navigator, record)
+            response = backend.last_async_response
+        else:
+            response = backend.exchange(**apdu)
+    except ExceptionRAPDU as e:
+        return ReplayedApdu(e.status, bytes(e.data or b''),
+                            int((time.perf_counter() - start) * 1e6))
+    return ReplayedApdu(response.status, bytes(response.data),
+                        int((time.perf_counter() - start) * 1e6))
+
+
+def test_replay_trace(firmware, backend, navigator, pytestconfig):
+    traces = pytestconfig.getoption("--replay_trace")
+    if not traces:
+        pytest.skip("needs --replay_trace")
+
+    reports = {}
+    for trace in traces:
+        records = read_trace(trace)
+        replayed = [replay(firmware, backend, navigator, record) for record in records]
+        reports[trace] = compare_replay(records, replayed, exact=False)
+        print(f'{trace}:')
+        print(format_report(reports[trace]))
+
+    output = pytestconfig.getoption("--replay_report")
+    if output:
+        with open(output, 'w', encoding='utf-8') as f:
+            json.dump(reports, f, indent=2)
+
+    for trace, report in reports.items():
+        assert report['mismatches'] == 0, f'{trace}: responses differ from the trace'
+
+
+# The exchanges of a client are recorded to a trace, which replays with the
+# same responses on the same emulator
+def test_record_and_replay(firmware, backend, navigator, tmp_path):
+    filename = str(tmp_path / 'test.pbctrace')
+    transaction = transaction_examples.TRANSACTION_MPC_TRANSFER.serialize()
+    with TraceWriter(filename) as trace:
+        client = PbcCommandSender(RecordingBackend(backend, trace))
+        client.get_version()
+        client.get_address(KEY_PATH)
+        with client.sign_tx(path=KEY_PATH, transaction=transaction, chain_id=CHAIN_IDS[0]):
+            wait_for_first_screen_of_review_flow(navigator)
+            approve_without_snapshots(firmware, navigator)
+        with pytest.raises(ExceptionRAPDU):
+            with client.sign_tx_with_template(template_id=0, transaction=transaction):
+                pass
+
+    records = read_trace(filename)
+    assert [(record.ins, record.asynchronous) for record in records] == [
+        (InsType.GET_VERSION, False),
+        (InsType.GET_ADDRESS, False),
+        (InsType.SIGN_TX, False),
+        (InsType.SIGN_TX, True),
+        (InsType.SIGN_TX, True),
+    ]
+    assert records[1].data == pack_derivation_path(KEY_PATH)
+    assert records[3].sw == 0x9000 and len(records[3].response) == 65
+    assert records[3].reviewed()
+    assert records[4].sw == Errors.SW_UNKNOWN_TX_TEMPLATE and not records[4].reviewed()
+    assert all(a.start_us + a.duration_us <= b.start_us for a, b in zip(records, records[1:]))
+
+    replayed = [replay(firmware, backend, navigator, record) for record in records]
+    report = compare_replay(records, replayed, exact=True)
+    assert report['mismatches'] == 0
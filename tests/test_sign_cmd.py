@@ -234,6 +234,96 @@ def test_sign_mpc_transfer(firmware, backend, navigator, test_name,
                                                      chain_id)
 
 
+def approve_without_snapshots(firmware, navigator):
+    if firmware.device.startswith("nano"):
+        navigator.navigate_until_text(NavInsID.RIGHT_CLICK,
+                                      [NavInsID.BOTH_CLICK], "Approve")
+    else:
+        navigator.navigate_until_text(NavInsID.USE_CASE_REVIEW_TAP, [
+            NavInsID.USE_CASE_REVIEW_CONFIRM,
+            NavInsID.USE_CASE_STATUS_DISMISS,
+        ], "Hold to sign")
+
+
+@pytest.mark.parametrize("transaction_name,transaction",
+                         transaction_examples.ZK_INVOCATION_TRANSACTIONS)
+def test_sign_zk_invocation(firmware, backend, navigator, test_name,
+                            transaction_name, transaction):
+    chain_id = CHAIN_IDS[0]
+    test_name = name_for_sign_test(test_name, transaction_name, chain_id)
+
+    client = PbcCommandSender(backend)
+
+    rapdu = client.get_address(path=KEY_PATH)
+    address = unpack_get_address_response(rapdu.data)
+
+    transaction_bytes = transaction.serialize()
+
+    # Blind signing disabled; ZK invocations are clear-signed
+    with client.sign_tx(path=KEY_PATH,
+                        transaction=transaction_bytes,
+                        chain_id=chain_id):
+        # Wait for first screen of the application
+        wait_for_first_screen_of_review_flow(navigator)
+
+        # Approve
+        move_to_end_and_approve(firmware, navigator, test_name)
+
+    response = client.get_async_response().data
+    rs_signature = unpack_sign_tx_response(response)
+    assert transaction.verify_signature_with_address(address, rs_signature,
+                                                     chain_id)
+
+
+@pytest.mark.parametrize("transaction_name,transaction",
+                         transaction_examples.MPC_TRANSFER_TRANSACTIONS)
+def test_sign_mpc_transfer_with_template(firmware, backend, navigator,
+                                         transaction_name, transaction):
+    client = PbcCommandSender(backend)
+    chain_id = CHAIN_IDS[0]
+    template_id = 1
+
+    rapdu = client.get_address(path=KEY_PATH)
+    address = unpack_get_address_response(rapdu.data)
+
+    client.set_tx_template(template_id=template_id,
+                           path=KEY_PATH,
+                           chain_id=chain_id,
+                           gas_cost=transaction.gas_cost,
+                           contract_address=transaction.contract_address.
+                           serialize())
+
+    # Sign the same transaction twice, to check that the template is kept
+    for _ in range(2):
+        with client.sign_tx_with_template(
+                template_id=template_id,
+                transaction=transaction.serialize()):
+            # Wait for first screen of the application
+            wait_for_first_screen_of_review_flow(navigator)
+
+            # Approve
+            approve_without_snapshots(firmware, navigator)
+
+        response = client.get_async_response().data
+        rs_signature = unpack_sign_tx_response(response)
+        assert transaction.verify_signature_with_address(
+            address, rs_signature, chain_id)
+
+
+def test_sign_tx_with_unknown_template(backend):
+    client = PbcCommandSender(backend)
+
+    transaction_bytes = transaction_examples.TRANSACTION_MPC_TRANSFER.serialize(
+    )
+
+    with pytest.raises(ExceptionRAPDU) as e:
+        with client.sign_tx_with_template(template_id=0,
+                                          transaction=transaction_bytes):
+            pass
+
+    assert e.value.status == Errors.SW_UNKNOWN_TX_TEMPLATE
+
+
 # Transaction signature refused test
 # The test will ask for a transaction signature that will be refused on screen
 def test_sign_tx_refused(firmware, backend, navigator, test_name):
@@ -0,0 +1,147 @@
+'''
+End-to-end latency benchmark of SIGN_TX.
+
+Signs transactions with RPCs of different sizes, sent in chunks of different
+sizes, and approves them automatically. Each APDU and the whole signing flow is
+timed, and the results are written as JSON to the file given by
+--benchmark_output, with percentiles of every phase:
+
+- transfer: Transport overhead of the APDUs, estimated as the number of APDUs
+  times the median round-trip time of GET_VERSION.
+- parse_hash: Round-trip time of the non-final APDUs, minus their transfer
+  time. Covers parsing and hashing of the transaction.
+- ui: From sending the final APDU until the user approves. Includes parsing
+  and hashing of the final chunk, and the automated navigation.
+- sign: From approval until the signature is received.
+
+Run with:
+
+    pytest --device nanosp --benchmark -k test_sign_latency
+'''
+import json
+import statistics
+import time
+
+import pytest
+
+from application_client.command_sender import PbcCommandSender, sign_tx_packets
+from application_client.response_unpacker import unpack_sign_tx_response
+from application_client.transaction import Transaction, ZkSecretInput, Address
+from test_sign_cmd import wait_for_first_screen_of_review_flow, approve_without_snapshots
+from utils import KEY_PATH, CHAIN_IDS
+
+pytestmark = pytest.mark.benchmark
+
+# Sizes of the RPC payloads to sign
+PAYLOAD_SIZES = [0, 256, 1024, 4096, 16384]
+
+# Maximum sizes of the transaction chunks
+CHUNK_SIZES = [64, 128, 255]
+
+# Number of GET_VERSION round-trips to estimate the transport overhead from
+TRANSPORT_SAMPLES = 20
+
+PHASES = ['transfer', 'parse_hash', 'ui', 'sign', 'total']
+
+ZK_CONTRACT_ADDRESS = Address.from_hex(
+    "03de0b295669a9fd93d5f28d9ec85e40f4cb697bae")
+
+
+def transaction_with_payload(payload_size: int) -> Transaction:
+    '''
+    Secret input to a ZK contract, which is clear-signed regardless of the size
+    of its payload.
+    '''
+    return Transaction(
+        nonce=0x111,
+        valid_to_time=0x222,
+        gas_cost=0x333,
+        contract_address=ZK_CONTRACT_ADDRESS,
+        rpc=ZkSecretInput([32], b'\xab' * payload_size),
+    )
+
+
+def percentiles(samples: list[float]) -> dict:
+    if len(samples) < 2:
+        return {'p50': samples[0], 'p90': samples[0], 'p99': samples[0]}
+    quantiles = statistics.quantiles(samples, n=100, method='inclusive')
+    return {'p50': quantiles[49], 'p90': quantiles[89], 'p99': quantiles[98]}
+
+
+@pytest.fixture(scope="module")
+def results(request):
+    results = []
+    yield results
+
+    output_path = request.config.getoption("--benchmark_output")
+    with open(output_path, 'w', encoding='utf-8') as output:
+        json.dump({'benchmarks': results}, output, indent=2)
+
+
+@pytest.fixture(scope="module")
+def transport_overhead(backend):
+    client = PbcCommandSender(backend)
+    samples = []
+    for _ in range(TRANSPORT_SAMPLES):
+        start = time.perf_counter()
+        client.get_version()
+        samples.append(time.perf_counter() - start)
+    return statistics.median(samples)
+
+
+def sign_once(client, firmware, navigator, transaction: bytes,
+              chunk_size: int, transport_overhead: float) -> dict:
+    packets = sign_tx_packets(KEY_PATH, transaction, CHAIN_IDS[0], chunk_size)
+    apdu_durations: list[float] = []
+
+    start = time.perf_counter()
+    with client.send_packets(packets, apdu_durations):
+        last_sent = time.perf_counter()
+        wait_for_first_screen_of_review_flow(navigator)
+        approve_without_snapshots(firmware, navigator)
+        approved = time.perf_counter()
+    done = time.perf_counter()
+
+    unpack_sign_tx_response(client.get_async_response().data)
+
+    transfer = len(packets) * transport_overhead
+    return {
+        'packets': len(packets),
+        'apdus': apdu_durations,
+        'transfer': transfer,
+        'parse_hash': max(0.0,
+                          sum(apdu_durations) - len(apdu_durations) * transport_overhead),
+        'ui': approved - last_sent,
+        'sign': done - approved,
+        'total': done - start,
+    }
+
+
+@pytest.mark.parametrize("chunk_size", CHUNK_SIZES)
+@pytest.mark.parametrize("payload_size", PAYLOAD_SIZES)
+def test_sign_latency(firmware, backend, navigator, request, results,
+                      transport_overhead, payload_size, chunk_size):
+    client = PbcCommandSender(backend)
+    transaction = transaction_with_payload(payload_size).serialize()
+    repetitions = request.config.getoption("--benchmark_repetitions")
+
+    samples = [
+        sign_once(client, firmware, navigator, transaction, chunk_size,
+                  transport_overhead) for _ in range(repetitions)
+    ]
+
+    apdu_durations = [d for sample in samples for d in sample['apdus']]
+    results.append({
+        'device': firmware.device,
+        'payload_size': payload_size,
+        'transaction_size': len(transaction),
+        'chunk_size': chunk_size,
+        'apdus': samples[0]['packets'],
+        'repetitions': repetitions,
+        'transport_overhead': transport_overhead,
+        'apdu': percentiles(apdu_durations) if apdu_durations else None,
+        **{
+            phase: percentiles([sample[phase] for sample in samples])
+            for phase in PHASES
+        },
+    })
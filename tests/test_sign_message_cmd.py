@@ -0,0 +1,106 @@
+import pytest
+
+from application_client.transaction import Message
+from application_client.command_sender import PbcCommandSender, Errors, sign_message_packets
+from application_client.response_unpacker import unpack_get_address_response, unpack_sign_tx_response
+from ragger.error import ExceptionRAPDU
+from ragger.navigator import NavInsID
+from utils import ROOT_SCREENSHOT_PATH, KEY_PATH
+from test_sign_cmd import wait_for_first_screen_of_review_flow
+
+MESSAGES = [
+    ('short', Message(b'Login to partisiablockchain.com, challenge 1234')),
+    ('unreadable', Message(bytes(range(0, 256)))),
+    ('long', Message(b'Proof of ownership. ' * 100)),
+]
+
+
+def move_to_end_and_choose(firmware, navigator, approve: bool, test_name=None):
+    '''Navigates the review and approves or rejects it. The screens are
+    compared with the snapshots of test_name, if given.
+    '''
+    if firmware.device.startswith("nano"):
+        navigate_instruction = NavInsID.RIGHT_CLICK
+        validation_instructions = [NavInsID.BOTH_CLICK]
+        text = "Approve" if approve else "Reject"
+    elif approve:
+        navigate_instruction = NavInsID.USE_CASE_REVIEW_TAP
+        validation_instructions = [
+            NavInsID.USE_CASE_REVIEW_CONFIRM,
+            NavInsID.USE_CASE_STATUS_DISMISS,
+        ]
+        text = "Hold to sign"
+    else:
+        navigate_instruction = NavInsID.USE_CASE_REVIEW_TAP
+        validation_instructions = [
+            NavInsID.USE_CASE_REVIEW_REJECT,
+            NavInsID.USE_CASE_CHOICE_CONFIRM,
+            NavInsID.USE_CASE_STATUS_DISMISS,
+        ]
+        text = "Hold to sign"
+
+    if test_name is None:
+        navigator.navigate_until_text(navigate_instruction, validation_instructions, text)
+    else:
+        navigator.navigate_until_text_and_compare(navigate_instruction,
+                                                  validation_instructions, text,
+                                                  ROOT_SCREENSHOT_PATH, test_name)
+
+
+# The snapshots show the preview of the message, truncated with "..." for the
+# long message, and the hash of the message
+@pytest.mark.parametrize("message_name,message", MESSAGES)
+def test_sign_message(firmware, backend, navigator, test_name, message_name, message):
+    test_name = '{}-{}'.format(test_name, message_name)
+    client = PbcCommandSender(backend)
+
+    rapdu = client.get_address(path=KEY_PATH)
+    address = unpack_get_address_response(rapdu.data)
+
+    with client.sign_message(path=KEY_PATH, message=message.serialize()):
+        wait_for_first_screen_of_review_flow(navigator)
+        move_to_end_and_choose(firmware, navigator, approve=True, test_name=test_name)
+
+    response = client.get_async_response().data
+    rs_signature = unpack_sign_tx_response(response)
+    assert message.verify_signature_with_address(address, rs_signature)
+
+
+def test_sign_message_refused(firmware, backend, navigator, test_name):
+    client = PbcCommandSender(backend)
+
+    with pytest.raises(ExceptionRAPDU) as e:
+        with client.sign_message(path=KEY_PATH,
+                                 message=MESSAGES[0][1].serialize()):
+            wait_for_first_screen_of_review_flow(navigator)
+            move_to_end_and_choose(firmware, navigator, approve=False, test_name=test_name)
+
+    # Assert that we have received a refusal
+    assert e.value.status == Errors.SW_DENY
+    assert len(e.value.data) == 0
+
+
+def test_sign_message_shorter_than_announced(backend):
+    client = PbcCommandSender(backend)
+
+    packets = sign_message_packets(KEY_PATH, b'Hello World')
+    packets[-1] = packets[-1].replace(data=b'Hello')
+
+    with pytest.raises(ExceptionRAPDU) as e:
+        with client.send_packets(packets):
+            pass
+
+    assert e.value.status == Errors.SW_WRONG_MESSAGE_LENGTH
+
+
+def test_sign_message_longer_than_announced(backend):
+    client = PbcCommandSender(backend)
+
+    packets = sign_message_packets(KEY_PATH, b'Hello World')
+    packets[-1] = packets[-1].replace(data=b'Hello World!')
+
+    with pytest.raises(ExceptionRAPDU) as e:
+        with client.send_packets(packets):
+            pass
+
+    assert e.value.status == Errors.SW_WRONG_MESSAGE_LENGTH
@@ -0,0 +1,89 @@
+import pytest
+
+from application_client.transaction import Message
+from application_client.command_sender import PbcCommandSender, Errors, InsType
+from application_client.response_unpacker import unpack_get_stack_usage_response
+from ragger.error import ExceptionRAPDU
+from utils import KEY_PATH, CHAIN_IDS
+from test_sign_cmd import wait_for_first_screen_of_review_flow, approve_without_snapshots
+import transaction_examples
+
+# Fraction of the stack any instruction may use, unless --stack_budget is given.
+# Leaves headroom for the SDK and for growth of the handlers.
+DEFAULT_STACK_BUDGET_FRACTION = 0.75
+
+# Instructions exercised by the test, which must all have been measured.
+EXERCISED_INSTRUCTIONS = [
+    InsType.GET_VERSION,
+    InsType.GET_APP_NAME,
+    InsType.GET_CHUNK_SIZE,
+    InsType.GET_ADDRESS,
+    InsType.SIGN_MESSAGE,
+    InsType.SET_TX_TEMPLATE,
+    InsType.SIGN_TX,
+]
+
+
+def ins_name(ins: int) -> str:
+    try:
+        return InsType(ins).name
+    except ValueError:
+        return hex(ins)
+
+
+# In this test we run every handler, including the signing done after approval,
+# and check that none of them used more stack than the budget.
+# GET_STACK_USAGE is only available when the app is built with ENABLE_STACK_USAGE=1.
+def test_stack_usage_within_budget(firmware, backend, navigator, request):
+    client = PbcCommandSender(backend)
+    chain_id = CHAIN_IDS[0]
+
+    try:
+        client.get_stack_usage()
+    except ExceptionRAPDU as e:
+        if e.status == Errors.SW_INS_NOT_SUPPORTED:
+            pytest.skip("app built without ENABLE_STACK_USAGE=1")
+        raise
+
+    client.get_version()
+    client.get_app_name()
+    client.get_chunk_size()
+    client.get_address(path=KEY_PATH)
+
+    message = Message(b'Stack usage')
+    with client.sign_message(path=KEY_PATH, message=message.serialize()):
+        wait_for_first_screen_of_review_flow(navigator)
+        approve_without_snapshots(firmware, navigator)
+    client.get_async_response()
+
+    transaction = transaction_examples.TRANSACTION_MPC_TRANSFER
+    client.set_tx_template(template_id=0,
+                           path=KEY_PATH,
+                           chain_id=chain_id,
+                           gas_cost=transaction.gas_cost,
+                           contract_address=transaction.contract_address.
+                           serialize())
+    with client.sign_tx(path=KEY_PATH,
+                        transaction=transaction.serialize(),
+                        chain_id=chain_id):
+        wait_for_first_screen_of_review_flow(navigator)
+        approve_without_snapshots(firmware, navigator)
+    client.get_async_response()
+
+    # The usage of an instruction is measured when the next APDU is received,
+    # so the signing done on approval is attributed to SIGN_TX here.
+    stack_size, high_water = unpack_get_stack_usage_response(
+        client.get_stack_usage().data)
+
+    budget = request.config.getoption("--stack_budget")
+    if budget is None:
+        budget = int(stack_size * DEFAULT_STACK_BUDGET_FRACTION)
+
+    for ins in EXERCISED_INSTRUCTIONS:
+        assert high_water[ins] > 0, f"{ins_name(ins)} was not measured"
+    over_budget = {
+        ins_name(ins): used
+        for ins, used in high_water.items() if used > budget
+    }
+    assert not over_budget, \
+        f"stack budget of {budget}/{stack_size} bytes exceeded: {over_budget}"
@@ -0,0 +1,31 @@
+import pytest
+
+from application_client.command_sender import PbcCommandSender, Errors
+from application_client.response_unpacker import unpack_get_stats_response
+from ragger.error import ExceptionRAPDU
+from utils import KEY_PATH
+
+
+# In this test we check that the instrumentation counters are returned and reset.
+# GET_STATS is only available when the app is built with ENABLE_STATS=1.
+def test_get_stats(backend):
+    client = PbcCommandSender(backend)
+
+    try:
+        client.get_stats()
+    except ExceptionRAPDU as e:
+        if e.status == Errors.SW_INS_NOT_SUPPORTED:
+            pytest.skip("app built without ENABLE_STATS=1")
+        raise
+
+    # Derive an address, which dispatches an APDU and derives a key
+    client.get_address(path=KEY_PATH)
+
+    stats = unpack_get_stats_response(client.get_stats().data)
+    assert stats['phases']['dispatch'] >= 1
+    assert stats['phases']['derive'] == 1
+    assert stats['phases']['parse'] == 0
+
+    # Counters are reset by GET_STATS
+    stats = unpack_get_stats_response(client.get_stats().data)
+    assert stats['phases']['derive'] == 0
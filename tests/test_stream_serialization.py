@@ -0,0 +1,69 @@
+import pytest
+
+from application_client.command_sender import (PbcCommandSender, sign_message_packets,
+                                               sign_message_stream, sign_tx_packets,
+                                               sign_tx_stream)
+from application_client.response_unpacker import (unpack_get_address_response,
+                                                  unpack_sign_tx_response)
+from application_client.transaction import Message
+from test_sign_cmd import wait_for_first_screen_of_review_flow, approve_without_snapshots
+from test_sign_message_cmd import move_to_end_and_choose
+from utils import KEY_PATH, CHAIN_IDS
+import transaction_examples
+
+
+def as_tuples(packets):
+    return [(packet.p1, packet.p2, packet.data) for packet in packets]
+
+
+def chunks_as_tuples(chunks):
+    return [(p1, p2, bytes(data)) for p1, p2, data in chunks]
+
+
+# Serializing into a buffer gives the same bytes as serialize, also at an
+# offset in a larger buffer
+@pytest.mark.parametrize("transaction_name,transaction", transaction_examples.VALID_TRANSACTIONS)
+def test_serialize_into(transaction_name, transaction):
+    serialized = transaction.serialize()
+    assert transaction.serialized_size() == len(serialized)
+
+    buffer = bytearray(len(serialized) + 3)
+    assert transaction.serialize_into(memoryview(buffer), 2) == 2 + len(serialized)
+    assert bytes(buffer[2:-1]) == serialized
+
+
+# The streamed chunks are the packets of the non-streamed requests
+@pytest.mark.parametrize("transaction_name,transaction", transaction_examples.VALID_TRANSACTIONS)
+@pytest.mark.parametrize("chain_id", CHAIN_IDS)
+def test_sign_tx_stream_chunks(transaction_name, transaction, chain_id):
+    packets = sign_tx_packets(KEY_PATH, transaction.serialize(), chain_id)
+    assert chunks_as_tuples(sign_tx_stream(KEY_PATH, transaction, chain_id)) == as_tuples(packets)
+    assert chunks_as_tuples(sign_tx_stream(KEY_PATH, transaction.serialize(),
+                                           chain_id)) == as_tuples(packets)
+
+
+@pytest.mark.parametrize("message", [b'', b'Hello', b'x' * 255, b'y' * 1000])
+def test_sign_message_stream_chunks(message):
+    packets = sign_message_packets(KEY_PATH, message)
+    assert chunks_as_tuples(sign_message_stream(KEY_PATH, message)) == as_tuples(packets)
+
+
+# Signing with the streamed requests
+def test_sign_tx_and_message_streamed(firmware, backend, navigator):
+    client = PbcCommandSender(backend)
+    address = unpack_get_address_response(client.get_address(path=KEY_PATH).data)
+    chain_id = CHAIN_IDS[0]
+    transaction = transaction_examples.TRANSACTION_MPC_TRANSFER_WITH_MEMO_LARGE
+
+    with client.sign_tx_streamed(path=KEY_PATH, transaction=transaction, chain_id=chain_id):
+        wait_for_first_screen_of_review_flow(navigator)
+        approve_without_snapshots(firmware, navigator)
+    signature = unpack_sign_tx_response(client.get_async_response().data)
+    assert transaction.verify_signature_with_address(address, signature, chain_id)
+
+    message = Message(b'Streamed message')
+    with client.sign_message_streamed(path=KEY_PATH, message=message.data):
+        wait_for_first_screen_of_review_flow(navigator)
+        move_to_end_and_choose(firmware, navigator, approve=True)
+    signature = unpack_sign_tx_response(client.get_async_response().data)
+    assert message.verify_signature_with_address(address, signature)
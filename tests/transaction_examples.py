@@ -1,4 +1,4 @@
-from application_client.transaction import Transaction, MpcTokenTransfer, Address, from_hex
+from application_client.transaction import Transaction, MpcTokenTransfer, ZkOpenInvocation, ZkSecretInput, Address, from_hex
 
 TRANSACTION_GENERIC_CONTRACT = Transaction(
     nonce=0x111,
@@ -146,6 +146,33 @@ TRANSACTION_MPC_TRANSFER_WITH_MEMO_LARGE_RIDICULOUS = Transaction(
     ),
 )
 
+TRANSACTION_ZK_OPEN_INVOCATION = Transaction(
+    nonce=0x111,
+    valid_to_time=0x222,
+    gas_cost=0x333,
+    contract_address=Address.from_hex(
+        "03de0b295669a9fd93d5f28d9ec85e40f4cb697bae"),
+    rpc=ZkOpenInvocation(0x1234, from_hex('deadbeef')),
+)
+
+TRANSACTION_ZK_SECRET_INPUT_OFF_CHAIN = Transaction(
+    nonce=0x111,
+    valid_to_time=0x222,
+    gas_cost=0x333,
+    contract_address=Address.from_hex(
+        "03de0b295669a9fd93d5f28d9ec85e40f4cb697bae"),
+    rpc=ZkSecretInput([32], from_hex('ab') * 4 * 32, on_chain=False),
+)
+
+TRANSACTION_ZK_SECRET_INPUT_ON_CHAIN_HUGE = Transaction(
+    nonce=0x111,
+    valid_to_time=0x222,
+    gas_cost=0x333,
+    contract_address=Address.from_hex(
+        "03de0b295669a9fd93d5f28d9ec85e40f4cb697bae"),
+    rpc=ZkSecretInput([32, 64, 1], from_hex('cd') * 8000),
+)
+
 BLIND_TRANSACTIONS = [
     ('generic', TRANSACTION_GENERIC_CONTRACT),
     ('almost_an_mpc_transfer', TRANSACTION_MPC_TRANSFER_FORGOT_SHORTNAME),
@@ -172,4 +199,11 @@ MPC_TRANSFER_TRANSACTIONS = [
      TRANSACTION_MPC_TRANSFER_WITH_MEMO_LARGE_AND_SMALL),
 ]
 
-VALID_TRANSACTIONS = BLIND_TRANSACTIONS + MPC_TRANSFER_TRANSACTIONS
+ZK_INVOCATION_TRANSACTIONS = [
+    ('zk_open_invocation', TRANSACTION_ZK_OPEN_INVOCATION),
+    ('zk_secret_input_off_chain', TRANSACTION_ZK_SECRET_INPUT_OFF_CHAIN),
+    ('zk_secret_input_on_chain_huge',
+     TRANSACTION_ZK_SECRET_INPUT_ON_CHAIN_HUGE),
+]
+
+VALID_TRANSACTIONS = BLIND_TRANSACTIONS + MPC_TRANSFER_TRANSACTIONS + ZK_INVOCATION_TRANSACTIONS
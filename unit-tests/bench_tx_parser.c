@@ -0,0 +1,363 @@
+/**
+ * Micro-benchmarks of the transaction parser hot path.
+ *
+ * Runs transaction_parser_update over a corpus of transactions at several
+ * chunk splits, and the buffer readers from buffer_util.c, and reports the
+ * results as JSON on stdout:
+ *
+ *   {"benchmarks": [{"name": ..., "iterations": ..., "ns_per_op": ...,
+ *                    "bytes_per_second": ..., "allocations": ...}, ...]}
+ *
+ * The parser must not allocate from the heap. All heap allocations made while
+ * a benchmark runs are counted by wrapping malloc, and the benchmark fails when
+ * any are made.
+ *
+ * Usage: bench_tx_parser [min time per benchmark in milliseconds]
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "buffer.h"
+#include "write.h"
+
+#include "well_known.h"
+#include "constants.h"
+#include "arena.h"
+#include "buffer_util.h"
+#include "transaction/deserialize.h"
+
+/// Allocation counting
+
+/** Whether heap allocations are currently being counted. */
+static bool COUNT_ALLOCATIONS = false;
+/** Number of heap allocations made while counting. */
+static uint64_t ALLOCATIONS = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    ALLOCATIONS += COUNT_ALLOCATIONS;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    ALLOCATIONS += COUNT_ALLOCATIONS;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    ALLOCATIONS += COUNT_ALLOCATIONS;
+    return __real_realloc(ptr, size);
+}
+
+/// Corpus
+
+/** Size of the RPC of the generic transaction. */
+#define GENERIC_RPC_LEN 2048
+
+/** Size of the memo of the large memo transaction. */
+#define LARGE_MEMO_LEN 100
+
+/** Size of the largest transaction in the corpus. */
+#define MAX_TRANSACTION_LEN_BENCH (TRANSACTION_HEADER_LEN + GENERIC_RPC_LEN)
+
+static const uint8_t ADDRESS_GENERIC[ADDRESS_LEN] = {
+    0x02, 0xc3, 0x39, 0x97, 0x54, 0x4e, 0x31, 0x75, 0xd2, 0x66, 0xbd,
+    0x02, 0x24, 0x39, 0xb2, 0x2c, 0xdb, 0x16, 0x50, 0x8c, 0x7a,
+};
+
+static const uint8_t ADDRESS_RECIPIENT[ADDRESS_LEN] = {
+    0x00, 0xa4, 0x08, 0x2d, 0x9d, 0x56, 0x07, 0x49, 0xec, 0xd0, 0xff,
+    0xa1, 0xdc, 0xaa, 0xae, 0xe2, 0xc2, 0xcb, 0x25, 0xd8, 0x81,
+};
+
+/**
+ * Transaction of the corpus.
+ */
+typedef struct {
+    /** Name of the transaction, used in benchmark names. */
+    const char *name;
+    /** Serialized transaction. */
+    uint8_t bytes[MAX_TRANSACTION_LEN_BENCH];
+    /** Length of the serialized transaction. */
+    size_t length;
+    /** Type the transaction is expected to be parsed as. */
+    transaction_type_e expected_type;
+} bench_transaction_t;
+
+/**
+ * Serializes the header of a transaction to the given contract, with the given
+ * RPC length. Returns the offset of the RPC.
+ */
+static size_t write_header(uint8_t *out, const uint8_t contract[ADDRESS_LEN], uint32_t rpc_len) {
+    write_u64_be(out, 0, 0x102);
+    write_u64_be(out, 8, 0x304);
+    write_u64_be(out, 16, 0x506);
+    memcpy(out + 24, contract, ADDRESS_LEN);
+    write_u32_be(out, 24 + ADDRESS_LEN, rpc_len);
+    return TRANSACTION_HEADER_LEN;
+}
+
+/**
+ * Serializes an MPC transfer with the given shortname, followed by the given
+ * memo bytes.
+ */
+static void build_mpc_transfer(bench_transaction_t *tx,
+                               uint8_t shortname,
+                               const uint8_t *memo,
+                               size_t memo_len) {
+    blockchain_address_s mpc_token_address = MPC_TOKEN_ADDRESS;
+    uint32_t rpc_len = 1 + ADDRESS_LEN + 8 + memo_len;
+    size_t offset = write_header(tx->bytes, mpc_token_address.raw_bytes, rpc_len);
+
+    tx->bytes[offset++] = shortname;
+    memcpy(tx->bytes + offset, ADDRESS_RECIPIENT, ADDRESS_LEN);
+    offset += ADDRESS_LEN;
+    write_u64_be(tx->bytes, offset, 0x333);
+    offset += 8;
+    memcpy(tx->bytes + offset, memo, memo_len);
+    tx->length = offset + memo_len;
+    tx->expected_type = MPC_TRANSFER;
+}
+
+/** Number of transactions in the corpus. */
+#define CORPUS_SIZE 4
+
+static bench_transaction_t CORPUS[CORPUS_SIZE];
+
+static void build_corpus(void) {
+    // Generic transaction, requiring blind signing
+    bench_transaction_t *generic = &CORPUS[0];
+    generic->name = "generic";
+    size_t offset = write_header(generic->bytes, ADDRESS_GENERIC, GENERIC_RPC_LEN);
+    for (size_t i = 0; i < GENERIC_RPC_LEN; i++) {
+        generic->bytes[offset + i] = (uint8_t) i;
+    }
+    generic->length = offset + GENERIC_RPC_LEN;
+    generic->expected_type = GENERIC_TRANSACTION;
+
+    // MPC transfer
+    CORPUS[1].name = "mpc_transfer";
+    build_mpc_transfer(&CORPUS[1], MPC_TOKEN_SHORTNAME_TRANSFER, NULL, 0);
+
+    // MPC transfer with small memo
+    uint8_t small_memo[8];
+    write_u64_be(small_memo, 0, 0x123456789);
+    CORPUS[2].name = "mpc_transfer_small_memo";
+    build_mpc_transfer(&CORPUS[2],
+                       MPC_TOKEN_SHORTNAME_TRANSFER_MEMO_SMALL,
+                       small_memo,
+                       sizeof(small_memo));
+
+    // MPC transfer with large memo
+    uint8_t large_memo[4 + LARGE_MEMO_LEN];
+    write_u32_be(large_memo, 0, LARGE_MEMO_LEN);
+    memset(large_memo + 4, 'm', LARGE_MEMO_LEN);
+    CORPUS[3].name = "mpc_transfer_large_memo";
+    build_mpc_transfer(&CORPUS[3],
+                       MPC_TOKEN_SHORTNAME_TRANSFER_MEMO_LARGE,
+                       large_memo,
+                       sizeof(large_memo));
+}
+
+/// Benchmark runner
+
+/** Minimum time to run each benchmark for. */
+static uint64_t MIN_DURATION_NS = 200 * 1000 * 1000;
+
+/** Number of operations to run between each check of the clock. */
+#define BATCH_SIZE 256
+
+/** Whether any benchmark has failed. */
+static bool ANY_FAILED = false;
+
+/** Whether any benchmark result has been printed. */
+static bool ANY_PRINTED = false;
+
+/** Sink for results, such that operations are not optimized away. */
+static volatile uint64_t SINK;
+
+/**
+ * Benchmarked operation. Returns false if the operation produced an unexpected
+ * result.
+ */
+typedef bool (*bench_op_t)(const void *arg);
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 * 1000 * 1000 + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Runs the given operation repeatedly for at least #MIN_DURATION_NS, and
+ * prints the result as a JSON object.
+ */
+static void run_benchmark(const char *name, bench_op_t op, const void *arg, size_t bytes_per_op) {
+    // Warm up, and check that the operation produces the expected result
+    bool ok = op(arg);
+
+    COUNT_ALLOCATIONS = true;
+    ALLOCATIONS = 0;
+
+    uint64_t iterations = 0;
+    uint64_t start = now_ns();
+    uint64_t elapsed = 0;
+    while (ok && elapsed < MIN_DURATION_NS) {
+        for (int i = 0; i < BATCH_SIZE; i++) {
+            ok &= op(arg);
+        }
+        iterations += BATCH_SIZE;
+        elapsed = now_ns() - start;
+    }
+
+    COUNT_ALLOCATIONS = false;
+
+    double ns_per_op = iterations == 0 ? 0 : (double) elapsed / (double) iterations;
+    double bytes_per_second = elapsed == 0 ? 0 : (double) bytes_per_op * 1e9 / ns_per_op;
+    bool passed = ok && ALLOCATIONS == 0;
+    ANY_FAILED |= !passed;
+
+    printf("%s\n    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, "
+           "\"bytes_per_second\": %.0f, \"allocations\": %llu, \"passed\": %s}",
+           ANY_PRINTED ? "," : "",
+           name,
+           (unsigned long long) iterations,
+           ns_per_op,
+           bytes_per_second,
+           (unsigned long long) ALLOCATIONS,
+           passed ? "true" : "false");
+    ANY_PRINTED = true;
+}
+
+/// Benchmarked operations
+
+/**
+ * Transaction parsed in chunks of at most the given size.
+ */
+typedef struct {
+    const bench_transaction_t *tx;
+    size_t chunk_len;
+} parse_arg_t;
+
+static uint8_t BENCH_ARENA_BUFFER[ARENA_SIZE];
+static arena_t BENCH_ARENA;
+
+static bool op_transaction_parser_update(const void *arg) {
+    const parse_arg_t *parse_arg = arg;
+    const bench_transaction_t *bench_tx = parse_arg->tx;
+
+    transaction_parsing_state_t state;
+    transaction_t tx;
+    arena_reset(&BENCH_ARENA);
+    transaction_parser_init(&state, &BENCH_ARENA);
+
+    parser_status_e status = PARSING_CONTINUE;
+    for (size_t offset = 0; offset < bench_tx->length; offset += parse_arg->chunk_len) {
+        size_t remaining = bench_tx->length - offset;
+        size_t chunk_len = remaining < parse_arg->chunk_len ? remaining : parse_arg->chunk_len;
+        buffer_t chunk = {.ptr = bench_tx->bytes + offset, .size = chunk_len, .offset = 0};
+        status = transaction_parser_update(&state, &chunk, &tx);
+        if (status < 0) {
+            return false;
+        }
+    }
+
+    SINK += tx.basic.nonce;
+    return status == PARSING_DONE && tx.type == bench_tx->expected_type;
+}
+
+static bool op_buffer_read_chain_id(const void *arg) {
+    (void) arg;
+    static const uint8_t CHAIN_ID[] = "\x00\x00\x00\x1bPartisia Blockchain Testnet";
+    buffer_t buf = {.ptr = CHAIN_ID, .size = sizeof(CHAIN_ID) - 1, .offset = 0};
+    chain_id_t chain_id;
+    bool ok = buffer_read_chain_id(&buf, &chain_id);
+    SINK += chain_id.length;
+    return ok && chain_id.length == 27;
+}
+
+static bool op_buffer_read_contract_address(const void *arg) {
+    (void) arg;
+    buffer_t buf = {.ptr = ADDRESS_GENERIC, .size = sizeof(ADDRESS_GENERIC), .offset = 0};
+    blockchain_address_s address;
+    bool ok = buffer_read_contract_address(&buf, &address);
+    SINK += address.raw_bytes[ADDRESS_LEN - 1];
+    return ok;
+}
+
+static bool op_buffer_read_bytes(const void *arg) {
+    (void) arg;
+    const bench_transaction_t *generic = &CORPUS[0];
+    buffer_t buf = {.ptr = generic->bytes, .size = MAX_CHUNK_LEN, .offset = 0};
+    uint8_t out[MAX_CHUNK_LEN];
+    size_t read = buffer_read_bytes(&buf, out, sizeof(out));
+    SINK += out[MAX_CHUNK_LEN - 1];
+    return read == MAX_CHUNK_LEN;
+}
+
+static bool op_buffer_read_leb128_u32(const void *arg) {
+    (void) arg;
+    static const uint8_t LEB128[] = {0xff, 0xff, 0xff, 0xff, 0x0f};
+    buffer_t buf = {.ptr = LEB128, .size = sizeof(LEB128), .offset = 0};
+    uint32_t value;
+    bool ok = buffer_read_leb128_u32(&buf, &value);
+    SINK += value;
+    return ok && value == UINT32_MAX;
+}
+
+/// Main
+
+/** Chunk splits to parse transactions at. */
+static const size_t CHUNK_LENS[] = {MAX_CHUNK_LEN, 128, 100};
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        MIN_DURATION_NS = strtoull(argv[1], NULL, 10) * 1000 * 1000;
+    }
+
+    build_corpus();
+    arena_init(&BENCH_ARENA, BENCH_ARENA_BUFFER, sizeof(BENCH_ARENA_BUFFER));
+
+    printf("{\"benchmarks\": [");
+
+    char name[128];
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        for (size_t j = 0; j < sizeof(CHUNK_LENS) / sizeof(CHUNK_LENS[0]); j++) {
+            // The leading part of the RPC must be in the first chunk to be
+            // clear-signed.
+            if (CORPUS[i].expected_type != GENERIC_TRANSACTION &&
+                CORPUS[i].length > CHUNK_LENS[j]) {
+                continue;
+            }
+
+            parse_arg_t arg = {.tx = &CORPUS[i], .chunk_len = CHUNK_LENS[j]};
+            snprintf(name,
+                     sizeof(name),
+                     "transaction_parser_update/%s/chunk_%zu",
+                     CORPUS[i].name,
+                     CHUNK_LENS[j]);
+            run_benchmark(name, op_transaction_parser_update, &arg, CORPUS[i].length);
+        }
+    }
+
+    run_benchmark("buffer_read_chain_id", op_buffer_read_chain_id, NULL, 4 + 27);
+    run_benchmark("buffer_read_contract_address",
+                  op_buffer_read_contract_address,
+                  NULL,
+                  ADDRESS_LEN);
+    run_benchmark("buffer_read_bytes", op_buffer_read_bytes, NULL, MAX_CHUNK_LEN);
+    run_benchmark("buffer_read_leb128_u32", op_buffer_read_leb128_u32, NULL, 5);
+
+    printf("\n]}\n");
+
+    return ANY_FAILED ? EXIT_FAILURE : EXIT_SUCCESS;
+}
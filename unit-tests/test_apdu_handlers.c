@@ -0,0 +1,745 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <cmocka.h>
+
+#include "cx.h"
+#include "io.h"
+#include "read.h"
+#include "write.h"
+#include "crypto_helpers.h"
+
+#include "apdu/dispatcher.h"
+#include "constants.h"
+#include "globals.h"
+#include "status_words.h"
+#include "types.h"
+#include "mock_app.h"
+#include "mock_sdk.h"
+#include "secp256k1.h"
+#include "stats.h"
+#include "well_known.h"
+
+/*
+ * In-process tests of the APDU handlers.
+ *
+ * The handlers are built against the host mock of the SDK: responses are
+ * recorded instead of sent, the UI is headless, and keys and signatures are
+ * computed in software. Signatures are checked against the public key of the
+ * signing path, like a client would.
+ *
+ * The emulator tests in tests/ are kept for the UI snapshots.
+ */
+
+/** BIP32 path used for signing. */
+static const uint32_t PATH[5] = {0x8000002c, 0x80000dd3, 0x80000000, 0, 0};
+#define PATH_LEN 5
+
+/** Chain id the transactions are signed for. */
+#define TEST_CHAIN_ID "Partisia Blockchain"
+
+/** Length of the serialized path: length and path. */
+#define PATH_DATA_LEN (1 + 4 * PATH_LEN)
+
+/** Length of a signature response: recovery id, r and s. */
+#define SIGNATURE_LEN (1 + 32 + 32)
+
+/** RPC of the test transaction. */
+static const uint8_t RPC[] = {0x01, 0x02, 0x03, 0x04, 0x05};
+
+/** Contract address of the test transaction. */
+static const uint8_t CONTRACT_ADDRESS[ADDRESS_LEN] = {
+    0x02, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99,
+    0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x00, 0x11, 0x22, 0x33};
+
+/** Length of the start of the RPC of the compressed test transaction. */
+#define COMPRESSED_RPC_HEAD_LEN 20
+
+/** Length of the rest of the RPC of the compressed test transaction. */
+#define COMPRESSED_RPC_TAIL_LEN 1197
+
+/**
+ * Rest of the RPC of the compressed test transaction, compressed: a pattern of
+ * 16 bytes repeated, zeroes, and a copy from the start of the window.
+ */
+static const uint8_t COMPRESSED_RPC_TAIL[] = {
+    0x0f, '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+    0xff, 0x00, 0x10,  // 130 bytes from 16 bytes back
+    0xff, 0x00, 0x10,  //
+    0xff, 0x00, 0x10,  //
+    0x87, 0x00, 0x10,  // 10 bytes from 16 bytes back
+    0x00, 0x00,        // Literal zero
+    0xff, 0x00, 0x01,  // 130 bytes from 1 byte back
+    0xff, 0x00, 0x01,  //
+    0xff, 0x00, 0x01,  //
+    0xff, 0x00, 0x01,  //
+    0xff, 0x00, 0x01,  //
+    0xff, 0x04, 0x00,  // 130 bytes from 1024 bytes back
+};
+
+/// Helpers
+
+/**
+ * Dispatches a single APDU, and checks that it was handled.
+ */
+static void send_apdu(uint8_t ins, uint8_t p1, uint8_t p2, const uint8_t *data, size_t len) {
+    command_t cmd = {.cla = CLA, .ins = ins, .p1 = p1, .p2 = p2, .lc = (uint8_t) len};
+    cmd.data = (uint8_t *) data;
+    mock_io_reset();
+    assert_true(apdu_dispatcher(&cmd) >= 0);
+}
+
+/**
+ * Writes the BIP32 path of the tests.
+ *
+ * @return number of bytes written.
+ */
+static size_t write_path(uint8_t *out) {
+    out[0] = PATH_LEN;
+    for (size_t i = 0; i < PATH_LEN; i++) {
+        write_u32_be(out, 1 + 4 * i, PATH[i]);
+    }
+    return PATH_DATA_LEN;
+}
+
+/**
+ * Writes the chain id of the tests, prefixed by its length.
+ *
+ * @return number of bytes written.
+ */
+static size_t write_chain_id(uint8_t *out) {
+    write_u32_be(out, 0, sizeof(TEST_CHAIN_ID) - 1);
+    memcpy(out + 4, TEST_CHAIN_ID, sizeof(TEST_CHAIN_ID) - 1);
+    return 4 + sizeof(TEST_CHAIN_ID) - 1;
+}
+
+/**
+ * Writes the test transaction.
+ *
+ * @return number of bytes written.
+ */
+static size_t write_transaction(uint8_t *out) {
+    write_u64_be(out, 0, 42);                // Nonce
+    write_u64_be(out, 8, 1700000000000);     // Valid-to time
+    write_u64_be(out, 16, 10000);            // Gas cost
+    memcpy(out + 24, CONTRACT_ADDRESS, ADDRESS_LEN);
+    write_u32_be(out, 24 + ADDRESS_LEN, sizeof(RPC));
+    memcpy(out + TRANSACTION_HEADER_LEN, RPC, sizeof(RPC));
+    return TRANSACTION_HEADER_LEN + sizeof(RPC);
+}
+
+/**
+ * Writes the decompressed RPC of the compressed test transaction.
+ *
+ * @return number of bytes written.
+ */
+static size_t write_decompressed_rpc(uint8_t *out) {
+    for (size_t i = 0; i < COMPRESSED_RPC_HEAD_LEN; i++) {
+        out[i] = (uint8_t) i;
+    }
+    uint8_t *tail = out + COMPRESSED_RPC_HEAD_LEN;
+    for (size_t i = 0; i < 16 + 3 * 130 + 10; i++) {
+        tail[i] = (uint8_t) "0123456789abcdef"[i % 16];
+    }
+    memset(tail + 416, 0, 1 + 5 * 130);
+    memcpy(tail + 1067, tail + 1067 - 1024, 130);
+    return COMPRESSED_RPC_HEAD_LEN + COMPRESSED_RPC_TAIL_LEN;
+}
+
+/**
+ * Sends the first chunk of SIGN_TX, and a chunk with the header of a
+ * transaction with an RPC of the given length and the given start of the RPC.
+ */
+static void send_transaction_start(uint32_t rpc_len, const uint8_t *rpc_head, size_t head_len) {
+    uint8_t first[PATH_DATA_LEN + 4 + sizeof(TEST_CHAIN_ID)];
+    size_t first_len = write_path(first);
+    first_len += write_chain_id(first + first_len);
+    send_apdu(SIGN_TX, P1_FIRST_CHUNK, P2_NOT_LAST_CHUNK, first, first_len);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+
+    uint8_t chunk[MAX_CHUNK_LEN];
+    write_transaction(chunk);
+    write_u32_be(chunk, 24 + ADDRESS_LEN, rpc_len);
+    memcpy(chunk + TRANSACTION_HEADER_LEN, rpc_head, head_len);
+    send_apdu(SIGN_TX,
+              P1_NOT_FIRST_CHUNK,
+              P2_NOT_LAST_CHUNK,
+              chunk,
+              TRANSACTION_HEADER_LEN + head_len);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+}
+
+/**
+ * Computes the digest signed for the test transaction: the transaction
+ * followed by the length prefixed chain id.
+ */
+static void transaction_digest(uint8_t out[static CX_SHA256_SIZE]) {
+    uint8_t data[TRANSACTION_HEADER_LEN + sizeof(RPC) + 4 + sizeof(TEST_CHAIN_ID)];
+    size_t len = write_transaction(data);
+    len += write_chain_id(data + len);
+
+    cx_sha256_t ctx;
+    assert_int_equal(cx_hash_init((cx_hash_t *) &ctx, CX_SHA256), CX_OK);
+    assert_int_equal(cx_hash_no_throw((cx_hash_t *) &ctx, CX_LAST, data, len, out, CX_SHA256_SIZE),
+                     CX_OK);
+}
+
+/**
+ * Public key of the BIP32 path of the tests.
+ */
+static void path_pubkey(uint8_t pubkey[static SECP256K1_PUBKEY_LEN]) {
+    assert_int_equal(
+        bip32_derive_get_pubkey_256(CX_CURVE_256K1, PATH, PATH_LEN, pubkey, NULL, CX_SHA512),
+        CX_OK);
+}
+
+/**
+ * Checks that the last response is a valid signature of the given digest by
+ * the key of the BIP32 path of the tests.
+ */
+static void assert_signature_response(const uint8_t digest[static CX_SHA256_SIZE]) {
+    assert_int_equal(G_mock_io.count, 1);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+    assert_int_equal(G_mock_io.data_len, SIGNATURE_LEN);
+    assert_true(G_mock_io.data[0] <= 1);
+
+    uint8_t pubkey[SECP256K1_PUBKEY_LEN];
+    path_pubkey(pubkey);
+    assert_true(secp256k1_verify(pubkey, digest, G_mock_io.data + 1, G_mock_io.data + 33));
+}
+
+/**
+ * Sends the test transaction to SIGN_TX, up to the start of the review.
+ */
+static void send_transaction(void) {
+    uint8_t first[PATH_DATA_LEN + 4 + sizeof(TEST_CHAIN_ID)];
+    size_t first_len = write_path(first);
+    first_len += write_chain_id(first + first_len);
+    send_apdu(SIGN_TX, P1_FIRST_CHUNK, P2_NOT_LAST_CHUNK, first, first_len);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+
+    uint8_t tx[TRANSACTION_HEADER_LEN + sizeof(RPC)];
+    const size_t tx_len = write_transaction(tx);
+    send_apdu(SIGN_TX, P1_NOT_FIRST_CHUNK, P2_LAST_CHUNK, tx, tx_len);
+    assert_int_equal(G_mock_io.count, 0);
+    assert_int_equal(G_mock_review, MOCK_REVIEW_TRANSACTION);
+}
+
+/// Tests
+
+static int setup(void **state) {
+    (void) state;
+    mock_app_reset();
+    return 0;
+}
+
+/**
+ * The software secp256k1 must compute the known multiples of the generator.
+ */
+static void test_secp256k1_known_pubkey(void **state) {
+    (void) state;
+
+    uint8_t private_key[SECP256K1_SCALAR_LEN] = {0};
+    private_key[31] = 2;
+    const uint8_t expected[SECP256K1_PUBKEY_LEN] = {
+        0x04, 0xc6, 0x04, 0x7f, 0x94, 0x41, 0xed, 0x7d, 0x6d, 0x30, 0x45, 0x40, 0x6e,
+        0x95, 0xc0, 0x7c, 0xd8, 0x5c, 0x77, 0x8e, 0x4b, 0x8c, 0xef, 0x3c, 0xa7, 0xab,
+        0xac, 0x09, 0xb9, 0x5c, 0x70, 0x9e, 0xe5, 0x1a, 0xe1, 0x68, 0xfe, 0xa6, 0x3d,
+        0xc3, 0x39, 0xa3, 0xc5, 0x84, 0x19, 0x46, 0x6c, 0xea, 0xee, 0xf7, 0xf6, 0x32,
+        0x65, 0x32, 0x66, 0xd0, 0xe1, 0x23, 0x64, 0x31, 0xa9, 0x50, 0xcf, 0xe5, 0x2a};
+
+    uint8_t pubkey[SECP256K1_PUBKEY_LEN];
+    assert_true(secp256k1_pubkey(private_key, pubkey));
+    assert_memory_equal(pubkey, expected, sizeof(expected));
+
+    // Order of the curve is not a valid private key
+    const uint8_t order[SECP256K1_SCALAR_LEN] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xfe, 0xba, 0xae, 0xdc, 0xe6, 0xaf, 0x48,
+        0xa0, 0x3b, 0xbf, 0xd2, 0x5e, 0x8c, 0xd0, 0x36, 0x41, 0x41};
+    assert_false(secp256k1_is_valid_scalar(order));
+    assert_false(secp256k1_pubkey(order, pubkey));
+}
+
+static void test_get_version(void **state) {
+    (void) state;
+
+    send_apdu(GET_VERSION, 0, 0, NULL, 0);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+    assert_int_equal(G_mock_io.data_len, 3);
+    assert_memory_equal(G_mock_io.data,
+                        ((uint8_t[]){MAJOR_VERSION, MINOR_VERSION, PATCH_VERSION}),
+                        3);
+
+    send_apdu(GET_VERSION, 1, 0, NULL, 0);
+    assert_int_equal(G_mock_io.sw, SW_WRONG_P1P2);
+}
+
+static void test_get_app_name(void **state) {
+    (void) state;
+
+    send_apdu(GET_APP_NAME, 0, 0, NULL, 0);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+    assert_int_equal(G_mock_io.data_len, sizeof(APPNAME) - 1);
+    assert_memory_equal(G_mock_io.data, APPNAME, sizeof(APPNAME) - 1);
+}
+
+static void test_get_chunk_size(void **state) {
+    (void) state;
+
+    send_apdu(GET_CHUNK_SIZE, 0, 0, NULL, 0);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+    assert_int_equal(G_mock_io.data_len, 8);
+    assert_int_equal(read_u16_be(G_mock_io.data, 0), IO_APDU_BUFFER_SIZE);
+    assert_int_equal(read_u16_be(G_mock_io.data, 2), 255);
+    assert_int_equal(read_u16_be(G_mock_io.data, 4), 59);
+    assert_int_equal(read_u16_be(G_mock_io.data, 6), COMPRESSION_WINDOW_LEN);
+
+    send_apdu(GET_CHUNK_SIZE, 0, 1, NULL, 0);
+    assert_int_equal(G_mock_io.sw, SW_WRONG_P1P2);
+
+    // A transaction in chunks of the maximum length is accepted
+    const size_t rpc_len = 3 * MAX_CHUNK_LEN;
+    uint8_t tx[TRANSACTION_HEADER_LEN + 3 * MAX_CHUNK_LEN];
+    write_transaction(tx);
+    write_u32_be(tx, 24 + ADDRESS_LEN, rpc_len);
+    memset(tx + TRANSACTION_HEADER_LEN, 0xab, rpc_len);
+
+    uint8_t first[PATH_DATA_LEN + 4 + sizeof(TEST_CHAIN_ID)];
+    size_t first_len = write_path(first);
+    first_len += write_chain_id(first + first_len);
+    send_apdu(SIGN_TX, P1_FIRST_CHUNK, P2_NOT_LAST_CHUNK, first, first_len);
+    for (size_t offset = 0; offset < sizeof(tx); offset += MAX_CHUNK_LEN) {
+        const size_t chunk_len =
+            sizeof(tx) - offset < MAX_CHUNK_LEN ? sizeof(tx) - offset : MAX_CHUNK_LEN;
+        const bool last = offset + chunk_len == sizeof(tx);
+        send_apdu(SIGN_TX,
+                  P1_NOT_FIRST_CHUNK,
+                  last ? P2_LAST_CHUNK : P2_NOT_LAST_CHUNK,
+                  tx + offset,
+                  chunk_len);
+        if (!last) {
+            assert_int_equal(G_mock_io.sw, SW_OK);
+        }
+    }
+    assert_int_equal(G_mock_review, MOCK_REVIEW_TRANSACTION);
+    assert_int_equal(G_context.tx_info.transaction.basic.nonce, 42);
+}
+
+static void test_get_address(void **state) {
+    (void) state;
+
+    // Address is derived from the public key of the path
+    uint8_t pubkey[SECP256K1_PUBKEY_LEN];
+    path_pubkey(pubkey);
+    uint8_t digest[CX_SHA256_SIZE];
+    cx_sha256_t ctx;
+    assert_int_equal(cx_hash_init((cx_hash_t *) &ctx, CX_SHA256), CX_OK);
+    assert_int_equal(
+        cx_hash_no_throw((cx_hash_t *) &ctx, CX_LAST, pubkey, sizeof(pubkey), digest, CX_SHA256_SIZE),
+        CX_OK);
+    uint8_t expected[ADDRESS_LEN] = {BLOCKCHAIN_ADDRESS_ACCOUNT};
+    memcpy(expected + 1, digest + 12, ADDRESS_LEN - 1);
+
+    uint8_t path[PATH_DATA_LEN];
+    write_path(path);
+
+    // Silent
+    send_apdu(GET_ADDRESS, P1_SILENT, 0, path, sizeof(path));
+    assert_int_equal(G_mock_io.sw, SW_OK);
+    assert_int_equal(G_mock_io.data_len, ADDRESS_LEN);
+    assert_memory_equal(G_mock_io.data, expected, ADDRESS_LEN);
+
+    // Confirmed
+    send_apdu(GET_ADDRESS, P1_CONFIRM, 0, path, sizeof(path));
+    assert_int_equal(G_mock_io.count, 0);
+    assert_int_equal(G_mock_review, MOCK_REVIEW_ADDRESS);
+    mock_ui_choose(true);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+    assert_memory_equal(G_mock_io.data, expected, ADDRESS_LEN);
+
+    // Rejected
+    send_apdu(GET_ADDRESS, P1_CONFIRM, 0, path, sizeof(path));
+    mock_ui_choose(false);
+    assert_int_equal(G_mock_io.sw, SW_DENY);
+    assert_int_equal(G_mock_io.data_len, 0);
+
+    // Truncated path
+    send_apdu(GET_ADDRESS, P1_SILENT, 0, path, sizeof(path) - 1);
+    assert_int_equal(G_mock_io.sw, SW_WRONG_DATA_LENGTH);
+}
+
+static void test_sign_tx(void **state) {
+    (void) state;
+
+    send_transaction();
+    assert_int_equal(G_context.tx_info.transaction.basic.nonce, 42);
+    assert_int_equal(G_context.tx_info.transaction.basic.gas_cost, 10000);
+
+    uint8_t digest[CX_SHA256_SIZE];
+    transaction_digest(digest);
+    assert_memory_equal(G_context.m_hash, digest, sizeof(digest));
+
+    mock_ui_choose(true);
+    assert_signature_response(digest);
+    assert_int_equal(G_context.state, STATE_APPROVED);
+
+    // Signing is deterministic
+    uint8_t signature[SIGNATURE_LEN];
+    memcpy(signature, G_mock_io.data, sizeof(signature));
+    send_transaction();
+    mock_ui_choose(true);
+    assert_memory_equal(G_mock_io.data, signature, sizeof(signature));
+}
+
+static void test_sign_tx_rejected(void **state) {
+    (void) state;
+
+    send_transaction();
+    mock_ui_choose(false);
+    assert_int_equal(G_mock_io.count, 1);
+    assert_int_equal(G_mock_io.sw, SW_DENY);
+    assert_int_equal(G_mock_io.data_len, 0);
+    assert_int_equal(G_context.state, STATE_NONE);
+}
+
+/**
+ * Sends an MPC transfer with the given large memo to SIGN_TX, up to the start
+ * of the review.
+ */
+static void send_mpc_transfer_with_memo(const char *memo) {
+    uint8_t first[PATH_DATA_LEN + 4 + sizeof(TEST_CHAIN_ID)];
+    size_t first_len = write_path(first);
+    first_len += write_chain_id(first + first_len);
+    send_apdu(SIGN_TX, P1_FIRST_CHUNK, P2_NOT_LAST_CHUNK, first, first_len);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+
+    const blockchain_address_s mpc_token = MPC_TOKEN_ADDRESS;
+    const size_t memo_len = strlen(memo);
+    const size_t rpc_len = 1 + ADDRESS_LEN + 8 + 4 + memo_len;
+    uint8_t tx[MAX_CHUNK_LEN];
+    write_transaction(tx);
+    memcpy(tx + 24, mpc_token.raw_bytes, ADDRESS_LEN);
+    write_u32_be(tx, 24 + ADDRESS_LEN, (uint32_t) rpc_len);
+    uint8_t *rpc = tx + TRANSACTION_HEADER_LEN;
+    rpc[0] = MPC_TOKEN_SHORTNAME_TRANSFER_MEMO_LARGE;
+    memcpy(rpc + 1, CONTRACT_ADDRESS, ADDRESS_LEN);
+    write_u64_be(rpc, 1 + ADDRESS_LEN, 0x444);
+    write_u32_be(rpc, 1 + ADDRESS_LEN + 8, (uint32_t) memo_len);
+    memcpy(rpc + 1 + ADDRESS_LEN + 8 + 4, memo, memo_len);
+    send_apdu(SIGN_TX, P1_NOT_FIRST_CHUNK, P2_LAST_CHUNK, tx, TRANSACTION_HEADER_LEN + rpc_len);
+    assert_int_equal(G_mock_io.count, 0);
+    assert_int_equal(G_mock_review, MOCK_REVIEW_TRANSACTION);
+    assert_int_equal(G_context.tx_info.transaction.type, MPC_TRANSFER);
+}
+
+/**
+ * The memos of the MPC transfer examples of tests/ are shown as they were
+ * before memos were allocated from the arena, such that the UI snapshots of
+ * these examples hold.
+ */
+static void test_sign_tx_mpc_transfer_memo(void **state) {
+    (void) state;
+
+    send_mpc_transfer_with_memo("Hello World");
+    assert_string_equal(G_context.display.memo, "Hello World");
+    mock_ui_choose(false);
+
+    send_mpc_transfer_with_memo("Hello");
+    assert_string_equal(G_context.display.memo, "Hello");
+    mock_ui_choose(false);
+
+    send_mpc_transfer_with_memo("");
+    assert_string_equal(G_context.display.memo, "");
+    mock_ui_choose(false);
+
+    // Unreadable characters are replaced
+    send_mpc_transfer_with_memo("Tab\there");
+    assert_string_equal(G_context.display.memo, "Tab?here");
+    mock_ui_choose(false);
+}
+
+static void test_sign_tx_from_template(void **state) {
+    (void) state;
+
+    // Template with path, chain id, gas cost and contract address
+    uint8_t template[PATH_DATA_LEN + 4 + sizeof(TEST_CHAIN_ID) + 8 + ADDRESS_LEN];
+    size_t template_len = write_path(template);
+    template_len += write_chain_id(template + template_len);
+    write_u64_be(template, template_len, 10000);
+    template_len += 8;
+    memcpy(template + template_len, CONTRACT_ADDRESS, ADDRESS_LEN);
+    template_len += ADDRESS_LEN;
+    send_apdu(SET_TX_TEMPLATE, 1, 0, template, template_len);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+
+    // Remaining fields of the test transaction
+    uint8_t chunk[1 + 8 + 8 + 4 + sizeof(RPC)];
+    chunk[0] = 1;
+    write_u64_be(chunk, 1, 42);
+    write_u64_be(chunk, 9, 1700000000000);
+    write_u32_be(chunk, 17, sizeof(RPC));
+    memcpy(chunk + 21, RPC, sizeof(RPC));
+    send_apdu(SIGN_TX, P1_TEMPLATE_FIRST_CHUNK, P2_LAST_CHUNK, chunk, sizeof(chunk));
+    assert_int_equal(G_mock_io.count, 0);
+    assert_int_equal(G_mock_review, MOCK_REVIEW_TRANSACTION);
+
+    // Signs the same digest as the full transaction
+    uint8_t digest[CX_SHA256_SIZE];
+    transaction_digest(digest);
+    mock_ui_choose(true);
+    assert_signature_response(digest);
+
+    // Unknown template
+    chunk[0] = 0;
+    send_apdu(SIGN_TX, P1_TEMPLATE_FIRST_CHUNK, P2_LAST_CHUNK, chunk, sizeof(chunk));
+    assert_int_equal(G_mock_io.sw, SW_UNKNOWN_TX_TEMPLATE);
+}
+
+static void test_sign_tx_compressed(void **state) {
+    (void) state;
+
+    uint8_t rpc[COMPRESSED_RPC_HEAD_LEN + COMPRESSED_RPC_TAIL_LEN];
+    const size_t rpc_len = write_decompressed_rpc(rpc);
+    send_transaction_start(rpc_len, rpc, COMPRESSED_RPC_HEAD_LEN);
+
+    // Compressed chunks of 7 bytes, splitting tokens
+    for (size_t offset = 0; offset < sizeof(COMPRESSED_RPC_TAIL); offset += 7) {
+        const size_t len = sizeof(COMPRESSED_RPC_TAIL) - offset < 7
+                               ? sizeof(COMPRESSED_RPC_TAIL) - offset
+                               : 7;
+        const bool last = offset + len == sizeof(COMPRESSED_RPC_TAIL);
+        send_apdu(SIGN_TX,
+                  P1_COMPRESSED_CHUNK,
+                  last ? P2_LAST_CHUNK : P2_NOT_LAST_CHUNK,
+                  COMPRESSED_RPC_TAIL + offset,
+                  len);
+        if (!last) {
+            assert_int_equal(G_mock_io.sw, SW_OK);
+        }
+    }
+    assert_int_equal(G_mock_io.count, 0);
+    assert_int_equal(G_mock_review, MOCK_REVIEW_TRANSACTION);
+
+    // Signs the digest of the decompressed transaction
+    uint8_t tx[TRANSACTION_HEADER_LEN];
+    write_transaction(tx);
+    write_u32_be(tx, 24 + ADDRESS_LEN, rpc_len);
+    uint8_t chain_id[4 + sizeof(TEST_CHAIN_ID)];
+    const size_t chain_id_len = write_chain_id(chain_id);
+    uint8_t digest[CX_SHA256_SIZE];
+    cx_sha256_t ctx;
+    assert_int_equal(cx_hash_init((cx_hash_t *) &ctx, CX_SHA256), CX_OK);
+    assert_int_equal(cx_hash_update((cx_hash_t *) &ctx, tx, sizeof(tx)), CX_OK);
+    assert_int_equal(cx_hash_update((cx_hash_t *) &ctx, rpc, rpc_len), CX_OK);
+    assert_int_equal(cx_hash_update((cx_hash_t *) &ctx, chain_id, chain_id_len), CX_OK);
+    assert_int_equal(cx_hash_final((cx_hash_t *) &ctx, digest), CX_OK);
+    mock_ui_choose(true);
+    assert_signature_response(digest);
+}
+
+static void test_sign_tx_compressed_errors(void **state) {
+    (void) state;
+
+    static const uint8_t HEAD[4] = {0x01, 0x02, 0x03, 0x04};
+    static const uint8_t LITERALS[] = {0x02, 'a', 'b', 'c'};
+
+    // Copy from before the first decompressed byte
+    send_transaction_start(sizeof(HEAD) + 3, HEAD, sizeof(HEAD));
+    send_apdu(SIGN_TX, P1_COMPRESSED_CHUNK, P2_LAST_CHUNK, (const uint8_t[]){0x80, 0x00, 0x01}, 3);
+    assert_int_equal(G_mock_io.sw, SW_TX_DECOMPRESSION_FAIL);
+
+    // Chunks after a failed chunk are rejected, compressed or not
+    send_transaction_start(sizeof(HEAD) + 6, HEAD, sizeof(HEAD));
+    send_apdu(SIGN_TX, P1_COMPRESSED_CHUNK, P2_NOT_LAST_CHUNK, (const uint8_t[]){0x80, 0x00, 0x05}, 3);
+    assert_int_equal(G_mock_io.sw, SW_TX_DECOMPRESSION_FAIL);
+    send_apdu(SIGN_TX, P1_COMPRESSED_CHUNK, P2_LAST_CHUNK, LITERALS, sizeof(LITERALS));
+    assert_int_equal(G_mock_io.sw, SW_BAD_STATE);
+    send_apdu(SIGN_TX, P1_NOT_FIRST_CHUNK, P2_LAST_CHUNK, LITERALS + 1, 3);
+    assert_int_equal(G_mock_io.sw, SW_BAD_STATE);
+
+    // Also after bytes rejected by the parser
+    send_transaction_start(sizeof(HEAD) + 2, HEAD, sizeof(HEAD));
+    send_apdu(SIGN_TX, P1_COMPRESSED_CHUNK, P2_NOT_LAST_CHUNK, LITERALS, sizeof(LITERALS));
+    assert_int_equal(G_mock_io.sw, SW_TX_PARSING_FAIL_EXPECTED_LESS_DATA);
+    send_apdu(SIGN_TX, P1_COMPRESSED_CHUNK, P2_LAST_CHUNK, LITERALS, 2);
+    assert_int_equal(G_mock_io.sw, SW_BAD_STATE);
+
+    // Stream ending inside a token
+    send_transaction_start(sizeof(HEAD) + 3, HEAD, sizeof(HEAD));
+    send_apdu(SIGN_TX, P1_COMPRESSED_CHUNK, P2_LAST_CHUNK, LITERALS, 2);
+    assert_int_equal(G_mock_io.sw, SW_TX_DECOMPRESSION_FAIL);
+
+    // More decompressed bytes than the RPC length
+    send_transaction_start(sizeof(HEAD) + 2, HEAD, sizeof(HEAD));
+    send_apdu(SIGN_TX, P1_COMPRESSED_CHUNK, P2_LAST_CHUNK, LITERALS, sizeof(LITERALS));
+    assert_int_equal(G_mock_io.sw, SW_TX_PARSING_FAIL_EXPECTED_LESS_DATA);
+
+    // Uncompressed chunk after a compressed chunk
+    send_transaction_start(sizeof(HEAD) + 6, HEAD, sizeof(HEAD));
+    send_apdu(SIGN_TX, P1_COMPRESSED_CHUNK, P2_NOT_LAST_CHUNK, LITERALS, sizeof(LITERALS));
+    assert_int_equal(G_mock_io.sw, SW_OK);
+    send_apdu(SIGN_TX, P1_NOT_FIRST_CHUNK, P2_LAST_CHUNK, LITERALS + 1, 3);
+    assert_int_equal(G_mock_io.sw, SW_BAD_STATE);
+
+    // Compressed chunk before the start of the RPC
+    uint8_t first[PATH_DATA_LEN + 4 + sizeof(TEST_CHAIN_ID)];
+    size_t first_len = write_path(first);
+    first_len += write_chain_id(first + first_len);
+    send_apdu(SIGN_TX, P1_FIRST_CHUNK, P2_NOT_LAST_CHUNK, first, first_len);
+    send_apdu(SIGN_TX, P1_COMPRESSED_CHUNK, P2_LAST_CHUNK, LITERALS, sizeof(LITERALS));
+    assert_int_equal(G_mock_io.sw, SW_BAD_STATE);
+}
+
+static void test_sign_message(void **state) {
+    (void) state;
+
+    static const char MESSAGE[] = "Hello, Partisia Blockchain!";
+    const size_t message_len = sizeof(MESSAGE) - 1;
+
+    uint8_t first[PATH_DATA_LEN + 4];
+    write_path(first);
+    write_u32_be(first, PATH_DATA_LEN, (uint32_t) message_len);
+    send_apdu(SIGN_MESSAGE, P1_FIRST_CHUNK, P2_NOT_LAST_CHUNK, first, sizeof(first));
+    assert_int_equal(G_mock_io.sw, SW_OK);
+
+    // Message in two chunks
+    send_apdu(SIGN_MESSAGE,
+              P1_NOT_FIRST_CHUNK,
+              P2_NOT_LAST_CHUNK,
+              (const uint8_t *) MESSAGE,
+              10);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+    send_apdu(SIGN_MESSAGE,
+              P1_NOT_FIRST_CHUNK,
+              P2_LAST_CHUNK,
+              (const uint8_t *) MESSAGE + 10,
+              message_len - 10);
+    assert_int_equal(G_mock_io.count, 0);
+    assert_int_equal(G_mock_review, MOCK_REVIEW_MESSAGE);
+
+    // SHA256(prefix || u32 length || message)
+    uint8_t length_bytes[4];
+    write_u32_be(length_bytes, 0, (uint32_t) message_len);
+    uint8_t digest[CX_SHA256_SIZE];
+    cx_sha256_t ctx;
+    assert_int_equal(cx_hash_init((cx_hash_t *) &ctx, CX_SHA256), CX_OK);
+    assert_int_equal(cx_hash_update((cx_hash_t *) &ctx,
+                                    (const uint8_t *) MESSAGE_SIGNING_PREFIX,
+                                    sizeof(MESSAGE_SIGNING_PREFIX) - 1),
+                     CX_OK);
+    assert_int_equal(cx_hash_update((cx_hash_t *) &ctx, length_bytes, sizeof(length_bytes)),
+                     CX_OK);
+    assert_int_equal(
+        cx_hash_update((cx_hash_t *) &ctx, (const uint8_t *) MESSAGE, message_len),
+        CX_OK);
+    assert_int_equal(cx_hash_final((cx_hash_t *) &ctx, digest), CX_OK);
+
+    mock_ui_choose(true);
+    assert_signature_response(digest);
+}
+
+/**
+ * Reads the counter of the given parser status from a GET_STATS response.
+ */
+static uint32_t stats_status_counter(size_t table, parser_status_e status) {
+    const size_t offset = 1 + 4 * STATS_PHASE_COUNT + 1 +
+                          4 * (table * STATS_PARSER_STATUS_COUNT + status - STATS_PARSER_STATUS_MIN);
+    return read_u32_be(G_mock_io.data, offset);
+}
+
+static void test_get_stats(void **state) {
+    (void) state;
+
+    // Reset the counters of earlier tests
+    send_apdu(GET_STATS, 0, 0, NULL, 0);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+
+    uint8_t path[PATH_DATA_LEN];
+    write_path(path);
+    send_apdu(GET_ADDRESS, P1_SILENT, 0, path, sizeof(path));
+    send_transaction();
+    mock_ui_choose(true);
+
+    send_apdu(GET_STATS, 0, 0, NULL, 0);
+    assert_int_equal(G_mock_io.sw, SW_OK);
+    assert_int_equal(G_mock_io.data_len,
+                     1 + 4 * STATS_PHASE_COUNT + 1 + 2 * 4 * STATS_PARSER_STATUS_COUNT);
+    assert_int_equal(G_mock_io.data[0], STATS_PHASE_COUNT);
+    // Dispatch is counted by the APDU loop of app_main, not by the dispatcher
+    assert_int_equal(read_u32_be(G_mock_io.data, 1 + 4 * STATS_PHASE_DISPATCH), 0);
+    assert_int_equal(read_u32_be(G_mock_io.data, 1 + 4 * STATS_PHASE_PARSE), 1);
+    assert_int_equal(read_u32_be(G_mock_io.data, 1 + 4 * STATS_PHASE_HASH), 1);
+    assert_int_equal(read_u32_be(G_mock_io.data, 1 + 4 * STATS_PHASE_DERIVE), 2);
+    assert_int_equal(read_u32_be(G_mock_io.data, 1 + 4 * STATS_PHASE_UI), 1);
+    assert_int_equal(G_mock_io.data[1 + 4 * STATS_PHASE_COUNT], STATS_PARSER_STATUS_COUNT);
+    assert_int_equal(stats_status_counter(0, PARSING_DONE), 1);
+    assert_int_equal(stats_status_counter(0, PARSING_CONTINUE), 0);
+    assert_int_equal(stats_status_counter(1, G_context.tx_info.transaction.rpc_parsing_error), 1);
+
+    // Counters are reset by GET_STATS
+    send_apdu(GET_STATS, 0, 0, NULL, 0);
+    assert_int_equal(read_u32_be(G_mock_io.data, 1 + 4 * STATS_PHASE_DERIVE), 0);
+    assert_int_equal(stats_status_counter(0, PARSING_DONE), 0);
+
+    // Hashing is counted per chunk of message, as for transactions
+    uint8_t first[PATH_DATA_LEN + 4];
+    write_path(first);
+    write_u32_be(first, PATH_DATA_LEN, 2);
+    send_apdu(SIGN_MESSAGE, P1_FIRST_CHUNK, P2_NOT_LAST_CHUNK, first, sizeof(first));
+    send_apdu(SIGN_MESSAGE, P1_NOT_FIRST_CHUNK, P2_NOT_LAST_CHUNK, (const uint8_t *) "a", 1);
+    send_apdu(SIGN_MESSAGE, P1_NOT_FIRST_CHUNK, P2_LAST_CHUNK, (const uint8_t *) "b", 1);
+    mock_ui_choose(false);
+    send_apdu(GET_STATS, 0, 0, NULL, 0);
+    assert_int_equal(read_u32_be(G_mock_io.data, 1 + 4 * STATS_PHASE_HASH), 2);
+
+    send_apdu(GET_STATS, 0, 1, NULL, 0);
+    assert_int_equal(G_mock_io.sw, SW_WRONG_P1P2);
+}
+
+static void test_dispatcher_errors(void **state) {
+    (void) state;
+
+    command_t cmd = {.cla = CLA + 1, .ins = GET_VERSION};
+    mock_io_reset();
+    assert_true(apdu_dispatcher(&cmd) >= 0);
+    assert_int_equal(G_mock_io.sw, SW_CLA_NOT_SUPPORTED);
+
+    send_apdu(0xff, 0, 0, NULL, 0);
+    assert_int_equal(G_mock_io.sw, SW_INS_NOT_SUPPORTED);
+
+    // Transaction chunk without a started transaction
+    uint8_t tx[TRANSACTION_HEADER_LEN + sizeof(RPC)];
+    const size_t tx_len = write_transaction(tx);
+    send_apdu(SIGN_TX, P1_NOT_FIRST_CHUNK, P2_LAST_CHUNK, tx, tx_len);
+    assert_int_equal(G_mock_io.sw, SW_BAD_STATE);
+
+    // First chunk must not be the last
+    send_apdu(SIGN_TX, P1_FIRST_CHUNK, P2_LAST_CHUNK, tx, tx_len);
+    assert_int_equal(G_mock_io.sw, SW_WRONG_P1P2);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup(test_secp256k1_known_pubkey, setup),
+        cmocka_unit_test_setup(test_get_version, setup),
+        cmocka_unit_test_setup(test_get_app_name, setup),
+        cmocka_unit_test_setup(test_get_chunk_size, setup),
+        cmocka_unit_test_setup(test_get_address, setup),
+        cmocka_unit_test_setup(test_sign_tx, setup),
+        cmocka_unit_test_setup(test_sign_tx_rejected, setup),
+        cmocka_unit_test_setup(test_sign_tx_mpc_transfer_memo, setup),
+        cmocka_unit_test_setup(test_sign_tx_from_template, setup),
+        cmocka_unit_test_setup(test_sign_tx_compressed, setup),
+        cmocka_unit_test_setup(test_sign_tx_compressed_errors, setup),
+        cmocka_unit_test_setup(test_sign_message, setup),
+        cmocka_unit_test_setup(test_get_stats, setup),
+        cmocka_unit_test_setup(test_dispatcher_errors, setup),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
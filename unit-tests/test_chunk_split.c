@@ -0,0 +1,269 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+
+#include <cmocka.h>
+
+#include "cx.h"
+#include "io.h"
+#include "write.h"
+
+#include "apdu/dispatcher.h"
+#include "constants.h"
+#include "globals.h"
+#include "status_words.h"
+#include "types.h"
+#include "mock_app.h"
+#include "mock_sdk.h"
+
+/*
+ * Chunk split invariance of SIGN_TX.
+ *
+ * Every transaction of the corpus directory given as argument is signed with
+ * every possible size of the first transaction chunk, and with random
+ * multi-way splits. The remaining chunks are as large as an APDU allows, as
+ * sent by the client.
+ *
+ * The digest to sign must never depend on the split. The parsed transaction
+ * must be identical to the one parsed with the split of the client, whenever
+ * the first chunk contains the header and the leading part of the RPC, as the
+ * parser requires. Shorter first chunks must never be clear-signed
+ * differently: they either fail, or fall back to blind signing.
+ */
+
+/** Maximum size of a transaction in the corpus. */
+#define MAX_TRANSACTION_SIZE (256 * 1024)
+/** Maximum number of transactions in the corpus. */
+#define MAX_CORPUS_SIZE 64
+/** Number of random multi-way splits per transaction. */
+#define RANDOM_SPLITS 200
+/** Maximum number of chunks of a random split. */
+#define MAX_CHUNK_COUNT (MAX_TRANSACTION_SIZE + 1)
+
+/** Chain id the transactions are signed for. */
+#define TEST_CHAIN_ID "Partisia Blockchain"
+
+/// Corpus
+
+typedef struct {
+    char name[256];
+    uint8_t *bytes;
+    size_t len;
+} corpus_entry_t;
+
+static corpus_entry_t CORPUS[MAX_CORPUS_SIZE];
+static struct CMUnitTest CORPUS_TESTS[MAX_CORPUS_SIZE];
+
+/**
+ * Reads every file in the given directory as a transaction.
+ *
+ * @return number of transactions read.
+ */
+static size_t read_corpus(const char *path) {
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        return 0;
+    }
+
+    size_t count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && count < MAX_CORPUS_SIZE) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        char file_path[1024];
+        snprintf(file_path, sizeof(file_path), "%s/%s", path, entry->d_name);
+        FILE *file = fopen(file_path, "rb");
+        if (file == NULL) {
+            continue;
+        }
+
+        corpus_entry_t *tx = &CORPUS[count];
+        tx->bytes = malloc(MAX_TRANSACTION_SIZE);
+        tx->len = fread(tx->bytes, 1, MAX_TRANSACTION_SIZE, file);
+        fclose(file);
+        snprintf(tx->name, sizeof(tx->name), "%s", entry->d_name);
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
+/// Signing
+
+/**
+ * Outcome of sending a transaction to SIGN_TX.
+ */
+typedef struct {
+    /** Whether the review has been started. */
+    bool reviewed;
+    /** Status word of the first rejected chunk, if not reviewed. */
+    uint16_t sw;
+    /** Parsed transaction. */
+    transaction_t transaction;
+    /** Digest to sign. */
+    uint8_t m_hash[CX_SHA256_SIZE];
+} outcome_t;
+
+/**
+ * Dispatches a single SIGN_TX APDU.
+ */
+static void send_chunk(uint8_t p1, bool last, const uint8_t *data, size_t len) {
+    uint8_t *copy = malloc(len);
+    memcpy(copy, data, len);
+    command_t cmd = {.cla = CLA,
+                     .ins = SIGN_TX,
+                     .p1 = p1,
+                     .p2 = last ? P2_LAST_CHUNK : P2_NOT_LAST_CHUNK,
+                     .lc = (uint8_t) len,
+                     .data = copy};
+    mock_io_reset();
+    assert_true(apdu_dispatcher(&cmd) >= 0);
+    free(copy);
+}
+
+/**
+ * Signs the given transaction, split into chunks of the given sizes. The rest
+ * of the transaction is split into chunks of #MAX_CHUNK_LEN.
+ */
+static outcome_t sign_split(const corpus_entry_t *tx,
+                            const size_t *chunk_lens,
+                            size_t chunk_count) {
+    mock_app_reset();
+
+    // First chunk: BIP32 path and chain id
+    uint8_t first[1 + 4 * 5 + 4 + sizeof(TEST_CHAIN_ID) - 1];
+    first[0] = 5;
+    const uint32_t path[5] = {0x8000002c, 0x80000dd3, 0x80000000, 0, 0};
+    for (size_t i = 0; i < 5; i++) {
+        write_u32_be(first, 1 + 4 * i, path[i]);
+    }
+    write_u32_be(first, 1 + 4 * 5, sizeof(TEST_CHAIN_ID) - 1);
+    memcpy(first + 1 + 4 * 5 + 4, TEST_CHAIN_ID, sizeof(TEST_CHAIN_ID) - 1);
+    send_chunk(P1_FIRST_CHUNK, false, first, sizeof(first));
+    assert_int_equal(G_mock_io.sw, SW_OK);
+
+    outcome_t outcome;
+    memset(&outcome, 0, sizeof(outcome));
+
+    size_t offset = 0;
+    size_t chunk_index = 0;
+    while (offset < tx->len) {
+        size_t len = chunk_index < chunk_count ? chunk_lens[chunk_index] : MAX_CHUNK_LEN;
+        if (len > tx->len - offset) {
+            len = tx->len - offset;
+        }
+        const bool last = offset + len == tx->len;
+        send_chunk(P1_NOT_FIRST_CHUNK, last, tx->bytes + offset, len);
+        offset += len;
+        chunk_index++;
+
+        if (G_mock_io.count == 0) {
+            // Review started
+            assert_true(last);
+            outcome.reviewed = true;
+            break;
+        }
+        if (G_mock_io.sw != SW_OK) {
+            outcome.sw = G_mock_io.sw;
+            break;
+        }
+        assert_false(last);
+    }
+
+    memcpy(&outcome.transaction, &G_context.tx_info.transaction, sizeof(transaction_t));
+    memcpy(outcome.m_hash, G_context.m_hash, sizeof(outcome.m_hash));
+    return outcome;
+}
+
+/**
+ * Checks an outcome against the outcome of the split of the client.
+ *
+ * @return true if the parsed transaction is identical.
+ */
+static bool check_outcome(const outcome_t *reference, const outcome_t *outcome) {
+    if (!outcome->reviewed) {
+        // Only the parsing of the header may fail, in which case the whole
+        // transaction is rejected
+        assert_false(outcome->sw == SW_OK);
+        return false;
+    }
+
+    assert_memory_equal(reference->m_hash, outcome->m_hash, CX_SHA256_SIZE);
+    if (memcmp(&reference->transaction, &outcome->transaction, sizeof(transaction_t)) == 0) {
+        return true;
+    }
+
+    // Never clear-signed differently
+    assert_int_equal(outcome->transaction.type, GENERIC_TRANSACTION);
+    return false;
+}
+
+/**
+ * Checks every size of the first transaction chunk, and random multi-way
+ * splits.
+ */
+static void test_chunk_split_invariance(void **state) {
+    const corpus_entry_t *tx = *state;
+
+    const outcome_t reference = sign_split(tx, NULL, 0);
+    assert_true(reference.reviewed);
+
+    // Every size of the first chunk. Once the first chunk is large enough to
+    // contain the parsed part, the outcome must be identical.
+    const size_t max_first = tx->len < MAX_CHUNK_LEN ? tx->len : MAX_CHUNK_LEN;
+    bool identical_seen = false;
+    for (size_t first_len = 1; first_len <= max_first; first_len++) {
+        const outcome_t outcome = sign_split(tx, &first_len, 1);
+        const bool identical = check_outcome(&reference, &outcome);
+        if (identical_seen && !identical) {
+            fail_msg("first chunk of %zu bytes parsed differently than a shorter one", first_len);
+        }
+        identical_seen |= identical;
+    }
+    assert_true(identical_seen);
+
+    // Random multi-way splits, with the first chunk as sent by the client
+    srand(1);
+    static size_t chunk_lens[MAX_CHUNK_COUNT];
+    for (size_t i = 0; i < RANDOM_SPLITS; i++) {
+        chunk_lens[0] = max_first;
+        size_t total = max_first;
+        size_t count = 1;
+        while (total < tx->len && count < MAX_CHUNK_COUNT) {
+            chunk_lens[count] = 1 + (size_t) rand() % MAX_CHUNK_LEN;
+            total += chunk_lens[count];
+            count++;
+        }
+
+        const outcome_t outcome = sign_split(tx, chunk_lens, count);
+        assert_true(check_outcome(&reference, &outcome));
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <corpus directory>\n", argv[0]);
+        return 1;
+    }
+
+    const size_t count = read_corpus(argv[1]);
+    if (count == 0) {
+        fprintf(stderr, "No transactions in %s\n", argv[1]);
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        CORPUS_TESTS[i] = (struct CMUnitTest){.name = CORPUS[i].name,
+                                              .test_func = test_chunk_split_invariance,
+                                              .initial_state = &CORPUS[i]};
+    }
+
+    return _cmocka_run_group_tests("chunk_split", CORPUS_TESTS, count, NULL, NULL);
+}
@@ -13,9 +13,25 @@
 #include <cmocka.h>
 
 #include "well_known.h"
+#include "constants.h"
+#include "arena.h"
 #include "buffer_util.h"
 #include "transaction/deserialize.h"
 
+/// Arena
+
+static uint8_t TEST_ARENA_BUFFER[ARENA_SIZE];
+static arena_t TEST_ARENA;
+
+/**
+ * Initializes the test arena, and returns it. Any previous allocations are
+ * discarded.
+ */
+static arena_t *fresh_test_arena(void) {
+    arena_init(&TEST_ARENA, TEST_ARENA_BUFFER, sizeof(TEST_ARENA_BUFFER));
+    return &TEST_ARENA;
+}
+
 /// Transactions
 
 // clang-format off
@@ -150,8 +166,8 @@ static uint8_t TRANSACTION_BYTES_MPC_TRANSFER_LARGE_MEMO[] = {
     0x01, 0xa4, 0x08, 0x2d, 0x9d, 0x56, 0x07, 0x49,
     0xec, 0xd0, 0xff, 0xa1, 0xdc, 0xaa, 0xae, 0xe2,
     0xc2, 0xcb, 0x25, 0xd8, 0x81,
-    // rpc length (4): 30
-    0x00, 0x00, 0x00, 30 + 4 + 15,
+    // rpc length (4): 45
+    0x00, 0x00, 0x00, 30 + 4 + 11,
     // shortname (1)
     0x17,
     // recipient (21)
@@ -236,6 +252,50 @@ static uint8_t TRANSACTION_BYTES_MPC_TRANSFER_UNKNOWN_SHORTNAME[] = {
     0x7f,
 };
 
+static uint8_t TRANSACTION_BYTES_ZK_OPEN_INVOCATION[] = {
+    // nonce (8)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02,
+    // valid-to time (8)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04,
+    // gas cost (8)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x06,
+    // contract address (21): ZK contract
+    0x03, 0xc3, 0x39, 0x97, 0x54, 0x4e, 0x31, 0x75,
+    0xd2, 0x66, 0xbd, 0x02, 0x24, 0x39, 0xb2, 0x2c,
+    0xdb, 0x16, 0x50, 0x8c, 0x7a,
+    // rpc length (4)
+    0x00, 0x00, 0x00, 0x07,
+    // 49: invocation kind (1): open invocation
+    0x09,
+    // 50: shortname (LEB128): 0x1234
+    0xb4, 0x24,
+    // 52: arguments (4)
+    0x00, 0x00, 0x00, 0x2a,
+};
+
+static uint8_t TRANSACTION_BYTES_ZK_SECRET_INPUT_ON_CHAIN_PART_1[255] = {
+    // nonce (8)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02,
+    // valid-to time (8)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x04,
+    // gas cost (8)
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x06,
+    // contract address (21): ZK contract
+    0x03, 0xc3, 0x39, 0x97, 0x54, 0x4e, 0x31, 0x75,
+    0xd2, 0x66, 0xbd, 0x02, 0x24, 0x39, 0xb2, 0x2c,
+    0xdb, 0x16, 0x50, 0x8c, 0x7a,
+    // rpc length (4): 1 + 12 + 0x400
+    0x00, 0x00, 0x04, 0x0d,
+    // 49: invocation kind (1): on-chain secret input
+    0x05,
+    // 50: bit lengths (4 + 2 * 4): [32, 64]
+    0x00, 0x00, 0x00, 0x02,
+    0x00, 0x00, 0x00, 0x20,
+    0x00, 0x00, 0x00, 0x40,
+    // 62: encrypted shares and arguments (0x400), not parsed. Zeroes in the
+    // remaining chunk.
+};
+
 // clang-format on
 
 static uint8_t ADDRESS_GENERIC_CONTRACT[21] = {
@@ -268,7 +328,7 @@ static void test_tx_serialization_generic(void **state) {
     transaction_parsing_state_t parsing_state;
     transaction_t tx;
 
-    transaction_parser_init(&parsing_state);
+    transaction_parser_init(&parsing_state, fresh_test_arena());
     parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
 
     // Check internal state of parser
@@ -297,7 +357,7 @@ static void test_tx_serialization_mpc_token_transfer(void **state) {
     transaction_parsing_state_t parsing_state;
     transaction_t tx;
 
-    transaction_parser_init(&parsing_state);
+    transaction_parser_init(&parsing_state, fresh_test_arena());
     parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
 
     // Check internal state of parser
@@ -316,6 +376,66 @@ static void test_tx_serialization_mpc_token_transfer(void **state) {
     assert_int_equal(tx.mpc_transfer.memo_length, 0);
 }
 
+static void test_tx_serialization_mpc_token_transfer_separate_header(void **state) {
+    // Setup
+    (void) state;
+    uint8_t raw_tx[sizeof(TRANSACTION_BYTES_MPC_TRANSFER_NO_MEMO)];
+    memcpy(raw_tx,
+           &TRANSACTION_BYTES_MPC_TRANSFER_NO_MEMO,
+           sizeof(TRANSACTION_BYTES_MPC_TRANSFER_NO_MEMO));
+    buffer_t header = {.ptr = raw_tx, .size = TRANSACTION_HEADER_LEN, .offset = 0};
+    buffer_t rpc = {.ptr = raw_tx + TRANSACTION_HEADER_LEN,
+                    .size = sizeof(raw_tx) - TRANSACTION_HEADER_LEN,
+                    .offset = 0};
+
+    // Run test
+    transaction_parsing_state_t parsing_state;
+    transaction_t tx;
+
+    transaction_parser_init(&parsing_state, fresh_test_arena());
+    parser_status_e status = transaction_parser_update_header(&parsing_state, &header, &tx);
+    assert_int_equal(status, PARSING_CONTINUE);
+    assert_int_equal(header.offset, header.size);
+
+    status = transaction_parser_update(&parsing_state, &rpc, &tx);
+
+    // Check internal state of parser
+    assert_int_equal(status, PARSING_DONE);
+    assert_int_equal(rpc.offset, rpc.size);
+    assert_int_equal(parsing_state.rpc_bytes_total, 0x1e);
+    assert_int_equal(parsing_state.rpc_bytes_parsed, 0x1e);
+
+    // Check output
+    assert_int_equal(tx.basic.nonce, 0x102);
+    assert_int_equal(tx.basic.valid_to_time, 0x304);
+    assert_int_equal(tx.basic.gas_cost, 0x506);
+    assert_memory_equal(tx.basic.contract_address.raw_bytes, ADDRESS_MPC_TOKEN, 21);
+    assert_int_equal(tx.type, MPC_TRANSFER);
+    assert_memory_equal(tx.mpc_transfer.recipient_address.raw_bytes, ADDRESS_RECIPIENT, 21);
+    assert_int_equal(tx.mpc_transfer.token_amount_10000ths, 0x333);
+    assert_int_equal(tx.mpc_transfer.memo_length, 0);
+}
+
+static void test_tx_serialization_separate_header_with_rpc(void **state) {
+    // Setup
+    (void) state;
+    uint8_t raw_tx[sizeof(TRANSACTION_BYTES_MPC_TRANSFER_NO_MEMO)];
+    memcpy(raw_tx,
+           &TRANSACTION_BYTES_MPC_TRANSFER_NO_MEMO,
+           sizeof(TRANSACTION_BYTES_MPC_TRANSFER_NO_MEMO));
+    buffer_t buf = {.ptr = raw_tx, .size = sizeof(raw_tx), .offset = 0};
+
+    // Run test
+    transaction_parsing_state_t parsing_state;
+    transaction_t tx;
+
+    transaction_parser_init(&parsing_state, fresh_test_arena());
+    parser_status_e status = transaction_parser_update_header(&parsing_state, &buf, &tx);
+
+    // RPC is not allowed in the header chunk
+    assert_int_equal(status, PARSING_FAILED_RPC_DATA);
+}
+
 static void test_tx_serialization_mpc_token_transfer_but_too_many_bytes(void **state) {
     // Setup
     (void) state;
@@ -329,7 +449,7 @@ static void test_tx_serialization_mpc_token_transfer_but_too_many_bytes(void **s
     transaction_parsing_state_t parsing_state;
     transaction_t tx;
 
-    transaction_parser_init(&parsing_state);
+    transaction_parser_init(&parsing_state, fresh_test_arena());
     parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
 
     // Check internal state of parser
@@ -345,6 +465,32 @@ static void test_tx_serialization_mpc_token_transfer_but_too_many_bytes(void **s
     assert_int_equal(tx.type, GENERIC_TRANSACTION);
 }
 
+static void test_tx_serialization_mpc_token_transfer_but_too_few_bytes(void **state) {
+    // Setup: MPC transfer declaring a longer RPC than the transfer
+    (void) state;
+    uint8_t raw_tx[sizeof(TRANSACTION_BYTES_MPC_TRANSFER_NO_MEMO)];
+    memcpy(raw_tx,
+           &TRANSACTION_BYTES_MPC_TRANSFER_NO_MEMO,
+           sizeof(TRANSACTION_BYTES_MPC_TRANSFER_NO_MEMO));
+    raw_tx[TRANSACTION_HEADER_LEN - 1] = 0x40;
+    buffer_t buf = {.ptr = raw_tx, .size = sizeof(raw_tx), .offset = 0};
+
+    // Run test
+    transaction_parsing_state_t parsing_state;
+    transaction_t tx;
+
+    transaction_parser_init(&parsing_state, fresh_test_arena());
+    parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
+
+    // Check internal state of parser: the rest of the RPC is expected
+    assert_int_equal(status, PARSING_CONTINUE);
+    assert_int_equal(parsing_state.rpc_bytes_total, 0x40);
+    assert_int_equal(parsing_state.rpc_bytes_parsed, 0x1e);
+
+    // Check output
+    assert_int_equal(tx.type, GENERIC_TRANSACTION);
+}
+
 static void test_tx_serialization_mpc_token_transfer_small_memo(void **state) {
     // Setup
     (void) state;
@@ -358,7 +504,7 @@ static void test_tx_serialization_mpc_token_transfer_small_memo(void **state) {
     transaction_parsing_state_t parsing_state;
     transaction_t tx;
 
-    transaction_parser_init(&parsing_state);
+    transaction_parser_init(&parsing_state, fresh_test_arena());
     parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
 
     // Check internal state of parser
@@ -391,13 +537,13 @@ static void test_tx_serialization_mpc_token_transfer_large_memo(void **state) {
     transaction_parsing_state_t parsing_state;
     transaction_t tx;
 
-    transaction_parser_init(&parsing_state);
+    transaction_parser_init(&parsing_state, fresh_test_arena());
     parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
 
     // Check internal state of parser
     assert_int_equal(status, PARSING_DONE);
-    assert_int_equal(parsing_state.rpc_bytes_total, 0x31);
-    assert_int_equal(parsing_state.rpc_bytes_parsed, 0x31);
+    assert_int_equal(parsing_state.rpc_bytes_total, 0x2d);
+    assert_int_equal(parsing_state.rpc_bytes_parsed, 0x2d);
 
     // Check output
     assert_int_equal(tx.basic.nonce, 0x102);
@@ -426,7 +572,7 @@ static void test_tx_serialization_mpc_token_transfer_large_multichunk_memo(void
     transaction_parsing_state_t parsing_state;
     transaction_t tx;
 
-    transaction_parser_init(&parsing_state);
+    transaction_parser_init(&parsing_state, fresh_test_arena());
     parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
 
     // Check internal state of parser
@@ -459,6 +605,165 @@ static void test_tx_serialization_mpc_token_transfer_large_multichunk_memo(void
                      GENERIC_TRANSACTION);  // Too large to be easily parsed; default to blind-sign
 }
 
+static void test_tx_serialization_mpc_token_transfer_memo_larger_than_arena(void **state) {
+    // Setup
+    (void) state;
+    uint8_t raw_tx[sizeof(TRANSACTION_BYTES_MPC_TRANSFER_LARGE_MEMO)];
+    memcpy(raw_tx,
+           &TRANSACTION_BYTES_MPC_TRANSFER_LARGE_MEMO,
+           sizeof(TRANSACTION_BYTES_MPC_TRANSFER_LARGE_MEMO));
+    buffer_t buf = {.ptr = raw_tx, .size = sizeof(raw_tx), .offset = 0};
+
+    // Arena without room for the memo's null terminator
+    uint8_t arena_buffer[11];
+    arena_t arena;
+    arena_init(&arena, arena_buffer, sizeof(arena_buffer));
+
+    // Run test
+    transaction_parsing_state_t parsing_state;
+    transaction_t tx;
+
+    transaction_parser_init(&parsing_state, &arena);
+    parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
+
+    // Check internal state of parser
+    assert_int_equal(status, PARSING_DONE);
+    assert_int_equal(buf.offset, buf.size);
+    assert_int_equal(arena.used, 0);
+
+    // Check output
+    assert_int_equal(tx.type, GENERIC_TRANSACTION);
+    assert_int_equal(tx.rpc_parsing_error, PARSING_FAILED_MPC_MEMO);
+}
+
+static void test_tx_serialization_zk_open_invocation(void **state) {
+    // Setup
+    (void) state;
+    uint8_t raw_tx[sizeof(TRANSACTION_BYTES_ZK_OPEN_INVOCATION)];
+    memcpy(raw_tx,
+           &TRANSACTION_BYTES_ZK_OPEN_INVOCATION,
+           sizeof(TRANSACTION_BYTES_ZK_OPEN_INVOCATION));
+    buffer_t buf = {.ptr = raw_tx, .size = sizeof(raw_tx), .offset = 0};
+
+    // Run test
+    transaction_parsing_state_t parsing_state;
+    transaction_t tx;
+
+    transaction_parser_init(&parsing_state, fresh_test_arena());
+    parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
+
+    // Check internal state of parser
+    assert_int_equal(status, PARSING_DONE);
+    assert_int_equal(buf.offset, buf.size);
+    assert_int_equal(parsing_state.rpc_bytes_total, 7);
+    assert_int_equal(parsing_state.rpc_bytes_parsed, 7);
+
+    // Check output
+    assert_int_equal(tx.basic.gas_cost, 0x506);
+    assert_int_equal(tx.type, ZK_INVOCATION);
+    assert_int_equal(tx.zk_invocation.kind, ZK_OPEN_INVOCATION);
+    assert_int_equal(tx.zk_invocation.shortname, 0x1234);
+}
+
+static void test_tx_serialization_zk_secret_input_multichunk(void **state) {
+    // Setup first chunk
+    (void) state;
+    uint8_t raw_tx[255];
+    memcpy(raw_tx,
+           &TRANSACTION_BYTES_ZK_SECRET_INPUT_ON_CHAIN_PART_1,
+           sizeof(TRANSACTION_BYTES_ZK_SECRET_INPUT_ON_CHAIN_PART_1));
+    buffer_t buf = {.ptr = raw_tx, .size = sizeof(raw_tx), .offset = 0};
+
+    // Run test
+    transaction_parsing_state_t parsing_state;
+    transaction_t tx;
+
+    transaction_parser_init(&parsing_state, fresh_test_arena());
+    parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
+
+    // Check internal state of parser
+    assert_int_equal(status, PARSING_CONTINUE);
+    assert_int_equal(buf.offset, buf.size);
+    assert_int_equal(parsing_state.rpc_bytes_total, 0x40d);
+    assert_int_equal(parsing_state.rpc_bytes_parsed, 255 - 49);
+
+    // Stream the remaining payload
+    uint32_t remaining = 0x40d - (255 - 49);
+    memset(raw_tx, 0xab, sizeof(raw_tx));
+    while (remaining > 0) {
+        buf.size = remaining < sizeof(raw_tx) ? remaining : sizeof(raw_tx);
+        buf.offset = 0;
+        remaining -= buf.size;
+
+        status = transaction_parser_update(&parsing_state, &buf, &tx);
+        assert_int_equal(status, remaining > 0 ? PARSING_CONTINUE : PARSING_DONE);
+        assert_int_equal(buf.offset, buf.size);
+    }
+
+    // Check output
+    assert_int_equal(tx.type, ZK_INVOCATION);
+    assert_int_equal(tx.zk_invocation.kind, ZK_SECRET_INPUT_ON_CHAIN);
+    assert_int_equal(tx.zk_invocation.secret_input_bits, 96);
+}
+
+/**
+ * Variant test that modifies a single byte of the given ZK transaction, and
+ * checks that it is parsed as a generic transaction with the given error.
+ */
+static void test_variant_zk_invocation_modified(uint8_t *transaction_bytes,
+                                                size_t length,
+                                                size_t modified_index,
+                                                uint8_t modified_value,
+                                                parser_status_e error) {
+    uint8_t raw_tx[length];
+    memcpy(raw_tx, transaction_bytes, length);
+    raw_tx[modified_index] = modified_value;
+    buffer_t buf = {.ptr = raw_tx, .size = sizeof(raw_tx), .offset = 0};
+
+    // Run test
+    transaction_parsing_state_t parsing_state;
+    transaction_t tx;
+
+    transaction_parser_init(&parsing_state, fresh_test_arena());
+    transaction_parser_update(&parsing_state, &buf, &tx);
+
+    // Check output
+    assert_int_equal(tx.type, GENERIC_TRANSACTION);
+    assert_int_equal(tx.rpc_parsing_error, error);
+}
+
+static void test_zk_invocation_malformed(void **state) {
+    (void) state;
+
+    // Unknown invocation kind
+    test_variant_zk_invocation_modified(TRANSACTION_BYTES_ZK_OPEN_INVOCATION,
+                                        sizeof(TRANSACTION_BYTES_ZK_OPEN_INVOCATION),
+                                        49,
+                                        0x07,
+                                        PARSING_FAILED_ZK_INVOCATION_KIND);
+
+    // Shortname exceeds the RPC
+    test_variant_zk_invocation_modified(TRANSACTION_BYTES_ZK_OPEN_INVOCATION,
+                                        sizeof(TRANSACTION_BYTES_ZK_OPEN_INVOCATION),
+                                        48,
+                                        0x02,
+                                        PARSING_FAILED_RPC_DATA);
+
+    // Negative bit length
+    test_variant_zk_invocation_modified(TRANSACTION_BYTES_ZK_SECRET_INPUT_ON_CHAIN_PART_1,
+                                        sizeof(TRANSACTION_BYTES_ZK_SECRET_INPUT_ON_CHAIN_PART_1),
+                                        58,
+                                        0x80,
+                                        PARSING_FAILED_ZK_SECRET_INPUT_BIT_LENGTHS);
+
+    // Too many bit lengths for the chunk
+    test_variant_zk_invocation_modified(TRANSACTION_BYTES_ZK_SECRET_INPUT_ON_CHAIN_PART_1,
+                                        sizeof(TRANSACTION_BYTES_ZK_SECRET_INPUT_ON_CHAIN_PART_1),
+                                        52,
+                                        0x01,
+                                        PARSING_FAILED_ZK_SECRET_INPUT_BIT_LENGTHS);
+}
+
 /**
  * Variant test that cuts off a part of the transaction bytes, and checks
  * whether parsing it will produce the expected error.
@@ -474,7 +779,7 @@ static void test_variant_transaction_cut_off(uint8_t *transaction_bytes,
     transaction_parsing_state_t parsing_state;
     transaction_t tx;
 
-    transaction_parser_init(&parsing_state);
+    transaction_parser_init(&parsing_state, fresh_test_arena());
     parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
 
     // Check internal state of parser
@@ -542,7 +847,7 @@ static void test_variant_transaction_rpc_cut_off(uint8_t *transaction_bytes,
     transaction_parsing_state_t parsing_state;
     transaction_t tx;
 
-    transaction_parser_init(&parsing_state);
+    transaction_parser_init(&parsing_state, fresh_test_arena());
     parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
 
     // Check entire buffer consumed
@@ -644,7 +949,7 @@ static void test_mpc_unknown_shortname() {
     transaction_parsing_state_t parsing_state;
     transaction_t tx;
 
-    transaction_parser_init(&parsing_state);
+    transaction_parser_init(&parsing_state, fresh_test_arena());
     parser_status_e status = transaction_parser_update(&parsing_state, &buf, &tx);
 
     // Check entire buffer consumed
@@ -782,14 +1087,100 @@ static void test_buffer_read_bytes_already_overflown(void **state) {
     test_buffer_variant_read_with_offset(11, 0);
 }
 
+static void test_buffer_variant_read_leb128(uint8_t *bytes,
+                                            size_t length,
+                                            bool expected_success,
+                                            uint32_t expected_value) {
+    buffer_t buf = {.ptr = bytes, .size = length, .offset = 0};
+    uint32_t value = 0;
+
+    assert_int_equal(buffer_read_leb128_u32(&buf, &value), expected_success);
+    if (expected_success) {
+        assert_int_equal(value, expected_value);
+        assert_int_equal(buf.offset, length);
+    }
+}
+
+static void test_buffer_read_leb128(void **state) {
+    (void) state;
+
+    uint8_t zero[] = {0x00};
+    uint8_t one_byte[] = {0x7f};
+    uint8_t two_bytes[] = {0xb4, 0x24};
+    uint8_t max[] = {0xff, 0xff, 0xff, 0xff, 0x0f};
+    uint8_t overflow[] = {0xff, 0xff, 0xff, 0xff, 0x1f};
+    uint8_t too_long[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+    uint8_t cut_off[] = {0x80, 0x80};
+
+    test_buffer_variant_read_leb128(zero, sizeof(zero), true, 0);
+    test_buffer_variant_read_leb128(one_byte, sizeof(one_byte), true, 0x7f);
+    test_buffer_variant_read_leb128(two_bytes, sizeof(two_bytes), true, 0x1234);
+    test_buffer_variant_read_leb128(max, sizeof(max), true, 0xffffffff);
+    test_buffer_variant_read_leb128(overflow, sizeof(overflow), false, 0);
+    test_buffer_variant_read_leb128(too_long, sizeof(too_long), false, 0);
+    test_buffer_variant_read_leb128(cut_off, sizeof(cut_off), false, 0);
+}
+
+static void test_arena_alloc(void **state) {
+    (void) state;
+    arena_t *arena = fresh_test_arena();
+
+    uint8_t *first = arena_alloc(arena, 10);
+    uint8_t *second = arena_alloc(arena, 20);
+
+    assert_non_null(first);
+    assert_non_null(second);
+    assert_ptr_equal(second, first + 10);
+    assert_int_equal(arena->used, 30);
+    assert_int_equal(arena->high_water_mark, 30);
+    assert_int_equal(arena_available(arena), ARENA_SIZE - 30);
+}
+
+static void test_arena_alloc_exhausted(void **state) {
+    (void) state;
+    arena_t *arena = fresh_test_arena();
+
+    assert_non_null(arena_alloc(arena, ARENA_SIZE - 1));
+    assert_null(arena_alloc(arena, 2));
+    assert_non_null(arena_alloc(arena, 1));
+    assert_null(arena_alloc(arena, 1));
+    assert_int_equal(arena_available(arena), 0);
+}
+
+static void test_arena_reset_keeps_high_water_mark(void **state) {
+    (void) state;
+    arena_t *arena = fresh_test_arena();
+
+    uint8_t *first = arena_alloc(arena, 40);
+    memset(first, 0xff, 40);
+    arena_reset(arena);
+
+    assert_int_equal(arena->used, 0);
+    assert_int_equal(arena->high_water_mark, 40);
+
+    // Memory is zeroed when handed out again
+    uint8_t *second = arena_alloc(arena, 5);
+    uint8_t zeroes[40] = {0};
+    assert_ptr_equal(first, second);
+    assert_memory_equal(TEST_ARENA_BUFFER, zeroes, sizeof(zeroes));
+    assert_int_equal(arena->high_water_mark, 40);
+}
+
 int main() {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_tx_serialization_generic),
         cmocka_unit_test(test_tx_serialization_mpc_token_transfer),
+        cmocka_unit_test(test_tx_serialization_mpc_token_transfer_separate_header),
+        cmocka_unit_test(test_tx_serialization_separate_header_with_rpc),
         cmocka_unit_test(test_tx_serialization_mpc_token_transfer_but_too_many_bytes),
+        cmocka_unit_test(test_tx_serialization_mpc_token_transfer_but_too_few_bytes),
         cmocka_unit_test(test_tx_serialization_mpc_token_transfer_small_memo),
         cmocka_unit_test(test_tx_serialization_mpc_token_transfer_large_memo),
         cmocka_unit_test(test_tx_serialization_mpc_token_transfer_large_multichunk_memo),
+        cmocka_unit_test(test_tx_serialization_mpc_token_transfer_memo_larger_than_arena),
+        cmocka_unit_test(test_tx_serialization_zk_open_invocation),
+        cmocka_unit_test(test_tx_serialization_zk_secret_input_multichunk),
+        cmocka_unit_test(test_zk_invocation_malformed),
         cmocka_unit_test(test_cut_off_transactions),
         cmocka_unit_test(test_cut_off_rpc_no_memo),
         cmocka_unit_test(test_cut_off_rpc_small_memo),
@@ -804,6 +1195,10 @@ int main() {
         cmocka_unit_test(test_buffer_read_bytes_equal_size),
         cmocka_unit_test(test_buffer_read_bytes_already_read),
         cmocka_unit_test(test_buffer_read_bytes_already_overflown),
+        cmocka_unit_test(test_buffer_read_leb128),
+        cmocka_unit_test(test_arena_alloc),
+        cmocka_unit_test(test_arena_alloc_exhausted),
+        cmocka_unit_test(test_arena_reset_keeps_high_water_mark),
     };
 
     return cmocka_run_group_tests(tests, NULL, NULL);